@@ -0,0 +1,60 @@
+// Copyright 1998-2015 Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "Kismet/BlueprintAsyncActionBase.h"
+
+#include "SoundVisLoadSoundFileAction.generated.h"
+
+class USoundVisualization;
+
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FSoundVisLoadSoundFileDelegate, float, Progress);
+
+/**
+	Latent Blueprint node that loads a sound file and fires its pins on the game thread while and after it is decoded.
+	No need to poll anything every tick, analysis can be chained right behind OnDecoded.
+*/
+UCLASS()
+class USoundVisLoadSoundFileAction : public UBlueprintAsyncActionBase
+{
+	GENERATED_BODY()
+
+public:
+
+	// The whole song is decoded (or comes from the analysis cache) and can be analyzed. Progress is 1
+	UPROPERTY(BlueprintAssignable)
+	FSoundVisLoadSoundFileDelegate OnDecoded;
+
+	// Fired every few percent while decoding. Queries below the decoded part already work
+	UPROPERTY(BlueprintAssignable)
+	FSoundVisLoadSoundFileDelegate OnProgress;
+
+	// The file couldn't be loaded, or the decode was cancelled because another song got loaded. Progress is what was decoded until then
+	UPROPERTY(BlueprintAssignable)
+	FSoundVisLoadSoundFileDelegate OnFailed;
+
+	/**
+	* Will load a file (currently .ogg) from your Harddrive like "SV_LoadSoundFileFromHD", but tells you when it is decoded
+	*
+	* @param	_SoundVisualization	Object the song gets loaded into
+	* @param	_FilePath			Absolute path to the File. E.g.: "C:/Songs/File.ogg"
+	*
+	*/
+	UFUNCTION(BlueprintCallable, meta = (BlueprintInternalUseOnly = "true"), Category = "SoundVis | SoundFile")
+		static USoundVisLoadSoundFileAction* SV_LoadSoundFileFromHDAsync(USoundVisualization* _SoundVisualization, const FString _FilePath);
+
+	// UBlueprintAsyncActionBase interface
+	virtual void Activate() override;
+
+private:
+
+	// Fires the end pin and lets the action be collected
+	void Finish(bool _bSuccess);
+
+	UPROPERTY()
+	USoundVisualization* SoundVisualization;
+
+	FString FilePath;
+
+	float LastProgress;
+};
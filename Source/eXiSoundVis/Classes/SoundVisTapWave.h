@@ -0,0 +1,45 @@
+// Copyright 1998-2015 Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "Sound/SoundWaveProcedural.h"
+
+#include "SoundVisLiveTap.h"
+
+#include "SoundVisTapWave.generated.h"
+
+/**
+	Plays a loaded song and hands every frame the audio device pulls to a FSoundVisLiveRing.
+	The song gets decoded once, while it plays, instead of once for playback and once for the analysis.
+	The source SoundWave needs its compressed data, so it has to be loaded with bMakeSoundWavePlayable.
+*/
+UCLASS()
+class USoundVisTapWave : public USoundWaveProcedural
+{
+	GENERATED_BODY()
+
+public:
+
+	// Opens the compressed data of _SourceWave at _StartTime. Everything that gets rendered afterwards is written to _Ring
+	bool Init(USoundWave* _SourceWave, float _StartTime, const TSharedRef<FSoundVisLiveRing, ESPMode::ThreadSafe>& _Ring);
+
+	// USoundWave interface. Called by the audio device whenever it needs more samples
+	virtual int32 GeneratePCMData(uint8* _PCMData, const int32 _SamplesNeeded) override;
+
+	// UObject interface
+	virtual void BeginDestroy() override;
+
+private:
+
+	// Keeps the compressed data alive while it plays
+	UPROPERTY()
+	USoundWave* SourceWave = NULL;
+
+	// Only used by the thread the device renders on after Init()
+	ICompressedAudioInfo* AudioInfo = NULL;
+
+	TSharedPtr<FSoundVisLiveRing, ESPMode::ThreadSafe> Ring;
+
+	// The decoder reached the end of the song, the rest is silence
+	bool bSourceFinished = false;
+};
@@ -0,0 +1,203 @@
+// Copyright 1998-2015 Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "SoundVisTypes.generated.h"
+
+// Window functions that can be applied to the samples before the FFT
+UENUM(BlueprintType)
+enum class ESoundVisWindowType : uint8
+{
+	// Good allround window, used by default
+	Hann				UMETA(DisplayName = "Hann"),
+
+	// Slightly narrower main lobe than Hann, but the side lobes don't fall off
+	Hamming				UMETA(DisplayName = "Hamming"),
+
+	// Very low side lobes, good if quiet frequencies sit next to loud ones
+	BlackmanHarris		UMETA(DisplayName = "Blackman-Harris"),
+
+	// Wide main lobe, but the most exact amplitudes for single frequencies
+	FlatTop				UMETA(DisplayName = "Flat Top"),
+
+	Num					UMETA(Hidden)
+};
+
+// How the spectrum functions turn the requested window length into an FFT size
+UENUM(BlueprintType)
+enum class ESoundVisFFTSizePolicy : uint8
+{
+	// Next power of two. The window grows to that size around the requested part
+	PowerOfTwo			UMETA(DisplayName = "Power of Two"),
+
+	// Exactly the requested samples, zero padded up to the next power of two
+	ZeroPadded			UMETA(DisplayName = "Zero Padded"),
+
+	// Exactly the requested samples, zero padded up to the cheapest size made of the factors 2, 3, 5 and 7. Often barely bigger than the request
+	MixedRadix			UMETA(DisplayName = "Mixed Radix")
+};
+
+// Value the spectrum functions return for every bin
+UENUM(BlueprintType)
+enum class ESoundVisSpectrumOutput : uint8
+{
+	// Magnitude, averaged over the channels
+	Magnitude			UMETA(DisplayName = "Magnitude"),
+
+	// Square of the magnitude
+	Power				UMETA(DisplayName = "Power"),
+
+	// 20 log10 of the magnitude. Silence bottoms out at -200 dB
+	Decibels			UMETA(DisplayName = "Decibels")
+};
+
+// Order in which the decoder pool picks up waiting decode jobs. Jobs that already run are not interrupted
+UENUM(BlueprintType)
+enum class ESoundVisDecodePriority : uint8
+{
+	// Previews and songs that are only prepared
+	Background			UMETA(DisplayName = "Background"),
+
+	Normal				UMETA(DisplayName = "Normal"),
+
+	// The song that is playing right now
+	OnAir				UMETA(DisplayName = "On Air")
+};
+
+// Order of the entries returned by a library query
+UENUM(BlueprintType)
+enum class ESoundVisLibrarySort : uint8
+{
+	// File name without the directory, case insensitive
+	Name				UMETA(DisplayName = "Name"),
+
+	Duration			UMETA(DisplayName = "Duration"),
+
+	SampleRate			UMETA(DisplayName = "Sample Rate"),
+
+	NumChannels			UMETA(DisplayName = "Channels"),
+
+	// Last time the file was changed on disk
+	Modified			UMETA(DisplayName = "Modified")
+};
+
+// One sound file of the library index, with the info read from its header
+USTRUCT(BlueprintType)
+struct FSoundVisLibraryEntry
+{
+	GENERATED_USTRUCT_BODY()
+
+	// Absolute path, can be passed to SV_LoadSoundFileFromHD
+	UPROPERTY(BlueprintReadOnly, Category = "SoundVis | Library")
+	FString FilePath;
+
+	// In seconds
+	UPROPERTY(BlueprintReadOnly, Category = "SoundVis | Library")
+	float Duration;
+
+	UPROPERTY(BlueprintReadOnly, Category = "SoundVis | Library")
+	int32 SampleRate;
+
+	UPROPERTY(BlueprintReadOnly, Category = "SoundVis | Library")
+	int32 NumChannels;
+
+	UPROPERTY(BlueprintReadOnly, Category = "SoundVis | Library")
+	FDateTime ModificationTime;
+
+	// Size on disk. Together with ModificationTime it tells the rescan if the file changed
+	int64 FileSize;
+
+	// False if the header couldn't be read. Such files stay in the index, so they aren't read again until they change
+	bool bIsReadable;
+
+	FSoundVisLibraryEntry()
+		: Duration(0.0f)
+		, SampleRate(0)
+		, NumChannels(0)
+		, FileSize(0)
+		, bIsReadable(false)
+	{
+	}
+};
+
+/**
+	One spectrum (e.g. from SV_New_CalculateFrequencySpectrum) prepared for band queries.
+	Keeps the running sums of the bins, so the average of any frequency range is two lookups,
+	no matter how wide the range is. Build it once per spectrum and query as many bands as needed.
+*/
+USTRUCT(BlueprintType)
+struct FSoundVisSpectrumFrame
+{
+	GENERATED_USTRUCT_BODY()
+
+	// Number of bins of the spectrum the frame was built from
+	UPROPERTY(BlueprintReadOnly, Category = "SoundVis | Frequency Values")
+	int32 NumBins;
+
+	// Sample rate of the song the spectrum belongs to. Bin i covers i * SampleRate / (2 * NumBins) Hz
+	UPROPERTY(BlueprintReadOnly, Category = "SoundVis | Frequency Values")
+	int32 SampleRate;
+
+	// PrefixSums[i] is the sum of the first i bins. Double, so narrow bands high up don't drown in rounding errors
+	UPROPERTY()
+	TArray<double> PrefixSums;
+
+	FSoundVisSpectrumFrame()
+		: NumBins(0)
+		, SampleRate(0)
+	{
+	}
+
+	// Builds the running sums of _Bins. Reuses the memory of the previous spectrum
+	void Build(const float* _Bins, int32 _NumBins, int32 _SampleRate);
+
+	bool IsValid() const
+	{
+		return NumBins > 0 && SampleRate > 0;
+	}
+
+	// Bin of a frequency, mapped the same way as the Frequency Value functions do it. Not clamped, can be past the last bin
+	int32 GetBinIndex(float _Frequency) const;
+
+	// Average of the bins from _StartFrequency to _EndFrequency (both included). 0 if the frame is empty or the range has no bins
+	float GetAverage(float _StartFrequency, float _EndFrequency) const;
+
+	// Averages of the _NumEdges - 1 bands between neighbouring edges (in Hz) into _OutValues
+	void GetBandAverages(const float* _BandEdges, int32 _NumEdges, float* _OutValues) const;
+};
+
+// Log-frequency band layouts of the filterbank
+UENUM(BlueprintType)
+enum class ESoundVisBandLayout : uint8
+{
+	// 31.5 Hz to 16 kHz, one band per octave
+	Octave				UMETA(DisplayName = "Octave"),
+
+	// 25 Hz to 16 kHz, three bands per octave
+	ThirdOctave			UMETA(DisplayName = "1/3 Octave"),
+
+	// Any number of bands, evenly spaced on the Mel scale from 20 Hz to 20 kHz
+	Mel					UMETA(DisplayName = "Mel")
+};
+
+// What one row of a batched spectrum holds
+UENUM(BlueprintType)
+enum class ESoundVisBatchOutput : uint8
+{
+	// The linear bins, like SV_New_CalculateFrequencySpectrum returns them
+	Bins				UMETA(DisplayName = "Bins"),
+
+	// The bands of a filterbank, like SV_CalculateBandEnergies returns them
+	Bands				UMETA(DisplayName = "Bands")
+};
+
+// How the bins of a band are weighted
+UENUM(BlueprintType)
+enum class ESoundVisFilterShape : uint8
+{
+	// Plain average of the bins inside the band
+	Rectangular			UMETA(DisplayName = "Rectangular"),
+
+	// Peaks at the band center and overlaps half of the neighbouring bands, so bars move more smoothly
+	Triangular			UMETA(DisplayName = "Triangular")
+};
@@ -14,13 +14,34 @@
 #include "Sound/SoundWave.h"
 #include "Runtime/Core/Public/Async/AsyncWork.h"
 
+#include "SoundVisTypes.h"
+#include "SoundVisFFT.h"
+#include "SoundVisSlidingSTFT.h"
+#include "SoundVisSpectrogram.h"
+#include "SoundVisEnvelope.h"
+#include "SoundVisBeatGrid.h"
+#include "SoundVisStreamingPCM.h"
+#include "SoundVisLibraryIndex.h"
+#include "SoundVisTapWave.h"
+
 #include "SoundVisualization.generated.h"
 
+// Game thread callbacks of an asynchronous load. Both are optional
+struct FSoundVisDecodeCallbacks
+{
+	// Decoded part of the song (0 to 1), called every few percent
+	TFunction<void(float)> OnProgress;
+
+	// Called once. True if the song can be analyzed, false if loading or decoding failed or the decode was cancelled
+	TFunction<void(bool)> OnFinished;
+};
+
 /**
-	Most of this Multithread stuff is from Ramas Wiki Entry.
-	Go check it out and credit him for it! (:
+	One decode job: decodes a range of a SoundWave into a PCM buffer on a thread of the FSoundVisDecoderPool.
+	Every job has its own state, so several songs can be decoded at once.
+	The decoding part is still mostly from Ramas Wiki Entry. Go check it out and credit him for it! (:
 */
-class FAudioDecompressWorker : public FRunnable
+class FAudioDecompressWorker
 {
 
 public:
@@ -29,7 +50,13 @@ public:
 	uint8* PCMOutBuffer;
 
 	// Bool to check if the Worker finished
-	bool bIsFinished;
+	FThreadSafeBool bIsFinished;
+
+	// Checked between two chunks. A cancelled job stops with the watermark where it is
+	FThreadSafeBool bCancelRequested;
+
+	// Frames at the start of PCMOutBuffer that are decoded. Grows chunk by chunk while the worker runs
+	FThreadSafeCounter DecodedFrames;
 
 	// Time Variables
 	float CurrentTime;
@@ -41,11 +68,27 @@ public:
 	// Some Compressed Audio Information
 	ICompressedAudioInfo* AudioInfo;
 
-	static FAudioDecompressWorker* Runnable;
+	// Compressed data that gets decoded. The resource data of the Wave if not set
+	const uint8* SourceData;
+	uint32 SourceSize;
+
+	// True if AudioInfo already parsed the header of SourceData
+	bool bHeaderRead;
+
+	// Jobs with a higher priority are started first
+	ESoundVisDecodePriority Priority;
 
-	FRunnableThread* Thread;
+	// Posted to the game thread while decoding and when the job finishes. Set them before Start()
+	FSoundVisDecodeCallbacks Callbacks;
 
-	FThreadSafeCounter StopTaskCounter;
+	// Decoded part after which OnProgress is called again
+	static const float ProgressStep;
+
+	// Frames decoded before the watermark moves on
+	static const int32 DecodeChunkFrames = 8192;
+
+	// Longest a task waiting with WaitForFinish() sleeps before it looks at its own cancel flag again
+	static const uint32 FinishWaitMs = 20;
 
 	// Function to check if the Worker is finished
 	bool IsFinished() const
@@ -53,21 +96,63 @@ public:
 		return bIsFinished;
 	}
 
-	FAudioDecompressWorker(USoundWave* _InWave, uint8* _PCMBuffer, float _StartTime, float _Duration);
-	virtual ~FAudioDecompressWorker();
+	// Everything below the returned frame can be read, even while the worker is still decoding the rest
+	int32 GetDecodedFrames() const
+	{
+		const int32 Frames = DecodedFrames.GetValue();
+
+		// Reads of the samples must not be moved before the watermark was read
+		FPlatformMisc::MemoryBarrier();
 
-	virtual bool Init();
-	virtual uint32 Run();
-	virtual void Stop();
-	virtual void Exit();
+		return Frames;
+	}
+
+	// True once a finished job decoded its whole range. A failed or cancelled job leaves the rest of the buffer as it was
+	bool HasSucceeded() const
+	{
+		return bIsFinished && bSucceeded;
+	}
 
+	FAudioDecompressWorker(USoundWave* _InWave, uint8* _PCMBuffer, float _StartTime, float _Duration, ESoundVisDecodePriority _Priority = ESoundVisDecodePriority::Normal);
+
+	// Cancels the job and waits for it, so the buffer can be freed afterwards
+	~FAudioDecompressWorker();
+
+	// Decode _Data instead of the resource data of the Wave, e.g. a mapped file. If _OpenedAudioInfo already read the header,
+	// the job takes it over and doesn't parse the header again. Call before Start()
+	void SetSource(const uint8* _Data, uint32 _DataSize, ICompressedAudioInfo* _OpenedAudioInfo = NULL);
+
+	// Queues the job in the decoder pool. Decodes right away on platforms without threads
+	void Start();
+
+	// Decodes the whole range. Called on a decoder thread
+	void DoWork();
+
+	// Sets the job finished, posts OnFinished and wakes up everyone waiting for it
+	void MarkFinished();
+
+	// Makes a running job stop after its current chunk
+	void Cancel();
+
+	// Blocks until the job is finished or _WaitTimeMs passed. True if it's finished. For background tasks that wait for the whole buffer
+	bool WaitForFinish(uint32 _WaitTimeMs) const
+	{
+		return DoneEvent->Wait(_WaitTimeMs);
+	}
+
+	// Takes the job out of the queue if it didn't start yet, otherwise waits until it's done. Always waits for the event,
+	// so the worker is out of MarkFinished when this returns
 	void EnsureCompletion();
 
-	static FAudioDecompressWorker* Initialize(USoundWave* _InWave, uint8* _PCMBuffer, float _StartTime, float _Duration);
+private:
 
-	static void Shutdown();
+	// Signaled by MarkFinished
+	FEvent* DoneEvent;
 
-	static bool IsThreadFinished();
+	bool bStarted;
+
+	// Set by DoWork if the whole range got decoded
+	bool bSucceeded;
 };
 
 /**
@@ -87,10 +172,167 @@ public:
 	// Holds the Data of our Current Song
 	uint8* PCMSampleBuffer = NULL;
 
+	// Real size of PCMSampleBuffer, it comes from the buffer pool and can be bigger than the song
+	SIZE_T PCMSampleBufferSize = 0;
+
+	// Mapped file of the current song. The decoders read the compressed data straight from it
+	FSoundVisMappedFile* SongFile = NULL;
+
+	// Header of SongFile, parsed once while loading and handed to the first decoder of the song
+	ICompressedAudioInfo* SongAudioInfo = NULL;
+
+	// Bytes of sound files copied and mapped by LoadSoundFileFromHD, over all objects
+	static FThreadSafeCounter64 NumLoadBytesCopied;
+	static FThreadSafeCounter64 NumLoadBytesMapped;
+
+	// Decoded blocks around the playhead, used instead of PCMSampleBuffer if bStreamingDecode is set
+	FSoundVisStreamingPCM* StreamingPCM = NULL;
+
+	// Analysis thread of the song that plays through LiveWave, see SV_PlayWithLiveAnalysis
+	FSoundVisLiveAnalyzer* LiveAnalyzer = NULL;
+
+	UPROPERTY()
+	USoundVisTapWave* LiveWave = NULL;
+
+	// Index of the sound files below the directory of the last SV_StartLibraryScan
+	FSoundVisLibraryIndex* LibraryIndex = NULL;
+
+	// Reused by SV_GetAverageFrequencyValuesInBands, so the running sums don't allocate every call
+	FSoundVisSpectrumFrame BandQueryFrame;
+
+	// Cached FFT plans and scratch buffers, so the spectrum functions don't allocate every tick
+	FSoundVisFFTContext FFTContext;
+
+	// Recent frames of the spectrum functions on the hop grid, used if bSlidingSpectrum is set
+	FSoundVisSlidingSTFT SlidingSTFT;
+
+	// One FFT context per chunk of a batched spectrum, kept so repeated batches don't allocate
+	TIndirectArray<FSoundVisFFTContext> BatchContexts;
+
+	// Windows of a batch copied out of the streamed blocks, reused between batches
+	TArray<int16> BatchSamples;
+
+	// Precomputed spectrum of the whole song and the task that builds it
+	FSoundVisSpectrogram Spectrogram;
+	FAsyncTask<FSoundVisSpectrogramTask>* SpectrogramTask = NULL;
+
+	// The SoundWave the Spectrogram belongs to
+	USoundWave* SpectrogramWave = NULL;
+
+	// Onsets, tempo and beats of the SpectrogramWave, and the task that builds them from a spectrogram that was already there
+	FSoundVisBeatGrid BeatGrid;
+	FAsyncTask<FSoundVisBeatGridTask>* BeatGridTask = NULL;
+
+	// Min/max/RMS pyramid of the whole song for drawing waveforms, the task that builds it and the SoundWave it belongs to
+	FSoundVisEnvelope Envelope;
+	FAsyncTask<FSoundVisEnvelopeTask>* EnvelopeTask = NULL;
+	USoundWave* EnvelopeWave = NULL;
+
+	// True while the spectrogram task builds the envelope instead of EnvelopeTask, so it goes into the same cache entry
+	bool bSpectrogramBuildsEnvelope = false;
+
+	// Mapped cache entry of the current song, if it was loaded from the analysis cache. The entry of the next song
+	// is opened next to it, so a load that fails leaves the current analysis alone
+	FSoundVisAnalysisCache* AnalysisCache = NULL;
+
 	// This is the Current Song
 	UPROPERTY(BlueprintReadOnly, Category = "SoundVis | Song Data")
 	USoundWave* CurrentSoundWave;
 
+	// Priority of the decode jobs of this object. E.g. On Air for the main deck and Background for a preview deck
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "SoundVis | Settings")
+	ESoundVisDecodePriority DecodePriority = ESoundVisDecodePriority::Normal;
+
+	// If true, the compressed file is copied into the SoundWave, so it can be played. Turn it off for songs that are only analyzed, then loading copies nothing
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "SoundVis | Settings")
+	bool bMakeSoundWavePlayable = true;
+
+	// If true, loading only prepares the song for "SV_PlayWithLiveAnalysis": the compressed file is copied into the SoundWave and nothing gets decoded.
+	// The tap wave decodes it while it plays. Functions that read the decoded samples return no data for such songs
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "SoundVis | Live")
+	bool bLiveAnalysisOnly = false;
+
+	// Window function applied to the samples before every FFT
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "SoundVis | Settings")
+	ESoundVisWindowType WindowType = ESoundVisWindowType::Hann;
+
+	// How the spectrum functions size their FFT. Power of Two widens the window around the requested part, the others analyze exactly
+	// the requested samples and pad them with zeros. Mixed Radix pads to the cheapest size that holds them, not to the next power of two
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "SoundVis | Settings")
+	ESoundVisFFTSizePolicy FFTSizePolicy = ESoundVisFFTSizePolicy::PowerOfTwo;
+
+	// What the spectrum functions return per bin. Power and Decibels are computed in the same pass as the magnitudes. The band energy functions always use magnitudes
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "SoundVis | Settings")
+	ESoundVisSpectrumOutput SpectrumOutput = ESoundVisSpectrumOutput::Magnitude;
+
+	// If true, the spectrum, band and spectrogram functions run an int16 fixed point FFT instead of the float one. Reads and writes half the memory per window,
+	// for background analysis on weak machines. About 60 to 70 dB of dynamic range instead of the float path's 140, so quiet bins get noisy. Power of two sizes up to 65536 only.
+	// With SSE2 about as fast as the float path, without it the fixed point loops run scalar and take about four times as long
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "SoundVis | Settings")
+	bool bFixedPointAnalysis = false;
+
+	// If true, the spectrum functions compute frames on a fixed hop grid, keep the last few and blend the two around the requested time.
+	// A query every tick then only runs FFTs for the hops that passed since the last one, instead of a whole new window
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "SoundVis | Settings")
+	bool bSlidingSpectrum = false;
+
+	// Time (seconds) between two frames of the sliding spectrum
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "SoundVis | Settings", meta = (ClampMin = "0.001"))
+	float SlidingHopDuration = 0.01f;
+
+	// If true, loading a song also computes its whole spectrogram in the background. Spectrum queries with the same window length are then only a lookup
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "SoundVis | Spectrogram")
+	bool bPrecomputeSpectrogram = false;
+
+	// Window length (seconds) of the precomputed frames. Rounded up to a power of two samples like in the spectrum functions
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "SoundVis | Spectrogram", meta = (ClampMin = "0.001"))
+	float SpectrogramWindowDuration = 0.1f;
+
+	// Time (seconds) between two precomputed frames. Queries in between get blended from the two closest frames.
+	// Every frame takes one byte per bin, so 0.02 with the default window are about 100 KB per second of audio at 44.1 kHz
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "SoundVis | Spectrogram", meta = (ClampMin = "0.001"))
+	float SpectrogramHopDuration = 0.02f;
+
+	// If true, the spectrogram of every loaded song is stored in <Saved>/SoundVisCache. Loading the same file again then maps the stored analysis and skips decoding.
+	// Songs loaded that way have no decoded samples, so only the spectrum queries served by the spectrogram and the band energies return data
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "SoundVis | Spectrogram")
+	bool bUseAnalysisCache = false;
+
+	// If true, loading a song also computes its spectrogram and from that its onsets, tempo and beat grid in the background.
+	// Works with songs from the analysis cache too, but not with streamed ones
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "SoundVis | Beats")
+	bool bDetectBeats = false;
+
+	// If true, loading a song also builds its waveform envelope in the background, so "SV_GetEnvelope" can draw any zoom level right away.
+	// Not built for streamed songs, they have no decoded samples of the whole song. With the analysis cache it's stored in the entry
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "SoundVis | Amplitude")
+	bool bBuildEnvelope = false;
+
+	// If true, songs are decoded in blocks of one second around the position that gets analyzed instead of all at once.
+	// Memory stays at StreamingCacheSeconds no matter how long the song is. The spectrogram and the analysis cache need the whole song and are not built then
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "SoundVis | Streaming")
+	bool bStreamingDecode = false;
+
+	// Seconds of decoded samples kept in memory while streaming. Grows if a single request spans more than that
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "SoundVis | Streaming", meta = (ClampMin = "4"))
+	int32 StreamingCacheSeconds = 16;
+
+	// Seconds after the analyzed position that get decoded ahead of time
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "SoundVis | Streaming", meta = (ClampMin = "1"))
+	int32 StreamingPrefetchSeconds = 4;
+
+	// Window length (seconds) of the live spectrum. Rounded up to a power of two samples like in the spectrum functions
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "SoundVis | Live", meta = (ClampMin = "0.001"))
+	float LiveWindowDuration = 0.05f;
+
+	// Time (seconds) between two live spectrums
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "SoundVis | Live", meta = (ClampMin = "0.001"))
+	float LiveHopDuration = 0.01f;
+
+	// Time (seconds) between the audio device pulling samples and them being heard. Depends on the platform and its buffer sizes
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "SoundVis | Live", meta = (ClampMin = "0.0"))
+	float LiveLatency = 0.1f;
+
 	/// FUNCTIONS ///
 
 public:
@@ -102,14 +344,73 @@ public:
 	/// Functions to load Data from the HardDrive ///
 
 	// Function to load a sound file from the HD
-	bool LoadSoundFileFromHD(const FString& _FilePath);
+	bool LoadSoundFileFromHD(const FString& _FilePath, const FSoundVisDecodeCallbacks* _Callbacks = NULL);
 
 	// Function to fill in the RawFile sound data into the USoundWave object
 	int FillSoundWaveInfo(class USoundWave* _SW, TArray<uint8>* _RawFile);
 
+	// Function to parse the header of the compressed data with _AudioInfo and fill the sound data into the USoundWave object
+	bool ReadSoundWaveInfo(class USoundWave* _SW, const uint8* _Data, uint32 _DataSize, ICompressedAudioInfo* _AudioInfo);
+
+	// Function to map the cached analysis of a file and fill its sound data into the USoundWave object. The current analysis is only replaced on a hit
+	bool LoadAnalysisFromCache(class USoundWave* _SW, const FSoundVisCacheKey& _CacheKey);
+
 	/// Function to decompress the crompressed Data that comes with the .ogg file ///
 
-	void GetPCMDataFromFile(USoundWave* _SoundWave, float _StartTime, float _Duration, bool _Synchronous = false);
+	// With callbacks, the decode job reports its progress and the end of the decode on the game thread
+	void GetPCMDataFromFile(USoundWave* _SoundWave, float _StartTime, float _Duration, bool _Synchronous = false, const FSoundVisDecodeCallbacks* _Callbacks = NULL);
+
+	// If _SoundWave is the current song, returns its mapped file and hands over the parsed header (only once, NULL afterwards)
+	bool TakeSongSource(USoundWave* _SoundWave, const uint8*& _OutData, uint32& _OutDataSize, ICompressedAudioInfo*& _OutOpenedAudioInfo);
+
+	// Unmaps the file of the current song. Nothing may decode from it anymore
+	void ReleaseSongFile();
+
+	// Starts decoding _SoundWave block by block around the analyzed position, see bStreamingDecode
+	bool StartStreamingDecode(USoundWave* _SoundWave);
+
+	// Stops the streaming decode thread and frees its blocks
+	void StopStreamingDecode();
+
+	// Returns _NumFrames interleaved frames of _SoundWave starting at _FirstFrame, either from the whole decoded song or the streamed blocks.
+	// NULL if the samples aren't decoded (yet)
+	const int16* GetSampleFrames(USoundWave* _SoundWave, int32 _FirstFrame, int32 _NumFrames);
+
+	// Cancels the decode job and gives the whole song buffer back to the pool. The spectrogram task has to be stopped before, the envelope task gets stopped here
+	void ReleasePCMSampleBuffer();
+
+	/// Functions to analyze the playing Audio ///
+
+	// Plays _SoundWave from _StartTime on _AudioComponent through a tap wave and starts the thread that analyzes what gets played
+	bool StartLiveAnalysis(UAudioComponent* _AudioComponent, USoundWave* _SoundWave, float _StartTime);
+
+	// Stops the analysis thread. The song keeps playing
+	void StopLiveAnalysis();
+
+	/// Functions to precompute the Spectrogram of the current _SoundWave ///
+
+	// Starts the background task that computes the whole spectrogram of the loaded song. Waits for the decompression first.
+	// With a cache key the result also gets written to the analysis cache. Without _bKeepFrames only RMS, bands and flux get computed, enough for the beat grid
+	bool StartSpectrogramPrecompute(USoundWave* _SoundWave, const FSoundVisCacheKey* _CacheKey = NULL, const FSoundVisCacheMetadata* _CacheMetadata = NULL, bool _bKeepFrames = true);
+
+	// Cancels a running spectrogram task, waits for it and frees the spectrogram and the beat grid
+	void StopSpectrogramPrecompute();
+
+	/// Functions to detect the Beats of the current _SoundWave ///
+
+	// Starts the background task that builds the beat grid from the finished spectrogram of _SoundWave
+	bool StartBeatDetection(USoundWave* _SoundWave);
+
+	// Cancels a running beat grid task, waits for it and frees the beat grid
+	void StopBeatDetection();
+
+	/// Functions to build the Envelope of the current _SoundWave ///
+
+	// Starts the background task that builds the min/max/RMS pyramid of the loaded song. Waits for the decompression first
+	bool StartEnvelopeBuild(USoundWave* _SoundWave);
+
+	// Cancels a running envelope task, waits for it and frees the envelope
+	void StopEnvelopeBuild();
 
 	/// Functions to Analyze the current _SoundWave ///
 
@@ -119,17 +420,34 @@ public:
 	// My new function to calculate the frequency spectrum. Returns an array of frequencies from 0 to 22000. Amount of different frequencies depends on samplerate of song and Duration of the TimeWindow
 	void New_CalculateFrequencySpectrum(USoundWave* _SoundWave, const float _StartTime, const float _Duration, TArray<float>& _OutFrequencies);
 
+	// Same window and FFT as New_CalculateFrequencySpectrum, but the spectrum of channel _ChannelIndex (0 based) instead of the average. Only works on the decoded samples
+	void New_CalculateChannelSpectrum(USoundWave* _SoundWave, int32 _ChannelIndex, const float _StartTime, const float _Duration, TArray<float>& _OutFrequencies);
+
+	// Spectra of many windows of the same _Duration in one call, spread over the worker threads. Row i of _OutValues belongs to _StartTimes[i].
+	// Rows without samples stay 0, with bStreamingDecode that are all rows outside the decoded blocks. Returns the length of a row, 0 if the song is too short for the window
+	int32 New_CalculateFrequencySpectrumBatch(USoundWave* _SoundWave, const TArray<float>& _StartTimes, const float _Duration, const ESoundVisBatchOutput _Output, const ESoundVisBandLayout _Layout, const ESoundVisFilterShape _Shape, const int32 _NumMelBands, TArray<float>& _OutValues);
+
+	// Values of New_CalculateFrequencySpectrum at only the given frequencies (Hz), mapped to bins like SV_GetFrequencyValues does it.
+	// A few frequencies run through Goertzel filters instead of the whole FFT. False if there are no samples for the window
+	bool New_CalculateFrequencyValues(USoundWave* _SoundWave, const float _StartTime, const float _Duration, const int32* _Frequencies, const int32 _NumFrequencies, float* _OutValues);
+
+	// Same window and FFT as New_CalculateFrequencySpectrum, but returns log-frequency band values through a cached filterbank instead of the linear bins
+	void New_CalculateBandEnergies(USoundWave* _SoundWave, const float _StartTime, const float _Duration, const ESoundVisBandLayout _Layout, const ESoundVisFilterShape _Shape, const int32 _NumMelBands, TArray<float>& _OutBandEnergies);
+
 	// Old function to calculate the Amplitudes of a song. No new one currently
 	void Old_GetAmplitude(USoundWave* _SoundWave, const bool _bSplitChannels, const float _StartTime, const float _TimeLength, const int32 _AmplitudeBuckets, TArray< TArray<float> >& _OutAmplitudes);
 
 	/// Helper Functions ///
 
-	// Function used to get a better value for the FFT. Uses Hann Window
-	float GetFFTInValue(const int16 _SampleValue, const int16 _SampleIndex, const int16 _SampleCount);
+	// Spectrum of the _NumFrames long window centered at _CenterTime from the sliding STFT. Writes _FFTSize / 2 magnitudes, false if the samples aren't there
+	bool GetSlidingSpectrum(USoundWave* _SoundWave, const int32 _NumFrames, const int32 _FFTSize, const float _CenterTime, float* _OutMagnitudes);
+
+	// Window of the spectrum functions for the given part of the song, picked by FFTSizePolicy. _OutNumFrames frames are read from _OutFirstSample
+	// and zero padded up to _OutFFTSize. _OutCenterTime is the middle of the requested part. False if the part is empty
+	bool GetSpectrumWindow(USoundWave* _SoundWave, const float _StartTime, const float _Duration, int32& _OutFirstSample, int32& _OutNumFrames, int32& _OutFFTSize, float& _OutCenterTime) const;
 
-	// Not working, better not touch! :D
-	//UFUNCTION(BlueprintCallable, Category = "Test SV")
-	//void GetBPMOfSong(USoundWave* _SoundWave, int32 &BMPOfSong);
+	// Function used to get a better value for the FFT. Uses Hann Window. The spectrum functions use the precomputed window tables instead
+	float GetFFTInValue(const int16 _SampleValue, const int32 _SampleIndex, const int32 _SampleCount);
 
 	/// Blueprint Versions of the File Data Functions ///
 
@@ -155,13 +473,52 @@ public:
 	UFUNCTION(BlueprintCallable, Category = "SoundVis | SoundFile")
 		bool SV_LoadAllSoundFileNamesFromHD(const FString _DirectoryPath, const bool _bAbsolutePath, const bool _bFullPath, const FString _FileExtension, TArray<FString>& _SoundFileNames);
 
+	/// Blueprint Versions of the Library Functions ///
+
+	/**
+	* Will start indexing all SoundFiles below a Directory in the background. Only the headers are read (Duration, SampleRate, Channels).
+	* The index is saved, so later scans only read the files that are new or changed. Query it with "SV_QueryLibrary"
+	*
+	* @param	_DirectoryPath	Path to the Directory in which the Files are (absolute/relative)
+	* @param	_bAbsolutePath	Tells if the DirectoryPath is absolute (C:/..) or relative to the GameDirectory
+	* @param	_FileExtension	This is the Extension the Function should look for. For the Plugin it should be ogg
+	*
+	*/
+	UFUNCTION(BlueprintCallable, Category = "SoundVis | Library")
+		void SV_StartLibraryScan(const FString _DirectoryPath, const bool _bAbsolutePath, const FString _FileExtension);
+
+	/**
+	* Will return if the library scan is still running and how far it is
+	*
+	* @param	_NumFiles			Number of matching Files found so far
+	* @param	_NumHeadersRead		Number of new or changed Files whose header is read already
+	* @param	_NumHeadersToRead	Number of new or changed Files. Stays 0 until all Files are found
+	*
+	*/
+	UFUNCTION(BlueprintCallable, Category = "SoundVis | Library")
+		bool SV_GetLibraryScanProgress(int32& _NumFiles, int32& _NumHeadersRead, int32& _NumHeadersToRead);
+
+	/**
+	* Will return the indexed SoundFiles that match the filters. While a scan runs, this is the result of the previous scan
+	*
+	* @param	_NameFilter		Part of the File Name (case insensitive). Empty returns all Files
+	* @param	_MinDuration	Shortest Duration in seconds
+	* @param	_MaxDuration	Longest Duration in seconds. 0 means no limit
+	* @param	_SortBy			Order of the returned Entries
+	* @param	_bDescending	Reverses the order
+	* @param	_Entries		The Array of found Entries, with the full Path in FilePath
+	*
+	*/
+	UFUNCTION(BlueprintCallable, Category = "SoundVis | Library")
+		void SV_QueryLibrary(const FString _NameFilter, const float _MinDuration, const float _MaxDuration, const ESoundVisLibrarySort _SortBy, const bool _bDescending, TArray<FSoundVisLibraryEntry>& _Entries);
+
 	/// Blueprint Versions of the Analyze Functions ///
 
 	/**
 	* Will call the OLD CalculateFrequencySpectrum function from BP Side
 	*
 	* @param	_SoundWave		SoundWave that get's analyzed
-	* @param	_Channel		Channel number, 0 is combining them. Only supports up to 2 channels (stereo)
+	* @param	_Channel		Channel number, 0 is combining them
 	* @param	_StartTime		StartTime that frames the part of the song that you want to analyize
 	* @param	_TimeLength		How long the part is you want to analyze
 	* @param	_SpectrumWidth	In how many parts we want to cut the samples
@@ -177,18 +534,77 @@ public:
 	* @param	_SoundWave		SoundWave that gts analyzed
 	* @param	_StartTime		The StartPoint of the TimeWindow we want to analyze
 	* @param	_Duration		The length of the TimeWindow we want to analyze
-	* @param	_OutFrequencies	Array of float values for x Frequencies from 0 to 22000
+	* @param	_OutFrequencies	Array of float values for x Frequencies from 0 to 22000. Magnitudes, power or dB, see SpectrumOutput
 	* 
 	*/
 
 	UFUNCTION(BlueprintCallable, Category = "SoundVis | Frequency")
 		void SV_New_CalculateFrequencySpectrum(USoundWave* _SoundWave, const float _StartTime, const float _Duration, TArray<float>& _OutFrequencies);
 
+	/**
+	* Will calculate the spectra of many windows in one call, e.g. for a waterfall or a preview of the whole song.
+	* The windows are spread over all cores. Much faster than calling "SV_New_CalculateFrequencySpectrum" in a loop
+	*
+	* @param	_SoundWave		SoundWave that gets analyzed
+	* @param	_StartTimes		StartPoint of every window
+	* @param	_Duration		The length of every window
+	* @param	_Output			If a row holds the linear bins or the filterbank bands
+	* @param	_Layout			Band layout, only used for bands
+	* @param	_Shape			How the frequencies inside a band are weighted, only used for bands
+	* @param	_NumMelBands	Number of bands, only used by the Mel layout
+	* @param	_OutValues		One row after the other, row i belongs to _StartTimes[i]. Rows without decoded samples are 0
+	* @param	_RowLength		Number of values per row. 0 if the song is shorter than the window
+	*
+	*/
+	UFUNCTION(BlueprintCallable, Category = "SoundVis | Frequency")
+		void SV_CalculateFrequencySpectrumBatch(USoundWave* _SoundWave, const TArray<float>& _StartTimes, const float _Duration, const ESoundVisBatchOutput _Output, const ESoundVisBandLayout _Layout, const ESoundVisFilterShape _Shape, const int32 _NumMelBands, TArray<float>& _OutValues, int32& _RowLength);
+
+	/**
+	* Will calculate the spectrum like "SV_New_CalculateFrequencySpectrum", but of a single channel, e.g. for every speaker of a 5.1 or 7.1 song.
+	* Always runs on the decoded samples, the precomputed and the sliding spectrum only hold the combined channels
+	*
+	* @param	_SoundWave		SoundWave that gets analyzed
+	* @param	_Channel		Channel number, 0 is combining them
+	* @param	_StartTime		The StartPoint of the TimeWindow we want to analyze
+	* @param	_Duration		The length of the TimeWindow we want to analyze
+	* @param	_OutFrequencies	Array of float values for x Frequencies from 0 to 22000
+	*
+	*/
+	UFUNCTION(BlueprintCallable, Category = "SoundVis | Frequency")
+		void SV_New_CalculateChannelFrequencySpectrum(USoundWave* _SoundWave, int32 _Channel, const float _StartTime, const float _Duration, TArray<float>& _OutFrequencies);
+
+	/**
+	* Will calculate the spectrum like "SV_New_CalculateFrequencySpectrum", but directly returns log-frequency bands (octave, 1/3 octave or Mel), e.g. for equalizer bars
+	*
+	* @param	_SoundWave			SoundWave that get's analyzed
+	* @param	_StartTime			StartTime that frames the part of the song that you want to analyize
+	* @param	_Duration			How long the part is you want to analyze
+	* @param	_Layout				Band layout
+	* @param	_Shape				How the frequencies inside a band are weighted
+	* @param	_NumMelBands		Number of bands, only used by the Mel layout
+	* @param	_OutBandEnergies	Weighted average magnitude of every band, from low to high
+	*
+	*/
+	UFUNCTION(BlueprintCallable, Category = "SoundVis | Frequency")
+		void SV_CalculateBandEnergies(USoundWave* _SoundWave, const float _StartTime, const float _Duration, const ESoundVisBandLayout _Layout, const ESoundVisFilterShape _Shape, const int32 _NumMelBands, TArray<float>& _OutBandEnergies);
+
+	/**
+	* Will return the center frequency of every band "SV_CalculateBandEnergies" returns, e.g. to label the bars
+	*
+	* @param	_SoundWave				SoundWave that get's analyzed (SampleRate)
+	* @param	_Layout					Band layout
+	* @param	_NumMelBands			Number of bands, only used by the Mel layout
+	* @param	_OutCenterFrequencies	Center frequency of every band in Hz
+	*
+	*/
+	UFUNCTION(BlueprintCallable, Category = "SoundVis | Frequency")
+		void SV_GetBandCenterFrequencies(USoundWave* _SoundWave, const ESoundVisBandLayout _Layout, const int32 _NumMelBands, TArray<float>& _OutCenterFrequencies);
+
 	/**
 	* Will call the OLD GetAmplitude function from BP Side (no new one right now)
 	*
 	* @param	_SoundWave			SoundWave that get's analyzed
-	* @param	_Channel			Channel number, 0 is combining them. Only supports up to 2 channels (stereo)
+	* @param	_Channel			Channel number, 0 is combining them
 	* @param	_StartTime			StartTime that frames the part of the song that you want to analyize
 	* @param	_TimeLength			How long the part is you want to analyze
 	* @param	_AmplitudeBuckets	AmplitudeBuckets
@@ -198,8 +614,206 @@ public:
 	UFUNCTION(BlueprintCallable, Category = "SoundVis | Amplitude")
 		void SV_Old_GetAmplitude(USoundWave* _SoundWave, int32 _Channel, float _StartTime, float _TimeLength, int32 _AmplitudeBuckets, TArray<float>& _OutAmplitudes);
 
+	/// Blueprint Versions of the Envelope Functions ///
+
+	/**
+	* Starts building the waveform envelope of the whole song in the background
+	*
+	* @param	_SoundWave	SoundWave that was loaded with "SV_LoadSoundFileFromHD"
+	*
+	*/
+	UFUNCTION(BlueprintCallable, Category = "SoundVis | Amplitude")
+		bool SV_StartEnvelopeBuild(USoundWave* _SoundWave);
+
+	/**
+	* Tells if the envelope is finished and "SV_GetEnvelope" returns data
+	*
+	*/
+	UFUNCTION(BlueprintPure, Category = "SoundVis | Amplitude")
+		bool SV_IsEnvelopeReady() const;
+
+	/**
+	* Will return min, max and RMS (-1 to 1) of equally long parts of the song, e.g. one per pixel column of a waveform.
+	* Reads a few precomputed blocks per bucket, so it costs the same at every zoom level. Needs a finished envelope
+	*
+	* @param	_SoundWave		SoundWave the envelope was built for
+	* @param	_Channel		Channel number, 0 is combining them
+	* @param	_StartTime		StartTime that frames the part of the song that you want to draw
+	* @param	_TimeLength		How long the part is you want to draw
+	* @param	_Buckets		Number of parts
+	* @param	_OutMin			Lowest sample of every part. Empty if there is no envelope
+	* @param	_OutMax			Highest sample of every part
+	* @param	_OutRMS			RMS of every part
+	*
+	*/
+	UFUNCTION(BlueprintCallable, Category = "SoundVis | Amplitude")
+		void SV_GetEnvelope(USoundWave* _SoundWave, int32 _Channel, float _StartTime, float _TimeLength, int32 _Buckets, TArray<float>& _OutMin, TArray<float>& _OutMax, TArray<float>& _OutRMS);
+
+	/// Blueprint Versions of the Beat Functions ///
+
+	/**
+	* Starts building onsets, tempo and beat grid from the finished spectrogram of the song.
+	* Set "bDetectBeats" before loading to get them without waiting for the spectrogram yourself
+	*
+	* @param	_SoundWave	SoundWave the spectrogram was built for
+	*
+	*/
+	UFUNCTION(BlueprintCallable, Category = "SoundVis | Beats")
+		bool SV_StartBeatDetection(USoundWave* _SoundWave);
+
+	/**
+	* Tells if the beat grid is finished and the beat functions return data
+	*
+	*/
+	UFUNCTION(BlueprintPure, Category = "SoundVis | Beats")
+		bool SV_IsBeatGridReady() const;
+
+	/**
+	* Will return the tempo of the song. Needs a finished beat grid
+	*
+	* @param	_SoundWave		SoundWave the beat grid was built for
+	* @param	_BPM			Beats per minute, 0 if none was found
+	* @param	_Confidence		How periodic the song is at that tempo (0 to 1)
+	*
+	*/
+	UFUNCTION(BlueprintCallable, Category = "SoundVis | Beats")
+		void SV_GetTempo(USoundWave* _SoundWave, float& _BPM, float& _Confidence);
+
+	/**
+	* Will return the first beat after a given time. A binary search, cheap enough to call every tick
+	*
+	* @param	_SoundWave		SoundWave the beat grid was built for
+	* @param	_Time			Time in the song, e.g. the playback position
+	* @param	_BeatTime		Time of the next beat
+	* @param	_Confidence		How strong the onset on that beat is (0 to 1)
+	* @param	_BeatIndex		Index of the beat in the beat grid
+	*
+	*/
+	UFUNCTION(BlueprintCallable, Category = "SoundVis | Beats")
+		bool SV_GetNextBeat(USoundWave* _SoundWave, float _Time, float& _BeatTime, float& _Confidence, int32& _BeatIndex);
+
+	/**
+	* Will return all beats of the song
+	*
+	* @param	_SoundWave		SoundWave the beat grid was built for
+	* @param	_BeatTimes		Sorted beat times. Empty if there is no beat grid
+	* @param	_Confidences	How strong the onset on every beat is (0 to 1)
+	*
+	*/
+	UFUNCTION(BlueprintCallable, Category = "SoundVis | Beats")
+		void SV_GetBeatGrid(USoundWave* _SoundWave, TArray<float>& _BeatTimes, TArray<float>& _Confidences);
+
+	/**
+	* Will return the onsets (starts of notes and hits) after _StartTime up to _EndTime
+	*
+	* @param	_SoundWave		SoundWave the beat grid was built for
+	* @param	_StartTime		Onsets have to be after this time
+	* @param	_EndTime		Onsets can't be after this time
+	* @param	_OnsetTimes		Sorted onset times
+	*
+	*/
+	UFUNCTION(BlueprintCallable, Category = "SoundVis | Beats")
+		void SV_GetOnsetsInRange(USoundWave* _SoundWave, float _StartTime, float _EndTime, TArray<float>& _OnsetTimes);
+
+	/// Blueprint Versions of the Live Functions ///
+
+	/**
+	* Plays the song on an AudioComponent and analyzes the samples the audio device actually renders.
+	* The song is only decoded while it plays, "SV_GetLiveFrequencySpectrum" then always matches what is heard
+	*
+	* @param	_AudioComponent	AudioComponent to play on. Its Sound gets replaced
+	* @param	_SoundWave		SoundWave that was loaded with "SV_LoadSoundFileFromHD" and bMakeSoundWavePlayable or bLiveAnalysisOnly
+	* @param	_StartTime		Time in the song to start playing at
+	*
+	*/
+	UFUNCTION(BlueprintCallable, Category = "SoundVis | Live")
+		bool SV_PlayWithLiveAnalysis(UAudioComponent* _AudioComponent, USoundWave* _SoundWave, float _StartTime);
+
+	/**
+	* Stops analyzing the playing song. Stop the AudioComponent to stop the song itself
+	*
+	*/
+	UFUNCTION(BlueprintCallable, Category = "SoundVis | Live")
+		void SV_StopLiveAnalysis();
+
+	/**
+	* Will return the newest spectrum of the playing song, in the same format as "SV_New_CalculateFrequencySpectrum"
+	*
+	* @param	_OutFrequencies	Magnitudes from 0 to SampleRate / 2. Empty if there is no spectrum yet
+	* @param	_Time			Time in the song at the center of the spectrum
+	*
+	*/
+	UFUNCTION(BlueprintCallable, Category = "SoundVis | Live")
+		bool SV_GetLiveFrequencySpectrum(TArray<float>& _OutFrequencies, float& _Time);
+
+	/**
+	* Will return the time in the playing song that is heard right now, e.g. for "SV_GetNextBeat"
+	*
+	*/
+	UFUNCTION(BlueprintPure, Category = "SoundVis | Live")
+		float SV_GetLivePlaybackTime() const;
+
+	/// Blueprint Versions of the Spectrogram Functions ///
+
+	/**
+	* Starts computing the spectrum of the whole song in the background, using the Spectrogram settings.
+	* Afterwards "SV_New_CalculateFrequencySpectrum" calls with the same window length are served from it
+	*
+	* @param	_SoundWave	SoundWave that was loaded with "SV_LoadSoundFileFromHD"
+	*
+	*/
+	UFUNCTION(BlueprintCallable, Category = "SoundVis | Spectrogram")
+		bool SV_StartSpectrogramPrecompute(USoundWave* _SoundWave);
+
+	/**
+	* Tells if the precomputed spectrogram is finished and used by the spectrum queries
+	*
+	*/
+	UFUNCTION(BlueprintPure, Category = "SoundVis | Spectrogram")
+		bool SV_IsSpectrogramReady() const;
+
+	/**
+	* Will return the energies of the fixed bands (SubBass, Bass, LowMids, Mids, HighMids, Presence, Brilliance) and the RMS at a given time.
+	* Needs a finished spectrogram (precomputed or loaded from the analysis cache)
+	*
+	* @param	_SoundWave			SoundWave the spectrogram was built for
+	* @param	_Time				Time in the song (center of the analyzed window)
+	* @param	_OutBandEnergies	Average magnitude of every band. Empty if there is no spectrogram
+	* @param	_RMS				RMS of the samples around _Time
+	*
+	*/
+	UFUNCTION(BlueprintCallable, Category = "SoundVis | Spectrogram")
+		void SV_GetPrecomputedBandEnergies(USoundWave* _SoundWave, float _Time, TArray<float>& _OutBandEnergies, float& _RMS);
+
 	/// Frequency Data Functions ///
 
+	/**
+	* This function will return the same values as "SV_GetFrequencyValues", but calculates them straight from the song.
+	* Only these frequencies are analyzed, which is a lot cheaper than the whole spectrum
+	*
+	* @param	_SoundWave		SoundWave that gets analyzed
+	* @param	_StartTime		The StartPoint of the TimeWindow we want to analyze
+	* @param	_Duration		The length of the TimeWindow we want to analyze
+	* @param	F16 to F16000	Different values for the named fequencies (Hz)
+	*
+	*/
+	UFUNCTION(BlueprintCallable, Category = "SoundVis | Frequency Values")
+		void SV_CalculateFrequencyValues(USoundWave* _SoundWave, const float _StartTime, const float _Duration, float& F16, float& F32, float& F64, float& F128, float& F256, float& F512, float& F1000, float& F2000, float& F4000, float& F8000, float& F16000);
+
+	/**
+	* This function will return the values of a few frequencies like "SV_GetSpecificFrequencyValue", but calculates them straight from the song.
+	* Up to about a dozen frequencies are cheaper than the whole spectrum, above that it falls back to the FFT by itself
+	*
+	* @param	_SoundWave			SoundWave that gets analyzed
+	* @param	_StartTime			The StartPoint of the TimeWindow we want to analyze
+	* @param	_Duration			The length of the TimeWindow we want to analyze
+	* @param	_WantedFrequencies	Frequencies (Hz) to analyze
+	* @param	_OutValues			Value of every wanted frequency. Empty if there are no samples for the window
+	*
+	*/
+	UFUNCTION(BlueprintCallable, Category = "SoundVis | Frequency Values")
+		void SV_CalculateSpecificFrequencyValues(USoundWave* _SoundWave, const float _StartTime, const float _Duration, const TArray<int32>& _WantedFrequencies, TArray<float>& _OutValues);
+
 	/**
 	* This function will return all values for the most common frequencies. It's needs a Frequency Array from the "BP_New_CalculateFrequencySpectrum" function and the matching SoundWave
 	*
@@ -209,7 +823,7 @@ public:
 	*
 	*/
 	UFUNCTION(BlueprintCallable, Category = "SoundVis | Frequency Values")
-		void SV_GetFrequencyValues(USoundWave* _SoundWave, TArray<float> _Frequencies, float& F16, float& F32, float& F64, float& F128, float& F256, float& F512, float& F1000, float& F2000, float& F4000, float& F8000, float& F16000);
+		void SV_GetFrequencyValues(USoundWave* _SoundWave, const TArray<float>& _Frequencies, float& F16, float& F32, float& F64, float& F128, float& F256, float& F512, float& F1000, float& F2000, float& F4000, float& F8000, float& F16000);
 
 	/**
 	* This function will return the value of a specific frequency. It's needs a Frequency Array from the "BP_New_CalculateFrequencySpectrum" function and the matching SoundWave
@@ -220,7 +834,7 @@ public:
 	*
 	*/
 	UFUNCTION(BlueprintCallable, Category = "SoundVis | Frequency Values")
-		void SV_GetSpecificFrequencyValue(USoundWave* _SoundWave, TArray<float> _Frequencies, int32 _WantedFrequency, float& _FrequencyValue);
+		void SV_GetSpecificFrequencyValue(USoundWave* _SoundWave, const TArray<float>& _Frequencies, int32 _WantedFrequency, float& _FrequencyValue);
 
 	/**
 	* This function will return the average value for SubBass (20 to 60hz)
@@ -231,7 +845,7 @@ public:
 	*
 	*/
 	UFUNCTION(BlueprintCallable, Category = "SoundVis | Frequency Values")
-		void SV_GetAverageSubBassValue(USoundWave* _SoundWave, TArray<float> _Frequencies, float& _AverageSubBass);
+		void SV_GetAverageSubBassValue(USoundWave* _SoundWave, const TArray<float>& _Frequencies, float& _AverageSubBass);
 
 	/**
 	* This function will return the average value for Bass (60 to 250hz)
@@ -242,7 +856,7 @@ public:
 	*
 	*/
 	UFUNCTION(BlueprintCallable, Category = "SoundVis | Frequency Values")
-		void SV_GetAverageBassValue(USoundWave* _SoundWave, TArray<float> _Frequencies, float& _AverageBass);
+		void SV_GetAverageBassValue(USoundWave* _SoundWave, const TArray<float>& _Frequencies, float& _AverageBass);
 
 	/**
 	* This function will return the average value for a given frequency interval e.g.: 20 to 60 (SubBass)
@@ -255,6 +869,90 @@ public:
 	*
 	*/
 	UFUNCTION(BlueprintCallable, Category = "SoundVis | Frequency Values")
-		void SV_GetAverageFrequencyValueInRange(USoundWave* _SoundWave, TArray<float> _Frequencies, int32 _StartFrequence, int32 _EndFrequence, float& _AverageFrequency);
+		void SV_GetAverageFrequencyValueInRange(USoundWave* _SoundWave, const TArray<float>& _Frequencies, int32 _StartFrequence, int32 _EndFrequence, float& _AverageFrequency);
+
+	/**
+	* This function will return the average values of many frequency bands in one call, e.g. for the bars of an equalizer.
+	* Every band costs the same, no matter how wide it is
+	*
+	* @param	_SoundWave			SoundWave to get specific data from (SampleRate)
+	* @param	_Frequencies		Array of float values for different frequencies from 0 to 22000. Can be get by using the "BP_New_CalculateFrequencySpectrum" function
+	* @param	_BandEdges			Frequencies between the bands, ascending. N + 1 edges give N bands, e.g. 20, 60, 250 gives SubBass and Bass
+	* @param	_OutBandValues		Average value of every band, the same as "SV_GetAverageFrequencyValueInRange" from one edge to the next
+	*
+	*/
+	UFUNCTION(BlueprintCallable, Category = "SoundVis | Frequency Values")
+		void SV_GetAverageFrequencyValuesInBands(USoundWave* _SoundWave, const TArray<float>& _Frequencies, const TArray<float>& _BandEdges, TArray<float>& _OutBandValues);
+
+	/**
+	* This function will prepare a spectrum for band queries. Keep the frame while the spectrum doesn't change and query it with "SV_GetSpectrumFrameAverage" or "SV_GetSpectrumFrameBandValues"
+	*
+	* @param	_SoundWave		SoundWave to get specific data from (SampleRate)
+	* @param	_Frequencies	Array of float values for different frequencies from 0 to 22000. Can be get by using the "BP_New_CalculateFrequencySpectrum" function
+	* @param	_OutFrame		The prepared spectrum
+	*
+	*/
+	UFUNCTION(BlueprintCallable, Category = "SoundVis | Frequency Values")
+		void SV_MakeSpectrumFrame(USoundWave* _SoundWave, const TArray<float>& _Frequencies, FSoundVisSpectrumFrame& _OutFrame);
+
+	/**
+	* This function will return the average value of a frequency interval of a prepared spectrum
+	*
+	* @param	_Frame				Spectrum prepared with "SV_MakeSpectrumFrame"
+	* @param	_StartFrequency		Start Frequency of the Frequency interval
+	* @param	_EndFrequency		End Frequency of the Frequency interval
+	* @param	_AverageFrequency	Average value of the requested frequency interval
+	*
+	*/
+	UFUNCTION(BlueprintCallable, Category = "SoundVis | Frequency Values")
+		void SV_GetSpectrumFrameAverage(const FSoundVisSpectrumFrame& _Frame, float _StartFrequency, float _EndFrequency, float& _AverageFrequency);
+
+	/**
+	* This function will return the average values of many frequency bands of a prepared spectrum
+	*
+	* @param	_Frame				Spectrum prepared with "SV_MakeSpectrumFrame"
+	* @param	_BandEdges			Frequencies between the bands, ascending. N + 1 edges give N bands
+	* @param	_OutBandValues		Average value of every band
+	*
+	*/
+	UFUNCTION(BlueprintCallable, Category = "SoundVis | Frequency Values")
+		void SV_GetSpectrumFrameBandValues(const FSoundVisSpectrumFrame& _Frame, const TArray<float>& _BandEdges, TArray<float>& _OutBandValues);
+
+	/// Debug Functions ///
+
+	/**
+	* This function will return how many megabytes of sound files were copied and memory mapped while loading (summed over all SoundVisualization objects).
+	* Only the copy into the SoundWave (bMakeSoundWavePlayable) and platforms that can't map files should show up as copied
+	*
+	* @param	_CopiedMB		Megabytes copied
+	* @param	_MappedMB		Megabytes memory mapped
+	* @param	_bResetCounters	Sets both counters back to 0 after reading them
+	*
+	*/
+	UFUNCTION(BlueprintCallable, Category = "SoundVis | Debug")
+		void SV_GetLoadCopyCounts(float& _CopiedMB, float& _MappedMB, const bool _bResetCounters = false);
+
+	/**
+	* This function will return how often the FFT plans and scratch buffers had to be allocated (summed over all SoundVisualization objects).
+	* Once every window size was used once, these numbers should stop growing
+	*
+	* @param	_PlanAllocations	Number of kiss_fft plans that were created
+	* @param	_BufferAllocations	Number of scratch buffers that were (re)allocated
+	* @param	_bResetCounters		Sets both counters back to 0 after reading them
+	*
+	*/
+	UFUNCTION(BlueprintCallable, Category = "SoundVis | Debug")
+		void SV_GetFFTAllocationCounts(int32& _PlanAllocations, int32& _BufferAllocations, const bool _bResetCounters = false);
+
+	/**
+	* This function will return how many FFTs the sliding spectrum ran (summed over all SoundVisualization objects).
+	* Compare it to the number of spectrum queries to see how many were served from cached frames
+	*
+	* @param	_ComputedFrames		Number of frames that were computed
+	* @param	_bResetCounters		Sets the counter back to 0 after reading it
+	*
+	*/
+	UFUNCTION(BlueprintCallable, Category = "SoundVis | Debug")
+		void SV_GetSlidingSpectrumCounts(int32& _ComputedFrames, const bool _bResetCounters = false);
 
 };
\ No newline at end of file
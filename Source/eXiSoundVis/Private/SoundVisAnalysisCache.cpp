@@ -0,0 +1,596 @@
+// Copyright 1998-2015 Epic Games, Inc. All Rights Reserved.
+
+#include "eXiSoundVisPrivatePCH.h"
+#include "SoundVisAnalysisCache.h"
+#include "SoundVisSpectrogram.h"
+#include "SoundVisEnvelope.h"
+
+#if PLATFORM_WINDOWS
+	#include "AllowWindowsPlatformTypes.h"
+	#include <windows.h>
+	#include "HideWindowsPlatformTypes.h"
+	#define SOUNDVIS_MMAP_WINDOWS 1
+	#define SOUNDVIS_MMAP_POSIX 0
+#elif PLATFORM_MAC || PLATFORM_LINUX || PLATFORM_ANDROID || PLATFORM_IOS
+	#include <sys/mman.h>
+	#include <sys/stat.h>
+	#include <fcntl.h>
+	#include <unistd.h>
+	#define SOUNDVIS_MMAP_WINDOWS 0
+	#define SOUNDVIS_MMAP_POSIX 1
+#else
+	#define SOUNDVIS_MMAP_WINDOWS 0
+	#define SOUNDVIS_MMAP_POSIX 0
+#endif
+
+DECLARE_CYCLE_STAT(TEXT("Open Analysis Cache"), STAT_SoundVisCacheOpen, STATGROUP_SoundVis);
+DECLARE_CYCLE_STAT(TEXT("Write Analysis Cache"), STAT_SoundVisCacheWrite, STATGROUP_SoundVis);
+
+// Changes whenever the analysis itself gives other results, so old entries don't get used anymore
+static const uint32 SoundVisAnalysisVersion = 2;
+
+// On-disk header of a cache entry. Everything is stored little endian, offsets are from the start of the file
+struct FSoundVisCacheHeader
+{
+	uint32 Magic;
+	uint32 Version;
+
+	uint8 ContentHash[20];
+	uint32 ParamsHash;
+
+	FSoundVisCacheMetadata Metadata;
+
+	int32 FFTSize;
+	int32 HopSize;
+	int32 NumFrames;
+	int32 NumBands;
+
+	uint64 FramesOffset;
+	uint64 FrameRMSOffset;
+	uint64 BandEnergiesOffset;
+	uint64 FluxOffset;
+
+	// Frames of the envelope, 0 if the entry has none. Level 0 has DivideAndRoundUp(EnvelopeFrames, BaseBlockFrames) blocks per channel
+	int32 EnvelopeFrames;
+
+	uint64 EnvelopeMinOffset;
+	uint64 EnvelopeMaxOffset;
+	uint64 EnvelopeSumSquaresOffset;
+
+	// Bytes after the (aligned) header
+	uint64 PayloadSize;
+
+	// CRC of every block, without its padding
+	uint32 FramesCrc;
+	uint32 FrameRMSCrc;
+	uint32 BandEnergiesCrc;
+	uint32 FluxCrc;
+	uint32 EnvelopeMinCrc;
+	uint32 EnvelopeMaxCrc;
+	uint32 EnvelopeSumSquaresCrc;
+};
+
+// Every block of the file starts 16 byte aligned
+static const uint64 SoundVisCacheAlignment = 16;
+static const uint64 SoundVisCacheHeaderSize = (sizeof(FSoundVisCacheHeader) + SoundVisCacheAlignment - 1) & ~(SoundVisCacheAlignment - 1);
+
+// Bytes the CRC and the writer take in one go. FCrc::MemCrc32 only takes int32 lengths, and the frame check looks for a cancel in between
+static const uint64 SoundVisCacheChunkSize = 16 * 1024 * 1024;
+
+static uint32 SoundVisCacheCrc(const void* _Data, uint64 _Size, const FThreadSafeBool* _bCancel = NULL)
+{
+	const uint8* Data = (const uint8*)_Data;
+
+	uint32 Crc = 0;
+
+	for (uint64 Offset = 0; Offset < _Size && !(_bCancel && *_bCancel); Offset += SoundVisCacheChunkSize)
+	{
+		Crc = FCrc::MemCrc32(Data + Offset, (int32)FMath::Min(SoundVisCacheChunkSize, _Size - Offset), Crc);
+	}
+
+	return Crc;
+}
+
+// Writes one block and the zeros up to the next aligned offset
+static void SoundVisCacheWriteBlock(FArchive& _Writer, const void* _Data, uint64 _Size)
+{
+	const uint8* Data = (const uint8*)_Data;
+
+	for (uint64 Offset = 0; Offset < _Size && !_Writer.IsError(); Offset += SoundVisCacheChunkSize)
+	{
+		_Writer.Serialize(const_cast<uint8*>(Data + Offset), FMath::Min(SoundVisCacheChunkSize, _Size - Offset));
+	}
+
+	uint8 Padding[SoundVisCacheAlignment] = { 0 };
+
+	_Writer.Serialize(Padding, Align(_Size, SoundVisCacheAlignment) - _Size);
+}
+
+
+/// Cache Key ///
+
+FSoundVisCacheKey::FSoundVisCacheKey()
+	: ParamsHash(0)
+{
+	FMemory::Memzero(ContentHash, sizeof(ContentHash));
+}
+
+FSoundVisCacheKey FSoundVisCacheKey::Make(const uint8* _FileData, int64 _FileSize, float _WindowDuration, float _HopDuration, ESoundVisWindowType _WindowType, bool _bFixedPoint)
+{
+	FSoundVisCacheKey Key;
+
+	FSHA1::HashBuffer(_FileData, _FileSize, Key.ContentHash);
+
+	struct
+	{
+		uint32 AnalysisVersion;
+		float WindowDuration;
+		float HopDuration;
+		uint32 WindowType;
+		uint32 FixedPoint;
+	} Params = { SoundVisAnalysisVersion, _WindowDuration, _HopDuration, (uint32)_WindowType, _bFixedPoint ? 1u : 0u };
+
+	Key.ParamsHash = FCrc::MemCrc32(&Params, sizeof(Params));
+
+	return Key;
+}
+
+FString FSoundVisCacheKey::ToString() const
+{
+	return BytesToHex(ContentHash, sizeof(ContentHash)) + FString::Printf(TEXT("_%08X"), ParamsHash);
+}
+
+FSoundVisCacheMetadata::FSoundVisCacheMetadata()
+	: NumChannels(0)
+	, SampleRate(0)
+	, Duration(0.0f)
+	, RawPCMDataSize(0)
+{
+}
+
+
+/// Mapped File ///
+
+FSoundVisMappedFile::FSoundVisMappedFile()
+	: Data(NULL)
+	, Size(0)
+	, FileHandle(NULL)
+	, MappingHandle(NULL)
+{
+}
+
+FSoundVisMappedFile::~FSoundVisMappedFile()
+{
+	Close();
+}
+
+bool FSoundVisMappedFile::Open(const FString& _FilePath)
+{
+	Close();
+
+	const FString FullPath = FPaths::ConvertRelativePathToFull(_FilePath);
+
+#if SOUNDVIS_MMAP_WINDOWS
+	HANDLE File = CreateFileW(*FullPath, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+
+	if (File == INVALID_HANDLE_VALUE)
+	{
+		return false;
+	}
+
+	LARGE_INTEGER FileSize;
+
+	if (!GetFileSizeEx(File, &FileSize) || FileSize.QuadPart <= 0)
+	{
+		CloseHandle(File);
+		return false;
+	}
+
+	HANDLE Mapping = CreateFileMappingW(File, NULL, PAGE_READONLY, 0, 0, NULL);
+	const void* View = Mapping ? MapViewOfFile(Mapping, FILE_MAP_READ, 0, 0, 0) : NULL;
+
+	if (!View)
+	{
+		if (Mapping)
+		{
+			CloseHandle(Mapping);
+		}
+
+		CloseHandle(File);
+		return false;
+	}
+
+	FileHandle = File;
+	MappingHandle = Mapping;
+	Data = (const uint8*)View;
+	Size = FileSize.QuadPart;
+#elif SOUNDVIS_MMAP_POSIX
+	const int32 File = open(TCHAR_TO_UTF8(*FullPath), O_RDONLY);
+
+	if (File < 0)
+	{
+		return false;
+	}
+
+	struct stat FileStat;
+
+	if (fstat(File, &FileStat) != 0 || FileStat.st_size <= 0)
+	{
+		close(File);
+		return false;
+	}
+
+	void* View = mmap(NULL, FileStat.st_size, PROT_READ, MAP_SHARED, File, 0);
+
+	// The mapping stays valid without the descriptor
+	close(File);
+
+	if (View == MAP_FAILED)
+	{
+		return false;
+	}
+
+	MappingHandle = View;
+	Data = (const uint8*)View;
+	Size = FileStat.st_size;
+#else
+	if (!FFileHelper::LoadFileToArray(FallbackData, *FullPath, FILEREAD_Silent) || FallbackData.Num() == 0)
+	{
+		return false;
+	}
+
+	Data = FallbackData.GetData();
+	Size = FallbackData.Num();
+#endif
+
+	return true;
+}
+
+void FSoundVisMappedFile::Close()
+{
+#if SOUNDVIS_MMAP_WINDOWS
+	if (Data)
+	{
+		UnmapViewOfFile(Data);
+	}
+
+	if (MappingHandle)
+	{
+		CloseHandle(MappingHandle);
+	}
+
+	if (FileHandle)
+	{
+		CloseHandle(FileHandle);
+	}
+#elif SOUNDVIS_MMAP_POSIX
+	if (MappingHandle)
+	{
+		munmap(MappingHandle, Size);
+	}
+#endif
+
+	FallbackData.Empty();
+
+	Data = NULL;
+	Size = 0;
+	FileHandle = NULL;
+	MappingHandle = NULL;
+}
+
+
+/// Analysis Cache ///
+
+FSoundVisAnalysisCache::FSoundVisAnalysisCache()
+	: bIsOpen(false)
+	, VerifyTask(NULL)
+	, FFTSize(0)
+	, HopSize(0)
+	, NumFrames(0)
+	, Frames(NULL)
+	, FrameRMS(NULL)
+	, BandEnergies(NULL)
+	, Flux(NULL)
+	, NumFrameBytes(0)
+	, FramesCrc(0)
+	, EnvelopeFrames(0)
+	, EnvelopeMin(NULL)
+	, EnvelopeMax(NULL)
+	, EnvelopeSumSquares(NULL)
+{
+}
+
+FSoundVisAnalysisCache::~FSoundVisAnalysisCache()
+{
+	Close();
+}
+
+FString FSoundVisAnalysisCache::GetCacheDirectory()
+{
+	return FPaths::GameSavedDir() / TEXT("SoundVisCache");
+}
+
+FString FSoundVisAnalysisCache::GetCacheFilePath(const FSoundVisCacheKey& _Key)
+{
+	return GetCacheDirectory() / (_Key.ToString() + TEXT(".svcache"));
+}
+
+bool FSoundVisAnalysisCache::Open(const FSoundVisCacheKey& _Key)
+{
+	SCOPE_CYCLE_COUNTER(STAT_SoundVisCacheOpen);
+
+	Close();
+
+	FilePath = GetCacheFilePath(_Key);
+
+	if (!File.Open(FilePath))
+	{
+		// Simply not analyzed yet
+		return false;
+	}
+
+	const uint8* FileData = File.GetData();
+	const uint64 FileSize = File.GetSize();
+
+	const FSoundVisCacheHeader* Header = (const FSoundVisCacheHeader*)FileData;
+
+	// Every check that fails means the entry can't be used and gets rebuilt
+	const TCHAR* Problem = NULL;
+
+	if (FileSize < SoundVisCacheHeaderSize || Header->Magic != FileMagic)
+	{
+		Problem = TEXT("not a cache file");
+	}
+	else if (Header->Version != FileVersion)
+	{
+		Problem = TEXT("old version");
+	}
+	else if (FMemory::Memcmp(Header->ContentHash, _Key.ContentHash, sizeof(_Key.ContentHash)) != 0 || Header->ParamsHash != _Key.ParamsHash)
+	{
+		Problem = TEXT("key mismatch");
+	}
+	else if (Header->FFTSize < 2 || Header->HopSize <= 0 || Header->NumFrames <= 0 || Header->NumBands != FSoundVisSpectrogram::NumBands || Header->Metadata.SampleRate <= 0
+		|| Header->Metadata.NumChannels <= 0 || Header->EnvelopeFrames < 0)
+	{
+		Problem = TEXT("invalid layout");
+	}
+	else
+	{
+		const uint64 FramesSize = (uint64)Header->NumFrames * (Header->FFTSize / 2) * sizeof(uint8);
+		const uint64 FrameRMSSize = (uint64)Header->NumFrames * sizeof(float);
+		const uint64 BandEnergiesSize = (uint64)Header->NumFrames * FSoundVisSpectrogram::NumBands * sizeof(float);
+		const uint64 FluxSize = (uint64)Header->NumFrames * sizeof(float);
+
+		const uint64 NumEnvelopeValues = (uint64)FMath::DivideAndRoundUp(Header->EnvelopeFrames, FSoundVisEnvelope::BaseBlockFrames) * Header->Metadata.NumChannels;
+		const uint64 EnvelopeMinMaxSize = NumEnvelopeValues * sizeof(int16);
+		const uint64 EnvelopeSumSquaresSize = NumEnvelopeValues * sizeof(float);
+
+		if (SoundVisCacheHeaderSize + Header->PayloadSize != (uint64)FileSize
+			|| Header->FramesOffset % SoundVisCacheAlignment != 0 || Header->FramesOffset + FramesSize > FileSize
+			|| Header->FrameRMSOffset % SoundVisCacheAlignment != 0 || Header->FrameRMSOffset + FrameRMSSize > FileSize
+			|| Header->BandEnergiesOffset % SoundVisCacheAlignment != 0 || Header->BandEnergiesOffset + BandEnergiesSize > FileSize
+			|| Header->FluxOffset % SoundVisCacheAlignment != 0 || Header->FluxOffset + FluxSize > FileSize
+			|| Header->EnvelopeMinOffset % SoundVisCacheAlignment != 0 || Header->EnvelopeMinOffset + EnvelopeMinMaxSize > FileSize
+			|| Header->EnvelopeMaxOffset % SoundVisCacheAlignment != 0 || Header->EnvelopeMaxOffset + EnvelopeMinMaxSize > FileSize
+			|| Header->EnvelopeSumSquaresOffset % SoundVisCacheAlignment != 0 || Header->EnvelopeSumSquaresOffset + EnvelopeSumSquaresSize > FileSize)
+		{
+			Problem = TEXT("truncated");
+		}
+		// The float blocks are small, and a damaged float could be a NaN. The envelope gets copied right away, so it's checked here too.
+		// The frames get checked in the background
+		else if (SoundVisCacheCrc(FileData + Header->FrameRMSOffset, FrameRMSSize) != Header->FrameRMSCrc
+			|| SoundVisCacheCrc(FileData + Header->BandEnergiesOffset, BandEnergiesSize) != Header->BandEnergiesCrc
+			|| SoundVisCacheCrc(FileData + Header->FluxOffset, FluxSize) != Header->FluxCrc
+			|| SoundVisCacheCrc(FileData + Header->EnvelopeMinOffset, EnvelopeMinMaxSize) != Header->EnvelopeMinCrc
+			|| SoundVisCacheCrc(FileData + Header->EnvelopeMaxOffset, EnvelopeMinMaxSize) != Header->EnvelopeMaxCrc
+			|| SoundVisCacheCrc(FileData + Header->EnvelopeSumSquaresOffset, EnvelopeSumSquaresSize) != Header->EnvelopeSumSquaresCrc)
+		{
+			Problem = TEXT("checksum mismatch");
+		}
+	}
+
+	if (Problem)
+	{
+		UE_LOG(LogSoundVisualization, Warning, TEXT("Dropping analysis cache entry %s (%s)"), *FilePath, Problem);
+
+		File.Close();
+
+		IFileManager::Get().Delete(*FilePath, false, false, true);
+
+		return false;
+	}
+
+	Metadata = Header->Metadata;
+
+	FFTSize = Header->FFTSize;
+	HopSize = Header->HopSize;
+	NumFrames = Header->NumFrames;
+
+	Frames = FileData + Header->FramesOffset;
+	FrameRMS = (const float*)(FileData + Header->FrameRMSOffset);
+	BandEnergies = (const float*)(FileData + Header->BandEnergiesOffset);
+	Flux = (const float*)(FileData + Header->FluxOffset);
+	NumFrameBytes = (uint64)NumFrames * (FFTSize / 2);
+	FramesCrc = Header->FramesCrc;
+
+	EnvelopeFrames = Header->EnvelopeFrames;
+	EnvelopeMin = (const int16*)(FileData + Header->EnvelopeMinOffset);
+	EnvelopeMax = (const int16*)(FileData + Header->EnvelopeMaxOffset);
+	EnvelopeSumSquares = (const float*)(FileData + Header->EnvelopeSumSquaresOffset);
+
+	bIsOpen = true;
+
+	bCancelVerify = false;
+	bFramesDamaged = false;
+
+	VerifyTask = new FAsyncTask<FSoundVisCacheVerifyTask>(this);
+	VerifyTask->StartBackgroundTask();
+
+	return true;
+}
+
+void FSoundVisAnalysisCache::Close()
+{
+	if (VerifyTask)
+	{
+		bCancelVerify = true;
+
+		VerifyTask->EnsureCompletion();
+
+		delete VerifyTask;
+		VerifyTask = NULL;
+	}
+
+	File.Close();
+
+	// Only now, a mapped file can't be deleted on every platform
+	if (bIsOpen && bFramesDamaged)
+	{
+		UE_LOG(LogSoundVisualization, Warning, TEXT("Dropping analysis cache entry %s (checksum mismatch)"), *FilePath);
+
+		IFileManager::Get().Delete(*FilePath, false, false, true);
+	}
+
+	bIsOpen = false;
+	bFramesDamaged = false;
+
+	Frames = NULL;
+	FrameRMS = NULL;
+	BandEnergies = NULL;
+	Flux = NULL;
+
+	EnvelopeFrames = 0;
+	EnvelopeMin = NULL;
+	EnvelopeMax = NULL;
+	EnvelopeSumSquares = NULL;
+}
+
+void FSoundVisAnalysisCache::InitSpectrogram(FSoundVisSpectrogram& _Spectrogram) const
+{
+	check(bIsOpen);
+
+	_Spectrogram.InitFromMemory(Frames, FrameRMS, BandEnergies, Flux, NumFrames, Metadata.SampleRate, FFTSize, HopSize);
+}
+
+void FSoundVisAnalysisCache::InitEnvelope(FSoundVisEnvelope& _Envelope) const
+{
+	check(bIsOpen && HasEnvelope());
+
+	_Envelope.InitFromBaseLevel(EnvelopeMin, EnvelopeMax, EnvelopeSumSquares, Metadata.NumChannels, EnvelopeFrames, Metadata.SampleRate);
+}
+
+void FSoundVisAnalysisCache::VerifyFrames()
+{
+	const uint32 Crc = SoundVisCacheCrc(Frames, NumFrameBytes, &bCancelVerify);
+
+	if (!bCancelVerify && Crc != FramesCrc)
+	{
+		bFramesDamaged = true;
+	}
+}
+
+bool FSoundVisAnalysisCache::Write(const FSoundVisCacheKey& _Key, const FSoundVisCacheMetadata& _Metadata, const FSoundVisSpectrogram& _Spectrogram, const FSoundVisEnvelope* _Envelope)
+{
+	SCOPE_CYCLE_COUNTER(STAT_SoundVisCacheWrite);
+
+	if (!_Spectrogram.HasFrames())
+	{
+		return false;
+	}
+
+	const uint64 FramesSize = (uint64)_Spectrogram.GetNumFrames() * _Spectrogram.GetNumBins() * sizeof(uint8);
+	const uint64 FrameRMSSize = (uint64)_Spectrogram.GetNumFrames() * sizeof(float);
+	const uint64 BandEnergiesSize = (uint64)_Spectrogram.GetNumFrames() * FSoundVisSpectrogram::NumBands * sizeof(float);
+	const uint64 FluxSize = (uint64)_Spectrogram.GetNumFrames() * sizeof(float);
+
+	// Only an envelope of the whole song with the channels of the metadata can be set up from the entry again
+	const bool bWriteEnvelope = _Envelope && _Envelope->IsReady() && _Envelope->GetNumChannels() == _Metadata.NumChannels;
+
+	const uint64 NumEnvelopeValues = bWriteEnvelope ? (uint64)_Envelope->GetNumBaseBlocks() * _Envelope->GetNumChannels() : 0;
+	const uint64 EnvelopeMinMaxSize = NumEnvelopeValues * sizeof(int16);
+	const uint64 EnvelopeSumSquaresSize = NumEnvelopeValues * sizeof(float);
+
+	const int16* EnvelopeMin = bWriteEnvelope ? _Envelope->GetBaseMin() : NULL;
+	const int16* EnvelopeMax = bWriteEnvelope ? _Envelope->GetBaseMax() : NULL;
+	const float* EnvelopeSumSquares = bWriteEnvelope ? _Envelope->GetBaseSumSquares() : NULL;
+
+	FSoundVisCacheHeader Header;
+	FMemory::Memzero(&Header, sizeof(Header));
+
+	Header.Magic = FileMagic;
+	Header.Version = FileVersion;
+	FMemory::Memcpy(Header.ContentHash, _Key.ContentHash, sizeof(Header.ContentHash));
+	Header.ParamsHash = _Key.ParamsHash;
+	Header.Metadata = _Metadata;
+	Header.FFTSize = _Spectrogram.GetFFTSize();
+	Header.HopSize = _Spectrogram.GetHopSize();
+	Header.NumFrames = _Spectrogram.GetNumFrames();
+	Header.NumBands = FSoundVisSpectrogram::NumBands;
+	Header.FramesOffset = SoundVisCacheHeaderSize;
+	Header.FrameRMSOffset = Header.FramesOffset + Align(FramesSize, 16);
+	Header.BandEnergiesOffset = Header.FrameRMSOffset + Align(FrameRMSSize, 16);
+	Header.FluxOffset = Header.BandEnergiesOffset + Align(BandEnergiesSize, 16);
+	Header.EnvelopeFrames = bWriteEnvelope ? _Envelope->GetNumFrames() : 0;
+	Header.EnvelopeMinOffset = Header.FluxOffset + Align(FluxSize, 16);
+	Header.EnvelopeMaxOffset = Header.EnvelopeMinOffset + Align(EnvelopeMinMaxSize, 16);
+	Header.EnvelopeSumSquaresOffset = Header.EnvelopeMaxOffset + Align(EnvelopeMinMaxSize, 16);
+	Header.PayloadSize = Header.EnvelopeSumSquaresOffset + Align(EnvelopeSumSquaresSize, 16) - SoundVisCacheHeaderSize;
+	Header.FramesCrc = SoundVisCacheCrc(_Spectrogram.GetFrameData(), FramesSize);
+	Header.FrameRMSCrc = SoundVisCacheCrc(_Spectrogram.GetFrameRMSData(), FrameRMSSize);
+	Header.BandEnergiesCrc = SoundVisCacheCrc(_Spectrogram.GetBandEnergyData(), BandEnergiesSize);
+	Header.FluxCrc = SoundVisCacheCrc(_Spectrogram.GetFluxData(), FluxSize);
+	Header.EnvelopeMinCrc = SoundVisCacheCrc(EnvelopeMin, EnvelopeMinMaxSize);
+	Header.EnvelopeMaxCrc = SoundVisCacheCrc(EnvelopeMax, EnvelopeMinMaxSize);
+	Header.EnvelopeSumSquaresCrc = SoundVisCacheCrc(EnvelopeSumSquares, EnvelopeSumSquaresSize);
+
+	const FString EntryPath = GetCacheFilePath(_Key);
+	const FString TempFilePath = EntryPath + TEXT(".tmp");
+
+	FArchive* Writer = IFileManager::Get().CreateFileWriter(*TempFilePath);
+
+	if (!Writer)
+	{
+		return false;
+	}
+
+	uint8 HeaderBlock[SoundVisCacheHeaderSize] = { 0 };
+	FMemory::Memcpy(HeaderBlock, &Header, sizeof(Header));
+
+	Writer->Serialize(HeaderBlock, SoundVisCacheHeaderSize);
+
+	SoundVisCacheWriteBlock(*Writer, _Spectrogram.GetFrameData(), FramesSize);
+	SoundVisCacheWriteBlock(*Writer, _Spectrogram.GetFrameRMSData(), FrameRMSSize);
+	SoundVisCacheWriteBlock(*Writer, _Spectrogram.GetBandEnergyData(), BandEnergiesSize);
+	SoundVisCacheWriteBlock(*Writer, _Spectrogram.GetFluxData(), FluxSize);
+	SoundVisCacheWriteBlock(*Writer, EnvelopeMin, EnvelopeMinMaxSize);
+	SoundVisCacheWriteBlock(*Writer, EnvelopeMax, EnvelopeMinMaxSize);
+	SoundVisCacheWriteBlock(*Writer, EnvelopeSumSquares, EnvelopeSumSquaresSize);
+
+	const bool bWriteFailed = Writer->IsError();
+
+	delete Writer;
+
+	if (bWriteFailed || !IFileManager::Get().Move(*EntryPath, *TempFilePath, true, true))
+	{
+		IFileManager::Get().Delete(*TempFilePath, false, false, true);
+
+		UE_LOG(LogSoundVisualization, Warning, TEXT("Couldn't write analysis cache entry %s"), *EntryPath);
+
+		return false;
+	}
+
+	return true;
+}
+
+
+/// Verify Task ///
+
+FSoundVisCacheVerifyTask::FSoundVisCacheVerifyTask(FSoundVisAnalysisCache* _Cache)
+	: Cache(_Cache)
+{
+}
+
+void FSoundVisCacheVerifyTask::DoWork()
+{
+	Cache->VerifyFrames();
+}
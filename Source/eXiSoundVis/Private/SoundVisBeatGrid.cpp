@@ -0,0 +1,458 @@
+// Copyright 1998-2015 Epic Games, Inc. All Rights Reserved.
+
+#include "eXiSoundVisPrivatePCH.h"
+#include "SoundVisualization.h"
+#include "SoundVisBeatGrid.h"
+#include "SoundVisSpectrogram.h"
+
+DECLARE_CYCLE_STAT(TEXT("Build Beat Grid"), STAT_SoundVisBeatGridBuild, STATGROUP_SoundVis);
+
+// Length (seconds) of the window around every frame whose mean flux gets removed
+static const float BeatGridLocalMeanSeconds = 0.15f;
+
+// Tempo the autocorrelation prefers, and how fast the preference falls off (standard deviation in octaves)
+static const float BeatGridPreferredTempo = 120.0f;
+static const float BeatGridTempoOctaves = 1.0f;
+
+// How hard the beat tracker holds on to the tempo. Higher values follow the onsets less
+static const float BeatGridTightness = 100.0f;
+
+// Minimum onset strength (in standard deviations), and how far (seconds) around an onset nothing may be stronger
+static const float BeatGridOnsetThreshold = 1.0f;
+static const float BeatGridOnsetPeakSeconds = 0.03f;
+
+const float FSoundVisBeatGrid::MinTempo = 60.0f;
+const float FSoundVisBeatGrid::MaxTempo = 200.0f;
+
+/// De-/Constructurs ///
+
+FSoundVisBeatGrid::FSoundVisBeatGrid()
+	: Tempo(0.0f)
+	, TempoConfidence(0.0f)
+{
+}
+
+
+/// Building ///
+
+void FSoundVisBeatGrid::Build(const FSoundVisSpectrogram& _Spectrogram)
+{
+	SCOPE_CYCLE_COUNTER(STAT_SoundVisBeatGridBuild);
+
+	bIsReady = false;
+
+	if (!_Spectrogram.IsReady() || _Spectrogram.GetNumFrames() < 2 || bCancelRequested)
+	{
+		return;
+	}
+
+	const int32 HopSize = _Spectrogram.GetHopSize();
+	const int32 SampleRate = _Spectrogram.GetSampleRate();
+
+	const float SecondsPerFrame = (float)HopSize / SampleRate;
+
+	// Frame N covers the samples N * HopSize to N * HopSize + FFTSize, its time is the middle of them
+	const float FirstFrameTime = _Spectrogram.GetFFTSize() * 0.5f / SampleRate;
+
+	TArray<float> Strength;
+
+	if (!CalculateOnsetStrength(_Spectrogram, Strength))
+	{
+		return;
+	}
+
+	const int32 NumFrames = Strength.Num();
+
+	// Onsets are the peaks of the strength that stand out from their neighbourhood
+	OnsetTimes.Reset();
+
+	const int32 PeakRadius = FMath::Max(1, FMath::RoundToInt(BeatGridOnsetPeakSeconds / SecondsPerFrame));
+
+	for (int32 FrameIndex = 0; FrameIndex < NumFrames; ++FrameIndex)
+	{
+		const float Value = Strength[FrameIndex];
+
+		if (Value < BeatGridOnsetThreshold)
+		{
+			continue;
+		}
+
+		bool bIsPeak = true;
+
+		// On a plateau only the first frame counts
+		for (int32 OtherIndex = FMath::Max(0, FrameIndex - PeakRadius); OtherIndex <= FMath::Min(NumFrames - 1, FrameIndex + PeakRadius) && bIsPeak; ++OtherIndex)
+		{
+			bIsPeak = OtherIndex < FrameIndex ? Strength[OtherIndex] < Value : Strength[OtherIndex] <= Value;
+		}
+
+		if (bIsPeak)
+		{
+			OnsetTimes.Add(FirstFrameTime + FrameIndex * SecondsPerFrame);
+		}
+	}
+
+	const float Period = EstimatePeriod(Strength, SecondsPerFrame, TempoConfidence);
+
+	BeatTimes.Reset();
+	BeatConfidences.Reset();
+
+	if (Period <= 0.0f)
+	{
+		Tempo = 0.0f;
+		TempoConfidence = 0.0f;
+
+		bIsReady = !bCancelRequested;
+
+		return;
+	}
+
+	Tempo = 60.0f / (Period * SecondsPerFrame);
+
+	TArray<int32> BeatFrames;
+
+	if (!TrackBeats(Strength, Period, BeatFrames))
+	{
+		return;
+	}
+
+	BeatTimes.Reserve(BeatFrames.Num());
+	BeatConfidences.Reserve(BeatFrames.Num());
+
+	for (int32 FrameIndex : BeatFrames)
+	{
+		BeatTimes.Add(FirstFrameTime + FrameIndex * SecondsPerFrame);
+
+		// Strength is in standard deviations, one of them is a confidence of 0.63, three are 0.95
+		BeatConfidences.Add(1.0f - FMath::Exp(-Strength[FrameIndex]));
+	}
+
+	bIsReady = !bCancelRequested;
+}
+
+bool FSoundVisBeatGrid::CalculateOnsetStrength(const FSoundVisSpectrogram& _Spectrogram, TArray<float>& _OutStrength)
+{
+	const int32 NumFrames = _Spectrogram.GetNumFrames();
+	const float* Flux = _Spectrogram.GetFluxData();
+
+	if (bCancelRequested)
+	{
+		return false;
+	}
+
+	// Remove the local mean, so loud parts don't have more onsets than quiet ones
+	const int32 Radius = FMath::Max(1, FMath::RoundToInt(BeatGridLocalMeanSeconds * 0.5f * _Spectrogram.GetSampleRate() / _Spectrogram.GetHopSize()));
+
+	_OutStrength.SetNumUninitialized(NumFrames);
+
+	double WindowSum = 0.0;
+	int32 WindowFirst = 0;
+	int32 WindowLast = -1;
+
+	double Sum = 0.0;
+	double SquareSum = 0.0;
+
+	for (int32 FrameIndex = 0; FrameIndex < NumFrames; ++FrameIndex)
+	{
+		// Running sum over [FrameIndex - Radius, FrameIndex + Radius]
+		while (WindowLast < FMath::Min(FrameIndex + Radius, NumFrames - 1))
+		{
+			WindowSum += Flux[++WindowLast];
+		}
+
+		while (WindowFirst < FrameIndex - Radius)
+		{
+			WindowSum -= Flux[WindowFirst++];
+		}
+
+		const float Mean = WindowSum / (WindowLast - WindowFirst + 1);
+		const float Value = FMath::Max(0.0f, Flux[FrameIndex] - Mean);
+
+		_OutStrength[FrameIndex] = Value;
+
+		Sum += Value;
+		SquareSum += Value * Value;
+	}
+
+	// Scale to a standard deviation of 1, so the thresholds work for every song
+	const double Variance = SquareSum / NumFrames - FMath::Square(Sum / NumFrames);
+
+	if (Variance > 0.0)
+	{
+		const float Scale = 1.0f / FMath::Sqrt(Variance);
+
+		for (float& Value : _OutStrength)
+		{
+			Value *= Scale;
+		}
+	}
+
+	return true;
+}
+
+float FSoundVisBeatGrid::EstimatePeriod(const TArray<float>& _Strength, float _SecondsPerFrame, float& _OutConfidence) const
+{
+	_OutConfidence = 0.0f;
+
+	const int32 NumFrames = _Strength.Num();
+
+	const int32 MinLag = FMath::Max(1, FMath::FloorToInt(60.0f / (MaxTempo * _SecondsPerFrame)));
+	const int32 MaxLag = FMath::Min(NumFrames - 1, FMath::CeilToInt(60.0f / (MinTempo * _SecondsPerFrame)));
+
+	if (MaxLag <= MinLag)
+	{
+		return 0.0f;
+	}
+
+	const float* Strength = _Strength.GetData();
+
+	double Energy = 0.0;
+
+	for (int32 FrameIndex = 0; FrameIndex < NumFrames; ++FrameIndex)
+	{
+		Energy += Strength[FrameIndex] * Strength[FrameIndex];
+	}
+
+	if (Energy <= 0.0)
+	{
+		return 0.0f;
+	}
+
+	// Autocorrelation per frame pair, so long lags with fewer pairs aren't at a disadvantage. One lag more on each side for the refinement
+	const int32 FirstLag = FMath::Max(1, MinLag - 1);
+	const int32 LastLag = FMath::Min(NumFrames - 1, MaxLag + 1);
+
+	TArray<float> Autocorrelation;
+	TArray<float> Weighted;
+
+	Autocorrelation.SetNumZeroed(LastLag + 1);
+	Weighted.SetNumZeroed(LastLag + 1);
+
+	for (int32 Lag = FirstLag; Lag <= LastLag; ++Lag)
+	{
+		double LagSum = 0.0;
+
+		for (int32 FrameIndex = 0; FrameIndex + Lag < NumFrames; ++FrameIndex)
+		{
+			LagSum += Strength[FrameIndex] * Strength[FrameIndex + Lag];
+		}
+
+		Autocorrelation[Lag] = LagSum / (NumFrames - Lag);
+
+		// Half and double tempo correlate as well, the prior picks the one people would tap along to
+		const float LagTempo = 60.0f / (Lag * _SecondsPerFrame);
+		const float Octaves = FMath::Loge(LagTempo / BeatGridPreferredTempo) / FMath::Loge(2.0f);
+
+		Weighted[Lag] = Autocorrelation[Lag] * FMath::Exp(-0.5f * FMath::Square(Octaves / BeatGridTempoOctaves));
+	}
+
+	int32 BestLag = MinLag;
+
+	for (int32 Lag = MinLag + 1; Lag <= MaxLag; ++Lag)
+	{
+		if (Weighted[Lag] > Weighted[BestLag])
+		{
+			BestLag = Lag;
+		}
+	}
+
+	if (Weighted[BestLag] <= 0.0f)
+	{
+		return 0.0f;
+	}
+
+	_OutConfidence = FMath::Clamp(Autocorrelation[BestLag] / (float)(Energy / NumFrames), 0.0f, 1.0f);
+
+	// The period is rarely a whole number of frames. The peak of a parabola through the best lag and its neighbours is closer
+	float Period = BestLag;
+
+	if (BestLag > FirstLag && BestLag < LastLag)
+	{
+		const float Left = Weighted[BestLag - 1];
+		const float Center = Weighted[BestLag];
+		const float Right = Weighted[BestLag + 1];
+
+		const float Denominator = Left - 2.0f * Center + Right;
+
+		if (Denominator < 0.0f)
+		{
+			Period += FMath::Clamp(0.5f * (Left - Right) / Denominator, -0.5f, 0.5f);
+		}
+	}
+
+	return Period;
+}
+
+bool FSoundVisBeatGrid::TrackBeats(const TArray<float>& _Strength, float _Period, TArray<int32>& _OutBeatFrames) const
+{
+	const int32 NumFrames = _Strength.Num();
+
+	// The previous beat is searched between half and twice the period before a frame
+	const int32 MinOffset = FMath::Max(1, FMath::RoundToInt(_Period * 0.5f));
+	const int32 MaxOffset = FMath::Max(MinOffset, FMath::RoundToInt(_Period * 2.0f));
+
+	TArray<float> Penalty;
+	Penalty.SetNumUninitialized(MaxOffset + 1);
+
+	for (int32 Offset = MinOffset; Offset <= MaxOffset; ++Offset)
+	{
+		Penalty[Offset] = BeatGridTightness * FMath::Square(FMath::Loge(Offset / _Period));
+	}
+
+	// Best score of a beat sequence ending at every frame and the beat before it
+	TArray<float> Score;
+	TArray<int32> PreviousBeat;
+
+	Score.SetNumUninitialized(NumFrames);
+	PreviousBeat.SetNumUninitialized(NumFrames);
+
+	for (int32 FrameIndex = 0; FrameIndex < NumFrames; ++FrameIndex)
+	{
+		if ((FrameIndex & 1023) == 0 && bCancelRequested)
+		{
+			return false;
+		}
+
+		float BestScore = 0.0f;
+		int32 BestFrame = INDEX_NONE;
+
+		for (int32 Offset = MinOffset; Offset <= FMath::Min(MaxOffset, FrameIndex); ++Offset)
+		{
+			const float OffsetScore = Score[FrameIndex - Offset] - Penalty[Offset];
+
+			if (BestFrame == INDEX_NONE || OffsetScore > BestScore)
+			{
+				BestScore = OffsetScore;
+				BestFrame = FrameIndex - Offset;
+			}
+		}
+
+		Score[FrameIndex] = _Strength[FrameIndex] + BestScore;
+		PreviousBeat[FrameIndex] = BestFrame;
+	}
+
+	// The last beat is the best one within the last period, the others follow from it
+	int32 LastBeat = NumFrames - 1;
+
+	for (int32 FrameIndex = FMath::Max(0, NumFrames - FMath::RoundToInt(_Period)); FrameIndex < NumFrames; ++FrameIndex)
+	{
+		if (Score[FrameIndex] > Score[LastBeat])
+		{
+			LastBeat = FrameIndex;
+		}
+	}
+
+	TArray<int32> Backwards;
+
+	for (int32 FrameIndex = LastBeat; FrameIndex != INDEX_NONE; FrameIndex = PreviousBeat[FrameIndex])
+	{
+		Backwards.Add(FrameIndex);
+	}
+
+	// The grid runs through silence at the start and the end too. Drop the beats there that have no onset
+	double SquareSum = 0.0;
+
+	for (int32 FrameIndex : Backwards)
+	{
+		SquareSum += FMath::Square(_Strength[FrameIndex]);
+	}
+
+	const float Threshold = 0.5f * FMath::Sqrt(SquareSum / Backwards.Num());
+
+	int32 First = Backwards.Num() - 1;
+	int32 Last = 0;
+
+	while (First >= 0 && _Strength[Backwards[First]] < Threshold)
+	{
+		--First;
+	}
+
+	while (Last <= First && _Strength[Backwards[Last]] < Threshold)
+	{
+		++Last;
+	}
+
+	_OutBeatFrames.Reset();
+
+	for (int32 BeatIndex = First; BeatIndex >= Last; --BeatIndex)
+	{
+		_OutBeatFrames.Add(Backwards[BeatIndex]);
+	}
+
+	return true;
+}
+
+void FSoundVisBeatGrid::Cancel()
+{
+	bCancelRequested = true;
+}
+
+void FSoundVisBeatGrid::Reset()
+{
+	bIsReady = false;
+	bCancelRequested = false;
+
+	BeatTimes.Empty();
+	BeatConfidences.Empty();
+	OnsetTimes.Empty();
+
+	Tempo = 0.0f;
+	TempoConfidence = 0.0f;
+}
+
+
+/// Lookup ///
+
+int32 FSoundVisBeatGrid::UpperBound(const TArray<float>& _Values, float _Value)
+{
+	int32 First = 0;
+	int32 Count = _Values.Num();
+
+	while (Count > 0)
+	{
+		const int32 Step = Count / 2;
+
+		if (_Values[First + Step] <= _Value)
+		{
+			First += Step + 1;
+			Count -= Step + 1;
+		}
+		else
+		{
+			Count = Step;
+		}
+	}
+
+	return First;
+}
+
+int32 FSoundVisBeatGrid::FindNextBeat(float _Time) const
+{
+	check(bIsReady);
+
+	const int32 BeatIndex = UpperBound(BeatTimes, _Time);
+
+	return BeatIndex < BeatTimes.Num() ? BeatIndex : INDEX_NONE;
+}
+
+int32 FSoundVisBeatGrid::FindNextOnset(float _Time) const
+{
+	check(bIsReady);
+
+	const int32 OnsetIndex = UpperBound(OnsetTimes, _Time);
+
+	return OnsetIndex < OnsetTimes.Num() ? OnsetIndex : INDEX_NONE;
+}
+
+
+/// Background Task ///
+
+FSoundVisBeatGridTask::FSoundVisBeatGridTask(FSoundVisBeatGrid* _BeatGrid, const FSoundVisSpectrogram* _Spectrogram)
+	: BeatGrid(_BeatGrid)
+	, Spectrogram(_Spectrogram)
+{
+}
+
+void FSoundVisBeatGridTask::DoWork()
+{
+	BeatGrid->Build(*Spectrogram);
+}
@@ -0,0 +1,592 @@
+// Copyright 1998-2015 Epic Games, Inc. All Rights Reserved.
+
+#include "eXiSoundVisPrivatePCH.h"
+#include "SoundVisualization.h"
+#include "SoundVisKernels.h"
+#include "SoundVisFixedFFT.h"
+#include "SoundVisQ15FFT.h"
+
+/**
+	Microbenchmarks for the analysis kernels. Run them from the console, e.g.:
+	"SoundVis.Bench.Windowing 4096 2000" (FrameCount Iterations)
+	"SoundVis.Bench.FFT 2000" (Iterations)
+	"SoundVis.Bench.SpectrumOutput 4096 2 2000" (FFTSize Channels Iterations)
+	"SoundVis.Bench.FixedPoint 4096 2 2000" (FFTSize Channels Iterations)
+	"SoundVis.Bench.Goertzel 500" (Iterations)
+	"SoundVis.Bench.TrackSwitch C:/Songs/File.ogg 20" (FilePath Switches)
+	Results are written to the LogSoundVisualization category.
+*/
+
+#if !UE_BUILD_SHIPPING
+
+namespace SoundVisBenchmarks
+{
+	// Reads an optional int argument of a console command
+	int32 GetIntArg(const TArray<FString>& _Args, int32 _Index, int32 _Default)
+	{
+		return _Args.IsValidIndex(_Index) ? FMath::Max(1, FCString::Atoi(*_Args[_Index])) : _Default;
+	}
+
+	// Interleaved stereo noise, the same for every run
+	void FillTestSamples(TArray<int16>& _OutSamples, int32 _NumSamples)
+	{
+		FRandomStream Random(1337);
+
+		_OutSamples.SetNumUninitialized(_NumSamples);
+
+		for (int32 SampleIndex = 0; SampleIndex < _NumSamples; ++SampleIndex)
+		{
+			_OutSamples[SampleIndex] = (int16)Random.RandRange(-32768, 32767);
+		}
+	}
+
+	/// Windowing ///
+
+	void BenchWindowing(const TArray<FString>& _Args)
+	{
+		const int32 NumFrames = GetIntArg(_Args, 0, 4096);
+		const int32 NumIterations = GetIntArg(_Args, 1, 2000);
+		const int32 NumChannels = 2;
+
+		TArray<int16> Samples;
+		FillTestSamples(Samples, NumFrames * NumChannels);
+
+		TArray<float> Planes;
+		Planes.SetNumZeroed(NumFrames * NumChannels);
+
+		float* OutPlanes[NumChannels] = { Planes.GetData(), Planes.GetData() + NumFrames };
+
+		double Checksum = 0.0;
+
+		// What the spectrum functions did before: one cosine per sample per channel
+		const double ScalarStart = FPlatformTime::Seconds();
+
+		for (int32 Iteration = 0; Iteration < NumIterations; ++Iteration)
+		{
+			const int16* SamplePtr = Samples.GetData();
+
+			for (int32 SampleIndex = 0; SampleIndex < NumFrames; ++SampleIndex)
+			{
+				for (int32 ChannelIndex = 0; ChannelIndex < NumChannels; ++ChannelIndex)
+				{
+					OutPlanes[ChannelIndex][SampleIndex] = *SamplePtr * 0.5f * (1 - FMath::Cos(2 * PI * SampleIndex / (NumFrames - 1)));
+
+					SamplePtr++;
+				}
+			}
+
+			Checksum += OutPlanes[1][NumFrames / 2];
+		}
+
+		const double ScalarTime = FPlatformTime::Seconds() - ScalarStart;
+
+		// Precomputed table + vectorized deinterleave
+		FSoundVisFFTContext Context;
+
+		const double KernelStart = FPlatformTime::Seconds();
+
+		for (int32 Iteration = 0; Iteration < NumIterations; ++Iteration)
+		{
+			SoundVisKernels::DeinterleaveAndWindow(Samples.GetData(), NumChannels, NumFrames, Context.GetWindow(ESoundVisWindowType::Hann, NumFrames), OutPlanes);
+
+			Checksum += OutPlanes[1][NumFrames / 2];
+		}
+
+		const double KernelTime = FPlatformTime::Seconds() - KernelStart;
+
+		UE_LOG(LogSoundVisualization, Log, TEXT("Windowing %d stereo frames x %d: scalar cos %.3f ms, table + kernel %.3f ms, speedup %.2fx (checksum %f)"),
+			NumFrames, NumIterations, ScalarTime * 1000.0, KernelTime * 1000.0, ScalarTime / FMath::Max(KernelTime, 1e-9), Checksum);
+	}
+
+	FAutoConsoleCommand BenchWindowingCommand(
+		TEXT("SoundVis.Bench.Windowing"),
+		TEXT("Compares the per-sample cosine Hann window with the window table + deinterleave kernel. Args: FrameCount Iterations"),
+		FConsoleCommandWithArgsDelegate::CreateStatic(&BenchWindowing));
+
+	/// FFT Kernels ///
+
+	// Largest difference of two spectrums, relative to the largest bin
+	float GetMaxRelativeError(const kiss_fft_cpx* _Reference, const kiss_fft_cpx* _Bins, int32 _NumBins)
+	{
+		float MaxError = 0.0f;
+		float MaxMagnitude = 1e-20f;
+
+		for (int32 BinIndex = 0; BinIndex < _NumBins; ++BinIndex)
+		{
+			MaxError = FMath::Max(MaxError, FMath::Sqrt(FMath::Square(_Reference[BinIndex].r - _Bins[BinIndex].r) + FMath::Square(_Reference[BinIndex].i - _Bins[BinIndex].i)));
+			MaxMagnitude = FMath::Max(MaxMagnitude, FMath::Sqrt(FMath::Square(_Reference[BinIndex].r) + FMath::Square(_Reference[BinIndex].i)));
+		}
+
+		return MaxError / MaxMagnitude;
+	}
+
+	// Times kiss_fft against the fixed size kernels for every size that has one. Real is the FFT of the odd mono channel,
+	// complex the one a channel pair goes through
+	void BenchFFT(const TArray<FString>& _Args)
+	{
+		const int32 NumIterations = GetIntArg(_Args, 0, 2000);
+
+		for (int32 Size = 512; Size <= 4096; Size *= 2)
+		{
+			TArray<int16> Samples;
+			FillTestSamples(Samples, Size * 2);
+
+			TArray<float> Real;
+			TArray<kiss_fft_cpx> Complex;
+			Real.SetNumUninitialized(Size);
+			Complex.SetNumUninitialized(Size);
+
+			for (int32 SampleIndex = 0; SampleIndex < Size; ++SampleIndex)
+			{
+				Real[SampleIndex] = Samples[SampleIndex];
+				Complex[SampleIndex].r = Samples[SampleIndex * 2];
+				Complex[SampleIndex].i = Samples[SampleIndex * 2 + 1];
+			}
+
+			TArray<kiss_fft_cpx> KissBins, FixedBins, Temp;
+			KissBins.SetNumUninitialized(Size);
+			FixedBins.SetNumUninitialized(Size);
+			Temp.SetNumUninitialized(Size / 2);
+
+			kiss_fftr_cfg RealPlan = kiss_fftr_alloc(Size, 0, NULL, NULL);
+			kiss_fft_cfg ComplexPlan = kiss_fft_alloc(Size, 0, NULL, NULL);
+
+			double Checksum = 0.0;
+
+			// Real FFT
+			double StartTime = FPlatformTime::Seconds();
+
+			for (int32 Iteration = 0; Iteration < NumIterations; ++Iteration)
+			{
+				kiss_fftr(RealPlan, Real.GetData(), KissBins.GetData());
+
+				Checksum += KissBins[Size / 4].r;
+			}
+
+			const double KissRealTime = FPlatformTime::Seconds() - StartTime;
+
+			StartTime = FPlatformTime::Seconds();
+
+			for (int32 Iteration = 0; Iteration < NumIterations; ++Iteration)
+			{
+				SoundVisFixedFFT::RealForward(Real.GetData(), FixedBins.GetData(), Temp.GetData(), Size);
+
+				Checksum += FixedBins[Size / 4].r;
+			}
+
+			const double FixedRealTime = FPlatformTime::Seconds() - StartTime;
+
+			const float RealError = GetMaxRelativeError(KissBins.GetData(), FixedBins.GetData(), Size / 2 + 1);
+
+			// Complex FFT
+			StartTime = FPlatformTime::Seconds();
+
+			for (int32 Iteration = 0; Iteration < NumIterations; ++Iteration)
+			{
+				kiss_fft(ComplexPlan, Complex.GetData(), KissBins.GetData());
+
+				Checksum += KissBins[Size / 4].r;
+			}
+
+			const double KissComplexTime = FPlatformTime::Seconds() - StartTime;
+
+			StartTime = FPlatformTime::Seconds();
+
+			for (int32 Iteration = 0; Iteration < NumIterations; ++Iteration)
+			{
+				SoundVisFixedFFT::ComplexForward(Complex.GetData(), FixedBins.GetData(), Size);
+
+				Checksum += FixedBins[Size / 4].r;
+			}
+
+			const double FixedComplexTime = FPlatformTime::Seconds() - StartTime;
+
+			const float ComplexError = GetMaxRelativeError(KissBins.GetData(), FixedBins.GetData(), Size);
+
+			KISS_FFT_FREE(RealPlan);
+			KISS_FFT_FREE(ComplexPlan);
+
+			UE_LOG(LogSoundVisualization, Log, TEXT("FFT %d x %d: real kiss %.2f us, fixed %.2f us, speedup %.2fx (error %g) | complex kiss %.2f us, fixed %.2f us, speedup %.2fx (error %g) (checksum %f)"),
+				Size, NumIterations,
+				KissRealTime * 1e6 / NumIterations, FixedRealTime * 1e6 / NumIterations, KissRealTime / FMath::Max(FixedRealTime, 1e-9), RealError,
+				KissComplexTime * 1e6 / NumIterations, FixedComplexTime * 1e6 / NumIterations, KissComplexTime / FMath::Max(FixedComplexTime, 1e-9), ComplexError,
+				Checksum);
+		}
+	}
+
+	FAutoConsoleCommand BenchFFTCommand(
+		TEXT("SoundVis.Bench.FFT"),
+		TEXT("Compares kiss_fft with the fixed size FFT kernels for 512 to 4096 points, real and complex. Args: Iterations"),
+		FConsoleCommandWithArgsDelegate::CreateStatic(&BenchFFT));
+
+	/// Spectrum Output ///
+
+	void BenchSpectrumOutput(const TArray<FString>& _Args)
+	{
+		const int32 NumBins = GetIntArg(_Args, 0, 4096) / 2;
+		const int32 NumChannels = FMath::Min(GetIntArg(_Args, 1, 2), FSoundVisFFTContext::MaxChannels);
+		const int32 NumIterations = GetIntArg(_Args, 2, 2000);
+
+		TArray<int16> Samples;
+		FillTestSamples(Samples, NumBins * NumChannels * 2);
+
+		TArray<kiss_fft_cpx> Bins;
+		Bins.SetNumUninitialized(NumBins * NumChannels);
+
+		for (int32 BinIndex = 0; BinIndex < Bins.Num(); ++BinIndex)
+		{
+			Bins[BinIndex].r = Samples[BinIndex * 2] * 64.0f;
+			Bins[BinIndex].i = Samples[BinIndex * 2 + 1] * 64.0f;
+		}
+
+		const kiss_fft_cpx* ChannelBins[FSoundVisFFTContext::MaxChannels] = { 0 };
+
+		for (int32 ChannelIndex = 0; ChannelIndex < NumChannels; ++ChannelIndex)
+		{
+			ChannelBins[ChannelIndex] = Bins.GetData() + ChannelIndex * NumBins;
+		}
+
+		TArray<float> ScalarOut, KernelOut;
+		ScalarOut.SetNumUninitialized(NumBins);
+		KernelOut.SetNumUninitialized(NumBins);
+
+		for (int32 OutputIndex = 0; OutputIndex < 3; ++OutputIndex)
+		{
+			const ESoundVisSpectrumOutput Output = (ESoundVisSpectrumOutput)OutputIndex;
+
+			double Checksum = 0.0;
+
+			// Per bin sqrt and LogX, like the spectrum functions did before
+			const double ScalarStart = FPlatformTime::Seconds();
+
+			for (int32 Iteration = 0; Iteration < NumIterations; ++Iteration)
+			{
+				for (int32 BinIndex = 0; BinIndex < NumBins; ++BinIndex)
+				{
+					float ChannelSum = 0.0f;
+
+					for (int32 ChannelIndex = 0; ChannelIndex < NumChannels; ++ChannelIndex)
+					{
+						ChannelSum += FMath::Sqrt(FMath::Square(ChannelBins[ChannelIndex][BinIndex].r) + FMath::Square(ChannelBins[ChannelIndex][BinIndex].i));
+					}
+
+					const float Magnitude = ChannelSum / NumChannels;
+
+					ScalarOut[BinIndex] = Output == ESoundVisSpectrumOutput::Power ? Magnitude * Magnitude : Output == ESoundVisSpectrumOutput::Decibels ? 20.0f * FMath::LogX(10.0f, FMath::Max(Magnitude, 1e-10f)) : Magnitude;
+				}
+
+				Checksum += ScalarOut[NumBins / 2];
+			}
+
+			const double ScalarTime = FPlatformTime::Seconds() - ScalarStart;
+
+			const double KernelStart = FPlatformTime::Seconds();
+
+			for (int32 Iteration = 0; Iteration < NumIterations; ++Iteration)
+			{
+				SoundVisKernels::CombineChannelBins(ChannelBins, NumChannels, NumBins, Output, KernelOut.GetData());
+
+				Checksum += KernelOut[NumBins / 2];
+			}
+
+			const double KernelTime = FPlatformTime::Seconds() - KernelStart;
+
+			float MaxError = 0.0f;
+
+			for (int32 BinIndex = 0; BinIndex < NumBins; ++BinIndex)
+			{
+				const float Error = FMath::Abs(ScalarOut[BinIndex] - KernelOut[BinIndex]);
+
+				// Absolute for dB, relative for the linear outputs
+				MaxError = FMath::Max(MaxError, Output == ESoundVisSpectrumOutput::Decibels ? Error : Error / FMath::Max(FMath::Abs(ScalarOut[BinIndex]), 1e-20f));
+			}
+
+			UE_LOG(LogSoundVisualization, Log, TEXT("SpectrumOutput %d bins x %d channels x %d, output %d: scalar %.3f ms, kernel %.3f ms, speedup %.2fx, max error %g (checksum %f)"),
+				NumBins, NumChannels, NumIterations, OutputIndex, ScalarTime * 1000.0, KernelTime * 1000.0, ScalarTime / FMath::Max(KernelTime, 1e-9), MaxError, Checksum);
+		}
+	}
+
+	FAutoConsoleCommand BenchSpectrumOutputCommand(
+		TEXT("SoundVis.Bench.SpectrumOutput"),
+		TEXT("Compares per bin sqrt / LogX with the fused magnitude, power and dB kernel. Args: FFTSize Channels Iterations"),
+		FConsoleCommandWithArgsDelegate::CreateStatic(&BenchSpectrumOutput));
+
+	/// Fixed Point ///
+
+	// Times the float and the fixed point path of the FFT context on the same windows and compares their magnitudes.
+	// Noise is the worst case for the fixed point FFT, tones are closer to music: three sines and a quiet noise floor
+	void BenchFixedPoint(const TArray<FString>& _Args)
+	{
+		const int32 FFTSize = FMath::Clamp(FSoundVisFFTContext::GetPowerOfTwoSize(GetIntArg(_Args, 0, 4096)), FSoundVisQ15FFT::MinSize, FSoundVisQ15FFT::MaxSize);
+		const int32 NumChannels = FMath::Min(GetIntArg(_Args, 1, 2), FSoundVisFFTContext::MaxChannels);
+		const int32 NumIterations = GetIntArg(_Args, 2, 2000);
+		const int32 NumBins = FFTSize / 2;
+
+		TArray<int16> Samples;
+		FillTestSamples(Samples, FFTSize * NumChannels);
+
+		TArray<float> FloatMagnitudes, FixedMagnitudes;
+		FloatMagnitudes.SetNumUninitialized(NumBins);
+		FixedMagnitudes.SetNumUninitialized(NumBins);
+
+		FSoundVisFFTContext FloatContext, FixedContext;
+		FixedContext.SetFixedPoint(true);
+
+		for (int32 SignalIndex = 0; SignalIndex < 2; ++SignalIndex)
+		{
+			if (SignalIndex == 1)
+			{
+				for (int32 SampleIndex = 0; SampleIndex < Samples.Num(); ++SampleIndex)
+				{
+					const float Time = (float)(SampleIndex / NumChannels) / FFTSize;
+
+					Samples[SampleIndex] = (int16)(12000.0f * FMath::Sin(2 * PI * 37.3f * Time) + 6000.0f * FMath::Sin(2 * PI * 211.7f * Time) + 1500.0f * FMath::Sin(2 * PI * 0.31f * FFTSize * Time) + (Samples[SampleIndex] >> 8));
+				}
+			}
+
+			double Checksum = 0.0;
+
+			// Warm up both, so the plans and tables aren't timed
+			FloatContext.CalculateMagnitudes(Samples.GetData(), NumChannels, FFTSize, ESoundVisWindowType::Hann, FloatMagnitudes.GetData());
+			FixedContext.CalculateMagnitudes(Samples.GetData(), NumChannels, FFTSize, ESoundVisWindowType::Hann, FixedMagnitudes.GetData());
+
+			double StartTime = FPlatformTime::Seconds();
+
+			for (int32 Iteration = 0; Iteration < NumIterations; ++Iteration)
+			{
+				FloatContext.CalculateMagnitudes(Samples.GetData(), NumChannels, FFTSize, ESoundVisWindowType::Hann, FloatMagnitudes.GetData());
+
+				Checksum += FloatMagnitudes[NumBins / 2];
+			}
+
+			const double FloatTime = FPlatformTime::Seconds() - StartTime;
+
+			StartTime = FPlatformTime::Seconds();
+
+			for (int32 Iteration = 0; Iteration < NumIterations; ++Iteration)
+			{
+				FixedContext.CalculateMagnitudes(Samples.GetData(), NumChannels, FFTSize, ESoundVisWindowType::Hann, FixedMagnitudes.GetData());
+
+				Checksum += FixedMagnitudes[NumBins / 2];
+			}
+
+			const double FixedTime = FPlatformTime::Seconds() - StartTime;
+
+			// Largest error relative to the peak, and how many bins within 60 dB of the peak are more than 1 dB off
+			float Peak = 1e-20f;
+			float MaxError = 0.0f;
+
+			for (int32 BinIndex = 0; BinIndex < NumBins; ++BinIndex)
+			{
+				Peak = FMath::Max(Peak, FloatMagnitudes[BinIndex]);
+				MaxError = FMath::Max(MaxError, FMath::Abs(FloatMagnitudes[BinIndex] - FixedMagnitudes[BinIndex]));
+			}
+
+			int32 NumLoudBins = 0;
+			int32 NumOffBins = 0;
+
+			for (int32 BinIndex = 0; BinIndex < NumBins; ++BinIndex)
+			{
+				if (FloatMagnitudes[BinIndex] > Peak * 0.001f)
+				{
+					++NumLoudBins;
+
+					if (FMath::Abs(20.0f * FMath::LogX(10.0f, FMath::Max(FixedMagnitudes[BinIndex], 1e-10f) / FloatMagnitudes[BinIndex])) > 1.0f)
+					{
+						++NumOffBins;
+					}
+				}
+			}
+
+			// Bytes one channel window moves through the FFT: float plane and complex bins, or the int16 window and the magnitudes
+			const int32 FloatBytes = FFTSize * sizeof(float) + (NumBins + 1) * sizeof(kiss_fft_cpx);
+			const int32 FixedBytes = FFTSize * sizeof(int16) + NumBins * sizeof(float);
+
+			UE_LOG(LogSoundVisualization, Log, TEXT("FixedPoint %s %d x %d channels x %d: float %.2f us, fixed %.2f us, speedup %.2fx, %d vs %d bytes per channel | max error %.1f dB below peak, %d of %d bins within 60 dB of peak more than 1 dB off (checksum %f)"),
+				SignalIndex == 0 ? TEXT("noise") : TEXT("tones"), FFTSize, NumChannels, NumIterations,
+				FloatTime * 1e6 / NumIterations, FixedTime * 1e6 / NumIterations, FloatTime / FMath::Max(FixedTime, 1e-9), FloatBytes, FixedBytes,
+				-20.0f * FMath::LogX(10.0f, FMath::Max(MaxError, 1e-10f) / Peak), NumOffBins, NumLoudBins, Checksum);
+		}
+	}
+
+	FAutoConsoleCommand BenchFixedPointCommand(
+		TEXT("SoundVis.Bench.FixedPoint"),
+		TEXT("Compares speed and accuracy of the float and the fixed point FFT path on noise and tones. Args: FFTSize Channels Iterations"),
+		FConsoleCommandWithArgsDelegate::CreateStatic(&BenchFixedPoint));
+
+	/// Goertzel ///
+
+	// Times the FFT path of the context against GoertzelMagnitudes for 1 to 32 bins, mono, and prints up to how many bins the filters
+	// were faster. PrefersGoertzel is set from these numbers
+	void BenchGoertzel(const TArray<FString>& _Args)
+	{
+		const int32 NumIterations = GetIntArg(_Args, 0, 500);
+		const int32 MaxBins = 32;
+
+		for (int32 Size = 256; Size <= 8192; Size *= 2)
+		{
+			TArray<int16> Samples;
+			FillTestSamples(Samples, Size);
+
+			TArray<float> Plane, Magnitudes;
+			Plane.SetNumUninitialized(Size);
+			Magnitudes.SetNumUninitialized(Size / 2);
+
+			FSoundVisFFTContext Context;
+
+			// Warm up, so the plan and the window aren't timed
+			Context.CalculateMagnitudes(Samples.GetData(), 1, Size, ESoundVisWindowType::Hann, Magnitudes.GetData());
+
+			const float* Window = Context.GetWindow(ESoundVisWindowType::Hann, Size);
+
+			for (int32 SampleIndex = 0; SampleIndex < Size; ++SampleIndex)
+			{
+				Plane[SampleIndex] = Samples[SampleIndex] * Window[SampleIndex];
+			}
+
+			double Checksum = 0.0;
+
+			double StartTime = FPlatformTime::Seconds();
+
+			for (int32 Iteration = 0; Iteration < NumIterations; ++Iteration)
+			{
+				Context.CalculateMagnitudes(Samples.GetData(), 1, Size, ESoundVisWindowType::Hann, Magnitudes.GetData());
+
+				Checksum += Magnitudes[Size / 4];
+			}
+
+			const double FFTTime = (FPlatformTime::Seconds() - StartTime) / NumIterations;
+
+			double Coefficients[MaxBins];
+			float BinMagnitudes[MaxBins];
+
+			for (int32 BinIndex = 0; BinIndex < MaxBins; ++BinIndex)
+			{
+				Coefficients[BinIndex] = 2.0 * cos(2.0 * PI * (BinIndex * 7 + 3) / Size);
+			}
+
+			double SingleTime = 0.0;
+			double BlockTime = 0.0;
+			int32 NumFasterBins = 0;
+
+			for (int32 NumBins = 1; NumBins <= MaxBins; ++NumBins)
+			{
+				StartTime = FPlatformTime::Seconds();
+
+				for (int32 Iteration = 0; Iteration < NumIterations; ++Iteration)
+				{
+					SoundVisKernels::GoertzelMagnitudes(Plane.GetData(), Size, Coefficients, NumBins, BinMagnitudes);
+
+					Checksum += BinMagnitudes[0];
+				}
+
+				// The window pass of the Goertzel path is left out, the FFT path windows the same frames
+				const double GoertzelTime = (FPlatformTime::Seconds() - StartTime) / NumIterations;
+
+				SingleTime = NumBins == 1 ? GoertzelTime : SingleTime;
+				BlockTime = NumBins == 12 ? GoertzelTime : BlockTime;
+
+				if (GoertzelTime < FFTTime)
+				{
+					NumFasterBins = NumBins;
+				}
+			}
+
+			int32 NumPreferredBins = 0;
+
+			while (FSoundVisFFTContext::PrefersGoertzel(NumPreferredBins + 1, Size))
+			{
+				++NumPreferredBins;
+			}
+
+			UE_LOG(LogSoundVisualization, Log, TEXT("Goertzel %d x %d: FFT %.2f us, 1 bin %.2f us, 12 bins %.2f us, filters faster up to %d bins, PrefersGoertzel up to %d (checksum %f)"),
+				Size, NumIterations, FFTTime * 1e6, SingleTime * 1e6, BlockTime * 1e6, NumFasterBins, NumPreferredBins, Checksum);
+		}
+	}
+
+	FAutoConsoleCommand BenchGoertzelCommand(
+		TEXT("SoundVis.Bench.Goertzel"),
+		TEXT("Compares the FFT with Goertzel filters for 1 to 32 bins and 256 to 8192 points, and prints the break even point. Args: Iterations"),
+		FConsoleCommandWithArgsDelegate::CreateStatic(&BenchGoertzel));
+
+	/// Track Switching ///
+
+	// Loads a song again and again like a user skipping tracks, and measures the time until the first spectrum can be computed
+	void BenchTrackSwitch(const TArray<FString>& _Args)
+	{
+		if (_Args.Num() < 1)
+		{
+			UE_LOG(LogSoundVisualization, Warning, TEXT("Usage: SoundVis.Bench.TrackSwitch FilePath [Switches]"));
+
+			return;
+		}
+
+		const FString FilePath = _Args[0];
+		const int32 NumSwitches = GetIntArg(_Args, 1, 20);
+
+		USoundVisualization* Visualization = NewObject<USoundVisualization>();
+		Visualization->AddToRoot();
+
+		TArray<float> Spectrum;
+
+		double TotalLoadTime = 0.0;
+		double TotalLatency = 0.0;
+		double MaxLatency = 0.0;
+		int32 NumTimeouts = 0;
+
+		for (int32 Switch = 0; Switch < NumSwitches; ++Switch)
+		{
+			const double StartTime = FPlatformTime::Seconds();
+
+			// Also cancels the decode of the previous switch
+			if (!Visualization->LoadSoundFileFromHD(FilePath))
+			{
+				UE_LOG(LogSoundVisualization, Warning, TEXT("TrackSwitch: can't load %s"), *FilePath);
+
+				break;
+			}
+
+			TotalLoadTime += FPlatformTime::Seconds() - StartTime;
+
+			// Poll like a game would every tick, just without the frames in between
+			do
+			{
+				Visualization->New_CalculateFrequencySpectrum(Visualization->CurrentSoundWave, 0.0f, 0.1f, Spectrum);
+
+				if (Spectrum.Num() > 0)
+				{
+					break;
+				}
+
+				FPlatformProcess::Sleep(0.0f);
+			}
+			while (FPlatformTime::Seconds() - StartTime < 10.0);
+
+			const double Latency = FPlatformTime::Seconds() - StartTime;
+
+			if (Spectrum.Num() == 0)
+			{
+				++NumTimeouts;
+			}
+
+			TotalLatency += Latency;
+			MaxLatency = FMath::Max(MaxLatency, Latency);
+		}
+
+		UE_LOG(LogSoundVisualization, Log, TEXT("TrackSwitch %d switches: load (incl. cancelling the previous decode) %.3f ms avg, skip to first spectrum %.3f ms avg, %.3f ms max, %d timeouts"),
+			NumSwitches, TotalLoadTime * 1000.0 / NumSwitches, TotalLatency * 1000.0 / NumSwitches, MaxLatency * 1000.0, NumTimeouts);
+
+		Visualization->StopSpectrogramPrecompute();
+		Visualization->ReleasePCMSampleBuffer();
+		Visualization->StopStreamingDecode();
+
+		Visualization->RemoveFromRoot();
+	}
+
+	FAutoConsoleCommand BenchTrackSwitchCommand(
+		TEXT("SoundVis.Bench.TrackSwitch"),
+		TEXT("Measures the skip-to-first-spectrum latency when loading a song while the previous one is still decoding. Args: FilePath Switches"),
+		FConsoleCommandWithArgsDelegate::CreateStatic(&BenchTrackSwitch));
+}
+
+#endif
@@ -0,0 +1,296 @@
+// Copyright 1998-2015 Epic Games, Inc. All Rights Reserved.
+
+#include "eXiSoundVisPrivatePCH.h"
+#include "SoundVisualization.h"
+#include "SoundVisDecoderPool.h"
+
+FSoundVisDecoderPool* FSoundVisDecoderPool::Instance = NULL;
+
+const SIZE_T FSoundVisDecoderPool::MaxPooledBytes;
+
+const double FSoundVisDecoderPool::PooledBufferIdleSeconds = 60.0;
+
+/// Decoder Thread ///
+
+class FSoundVisDecoderPool::FDecoderThread : public FRunnable
+{
+
+public:
+
+	FDecoderThread(FSoundVisDecoderPool* _Pool, int32 _ThreadIndex)
+		: Pool(_Pool)
+	{
+		Thread = FRunnableThread::Create(this, *FString::Printf(TEXT("SoundVisDecoder%d"), _ThreadIndex), 0, TPri_BelowNormal);
+	}
+
+	virtual ~FDecoderThread()
+	{
+		delete Thread;
+		Thread = NULL;
+	}
+
+	virtual uint32 Run() override
+	{
+		while (!Pool->bIsShuttingDown)
+		{
+			FAudioDecompressWorker* Job = Pool->PopJob();
+
+			if (Job)
+			{
+				Job->DoWork();
+			}
+			else
+			{
+				Pool->WakeUpEvent->Wait();
+			}
+		}
+
+		// Let the next thread see the shutdown as well
+		Pool->WakeUpEvent->Trigger();
+
+		return 0;
+	}
+
+	void WaitForCompletion()
+	{
+		Thread->WaitForCompletion();
+	}
+
+private:
+
+	FSoundVisDecoderPool* Pool;
+	FRunnableThread* Thread;
+};
+
+
+/// De-/Constructurs ///
+
+FSoundVisDecoderPool::FSoundVisDecoderPool()
+	: PooledBytes(0)
+	, WakeUpEvent(FPlatformProcess::GetSynchEventFromPool(false))
+	, bIsShuttingDown(false)
+{
+	// Leave one core to the game thread
+	const int32 NumThreads = FMath::Clamp(FPlatformMisc::NumberOfCores() - 1, 1, MaxThreads);
+
+	for (int32 ThreadIndex = 0; ThreadIndex < NumThreads; ++ThreadIndex)
+	{
+		Threads.Add(new FDecoderThread(this, ThreadIndex));
+	}
+}
+
+FSoundVisDecoderPool::~FSoundVisDecoderPool()
+{
+	bIsShuttingDown = true;
+
+	WakeUpEvent->Trigger();
+
+	for (FDecoderThread* Thread : Threads)
+	{
+		Thread->WaitForCompletion();
+
+		delete Thread;
+	}
+
+	Threads.Empty();
+
+	// Nobody is going to decode these anymore, don't let their owners wait forever
+	for (FAudioDecompressWorker* Job : PendingJobs)
+	{
+		Job->MarkFinished();
+	}
+
+	PendingJobs.Empty();
+
+	for (const FPooledBuffer& Buffer : FreeBuffers)
+	{
+		FMemory::Free(Buffer.Data);
+	}
+
+	FreeBuffers.Empty();
+	PooledBytes = 0;
+
+	FPlatformProcess::ReturnSynchEventToPool(WakeUpEvent);
+	WakeUpEvent = NULL;
+}
+
+FSoundVisDecoderPool& FSoundVisDecoderPool::Get()
+{
+	if (!Instance)
+	{
+		Instance = new FSoundVisDecoderPool();
+	}
+
+	return *Instance;
+}
+
+void FSoundVisDecoderPool::Shutdown()
+{
+	delete Instance;
+	Instance = NULL;
+}
+
+
+/// Jobs ///
+
+void FSoundVisDecoderPool::AddJob(FAudioDecompressWorker* _Job)
+{
+	{
+		FScopeLock Lock(&QueueLock);
+
+		PendingJobs.Add(_Job);
+	}
+
+	WakeUpEvent->Trigger();
+}
+
+bool FSoundVisDecoderPool::RetractJob(FAudioDecompressWorker* _Job)
+{
+	FScopeLock Lock(&QueueLock);
+
+	return PendingJobs.RemoveSingle(_Job) > 0;
+}
+
+FAudioDecompressWorker* FSoundVisDecoderPool::PopJob()
+{
+	FScopeLock Lock(&QueueLock);
+
+	if (PendingJobs.Num() == 0)
+	{
+		return NULL;
+	}
+
+	// Highest priority wins, the oldest job of that priority first
+	int32 BestIndex = 0;
+
+	for (int32 JobIndex = 1; JobIndex < PendingJobs.Num(); ++JobIndex)
+	{
+		if (PendingJobs[JobIndex]->Priority > PendingJobs[BestIndex]->Priority)
+		{
+			BestIndex = JobIndex;
+		}
+	}
+
+	FAudioDecompressWorker* Job = PendingJobs[BestIndex];
+
+	PendingJobs.RemoveAt(BestIndex);
+
+	// The wake up event only woke this thread, hand the rest to another one
+	if (PendingJobs.Num() > 0)
+	{
+		WakeUpEvent->Trigger();
+	}
+
+	return Job;
+}
+
+
+/// Buffers ///
+
+uint8* FSoundVisDecoderPool::AcquireBuffer(SIZE_T _MinBytes, SIZE_T& _OutBytes)
+{
+	// A new song is coming, what sat around since the last few wasn't needed
+	TrimBuffers(PooledBufferIdleSeconds);
+
+	{
+		FScopeLock Lock(&BufferLock);
+
+		int32 BestIndex = INDEX_NONE;
+
+		// Don't hand out buffers that are more than twice as big, a short song would keep a long one's memory
+		for (int32 BufferIndex = 0; BufferIndex < FreeBuffers.Num(); ++BufferIndex)
+		{
+			if (FreeBuffers[BufferIndex].Size >= _MinBytes && FreeBuffers[BufferIndex].Size <= _MinBytes * 2 && (BestIndex == INDEX_NONE || FreeBuffers[BufferIndex].Size < FreeBuffers[BestIndex].Size))
+			{
+				BestIndex = BufferIndex;
+			}
+		}
+
+		if (BestIndex != INDEX_NONE)
+		{
+			const FPooledBuffer Buffer = FreeBuffers[BestIndex];
+
+			FreeBuffers.RemoveAt(BestIndex);
+			PooledBytes -= Buffer.Size;
+
+			_OutBytes = Buffer.Size;
+
+			return Buffer.Data;
+		}
+	}
+
+	_OutBytes = _MinBytes;
+
+	return (uint8*)FMemory::Malloc(_MinBytes);
+}
+
+void FSoundVisDecoderPool::ReleaseBuffer(uint8* _Buffer, SIZE_T _Bytes)
+{
+	if (!_Buffer)
+	{
+		return;
+	}
+
+	// Objects can outlive the module
+	if (!Instance)
+	{
+		FMemory::Free(_Buffer);
+
+		return;
+	}
+
+	FScopeLock Lock(&Instance->BufferLock);
+
+	TArray<FPooledBuffer>& FreeBuffers = Instance->FreeBuffers;
+
+	FPooledBuffer Buffer;
+	Buffer.Data = _Buffer;
+	Buffer.Size = _Bytes;
+	Buffer.ReleaseTime = FPlatformTime::Seconds();
+
+	// Kept in release order, the oldest first
+	FreeBuffers.Add(Buffer);
+	Instance->PooledBytes += _Bytes;
+
+	Instance->EnforceByteLimit();
+}
+
+void FSoundVisDecoderPool::TrimBuffers(double _MaxIdleSeconds)
+{
+	if (!Instance)
+	{
+		return;
+	}
+
+	FScopeLock Lock(&Instance->BufferLock);
+
+	TArray<FPooledBuffer>& FreeBuffers = Instance->FreeBuffers;
+
+	const double OldestReleaseTime = FPlatformTime::Seconds() - _MaxIdleSeconds;
+
+	int32 NumExpired = 0;
+
+	while (NumExpired < FreeBuffers.Num() && (_MaxIdleSeconds <= 0.0 || FreeBuffers[NumExpired].ReleaseTime < OldestReleaseTime))
+	{
+		FMemory::Free(FreeBuffers[NumExpired].Data);
+
+		Instance->PooledBytes -= FreeBuffers[NumExpired].Size;
+
+		++NumExpired;
+	}
+
+	FreeBuffers.RemoveAt(0, NumExpired);
+}
+
+void FSoundVisDecoderPool::EnforceByteLimit()
+{
+	// A buffer bigger than the whole limit doesn't stay either
+	while (PooledBytes > MaxPooledBytes && FreeBuffers.Num() > 0)
+	{
+		FMemory::Free(FreeBuffers[0].Data);
+
+		PooledBytes -= FreeBuffers[0].Size;
+
+		FreeBuffers.RemoveAt(0);
+	}
+}
@@ -0,0 +1,311 @@
+// Copyright 1998-2015 Epic Games, Inc. All Rights Reserved.
+
+#include "eXiSoundVisPrivatePCH.h"
+#include "SoundVisualization.h"
+#include "SoundVisEnvelope.h"
+#include "SoundVisKernels.h"
+#include "Async/ParallelFor.h"
+
+DECLARE_CYCLE_STAT(TEXT("Build Envelope"), STAT_SoundVisEnvelopeBuild, STATGROUP_SoundVis);
+DECLARE_CYCLE_STAT(TEXT("Envelope Lookup"), STAT_SoundVisEnvelopeLookup, STATGROUP_SoundVis);
+
+// Level 0 blocks a worker computes in one go
+static const int32 EnvelopeBlocksPerChunk = 1024;
+
+/// De-/Constructurs ///
+
+FSoundVisEnvelope::FSoundVisEnvelope()
+	: NumChannels(0)
+	, NumFrames(0)
+	, SampleRate(0)
+{
+}
+
+
+/// Building ///
+
+void FSoundVisEnvelope::Build(const int16* _PCM, int32 _NumChannels, int32 _NumFrames, int32 _SampleRate)
+{
+	SCOPE_CYCLE_COUNTER(STAT_SoundVisEnvelopeBuild);
+
+	bIsReady = false;
+
+	if (!_PCM || _NumChannels <= 0 || _NumFrames <= 0 || bCancelRequested)
+	{
+		return;
+	}
+
+	NumChannels = _NumChannels;
+	NumFrames = _NumFrames;
+	SampleRate = _SampleRate;
+
+	Levels.Empty();
+
+	// Level 0 straight from the samples
+	{
+		FLevel Level;
+		Level.NumBlocks = FMath::DivideAndRoundUp(_NumFrames, BaseBlockFrames);
+
+		Level.Min.SetNumUninitialized(Level.NumBlocks * _NumChannels);
+		Level.Max.SetNumUninitialized(Level.NumBlocks * _NumChannels);
+		Level.SumSquares.SetNumUninitialized(Level.NumBlocks * _NumChannels);
+
+		const int32 NumChunks = FMath::DivideAndRoundUp(Level.NumBlocks, EnvelopeBlocksPerChunk);
+
+		ParallelFor(NumChunks, [&](int32 ChunkIndex)
+		{
+			TArray<int16, TInlineAllocator<8>> BlockMin;
+			TArray<int16, TInlineAllocator<8>> BlockMax;
+			TArray<float, TInlineAllocator<8>> BlockSumSquares;
+
+			BlockMin.SetNumUninitialized(_NumChannels);
+			BlockMax.SetNumUninitialized(_NumChannels);
+			BlockSumSquares.SetNumUninitialized(_NumChannels);
+
+			const int32 FirstBlock = ChunkIndex * EnvelopeBlocksPerChunk;
+			const int32 LastBlock = FMath::Min(FirstBlock + EnvelopeBlocksPerChunk, Level.NumBlocks);
+
+			for (int32 BlockIndex = FirstBlock; BlockIndex < LastBlock; ++BlockIndex)
+			{
+				if (bCancelRequested)
+				{
+					return;
+				}
+
+				const int32 FirstFrame = BlockIndex * BaseBlockFrames;
+				const int32 BlockFrames = FMath::Min(BaseBlockFrames, _NumFrames - FirstFrame);
+
+				SoundVisKernels::MinMaxSquares(_PCM + (int64)FirstFrame * _NumChannels, _NumChannels, BlockFrames, BlockMin.GetData(), BlockMax.GetData(), BlockSumSquares.GetData());
+
+				for (int32 ChannelIndex = 0; ChannelIndex < _NumChannels; ++ChannelIndex)
+				{
+					const int32 ValueIndex = ChannelIndex * Level.NumBlocks + BlockIndex;
+
+					Level.Min[ValueIndex] = BlockMin[ChannelIndex];
+					Level.Max[ValueIndex] = BlockMax[ChannelIndex];
+					Level.SumSquares[ValueIndex] = BlockSumSquares[ChannelIndex];
+				}
+			}
+		});
+
+		if (bCancelRequested)
+		{
+			return;
+		}
+
+		Levels.Add(MoveTemp(Level));
+	}
+
+	BuildUpperLevels();
+
+	bIsReady = !bCancelRequested;
+}
+
+void FSoundVisEnvelope::InitFromBaseLevel(const int16* _Min, const int16* _Max, const float* _SumSquares, int32 _NumChannels, int32 _NumFrames, int32 _SampleRate)
+{
+	Reset();
+
+	if (_NumChannels <= 0 || _NumFrames <= 0)
+	{
+		return;
+	}
+
+	NumChannels = _NumChannels;
+	NumFrames = _NumFrames;
+	SampleRate = _SampleRate;
+
+	FLevel Level;
+	Level.NumBlocks = FMath::DivideAndRoundUp(_NumFrames, BaseBlockFrames);
+
+	Level.Min.Append(_Min, Level.NumBlocks * _NumChannels);
+	Level.Max.Append(_Max, Level.NumBlocks * _NumChannels);
+	Level.SumSquares.Append(_SumSquares, Level.NumBlocks * _NumChannels);
+
+	Levels.Add(MoveTemp(Level));
+
+	BuildUpperLevels();
+
+	bIsReady = true;
+}
+
+void FSoundVisEnvelope::BuildUpperLevels()
+{
+	// Every level above merges pairs of blocks. Half the work of the level below, not worth the threads
+	while (Levels.Last().NumBlocks > 1)
+	{
+		if (bCancelRequested)
+		{
+			return;
+		}
+
+		const FLevel& Source = Levels.Last();
+
+		FLevel Level;
+		Level.NumBlocks = FMath::DivideAndRoundUp(Source.NumBlocks, 2);
+
+		Level.Min.SetNumUninitialized(Level.NumBlocks * NumChannels);
+		Level.Max.SetNumUninitialized(Level.NumBlocks * NumChannels);
+		Level.SumSquares.SetNumUninitialized(Level.NumBlocks * NumChannels);
+
+		for (int32 ChannelIndex = 0; ChannelIndex < NumChannels; ++ChannelIndex)
+		{
+			const int32 SourceOffset = ChannelIndex * Source.NumBlocks;
+			const int32 Offset = ChannelIndex * Level.NumBlocks;
+
+			for (int32 BlockIndex = 0; BlockIndex < Level.NumBlocks; ++BlockIndex)
+			{
+				const int32 First = SourceOffset + BlockIndex * 2;
+
+				// An odd last block has no partner and moves up as it is
+				if (BlockIndex * 2 + 1 < Source.NumBlocks)
+				{
+					Level.Min[Offset + BlockIndex] = FMath::Min(Source.Min[First], Source.Min[First + 1]);
+					Level.Max[Offset + BlockIndex] = FMath::Max(Source.Max[First], Source.Max[First + 1]);
+					Level.SumSquares[Offset + BlockIndex] = Source.SumSquares[First] + Source.SumSquares[First + 1];
+				}
+				else
+				{
+					Level.Min[Offset + BlockIndex] = Source.Min[First];
+					Level.Max[Offset + BlockIndex] = Source.Max[First];
+					Level.SumSquares[Offset + BlockIndex] = Source.SumSquares[First];
+				}
+			}
+		}
+
+		// Source points into Levels, so only add once the new level is done
+		Levels.Add(MoveTemp(Level));
+	}
+}
+
+void FSoundVisEnvelope::Cancel()
+{
+	bCancelRequested = true;
+}
+
+void FSoundVisEnvelope::Reset()
+{
+	bIsReady = false;
+	bCancelRequested = false;
+
+	Levels.Empty();
+
+	NumChannels = 0;
+	NumFrames = 0;
+	SampleRate = 0;
+}
+
+
+/// Lookup ///
+
+void FSoundVisEnvelope::GetBuckets(int32 _FirstFrame, int32 _NumFrames, int32 _NumBuckets, int32 _Channel, float* _OutMin, float* _OutMax, float* _OutRMS) const
+{
+	SCOPE_CYCLE_COUNTER(STAT_SoundVisEnvelopeLookup);
+
+	check(bIsReady);
+
+	if (_NumBuckets <= 0)
+	{
+		return;
+	}
+
+	// Coarsest level whose blocks aren't longer than a bucket
+	const int32 FramesPerBucket = FMath::Max(1, _NumFrames / _NumBuckets);
+
+	int32 LevelIndex = 0;
+
+	while (LevelIndex + 1 < Levels.Num() && (BaseBlockFrames << (LevelIndex + 1)) <= FramesPerBucket)
+	{
+		++LevelIndex;
+	}
+
+	const FLevel& Level = Levels[LevelIndex];
+	const int32 BlockShift = BaseBlockShift + LevelIndex;
+
+	const int32 FirstChannel = _Channel == INDEX_NONE ? 0 : _Channel;
+	const int32 LastChannel = _Channel == INDEX_NONE ? NumChannels - 1 : _Channel;
+
+	for (int32 BucketIndex = 0; BucketIndex < _NumBuckets; ++BucketIndex)
+	{
+		int64 BucketStart = _FirstFrame + (int64)_NumFrames * BucketIndex / _NumBuckets;
+		int64 BucketEnd = _FirstFrame + (int64)_NumFrames * (BucketIndex + 1) / _NumBuckets;
+
+		// Zoomed in further than one frame per bucket, every bucket still shows its frame
+		BucketEnd = FMath::Max(BucketEnd, BucketStart + 1);
+
+		BucketStart = FMath::Max<int64>(BucketStart, 0);
+		BucketEnd = FMath::Min<int64>(BucketEnd, NumFrames);
+
+		if (BucketStart >= BucketEnd)
+		{
+			_OutMin[BucketIndex] = 0.0f;
+			_OutMax[BucketIndex] = 0.0f;
+			_OutRMS[BucketIndex] = 0.0f;
+
+			continue;
+		}
+
+		const int32 FirstBlock = (int32)(BucketStart >> BlockShift);
+		const int32 LastBlock = (int32)((BucketEnd - 1) >> BlockShift);
+
+		int16 Min = MAX_int16;
+		int16 Max = MIN_int16;
+		double SumSquares = 0.0;
+
+		for (int32 ChannelIndex = FirstChannel; ChannelIndex <= LastChannel; ++ChannelIndex)
+		{
+			const int32 Offset = ChannelIndex * Level.NumBlocks;
+
+			for (int32 BlockIndex = FirstBlock; BlockIndex <= LastBlock; ++BlockIndex)
+			{
+				Min = FMath::Min(Min, Level.Min[Offset + BlockIndex]);
+				Max = FMath::Max(Max, Level.Max[Offset + BlockIndex]);
+				SumSquares += Level.SumSquares[Offset + BlockIndex];
+			}
+		}
+
+		// The RMS is over the whole blocks, the last block of the song can be shorter
+		const int64 CoveredFrames = FMath::Min<int64>((int64)(LastBlock + 1) << BlockShift, NumFrames) - ((int64)FirstBlock << BlockShift);
+		const int32 NumBucketChannels = LastChannel - FirstChannel + 1;
+
+		_OutMin[BucketIndex] = Min / 32768.0f;
+		_OutMax[BucketIndex] = Max / 32768.0f;
+		_OutRMS[BucketIndex] = FMath::Sqrt(SumSquares / (CoveredFrames * NumBucketChannels)) / 32768.0f;
+	}
+}
+
+
+/// Background Task ///
+
+FSoundVisEnvelopeTask::FSoundVisEnvelopeTask(FSoundVisEnvelope* _Envelope, FAudioDecompressWorker* _DecompressWorker, const int16* _PCM, int32 _NumChannels, int32 _NumFrames, int32 _SampleRate)
+	: Envelope(_Envelope)
+	, DecompressWorker(_DecompressWorker)
+	, PCM(_PCM)
+	, NumChannels(_NumChannels)
+	, NumFrames(_NumFrames)
+	, SampleRate(_SampleRate)
+{
+}
+
+void FSoundVisEnvelopeTask::DoWork()
+{
+	// The PCM buffer is only complete once the worker is done with it. Sleeps on its event, the timeout is only there to see a cancel
+	while (DecompressWorker && !DecompressWorker->WaitForFinish(FAudioDecompressWorker::FinishWaitMs))
+	{
+		if (Envelope->IsCancelRequested())
+		{
+			return;
+		}
+	}
+
+	// The pooled buffer isn't cleared, past a failed decode it still holds an older song
+	if (DecompressWorker && !DecompressWorker->HasSucceeded())
+	{
+		UE_LOG(LogSoundVisualization, Warning, TEXT("Envelope skipped, the song couldn't be decoded"));
+
+		return;
+	}
+
+	const int32 NumDecodedFrames = DecompressWorker ? FMath::Min(NumFrames, DecompressWorker->GetDecodedFrames()) : NumFrames;
+
+	Envelope->Build(PCM, NumChannels, NumDecodedFrames, SampleRate);
+}
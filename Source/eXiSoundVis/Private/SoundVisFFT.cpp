@@ -0,0 +1,674 @@
+// Copyright 1998-2015 Epic Games, Inc. All Rights Reserved.
+
+#include "eXiSoundVisPrivatePCH.h"
+#include "SoundVisFFT.h"
+#include "SoundVisKernels.h"
+#include "SoundVisFilterbank.h"
+#include "SoundVisFixedFFT.h"
+#include "SoundVisQ15FFT.h"
+
+#include "Async/ParallelFor.h"
+
+DECLARE_CYCLE_STAT(TEXT("Goertzel Bins"), STAT_SoundVisGoertzel, STATGROUP_SoundVis);
+DECLARE_CYCLE_STAT(TEXT("Fixed Point FFT"), STAT_SoundVisFixedPoint, STATGROUP_SoundVis);
+
+FThreadSafeCounter FSoundVisFFTContext::NumPlanAllocations;
+FThreadSafeCounter FSoundVisFFTContext::NumScratchAllocations;
+
+/// De-/Constructurs ///
+
+static void FreeRealPlan(kiss_fftr_cfg _Plan)
+{
+	KISS_FFT_FREE(_Plan);
+}
+
+static void FreeComplexPlan(kiss_fft_cfg _Plan)
+{
+	KISS_FFT_FREE(_Plan);
+}
+
+template<typename T>
+static void FreeTable(T* _Table)
+{
+	FMemory::Free(_Table);
+}
+
+static void DeleteFilterbank(FSoundVisFilterbank* _Filterbank)
+{
+	delete _Filterbank;
+}
+
+FSoundVisFFTContext::FSoundVisFFTContext()
+	: RealPlans(&FreeRealPlan)
+	, ComplexPlans(&FreeComplexPlan)
+	, Windows(&FreeTable<float>)
+	, FixedWindows(&FreeTable<int16>)
+	, Filterbanks(&DeleteFilterbank)
+	, bParallelChannels(true)
+	, bFixedPoint(false)
+{
+	FMemory::Memzero(Scratch, sizeof(Scratch));
+	FMemory::Memzero(ScratchSize, sizeof(ScratchSize));
+}
+
+FSoundVisFFTContext::~FSoundVisFFTContext()
+{
+	Reset();
+}
+
+
+/// Spectrum ///
+
+void FSoundVisFFTContext::CalculateMagnitudes(const int16* _Interleaved, int32 _NumChannels, int32 _Size, ESoundVisWindowType _WindowType, float* _OutMagnitudes, int32 _NumFrames)
+{
+	CalculateSpectrum(_Interleaved, _NumChannels, _Size, _WindowType, ESoundVisSpectrumOutput::Magnitude, _OutMagnitudes, _NumFrames);
+}
+
+// Mean of the magnitudes of _NumChannels channels, _Stride values apart
+static void AverageFixedChannels(const float* _ChannelMagnitudes, int32 _NumChannels, int32 _Stride, int32 _NumBins, float* _OutMagnitudes)
+{
+	const float Scale = 1.0f / _NumChannels;
+
+	for (int32 BinIndex = 0; BinIndex < _NumBins; ++BinIndex)
+	{
+		float Sum = 0.0f;
+
+		for (int32 ChannelIndex = 0; ChannelIndex < _NumChannels; ++ChannelIndex)
+		{
+			Sum += _ChannelMagnitudes[ChannelIndex * _Stride + BinIndex];
+		}
+
+		_OutMagnitudes[BinIndex] = Sum * Scale;
+	}
+}
+
+void FSoundVisFFTContext::CalculateSpectrum(const int16* _Interleaved, int32 _NumChannels, int32 _Size, ESoundVisWindowType _WindowType, ESoundVisSpectrumOutput _Output, float* _OutValues, int32 _NumFrames)
+{
+	if (UsesFixedPoint(_Size))
+	{
+		AverageFixedChannels(ForwardFixedChannels(_Interleaved, _NumChannels, _NumFrames, _Size, _WindowType), _NumChannels, _Size / 2, _Size / 2, _OutValues);
+
+		SoundVisKernels::ConvertMagnitudes(_OutValues, _Size / 2, _Output, _OutValues);
+
+		return;
+	}
+
+	kiss_fft_cpx* out[MaxChannels] = { 0 };
+
+	ForwardChannels(_Interleaved, _NumChannels, _NumFrames, _Size, _WindowType, out);
+
+	SoundVisKernels::CombineChannelBins(out, _NumChannels, _Size / 2, _Output, _OutValues);
+}
+
+void FSoundVisFFTContext::CalculateChannelSpectrum(const int16* _Interleaved, int32 _NumChannels, int32 _Channel, int32 _Size, ESoundVisWindowType _WindowType, ESoundVisSpectrumOutput _Output, float* _OutValues, int32 _NumFrames)
+{
+	check(_Channel >= 0 && _Channel < _NumChannels);
+
+	const int32 NumFrames = _NumFrames > 0 ? FMath::Min(_NumFrames, _Size) : _Size;
+
+	if (UsesFixedPoint(_Size))
+	{
+		SCOPE_CYCLE_COUNTER(STAT_SoundVisFixedPoint);
+
+		const FSoundVisQ15FFT& FFT = GetQ15FFT(_Size);
+
+		int16* Samples = GetScratch<int16>(ESoundVisScratch::FixedSamples, _Size);
+
+		FFT.WindowChannel(_Interleaved, _NumChannels, _Channel, NumFrames, GetFixedWindow(_WindowType, NumFrames), Samples);
+		FFT.CalculateMagnitudes(Samples, _OutValues);
+
+		SoundVisKernels::ConvertMagnitudes(_OutValues, _Size / 2, _Output, _OutValues);
+
+		return;
+	}
+
+	// Only the requested channel gets picked out of the frames, the window spans the frames only, not the padding
+	float* Plane = GetScratch<float>(ESoundVisScratch::Input, GetPlaneStride(_Size));
+	const float* Window = GetWindow(_WindowType, NumFrames);
+
+	for (int32 FrameIndex = 0; FrameIndex < NumFrames; ++FrameIndex)
+	{
+		Plane[FrameIndex] = _Interleaved[FrameIndex * _NumChannels + _Channel] * Window[FrameIndex];
+	}
+
+	if (NumFrames < _Size)
+	{
+		FMemory::Memzero(Plane + NumFrames, (_Size - NumFrames) * sizeof(float));
+	}
+
+	kiss_fft_cpx* Bins = GetScratch<kiss_fft_cpx>(ESoundVisScratch::Output, _Size / 2 + 1);
+
+	TransformChannels(&Plane, &Bins, 1, _Size);
+
+	SoundVisKernels::CombineChannelBins(&Bins, 1, _Size / 2, _Output, _OutValues);
+}
+
+void FSoundVisFFTContext::CalculateBinMagnitudes(const int16* _Interleaved, int32 _NumChannels, int32 _Size, ESoundVisWindowType _WindowType, const int32* _Bins, int32 _NumBins, float* _OutMagnitudes, int32 _NumFrames)
+{
+	if (!PrefersGoertzel(_NumBins, _Size))
+	{
+		float* Magnitudes = GetScratch<float>(ESoundVisScratch::Magnitudes, _Size / 2);
+
+		CalculateMagnitudes(_Interleaved, _NumChannels, _Size, _WindowType, Magnitudes, _NumFrames);
+
+		for (int32 BinIndex = 0; BinIndex < _NumBins; ++BinIndex)
+		{
+			_OutMagnitudes[BinIndex] = Magnitudes[_Bins[BinIndex]];
+		}
+
+		return;
+	}
+
+	SCOPE_CYCLE_COUNTER(STAT_SoundVisGoertzel);
+
+	const int32 NumFrames = _NumFrames > 0 ? FMath::Min(_NumFrames, _Size) : _Size;
+
+	float* buf[MaxChannels] = { 0 };
+
+	// Same window as the FFT path, so both return the same values. The zero padding doesn't change the filters, so they stop after the frames
+	WindowChannels(_Interleaved, _NumChannels, NumFrames, NumFrames, _WindowType, buf);
+
+	double* Coefficients = GetScratch<double>(ESoundVisScratch::Goertzel, _NumBins);
+	float* ChannelMagnitudes = GetScratch<float>(ESoundVisScratch::Magnitudes, _NumBins);
+
+	for (int32 BinIndex = 0; BinIndex < _NumBins; ++BinIndex)
+	{
+		// In double, FMath::Cos only takes floats
+		Coefficients[BinIndex] = 2.0 * cos(2.0 * PI * _Bins[BinIndex] / _Size);
+
+		_OutMagnitudes[BinIndex] = 0.0f;
+	}
+
+	// Averaged over the channels like CombineChannelBins does it
+	for (int32 ChannelIndex = 0; ChannelIndex < _NumChannels; ++ChannelIndex)
+	{
+		SoundVisKernels::GoertzelMagnitudes(buf[ChannelIndex], NumFrames, Coefficients, _NumBins, ChannelMagnitudes);
+
+		for (int32 BinIndex = 0; BinIndex < _NumBins; ++BinIndex)
+		{
+			_OutMagnitudes[BinIndex] += ChannelMagnitudes[BinIndex];
+		}
+	}
+
+	for (int32 BinIndex = 0; BinIndex < _NumBins; ++BinIndex)
+	{
+		_OutMagnitudes[BinIndex] /= _NumChannels;
+	}
+}
+
+bool FSoundVisFFTContext::PrefersGoertzel(int32 _NumBins, int32 _Size)
+{
+	// Measured with SoundVis.Bench.Goertzel against the real FFT plus magnitudes, SSE2 x64: the filters were faster up to 8 bins at
+	// 256 points, 8 to 16 at 512 and 12 from 1024 to 8192, one full block of GoertzelMagnitudes. A 13th bin runs alone and costs
+	// about a third of the block, so the limit stays at 12 even where log2 N is larger
+	return _NumBins > 0 && _NumBins <= FMath::Min((int32)FMath::FloorLog2(_Size), 12);
+}
+
+void FSoundVisFFTContext::CalculateBandEnergies(const int16* _Interleaved, int32 _NumChannels, int32 _Size, ESoundVisWindowType _WindowType, const FSoundVisFilterbank& _Filterbank, float* _OutBands, int32 _NumFrames)
+{
+	// Only the bins the bands read from, straight into a scratch block that stays in the cache
+	const int32 NumBinsUsed = FMath::Min(_Filterbank.GetNumBinsUsed(), _Size / 2);
+
+	float* Magnitudes = GetScratch<float>(ESoundVisScratch::Magnitudes, NumBinsUsed);
+
+	if (UsesFixedPoint(_Size))
+	{
+		AverageFixedChannels(ForwardFixedChannels(_Interleaved, _NumChannels, _NumFrames, _Size, _WindowType), _NumChannels, _Size / 2, NumBinsUsed, Magnitudes);
+	}
+	else
+	{
+		kiss_fft_cpx* out[MaxChannels] = { 0 };
+
+		ForwardChannels(_Interleaved, _NumChannels, _NumFrames, _Size, _WindowType, out);
+
+		SoundVisKernels::CombineChannelBins(out, _NumChannels, NumBinsUsed, ESoundVisSpectrumOutput::Magnitude, Magnitudes);
+	}
+
+	_Filterbank.Apply(Magnitudes, _OutBands);
+}
+
+void FSoundVisFFTContext::ForwardChannels(const int16* _Interleaved, int32 _NumChannels, int32 _NumFrames, int32 _Size, ESoundVisWindowType _WindowType, kiss_fft_cpx** _OutChannelBins)
+{
+	const int32 NumBins = _Size / 2 + 1;
+
+	float* buf[MaxChannels] = { 0 };
+	kiss_fft_cpx** out = _OutChannelBins;
+
+	// Use Window function to get a better result for the Data. Splits the channels in the same pass
+	WindowChannels(_Interleaved, _NumChannels, _NumFrames > 0 ? FMath::Min(_NumFrames, _Size) : _Size, _Size, _WindowType, buf);
+
+	// One scratch block for all channels, reused between calls. The real FFT only returns _Size / 2 + 1 bins
+	kiss_fft_cpx* OutBuffer = GetScratch<kiss_fft_cpx>(ESoundVisScratch::Output, NumBins * _NumChannels);
+
+	for (int32 ChannelIndex = 0; ChannelIndex < _NumChannels; ChannelIndex++)
+	{
+		out[ChannelIndex] = OutBuffer + ChannelIndex * NumBins;
+	}
+
+	TransformChannels(buf, out, _NumChannels, _Size);
+}
+
+const float* FSoundVisFFTContext::ForwardFixedChannels(const int16* _Interleaved, int32 _NumChannels, int32 _NumFrames, int32 _Size, ESoundVisWindowType _WindowType)
+{
+	SCOPE_CYCLE_COUNTER(STAT_SoundVisFixedPoint);
+
+	check(_NumChannels > 0 && _NumChannels <= MaxChannels);
+
+	const int32 NumFrames = _NumFrames > 0 ? FMath::Min(_NumFrames, _Size) : _Size;
+	const int32 NumBins = _Size / 2;
+
+	const FSoundVisQ15FFT& FFT = GetQ15FFT(_Size);
+	const int16* Window = GetFixedWindow(_WindowType, NumFrames);
+
+	// One window of int16 samples that stays in the cache, every channel goes through it in turn
+	int16* Samples = GetScratch<int16>(ESoundVisScratch::FixedSamples, _Size);
+	float* Magnitudes = GetScratch<float>(ESoundVisScratch::FixedMagnitudes, NumBins * _NumChannels);
+
+	for (int32 ChannelIndex = 0; ChannelIndex < _NumChannels; ++ChannelIndex)
+	{
+		FFT.WindowChannel(_Interleaved, _NumChannels, ChannelIndex, NumFrames, Window, Samples);
+		FFT.CalculateMagnitudes(Samples, Magnitudes + ChannelIndex * NumBins);
+	}
+
+	return Magnitudes;
+}
+
+void FSoundVisFFTContext::WindowChannels(const int16* _Interleaved, int32 _NumChannels, int32 _NumFrames, int32 _Size, ESoundVisWindowType _WindowType, float** _OutPlanes)
+{
+	check(_NumChannels > 0 && _NumChannels <= MaxChannels);
+
+	const int32 PlaneStride = GetPlaneStride(_Size);
+
+	float* InBuffer = GetScratch<float>(ESoundVisScratch::Input, PlaneStride * _NumChannels);
+
+	for (int32 ChannelIndex = 0; ChannelIndex < _NumChannels; ChannelIndex++)
+	{
+		_OutPlanes[ChannelIndex] = InBuffer + ChannelIndex * PlaneStride;
+	}
+
+	// The window spans the frames only, not the padding
+	SoundVisKernels::DeinterleaveAndWindow(_Interleaved, _NumChannels, _NumFrames, GetWindow(_WindowType, _NumFrames), _OutPlanes);
+
+	if (_NumFrames < _Size)
+	{
+		for (int32 ChannelIndex = 0; ChannelIndex < _NumChannels; ChannelIndex++)
+		{
+			FMemory::Memzero(_OutPlanes[ChannelIndex] + _NumFrames, (_Size - _NumFrames) * sizeof(float));
+		}
+	}
+}
+
+
+/// FFT Sizes ///
+
+int32 FSoundVisFFTContext::GetPowerOfTwoSize(int32 _NumSamples)
+{
+	int32 PoT = 2;
+	while (_NumSamples > PoT) PoT *= 2;
+
+	return PoT;
+}
+
+int32 FSoundVisFFTContext::GetMixedRadixSize(int32 _NumSamples)
+{
+	const int32 PoT = GetPowerOfTwoSize(_NumSamples);
+
+	int32 BestSize = PoT;
+	float BestCost = EstimateFFTCost(PoT);
+
+	// Every 2 * 3^a * 5^b * 7^c * 2^d between the request and the power of two. That's at most a few hundred candidates
+	for (int64 Odd3 = 1; Odd3 <= PoT; Odd3 *= 3)
+	{
+		for (int64 Odd5 = Odd3; Odd5 <= PoT; Odd5 *= 5)
+		{
+			for (int64 Odd7 = Odd5; Odd7 <= PoT; Odd7 *= 7)
+			{
+				// The real FFT needs an even size
+				int64 Size = Odd7 * 2;
+
+				while (Size < _NumSamples)
+				{
+					Size *= 2;
+				}
+
+				if (Size < PoT)
+				{
+					const float Cost = EstimateFFTCost((int32)Size);
+
+					if (Cost < BestCost)
+					{
+						BestCost = Cost;
+						BestSize = (int32)Size;
+					}
+				}
+			}
+		}
+	}
+
+	return BestSize;
+}
+
+int32 FSoundVisFFTContext::GetFFTSize(ESoundVisFFTSizePolicy _Policy, int32 _NumSamples)
+{
+	return _Policy == ESoundVisFFTSizePolicy::MixedRadix ? GetMixedRadixSize(_NumSamples) : GetPowerOfTwoSize(_NumSamples);
+}
+
+float FSoundVisFFTContext::EstimateFFTCost(int32 _Size)
+{
+	// kiss_fftr runs a complex FFT of half the size. It splits off factors of 4 first, then 2, 3 and 5,
+	// everything else goes through the generic butterfly. Costs per point and stage, relative to radix 2
+	int32 Remaining = _Size / 2;
+	float StageCost = 0.0f;
+
+	const int32 Radices[] = { 4, 2, 3, 5 };
+	const float RadixCosts[] = { 1.7f, 1.0f, 1.9f, 2.9f };
+
+	for (int32 RadixIndex = 0; RadixIndex < ARRAY_COUNT(Radices); ++RadixIndex)
+	{
+		while (Remaining > 1 && Remaining % Radices[RadixIndex] == 0)
+		{
+			Remaining /= Radices[RadixIndex];
+			StageCost += RadixCosts[RadixIndex];
+		}
+	}
+
+	// Generic butterfly, O(p) per point
+	while (Remaining > 1 && Remaining % 7 == 0)
+	{
+		Remaining /= 7;
+		StageCost += 7.0f;
+	}
+
+	// Anything left isn't a size we create, but keep the estimate honest
+	if (Remaining > 1)
+	{
+		StageCost += Remaining;
+	}
+
+	// Plus the pass that splits the half size result into the real spectrum
+	return _Size * 0.5f * StageCost + _Size;
+}
+
+
+/// Transforms ///
+
+void FSoundVisFFTContext::RealForward(const float* _InSamples, kiss_fft_cpx* _OutBins, int32 _Size)
+{
+	if (SoundVisFixedFFT::HasRealKernel(_Size))
+	{
+		SoundVisFixedFFT::RealForward(_InSamples, _OutBins, GetScratch<kiss_fft_cpx>(ESoundVisScratch::Temp, _Size / 2), _Size);
+	}
+	else
+	{
+		kiss_fftr(GetRealPlan(_Size), _InSamples, _OutBins);
+	}
+}
+
+void FSoundVisFFTContext::StereoForward(const float* _InLeft, const float* _InRight, kiss_fft_cpx* _OutLeft, kiss_fft_cpx* _OutRight, int32 _Size)
+{
+	PackedStereoForward(GetPairPlan(_Size), _InLeft, _InRight, GetScratch<kiss_fft_cpx>(ESoundVisScratch::Temp, _Size * 2), _OutLeft, _OutRight, _Size);
+}
+
+void FSoundVisFFTContext::TransformChannels(const float* const* _InPlanes, kiss_fft_cpx* const* _OutChannelBins, int32 _NumChannels, int32 _Size)
+{
+	const int32 NumPairs = _NumChannels / 2;
+
+	// Our samples are real, so we don't need the full complex FFT. Two channels are packed into one complex FFT
+	if (NumPairs > 1 && bParallelChannels)
+	{
+		// Plan and scratch are fetched up front, the maps must not change while the pairs run. Complex plans are read only
+		// during an out-of-place transform, so all pairs can share one
+		kiss_fft_cfg Plan = GetPairPlan(_Size);
+		kiss_fft_cpx* Packed = GetScratch<kiss_fft_cpx>(ESoundVisScratch::Temp, _Size * 2 * NumPairs);
+
+		ParallelFor(NumPairs, [&](int32 PairIndex)
+		{
+			const int32 ChannelIndex = PairIndex * 2;
+
+			PackedStereoForward(Plan, _InPlanes[ChannelIndex], _InPlanes[ChannelIndex + 1], Packed + PairIndex * _Size * 2, _OutChannelBins[ChannelIndex], _OutChannelBins[ChannelIndex + 1], _Size);
+		});
+	}
+	else
+	{
+		for (int32 PairIndex = 0; PairIndex < NumPairs; ++PairIndex)
+		{
+			const int32 ChannelIndex = PairIndex * 2;
+
+			StereoForward(_InPlanes[ChannelIndex], _InPlanes[ChannelIndex + 1], _OutChannelBins[ChannelIndex], _OutChannelBins[ChannelIndex + 1], _Size);
+		}
+	}
+
+	// Mono, or the last channel of an odd channel count
+	if (_NumChannels % 2 != 0)
+	{
+		RealForward(_InPlanes[_NumChannels - 1], _OutChannelBins[_NumChannels - 1], _Size);
+	}
+}
+
+void FSoundVisFFTContext::PackedStereoForward(kiss_fft_cfg _Plan, const float* _InLeft, const float* _InRight, kiss_fft_cpx* _Packed, kiss_fft_cpx* _OutLeft, kiss_fft_cpx* _OutRight, int32 _Size)
+{
+	kiss_fft_cpx* Spectrum = _Packed + _Size;
+
+	// Left channel goes into the real part, right channel into the imaginary part
+	for (int32 SampleIndex = 0; SampleIndex < _Size; ++SampleIndex)
+	{
+		_Packed[SampleIndex].r = _InLeft[SampleIndex];
+		_Packed[SampleIndex].i = _InRight[SampleIndex];
+	}
+
+	if (_Plan)
+	{
+		kiss_fft(_Plan, _Packed, Spectrum);
+	}
+	else
+	{
+		SoundVisFixedFFT::ComplexForward(_Packed, Spectrum, _Size);
+	}
+
+	// Both inputs are real, so their spectra are conjugate symmetric. Z[k] and conj(Z[N - k]) separate them again:
+	// L[k] = (Z[k] + conj(Z[N - k])) / 2 and R[k] = (Z[k] - conj(Z[N - k])) / 2i
+	for (int32 BinIndex = 0; BinIndex <= _Size / 2; ++BinIndex)
+	{
+		const kiss_fft_cpx& Z = Spectrum[BinIndex];
+		const kiss_fft_cpx& ZMirror = Spectrum[(_Size - BinIndex) % _Size];
+
+		_OutLeft[BinIndex].r = 0.5f * (Z.r + ZMirror.r);
+		_OutLeft[BinIndex].i = 0.5f * (Z.i - ZMirror.i);
+
+		_OutRight[BinIndex].r = 0.5f * (Z.i + ZMirror.i);
+		_OutRight[BinIndex].i = 0.5f * (ZMirror.r - Z.r);
+	}
+}
+
+
+/// Plans and Scratch Memory ///
+
+kiss_fftr_cfg FSoundVisFFTContext::GetRealPlan(int32 _Size)
+{
+	check((_Size & 1) == 0);
+
+	if (kiss_fftr_cfg CachedPlan = RealPlans.Find(_Size))
+	{
+		return CachedPlan;
+	}
+
+	kiss_fftr_cfg Plan = kiss_fftr_alloc(_Size, 0, NULL, NULL);
+
+	if (Plan)
+	{
+		NumPlanAllocations.Increment();
+
+		RealPlans.Add(_Size, Plan);
+	}
+
+	return Plan;
+}
+
+kiss_fft_cfg FSoundVisFFTContext::GetComplexPlan(int32 _Size)
+{
+	if (kiss_fft_cfg CachedPlan = ComplexPlans.Find(_Size))
+	{
+		return CachedPlan;
+	}
+
+	kiss_fft_cfg Plan = kiss_fft_alloc(_Size, 0, NULL, NULL);
+
+	if (Plan)
+	{
+		NumPlanAllocations.Increment();
+
+		ComplexPlans.Add(_Size, Plan);
+	}
+
+	return Plan;
+}
+
+kiss_fft_cfg FSoundVisFFTContext::GetPairPlan(int32 _Size)
+{
+	// The common sizes have their own kernel and need no plan
+	return SoundVisFixedFFT::HasComplexKernel(_Size) ? NULL : GetComplexPlan(_Size);
+}
+
+bool FSoundVisFFTContext::SupportsFixedPoint(int32 _Size)
+{
+	return FSoundVisQ15FFT::SupportsSize(_Size);
+}
+
+const FSoundVisQ15FFT& FSoundVisFFTContext::GetQ15FFT(int32 _Size)
+{
+	if (FSoundVisQ15FFT** CachedFFT = Q15FFTs.Find(_Size))
+	{
+		return **CachedFFT;
+	}
+
+	FSoundVisQ15FFT* FFT = new FSoundVisQ15FFT();
+
+	FFT->Build(_Size);
+
+	NumPlanAllocations.Increment();
+
+	Q15FFTs.Add(_Size, FFT);
+
+	return *FFT;
+}
+
+const int16* FSoundVisFFTContext::GetFixedWindow(ESoundVisWindowType _Type, int32 _Size)
+{
+	const uint64 Key = ((uint64)_Size << 8) | (uint64)_Type;
+
+	if (int16* CachedWindow = FixedWindows.Find(Key))
+	{
+		return CachedWindow;
+	}
+
+	int16* Window = (int16*)FMemory::Malloc(_Size * sizeof(int16), 16);
+
+	// Quantized from the float table, so both paths use the same window
+	FSoundVisQ15FFT::QuantizeWindow(GetWindow(_Type, _Size), _Size, Window);
+
+	NumPlanAllocations.Increment();
+
+	FixedWindows.Add(Key, Window);
+
+	return Window;
+}
+
+const float* FSoundVisFFTContext::GetWindow(ESoundVisWindowType _Type, int32 _Size)
+{
+	const uint64 Key = ((uint64)_Size << 8) | (uint64)_Type;
+
+	if (float* CachedWindow = Windows.Find(Key))
+	{
+		return CachedWindow;
+	}
+
+	float* Window = (float*)FMemory::Malloc(_Size * sizeof(float), 16);
+
+	SoundVisKernels::BuildWindow(_Type, _Size, Window);
+
+	NumPlanAllocations.Increment();
+
+	Windows.Add(Key, Window);
+
+	return Window;
+}
+
+const FSoundVisFilterbank& FSoundVisFFTContext::GetFilterbank(int32 _Size, int32 _SampleRate, ESoundVisBandLayout _Layout, ESoundVisFilterShape _Shape, int32 _NumMelBands)
+{
+	const uint64 Key = FSoundVisFilterbank::MakeKey(_Size, _SampleRate, _Layout, _Shape, _NumMelBands);
+
+	if (FSoundVisFilterbank* CachedFilterbank = Filterbanks.Find(Key))
+	{
+		return *CachedFilterbank;
+	}
+
+	FSoundVisFilterbank* Filterbank = new FSoundVisFilterbank();
+
+	Filterbank->Build(_Size, _SampleRate, _Layout, _Shape, _NumMelBands);
+
+	NumPlanAllocations.Increment();
+
+	Filterbanks.Add(Key, Filterbank);
+
+	return *Filterbank;
+}
+
+void* FSoundVisFFTContext::GetScratchMemory(ESoundVisScratch::Type _Slot, SIZE_T _NumBytes)
+{
+	check(_Slot >= 0 && _Slot < ESoundVisScratch::Num);
+
+	if (ScratchSize[_Slot] < _NumBytes)
+	{
+		// No need to keep the old content, so don't use Realloc
+		FMemory::Free(Scratch[_Slot]);
+
+		Scratch[_Slot] = FMemory::Malloc(_NumBytes, 16);
+		ScratchSize[_Slot] = _NumBytes;
+
+		NumScratchAllocations.Increment();
+	}
+
+	return Scratch[_Slot];
+}
+
+void FSoundVisFFTContext::Reset()
+{
+	for (TMap<int32, FSoundVisQ15FFT*>::TIterator FFTIt(Q15FFTs); FFTIt; ++FFTIt)
+	{
+		delete FFTIt.Value();
+	}
+
+	RealPlans.Empty();
+	ComplexPlans.Empty();
+	Windows.Empty();
+	FixedWindows.Empty();
+	Q15FFTs.Empty();
+	Filterbanks.Empty();
+
+	for (int32 SlotIndex = 0; SlotIndex < ESoundVisScratch::Num; ++SlotIndex)
+	{
+		FMemory::Free(Scratch[SlotIndex]);
+
+		Scratch[SlotIndex] = NULL;
+		ScratchSize[SlotIndex] = 0;
+	}
+}
+
+
+/// Allocation Counters ///
+
+int32 FSoundVisFFTContext::GetNumPlanAllocations()
+{
+	return NumPlanAllocations.GetValue();
+}
+
+int32 FSoundVisFFTContext::GetNumScratchAllocations()
+{
+	return NumScratchAllocations.GetValue();
+}
+
+void FSoundVisFFTContext::ResetAllocationCounters()
+{
+	NumPlanAllocations.Reset();
+	NumScratchAllocations.Reset();
+}
@@ -0,0 +1,214 @@
+// Copyright 1998-2015 Epic Games, Inc. All Rights Reserved.
+
+#include "eXiSoundVisPrivatePCH.h"
+#include "SoundVisFilterbank.h"
+#include "SoundVisKernels.h"
+
+DECLARE_CYCLE_STAT(TEXT("Build Filterbank"), STAT_SoundVisFilterbankBuild, STATGROUP_SoundVis);
+DECLARE_CYCLE_STAT(TEXT("Apply Filterbank"), STAT_SoundVisFilterbankApply, STATGROUP_SoundVis);
+
+const float FSoundVisFilterbank::MinFrequency = 20.0f;
+const float FSoundVisFilterbank::MaxFrequency = 20000.0f;
+
+// Frequency range of one band in Hz. Triangles rise from Lower to Center and fall to Upper
+struct FSoundVisBand
+{
+	float Lower;
+	float Center;
+	float Upper;
+};
+
+static float HzToMel(float _Frequency)
+{
+	return 2595.0f * FMath::LogX(10.0f, 1.0f + _Frequency / 700.0f);
+}
+
+static float MelToHz(float _Mel)
+{
+	return 700.0f * (FMath::Pow(10.0f, _Mel / 2595.0f) - 1.0f);
+}
+
+static void MakeBands(int32 _SampleRate, ESoundVisBandLayout _Layout, ESoundVisFilterShape _Shape, int32 _NumMelBands, TArray<FSoundVisBand>& _OutBands)
+{
+	_OutBands.Reset();
+
+	const float TopFrequency = FMath::Min(FSoundVisFilterbank::MaxFrequency, _SampleRate * 0.5f);
+
+	if (TopFrequency <= FSoundVisFilterbank::MinFrequency)
+	{
+		return;
+	}
+
+	const bool bTriangular = _Shape == ESoundVisFilterShape::Triangular;
+
+	if (_Layout == ESoundVisBandLayout::Mel)
+	{
+		const int32 NumBands = FMath::Clamp(_NumMelBands, 1, FSoundVisFilterbank::MaxMelBands);
+
+		const float MelMin = HzToMel(FSoundVisFilterbank::MinFrequency);
+		const float MelStep = (HzToMel(TopFrequency) - MelMin) / (NumBands + 1);
+
+		for (int32 BandIndex = 0; BandIndex < NumBands; ++BandIndex)
+		{
+			const float CenterMel = MelMin + (BandIndex + 1) * MelStep;
+
+			// Triangles reach to the neighbouring centers, rectangles only to the middle between them
+			const float HalfWidth = bTriangular ? MelStep : MelStep * 0.5f;
+
+			FSoundVisBand Band = { MelToHz(CenterMel - HalfWidth), MelToHz(CenterMel), MelToHz(CenterMel + HalfWidth) };
+
+			_OutBands.Add(Band);
+		}
+	}
+	else
+	{
+		const int32 BandsPerOctave = _Layout == ESoundVisBandLayout::Octave ? 1 : 3;
+
+		// Centers on the base 2 grid through 1 kHz, like the ISO bands (the nominal 31.5 Hz band sits at 31.25 Hz)
+		const int32 FirstStep = FMath::CeilToInt(BandsPerOctave * FMath::Log2(FSoundVisFilterbank::MinFrequency / 1000.0f));
+		const int32 LastStep = FMath::FloorToInt(BandsPerOctave * FMath::Log2(TopFrequency / 1000.0f));
+
+		// Half a band up or down. Triangles reach to the neighbouring centers, a whole band
+		const float HalfBandRatio = FMath::Pow(2.0f, 0.5f / BandsPerOctave);
+		const float EdgeRatio = bTriangular ? HalfBandRatio * HalfBandRatio : HalfBandRatio;
+
+		for (int32 Step = FirstStep; Step <= LastStep; ++Step)
+		{
+			const float Center = 1000.0f * FMath::Pow(2.0f, (float)Step / BandsPerOctave);
+
+			FSoundVisBand Band = { Center / EdgeRatio, Center, Center * EdgeRatio };
+
+			_OutBands.Add(Band);
+		}
+	}
+}
+
+
+/// De-/Constructurs ///
+
+FSoundVisFilterbank::FSoundVisFilterbank()
+	: NumBinsUsed(0)
+{
+}
+
+
+/// Filterbank ///
+
+void FSoundVisFilterbank::Build(int32 _FFTSize, int32 _SampleRate, ESoundVisBandLayout _Layout, ESoundVisFilterShape _Shape, int32 _NumMelBands)
+{
+	SCOPE_CYCLE_COUNTER(STAT_SoundVisFilterbankBuild);
+
+	RowFirstBin.Reset();
+	RowNumWeights.Reset();
+	RowWeightOffset.Reset();
+	Weights.Reset();
+
+	NumBinsUsed = 0;
+
+	TArray<FSoundVisBand> Bands;
+	MakeBands(_SampleRate, _Layout, _Shape, _NumMelBands, Bands);
+
+	const int32 NumBins = _FFTSize / 2;
+	const float BinWidth = (float)_SampleRate / _FFTSize;
+
+	if (NumBins <= 0 || BinWidth <= 0.0f)
+	{
+		return;
+	}
+
+	for (const FSoundVisBand& Band : Bands)
+	{
+		const int32 WeightOffset = Weights.Num();
+		const int32 LowBin = FMath::Max(FMath::CeilToInt(Band.Lower / BinWidth), 0);
+		const int32 HighBin = FMath::Min(FMath::FloorToInt(Band.Upper / BinWidth), NumBins - 1);
+
+		int32 FirstBin = INDEX_NONE;
+		float WeightSum = 0.0f;
+
+		for (int32 BinIndex = LowBin; BinIndex <= HighBin; ++BinIndex)
+		{
+			const float Frequency = BinIndex * BinWidth;
+
+			float Weight = 1.0f;
+
+			if (_Shape == ESoundVisFilterShape::Triangular)
+			{
+				Weight = Frequency <= Band.Center ? (Frequency - Band.Lower) / (Band.Center - Band.Lower) : (Band.Upper - Frequency) / (Band.Upper - Band.Center);
+			}
+
+			// The zeros at the ends of a triangle would only cost time
+			if (Weight <= 0.0f)
+			{
+				if (FirstBin == INDEX_NONE)
+				{
+					continue;
+				}
+
+				break;
+			}
+
+			if (FirstBin == INDEX_NONE)
+			{
+				FirstBin = BinIndex;
+			}
+
+			Weights.Add(Weight);
+			WeightSum += Weight;
+		}
+
+		// Narrow low bands of small FFTs can fall between two bins. Take the closest one, so the band doesn't stay 0
+		if (FirstBin == INDEX_NONE)
+		{
+			FirstBin = FMath::Clamp(FMath::RoundToInt(Band.Center / BinWidth), 0, NumBins - 1);
+
+			Weights.Add(1.0f);
+			WeightSum = 1.0f;
+		}
+
+		const int32 NumWeights = Weights.Num() - WeightOffset;
+
+		// Every band is a weighted average, so wide and narrow bands are comparable
+		for (int32 WeightIndex = WeightOffset; WeightIndex < Weights.Num(); ++WeightIndex)
+		{
+			Weights[WeightIndex] /= WeightSum;
+		}
+
+		RowFirstBin.Add(FirstBin);
+		RowNumWeights.Add(NumWeights);
+		RowWeightOffset.Add(WeightOffset);
+
+		NumBinsUsed = FMath::Max(NumBinsUsed, FirstBin + NumWeights);
+	}
+}
+
+void FSoundVisFilterbank::Apply(const float* _Magnitudes, float* _OutBands) const
+{
+	SCOPE_CYCLE_COUNTER(STAT_SoundVisFilterbankApply);
+
+	SoundVisKernels::SparseMatVec(_Magnitudes, RowFirstBin.GetData(), RowNumWeights.GetData(), RowWeightOffset.GetData(), Weights.GetData(), GetNumBands(), _OutBands);
+}
+
+void FSoundVisFilterbank::GetCenterFrequencies(int32 _SampleRate, ESoundVisBandLayout _Layout, int32 _NumMelBands, TArray<float>& _OutCenters)
+{
+	TArray<FSoundVisBand> Bands;
+	MakeBands(_SampleRate, _Layout, ESoundVisFilterShape::Rectangular, _NumMelBands, Bands);
+
+	_OutCenters.Reset();
+
+	for (const FSoundVisBand& Band : Bands)
+	{
+		_OutCenters.Add(Band.Center);
+	}
+}
+
+uint64 FSoundVisFilterbank::MakeKey(int32 _FFTSize, int32 _SampleRate, ESoundVisBandLayout _Layout, ESoundVisFilterShape _Shape, int32 _NumMelBands)
+{
+	// The band count only matters for Mel, the other layouts share one entry
+	const int32 NumMelBands = _Layout == ESoundVisBandLayout::Mel ? FMath::Clamp(_NumMelBands, 1, MaxMelBands) : 0;
+
+	return (uint64)(_FFTSize & 0xFFFFFF)
+		| ((uint64)(_SampleRate & 0xFFFFF) << 24)
+		| ((uint64)_Layout << 44)
+		| ((uint64)_Shape << 48)
+		| ((uint64)NumMelBands << 52);
+}
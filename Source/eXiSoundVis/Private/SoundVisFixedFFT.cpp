@@ -0,0 +1,327 @@
+// Copyright 1998-2015 Epic Games, Inc. All Rights Reserved.
+
+#include "eXiSoundVisPrivatePCH.h"
+#include "SoundVisFixedFFT.h"
+#include "SoundVisSimd.h"
+
+namespace SoundVisFixedFFT
+{
+	/// Butterflies ///
+
+	FORCEINLINE kiss_fft_cpx ComplexMul(const kiss_fft_cpx& _A, const kiss_fft_cpx& _B)
+	{
+		kiss_fft_cpx Result;
+		Result.r = _A.r * _B.r - _A.i * _B.i;
+		Result.i = _A.r * _B.i + _A.i * _B.r;
+
+		return Result;
+	}
+
+	// exp(-2 pi i _Index / _Size), in double so the bigger sizes don't collect rounding errors
+	kiss_fft_cpx Twiddle(int32 _Index, int32 _Size)
+	{
+		const double Phase = -2.0 * PI * _Index / _Size;
+
+		kiss_fft_cpx Result;
+		Result.r = (float)cos(Phase);
+		Result.i = (float)sin(Phase);
+
+		return Result;
+	}
+
+#if SOUNDVIS_SSE
+	// Two complex products at once. _X and _W hold two values each as r, i, r, i
+	FORCEINLINE __m128 ComplexMul2(__m128 _X, __m128 _W)
+	{
+		const __m128 Real = _mm_shuffle_ps(_W, _W, _MM_SHUFFLE(2, 2, 0, 0));
+		const __m128 Imag = _mm_shuffle_ps(_W, _W, _MM_SHUFFLE(3, 3, 1, 1));
+		const __m128 Swapped = _mm_shuffle_ps(_X, _X, _MM_SHUFFLE(2, 3, 0, 1));
+
+		// r * wr - i * wi, i * wr + r * wi
+		return _mm_add_ps(_mm_mul_ps(_X, Real), _mm_mul_ps(_mm_mul_ps(Swapped, Imag), _mm_setr_ps(-1.0f, 1.0f, -1.0f, 1.0f)));
+	}
+
+	// Two values times -i: i, -r
+	FORCEINLINE __m128 MulNegI2(__m128 _X)
+	{
+		return _mm_mul_ps(_mm_shuffle_ps(_X, _X, _MM_SHUFFLE(2, 3, 0, 1)), _mm_setr_ps(1.0f, -1.0f, 1.0f, -1.0f));
+	}
+#endif
+
+	/**
+		Combines groups of four DFTs of _M values (_M >= 2) into DFTs of 4 _M values. Two radix 2 decimation in time stages in one pass:
+		X = A + W^2k B, Y = C + W^2k D, then X + W^k Y for the outer stage, with W^M = -i.
+		_Twiddles holds W^k for k < _M followed by W^2k, W = exp(-2 pi i / 4 _M)
+	*/
+	FORCEINLINE void Radix4Stage(kiss_fft_cpx* _Data, const kiss_fft_cpx* _Twiddles, int32 _Size, int32 _M)
+	{
+		const kiss_fft_cpx* Twiddles1 = _Twiddles;
+		const kiss_fft_cpx* Twiddles2 = _Twiddles + _M;
+
+		for (int32 Group = 0; Group < _Size; Group += 4 * _M)
+		{
+			kiss_fft_cpx* A = _Data + Group;
+			kiss_fft_cpx* B = A + _M;
+			kiss_fft_cpx* C = B + _M;
+			kiss_fft_cpx* D = C + _M;
+
+#if SOUNDVIS_SSE
+			// Two butterflies per iteration, _M is at least 2 and a power of two
+			for (int32 Index = 0; Index < _M; Index += 2)
+			{
+				const __m128 W1 = _mm_loadu_ps((const float*)(Twiddles1 + Index));
+				const __m128 W2 = _mm_loadu_ps((const float*)(Twiddles2 + Index));
+
+				const __m128 ValueA = _mm_loadu_ps((const float*)(A + Index));
+				const __m128 ValueB = ComplexMul2(_mm_loadu_ps((const float*)(B + Index)), W2);
+				const __m128 ValueC = _mm_loadu_ps((const float*)(C + Index));
+				const __m128 ValueD = ComplexMul2(_mm_loadu_ps((const float*)(D + Index)), W2);
+
+				const __m128 X0 = _mm_add_ps(ValueA, ValueB);
+				const __m128 X1 = _mm_sub_ps(ValueA, ValueB);
+				const __m128 Y0 = ComplexMul2(_mm_add_ps(ValueC, ValueD), W1);
+				const __m128 Y1 = MulNegI2(ComplexMul2(_mm_sub_ps(ValueC, ValueD), W1));
+
+				_mm_storeu_ps((float*)(A + Index), _mm_add_ps(X0, Y0));
+				_mm_storeu_ps((float*)(B + Index), _mm_add_ps(X1, Y1));
+				_mm_storeu_ps((float*)(C + Index), _mm_sub_ps(X0, Y0));
+				_mm_storeu_ps((float*)(D + Index), _mm_sub_ps(X1, Y1));
+			}
+#else
+			for (int32 Index = 0; Index < _M; ++Index)
+			{
+				const kiss_fft_cpx ValueA = A[Index];
+				const kiss_fft_cpx ValueB = ComplexMul(B[Index], Twiddles2[Index]);
+				const kiss_fft_cpx ValueC = C[Index];
+				const kiss_fft_cpx ValueD = ComplexMul(D[Index], Twiddles2[Index]);
+
+				kiss_fft_cpx X0, X1, Y0, Y1;
+				X0.r = ValueA.r + ValueB.r;		X0.i = ValueA.i + ValueB.i;
+				X1.r = ValueA.r - ValueB.r;		X1.i = ValueA.i - ValueB.i;
+				Y0.r = ValueC.r + ValueD.r;		Y0.i = ValueC.i + ValueD.i;
+				Y1.r = ValueC.r - ValueD.r;		Y1.i = ValueC.i - ValueD.i;
+
+				Y0 = ComplexMul(Y0, Twiddles1[Index]);
+				Y1 = ComplexMul(Y1, Twiddles1[Index]);
+
+				// X1 - i Y1 and X1 + i Y1
+				A[Index].r = X0.r + Y0.r;		A[Index].i = X0.i + Y0.i;
+				B[Index].r = X1.r + Y1.i;		B[Index].i = X1.i - Y1.r;
+				C[Index].r = X0.r - Y0.r;		C[Index].i = X0.i - Y0.i;
+				D[Index].r = X1.r - Y1.i;		D[Index].i = X1.i + Y1.r;
+			}
+#endif
+		}
+	}
+
+	// Radix 4 stages from sub size M up to the full size. Every stage is its own instance, so the loops see constant bounds
+	template<int32 Size, int32 M>
+	struct TRadix4Stages
+	{
+		static FORCEINLINE void Run(kiss_fft_cpx* _Data, const kiss_fft_cpx* _Twiddles)
+		{
+			Radix4Stage(_Data, _Twiddles, Size, M);
+
+			TRadix4Stages<Size, (M * 16 <= Size ? M * 4 : 0)>::Run(_Data, _Twiddles + 2 * M);
+		}
+	};
+
+	template<int32 Size>
+	struct TRadix4Stages<Size, 0>
+	{
+		static FORCEINLINE void Run(kiss_fft_cpx* _Data, const kiss_fft_cpx* _Twiddles)
+		{
+		}
+	};
+
+
+	/// Kernels ///
+
+	template<int32 Log2Size>
+	struct TKernel
+	{
+		enum
+		{
+			Size = 1 << Log2Size,
+
+			// Odd powers of two start with one radix 2 stage, so the radix 4 stages start at a sub size of 2. Even ones start with
+			// plain 4 point DFTs, the general radix 4 stages at a sub size of 4
+			bRadix2First = Log2Size & 1,
+			FirstM = bRadix2First ? 2 : 4,
+
+			// W^k and W^2k of every general radix 4 stage
+			NumStageTwiddles = Size
+		};
+
+		// Input index of every output position of the first stage
+		static uint16 BitReverse[Size];
+
+		// Radix4Stage tables of all stages, one after the other
+		static kiss_fft_cpx StageTwiddles[NumStageTwiddles];
+
+		// exp(-2 pi i k / (2 Size)) to split the spectrum of the real FFT of 2 Size samples
+		static kiss_fft_cpx RealTwiddles[Size];
+
+		static void BuildTables()
+		{
+			for (int32 Index = 0; Index < Size; ++Index)
+			{
+				int32 Reversed = 0;
+
+				for (int32 Bit = 0; Bit < Log2Size; ++Bit)
+				{
+					Reversed |= ((Index >> Bit) & 1) << (Log2Size - 1 - Bit);
+				}
+
+				BitReverse[Index] = (uint16)Reversed;
+			}
+
+			kiss_fft_cpx* Twiddles = StageTwiddles;
+
+			for (int32 M = FirstM; M * 4 <= Size; M *= 4)
+			{
+				for (int32 Index = 0; Index < M; ++Index)
+				{
+					Twiddles[Index] = Twiddle(Index, 4 * M);
+					Twiddles[M + Index] = Twiddle(2 * Index, 4 * M);
+				}
+
+				Twiddles += 2 * M;
+			}
+
+			check(Twiddles <= StageTwiddles + NumStageTwiddles);
+
+			for (int32 Index = 0; Index < Size; ++Index)
+			{
+				RealTwiddles[Index] = Twiddle(Index, 2 * Size);
+			}
+		}
+
+		static void Forward(const kiss_fft_cpx* _In, kiss_fft_cpx* _Out)
+		{
+			for (int32 Index = 0; Index < Size; ++Index)
+			{
+				_Out[Index] = _In[BitReverse[Index]];
+			}
+
+			if (bRadix2First)
+			{
+				for (int32 Index = 0; Index < Size; Index += 2)
+				{
+					const kiss_fft_cpx A = _Out[Index];
+					const kiss_fft_cpx B = _Out[Index + 1];
+
+					_Out[Index].r = A.r + B.r;		_Out[Index].i = A.i + B.i;
+					_Out[Index + 1].r = A.r - B.r;	_Out[Index + 1].i = A.i - B.i;
+				}
+			}
+			else
+			{
+				// 4 point DFTs, all twiddles are 1 or -i
+				for (int32 Index = 0; Index < Size; Index += 4)
+				{
+					kiss_fft_cpx* Values = _Out + Index;
+
+					kiss_fft_cpx X0, X1, Y0, Y1;
+					X0.r = Values[0].r + Values[1].r;	X0.i = Values[0].i + Values[1].i;
+					X1.r = Values[0].r - Values[1].r;	X1.i = Values[0].i - Values[1].i;
+					Y0.r = Values[2].r + Values[3].r;	Y0.i = Values[2].i + Values[3].i;
+					Y1.r = Values[2].r - Values[3].r;	Y1.i = Values[2].i - Values[3].i;
+
+					Values[0].r = X0.r + Y0.r;			Values[0].i = X0.i + Y0.i;
+					Values[1].r = X1.r + Y1.i;			Values[1].i = X1.i - Y1.r;
+					Values[2].r = X0.r - Y0.r;			Values[2].i = X0.i - Y0.i;
+					Values[3].r = X1.r - Y1.i;			Values[3].i = X1.i + Y1.r;
+				}
+			}
+
+			TRadix4Stages<Size, FirstM>::Run(_Out, StageTwiddles);
+		}
+
+		// Real FFT of 2 Size samples through the complex FFT of Size values, like kiss_fftr. Writes Size + 1 bins
+		static void RealForward(const float* _InSamples, kiss_fft_cpx* _OutBins, kiss_fft_cpx* _Temp)
+		{
+			// Even samples are the real parts, odd samples the imaginary parts
+			Forward((const kiss_fft_cpx*)_InSamples, _Temp);
+
+			_OutBins[0].r = _Temp[0].r + _Temp[0].i;
+			_OutBins[0].i = 0.0f;
+
+			_OutBins[Size].r = _Temp[0].r - _Temp[0].i;
+			_OutBins[Size].i = 0.0f;
+
+			// Spectra of the even and the odd samples, separated like the packed stereo channels, then X[k] = E[k] + W^k O[k]
+			for (int32 BinIndex = 1; BinIndex < Size; ++BinIndex)
+			{
+				const kiss_fft_cpx& Z = _Temp[BinIndex];
+				const kiss_fft_cpx& ZMirror = _Temp[Size - BinIndex];
+
+				kiss_fft_cpx Odd;
+				Odd.r = 0.5f * (Z.i + ZMirror.i);
+				Odd.i = 0.5f * (ZMirror.r - Z.r);
+
+				Odd = ComplexMul(Odd, RealTwiddles[BinIndex]);
+
+				_OutBins[BinIndex].r = 0.5f * (Z.r + ZMirror.r) + Odd.r;
+				_OutBins[BinIndex].i = 0.5f * (Z.i - ZMirror.i) + Odd.i;
+			}
+		}
+	};
+
+	template<int32 Log2Size> uint16 TKernel<Log2Size>::BitReverse[TKernel<Log2Size>::Size];
+	template<int32 Log2Size> kiss_fft_cpx TKernel<Log2Size>::StageTwiddles[TKernel<Log2Size>::NumStageTwiddles];
+	template<int32 Log2Size> kiss_fft_cpx TKernel<Log2Size>::RealTwiddles[TKernel<Log2Size>::Size];
+
+	// Fills the tables of all sizes while the module is loaded, before any thread can run a transform
+	struct FTableInitializer
+	{
+		FTableInitializer()
+		{
+			TKernel<8>::BuildTables();
+			TKernel<9>::BuildTables();
+			TKernel<10>::BuildTables();
+			TKernel<11>::BuildTables();
+			TKernel<12>::BuildTables();
+		}
+	};
+
+	static FTableInitializer TableInitializer;
+}
+
+
+/// Dispatch ///
+
+bool SoundVisFixedFFT::HasComplexKernel(int32 _Size)
+{
+	return _Size >= 256 && _Size <= 4096 && FMath::IsPowerOfTwo(_Size);
+}
+
+bool SoundVisFixedFFT::HasRealKernel(int32 _Size)
+{
+	return _Size >= 512 && _Size <= 4096 && FMath::IsPowerOfTwo(_Size);
+}
+
+void SoundVisFixedFFT::ComplexForward(const kiss_fft_cpx* _In, kiss_fft_cpx* _Out, int32 _Size)
+{
+	switch (_Size)
+	{
+	case 256:	TKernel<8>::Forward(_In, _Out);		break;
+	case 512:	TKernel<9>::Forward(_In, _Out);		break;
+	case 1024:	TKernel<10>::Forward(_In, _Out);	break;
+	case 2048:	TKernel<11>::Forward(_In, _Out);	break;
+	case 4096:	TKernel<12>::Forward(_In, _Out);	break;
+	default:	checkNoEntry();						break;
+	}
+}
+
+void SoundVisFixedFFT::RealForward(const float* _InSamples, kiss_fft_cpx* _OutBins, kiss_fft_cpx* _Temp, int32 _Size)
+{
+	switch (_Size)
+	{
+	case 512:	TKernel<8>::RealForward(_InSamples, _OutBins, _Temp);	break;
+	case 1024:	TKernel<9>::RealForward(_InSamples, _OutBins, _Temp);	break;
+	case 2048:	TKernel<10>::RealForward(_InSamples, _OutBins, _Temp);	break;
+	case 4096:	TKernel<11>::RealForward(_InSamples, _OutBins, _Temp);	break;
+	default:	checkNoEntry();											break;
+	}
+}
@@ -0,0 +1,692 @@
+// Copyright 1998-2015 Epic Games, Inc. All Rights Reserved.
+
+#include "eXiSoundVisPrivatePCH.h"
+#include "SoundVisKernels.h"
+#include "SoundVisSimd.h"
+
+/// Window Functions ///
+
+void SoundVisKernels::BuildWindow(ESoundVisWindowType _Type, int32 _Size, float* _OutWindow)
+{
+	// Generalized cosine windows: a0 - a1 * cos(x) + a2 * cos(2x) - a3 * cos(3x) + a4 * cos(4x)
+	double Coefficients[5] = { 0.5, 0.5, 0.0, 0.0, 0.0 };
+
+	switch (_Type)
+	{
+	case ESoundVisWindowType::Hamming:
+		Coefficients[0] = 0.54;
+		Coefficients[1] = 0.46;
+		break;
+	case ESoundVisWindowType::BlackmanHarris:
+		Coefficients[0] = 0.35875;
+		Coefficients[1] = 0.48829;
+		Coefficients[2] = 0.14128;
+		Coefficients[3] = 0.01168;
+		break;
+	case ESoundVisWindowType::FlatTop:
+		Coefficients[0] = 0.21557895;
+		Coefficients[1] = 0.41663158;
+		Coefficients[2] = 0.277263158;
+		Coefficients[3] = 0.083578947;
+		Coefficients[4] = 0.006947368;
+		break;
+	default:
+		break;
+	}
+
+	// Same symmetric form (N - 1) as the old Hann window in GetFFTInValue
+	const double Step = _Size > 1 ? 2.0 * PI / (_Size - 1) : 0.0;
+
+	for (int32 SampleIndex = 0; SampleIndex < _Size; ++SampleIndex)
+	{
+		const double X = Step * SampleIndex;
+
+		_OutWindow[SampleIndex] = (float)(Coefficients[0]
+			- Coefficients[1] * FMath::Cos(X)
+			+ Coefficients[2] * FMath::Cos(2.0 * X)
+			- Coefficients[3] * FMath::Cos(3.0 * X)
+			+ Coefficients[4] * FMath::Cos(4.0 * X));
+	}
+}
+
+
+/// Sample Conversion ///
+
+void SoundVisKernels::DeinterleaveAndWindow(const int16* _Interleaved, int32 _NumChannels, int32 _NumFrames, const float* _Window, float* const* _OutPlanes)
+{
+	int32 FrameIndex = 0;
+
+	if (_NumChannels == 1)
+	{
+		float* Out = _OutPlanes[0];
+
+#if SOUNDVIS_SSE
+		// 8 samples per loop: widen to int32 by unpacking against itself and shifting the sign back down
+		for (; FrameIndex + 8 <= _NumFrames; FrameIndex += 8)
+		{
+			const __m128i Samples = _mm_loadu_si128((const __m128i*)(_Interleaved + FrameIndex));
+
+			const __m128 Low = _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpacklo_epi16(Samples, Samples), 16));
+			const __m128 High = _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpackhi_epi16(Samples, Samples), 16));
+
+			_mm_storeu_ps(Out + FrameIndex, _mm_mul_ps(Low, _mm_loadu_ps(_Window + FrameIndex)));
+			_mm_storeu_ps(Out + FrameIndex + 4, _mm_mul_ps(High, _mm_loadu_ps(_Window + FrameIndex + 4)));
+		}
+#elif SOUNDVIS_NEON
+		for (; FrameIndex + 4 <= _NumFrames; FrameIndex += 4)
+		{
+			const float32x4_t Samples = vcvtq_f32_s32(vmovl_s16(vld1_s16(_Interleaved + FrameIndex)));
+
+			vst1q_f32(Out + FrameIndex, vmulq_f32(Samples, vld1q_f32(_Window + FrameIndex)));
+		}
+#endif
+	}
+	else if (_NumChannels == 2)
+	{
+		float* OutLeft = _OutPlanes[0];
+		float* OutRight = _OutPlanes[1];
+
+#if SOUNDVIS_SSE
+		// 4 frames per loop. Each int32 lane holds one frame, left in the low half and right in the high half
+		for (; FrameIndex + 4 <= _NumFrames; FrameIndex += 4)
+		{
+			const __m128i Frames = _mm_loadu_si128((const __m128i*)(_Interleaved + FrameIndex * 2));
+			const __m128 Window = _mm_loadu_ps(_Window + FrameIndex);
+
+			const __m128 Left = _mm_cvtepi32_ps(_mm_srai_epi32(_mm_slli_epi32(Frames, 16), 16));
+			const __m128 Right = _mm_cvtepi32_ps(_mm_srai_epi32(Frames, 16));
+
+			_mm_storeu_ps(OutLeft + FrameIndex, _mm_mul_ps(Left, Window));
+			_mm_storeu_ps(OutRight + FrameIndex, _mm_mul_ps(Right, Window));
+		}
+#elif SOUNDVIS_NEON
+		for (; FrameIndex + 4 <= _NumFrames; FrameIndex += 4)
+		{
+			const int16x4x2_t Frames = vld2_s16(_Interleaved + FrameIndex * 2);
+			const float32x4_t Window = vld1q_f32(_Window + FrameIndex);
+
+			vst1q_f32(OutLeft + FrameIndex, vmulq_f32(vcvtq_f32_s32(vmovl_s16(Frames.val[0])), Window));
+			vst1q_f32(OutRight + FrameIndex, vmulq_f32(vcvtq_f32_s32(vmovl_s16(Frames.val[1])), Window));
+		}
+#endif
+	}
+	else
+	{
+#if SOUNDVIS_SSE
+		// Surround: 4 frames per loop, every channel gathers its 4 samples into one vector and is written to its own plane
+		for (; FrameIndex + 4 <= _NumFrames; FrameIndex += 4)
+		{
+			const int16* Frame = _Interleaved + FrameIndex * _NumChannels;
+			const __m128 Window = _mm_loadu_ps(_Window + FrameIndex);
+
+			for (int32 ChannelIndex = 0; ChannelIndex < _NumChannels; ++ChannelIndex)
+			{
+				const __m128 Samples = _mm_setr_ps(Frame[ChannelIndex], Frame[_NumChannels + ChannelIndex], Frame[2 * _NumChannels + ChannelIndex], Frame[3 * _NumChannels + ChannelIndex]);
+
+				_mm_storeu_ps(_OutPlanes[ChannelIndex] + FrameIndex, _mm_mul_ps(Samples, Window));
+			}
+		}
+#elif SOUNDVIS_NEON
+		for (; FrameIndex + 4 <= _NumFrames; FrameIndex += 4)
+		{
+			const int16* Frame = _Interleaved + FrameIndex * _NumChannels;
+			const float32x4_t Window = vld1q_f32(_Window + FrameIndex);
+
+			for (int32 ChannelIndex = 0; ChannelIndex < _NumChannels; ++ChannelIndex)
+			{
+				int16x4_t Samples = vdup_n_s16(Frame[ChannelIndex]);
+				Samples = vset_lane_s16(Frame[_NumChannels + ChannelIndex], Samples, 1);
+				Samples = vset_lane_s16(Frame[2 * _NumChannels + ChannelIndex], Samples, 2);
+				Samples = vset_lane_s16(Frame[3 * _NumChannels + ChannelIndex], Samples, 3);
+
+				vst1q_f32(_OutPlanes[ChannelIndex] + FrameIndex, vmulq_f32(vcvtq_f32_s32(vmovl_s16(Samples)), Window));
+			}
+		}
+#endif
+	}
+
+	// Scalar loop for the tail
+	for (; FrameIndex < _NumFrames; ++FrameIndex)
+	{
+		const int16* Frame = _Interleaved + FrameIndex * _NumChannels;
+
+		for (int32 ChannelIndex = 0; ChannelIndex < _NumChannels; ++ChannelIndex)
+		{
+			_OutPlanes[ChannelIndex][FrameIndex] = Frame[ChannelIndex] * _Window[FrameIndex];
+		}
+	}
+}
+
+
+/// Envelope ///
+
+void SoundVisKernels::MinMaxSquares(const int16* _Interleaved, int32 _NumChannels, int32 _NumFrames, int16* _OutMin, int16* _OutMax, float* _OutSumSquares)
+{
+	for (int32 ChannelIndex = 0; ChannelIndex < _NumChannels; ++ChannelIndex)
+	{
+		_OutMin[ChannelIndex] = MAX_int16;
+		_OutMax[ChannelIndex] = MIN_int16;
+		_OutSumSquares[ChannelIndex] = 0.0f;
+	}
+
+	int32 FrameIndex = 0;
+
+#if SOUNDVIS_SSE
+	if (_NumChannels == 1 || _NumChannels == 2)
+	{
+		// 8 samples per loop. With stereo the even lanes are left and the odd ones right, the lanes get split after the loop
+		const int32 FramesPerLoop = 8 / _NumChannels;
+
+		__m128i Min = _mm_set1_epi16(MAX_int16);
+		__m128i Max = _mm_set1_epi16(MIN_int16);
+		__m128 EvenSquares = _mm_setzero_ps();
+		__m128 OddSquares = _mm_setzero_ps();
+
+		// madd sums neighbouring lanes. Masking one of the factors keeps the channels apart and two -32768 from overflowing
+		const __m128i EvenMask = _mm_set1_epi32(0x0000FFFF);
+		const __m128i OddMask = _mm_set1_epi32((int32)0xFFFF0000);
+
+		for (; FrameIndex + FramesPerLoop <= _NumFrames; FrameIndex += FramesPerLoop)
+		{
+			const __m128i Samples = _mm_loadu_si128((const __m128i*)(_Interleaved + FrameIndex * _NumChannels));
+
+			Min = _mm_min_epi16(Min, Samples);
+			Max = _mm_max_epi16(Max, Samples);
+
+			EvenSquares = _mm_add_ps(EvenSquares, _mm_cvtepi32_ps(_mm_madd_epi16(Samples, _mm_and_si128(Samples, EvenMask))));
+			OddSquares = _mm_add_ps(OddSquares, _mm_cvtepi32_ps(_mm_madd_epi16(Samples, _mm_and_si128(Samples, OddMask))));
+		}
+
+		MS_ALIGN(16) int16 MinLanes[8] GCC_ALIGN(16);
+		MS_ALIGN(16) int16 MaxLanes[8] GCC_ALIGN(16);
+		MS_ALIGN(16) float EvenLanes[4] GCC_ALIGN(16);
+		MS_ALIGN(16) float OddLanes[4] GCC_ALIGN(16);
+
+		_mm_store_si128((__m128i*)MinLanes, Min);
+		_mm_store_si128((__m128i*)MaxLanes, Max);
+		_mm_store_ps(EvenLanes, EvenSquares);
+		_mm_store_ps(OddLanes, OddSquares);
+
+		for (int32 LaneIndex = 0; LaneIndex < 8; ++LaneIndex)
+		{
+			const int32 ChannelIndex = LaneIndex % _NumChannels;
+
+			_OutMin[ChannelIndex] = FMath::Min(_OutMin[ChannelIndex], MinLanes[LaneIndex]);
+			_OutMax[ChannelIndex] = FMath::Max(_OutMax[ChannelIndex], MaxLanes[LaneIndex]);
+		}
+
+		const float EvenSum = EvenLanes[0] + EvenLanes[1] + EvenLanes[2] + EvenLanes[3];
+		const float OddSum = OddLanes[0] + OddLanes[1] + OddLanes[2] + OddLanes[3];
+
+		if (_NumChannels == 1)
+		{
+			_OutSumSquares[0] = EvenSum + OddSum;
+		}
+		else
+		{
+			_OutSumSquares[0] = EvenSum;
+			_OutSumSquares[1] = OddSum;
+		}
+	}
+#elif SOUNDVIS_NEON
+	if (_NumChannels == 1)
+	{
+		int16x8_t Min = vdupq_n_s16(MAX_int16);
+		int16x8_t Max = vdupq_n_s16(MIN_int16);
+		float32x4_t Squares = vdupq_n_f32(0.0f);
+
+		for (; FrameIndex + 8 <= _NumFrames; FrameIndex += 8)
+		{
+			const int16x8_t Samples = vld1q_s16(_Interleaved + FrameIndex);
+
+			Min = vminq_s16(Min, Samples);
+			Max = vmaxq_s16(Max, Samples);
+
+			Squares = vaddq_f32(Squares, vcvtq_f32_s32(vmull_s16(vget_low_s16(Samples), vget_low_s16(Samples))));
+			Squares = vaddq_f32(Squares, vcvtq_f32_s32(vmull_s16(vget_high_s16(Samples), vget_high_s16(Samples))));
+		}
+
+		int16 MinLanes[8];
+		int16 MaxLanes[8];
+		float SquareLanes[4];
+
+		vst1q_s16(MinLanes, Min);
+		vst1q_s16(MaxLanes, Max);
+		vst1q_f32(SquareLanes, Squares);
+
+		for (int32 LaneIndex = 0; LaneIndex < 8; ++LaneIndex)
+		{
+			_OutMin[0] = FMath::Min(_OutMin[0], MinLanes[LaneIndex]);
+			_OutMax[0] = FMath::Max(_OutMax[0], MaxLanes[LaneIndex]);
+		}
+
+		_OutSumSquares[0] = SquareLanes[0] + SquareLanes[1] + SquareLanes[2] + SquareLanes[3];
+	}
+	else if (_NumChannels == 2)
+	{
+		// vld2 splits the channels while loading
+		int16x8_t Min[2] = { vdupq_n_s16(MAX_int16), vdupq_n_s16(MAX_int16) };
+		int16x8_t Max[2] = { vdupq_n_s16(MIN_int16), vdupq_n_s16(MIN_int16) };
+		float32x4_t Squares[2] = { vdupq_n_f32(0.0f), vdupq_n_f32(0.0f) };
+
+		for (; FrameIndex + 8 <= _NumFrames; FrameIndex += 8)
+		{
+			const int16x8x2_t Frames = vld2q_s16(_Interleaved + FrameIndex * 2);
+
+			for (int32 ChannelIndex = 0; ChannelIndex < 2; ++ChannelIndex)
+			{
+				const int16x8_t Samples = Frames.val[ChannelIndex];
+
+				Min[ChannelIndex] = vminq_s16(Min[ChannelIndex], Samples);
+				Max[ChannelIndex] = vmaxq_s16(Max[ChannelIndex], Samples);
+
+				Squares[ChannelIndex] = vaddq_f32(Squares[ChannelIndex], vcvtq_f32_s32(vmull_s16(vget_low_s16(Samples), vget_low_s16(Samples))));
+				Squares[ChannelIndex] = vaddq_f32(Squares[ChannelIndex], vcvtq_f32_s32(vmull_s16(vget_high_s16(Samples), vget_high_s16(Samples))));
+			}
+		}
+
+		for (int32 ChannelIndex = 0; ChannelIndex < 2; ++ChannelIndex)
+		{
+			int16 MinLanes[8];
+			int16 MaxLanes[8];
+			float SquareLanes[4];
+
+			vst1q_s16(MinLanes, Min[ChannelIndex]);
+			vst1q_s16(MaxLanes, Max[ChannelIndex]);
+			vst1q_f32(SquareLanes, Squares[ChannelIndex]);
+
+			for (int32 LaneIndex = 0; LaneIndex < 8; ++LaneIndex)
+			{
+				_OutMin[ChannelIndex] = FMath::Min(_OutMin[ChannelIndex], MinLanes[LaneIndex]);
+				_OutMax[ChannelIndex] = FMath::Max(_OutMax[ChannelIndex], MaxLanes[LaneIndex]);
+			}
+
+			_OutSumSquares[ChannelIndex] = SquareLanes[0] + SquareLanes[1] + SquareLanes[2] + SquareLanes[3];
+		}
+	}
+#endif
+
+	// Scalar loop for the tail and for any other channel count
+	for (; FrameIndex < _NumFrames; ++FrameIndex)
+	{
+		const int16* Frame = _Interleaved + FrameIndex * _NumChannels;
+
+		for (int32 ChannelIndex = 0; ChannelIndex < _NumChannels; ++ChannelIndex)
+		{
+			const int16 Sample = Frame[ChannelIndex];
+
+			_OutMin[ChannelIndex] = FMath::Min(_OutMin[ChannelIndex], Sample);
+			_OutMax[ChannelIndex] = FMath::Max(_OutMax[ChannelIndex], Sample);
+			_OutSumSquares[ChannelIndex] += (float)Sample * Sample;
+		}
+	}
+}
+
+
+/// Goertzel ///
+
+#if SOUNDVIS_SSE
+namespace SoundVisKernels
+{
+	// 2 * _NumPairs targets, one register per pair. Every pair is its own dependency chain, so the more pairs the more of the
+	// multiply + add latency is hidden. 6 pairs still fit the 16 registers of x64 and were the fastest, see PrefersGoertzel
+	template<int32 _NumPairs>
+	FORCEINLINE void GoertzelPairs(const float* _Samples, int32 _NumSamples, const double* _Coefficients, float* _OutMagnitudes)
+	{
+		__m128d Coeff[_NumPairs];
+		__m128d S1[_NumPairs];
+		__m128d S2[_NumPairs];
+
+		for (int32 PairIndex = 0; PairIndex < _NumPairs; ++PairIndex)
+		{
+			Coeff[PairIndex] = _mm_loadu_pd(_Coefficients + PairIndex * 2);
+			S1[PairIndex] = _mm_setzero_pd();
+			S2[PairIndex] = _mm_setzero_pd();
+		}
+
+		for (int32 SampleIndex = 0; SampleIndex < _NumSamples; ++SampleIndex)
+		{
+			const __m128d Sample = _mm_set1_pd(_Samples[SampleIndex]);
+
+			for (int32 PairIndex = 0; PairIndex < _NumPairs; ++PairIndex)
+			{
+				// Sample - S2 doesn't wait for the previous step, only the multiply and one add are on the chain
+				const __m128d S0 = _mm_add_pd(_mm_sub_pd(Sample, S2[PairIndex]), _mm_mul_pd(Coeff[PairIndex], S1[PairIndex]));
+
+				S2[PairIndex] = S1[PairIndex];
+				S1[PairIndex] = S0;
+			}
+		}
+
+		for (int32 PairIndex = 0; PairIndex < _NumPairs; ++PairIndex)
+		{
+			// |X|^2 = S1^2 + S2^2 - Coeff * S1 * S2
+			const __m128d Power = _mm_sub_pd(_mm_add_pd(_mm_mul_pd(S1[PairIndex], S1[PairIndex]), _mm_mul_pd(S2[PairIndex], S2[PairIndex])), _mm_mul_pd(Coeff[PairIndex], _mm_mul_pd(S1[PairIndex], S2[PairIndex])));
+
+			_mm_storel_pi((__m64*)(_OutMagnitudes + PairIndex * 2), _mm_cvtpd_ps(_mm_sqrt_pd(_mm_max_pd(Power, _mm_setzero_pd()))));
+		}
+	}
+}
+#endif
+
+void SoundVisKernels::GoertzelMagnitudes(const float* _Samples, int32 _NumSamples, const double* _Coefficients, int32 _NumTargets, float* _OutMagnitudes)
+{
+	// The state runs in double. With float, low bins (2 cos(w) close to 2) drift away from what the FFT returns
+	int32 TargetIndex = 0;
+
+#if SOUNDVIS_SSE
+	// 12 targets per loop, then one block of 8, 4 and 2 for the rest
+	for (; TargetIndex + 12 <= _NumTargets; TargetIndex += 12)
+	{
+		GoertzelPairs<6>(_Samples, _NumSamples, _Coefficients + TargetIndex, _OutMagnitudes + TargetIndex);
+	}
+
+	if (TargetIndex + 8 <= _NumTargets)
+	{
+		GoertzelPairs<4>(_Samples, _NumSamples, _Coefficients + TargetIndex, _OutMagnitudes + TargetIndex);
+
+		TargetIndex += 8;
+	}
+
+	if (TargetIndex + 4 <= _NumTargets)
+	{
+		GoertzelPairs<2>(_Samples, _NumSamples, _Coefficients + TargetIndex, _OutMagnitudes + TargetIndex);
+
+		TargetIndex += 4;
+	}
+
+	if (TargetIndex + 2 <= _NumTargets)
+	{
+		GoertzelPairs<1>(_Samples, _NumSamples, _Coefficients + TargetIndex, _OutMagnitudes + TargetIndex);
+
+		TargetIndex += 2;
+	}
+#endif
+
+	// The odd target, and everything on platforms without SSE (NEON has no double lanes on 32 bit ARM)
+	for (; TargetIndex < _NumTargets; ++TargetIndex)
+	{
+		const double Coeff = _Coefficients[TargetIndex];
+
+		double S1 = 0.0;
+		double S2 = 0.0;
+
+		for (int32 SampleIndex = 0; SampleIndex < _NumSamples; ++SampleIndex)
+		{
+			const double S0 = (_Samples[SampleIndex] - S2) + Coeff * S1;
+
+			S2 = S1;
+			S1 = S0;
+		}
+
+		_OutMagnitudes[TargetIndex] = (float)FMath::Sqrt(FMath::Max(S1 * S1 + S2 * S2 - Coeff * S1 * S2, 0.0));
+	}
+}
+
+
+/// Sparse Products ///
+
+void SoundVisKernels::SparseMatVec(const float* _Input, const int32* _RowFirst, const int32* _RowNum, const int32* _RowOffset, const float* _Weights, int32 _NumRows, float* _Out)
+{
+	for (int32 RowIndex = 0; RowIndex < _NumRows; ++RowIndex)
+	{
+		const float* Input = _Input + _RowFirst[RowIndex];
+		const float* Weights = _Weights + _RowOffset[RowIndex];
+		const int32 NumWeights = _RowNum[RowIndex];
+
+		int32 WeightIndex = 0;
+		float Sum = 0.0f;
+
+#if SOUNDVIS_SSE
+		// Rows are short and start anywhere, so unaligned loads and one horizontal add per row
+		__m128 Sum4 = _mm_setzero_ps();
+
+		for (; WeightIndex + 4 <= NumWeights; WeightIndex += 4)
+		{
+			Sum4 = _mm_add_ps(Sum4, _mm_mul_ps(_mm_loadu_ps(Input + WeightIndex), _mm_loadu_ps(Weights + WeightIndex)));
+		}
+
+		Sum4 = _mm_add_ps(Sum4, _mm_movehl_ps(Sum4, Sum4));
+		Sum4 = _mm_add_ss(Sum4, _mm_shuffle_ps(Sum4, Sum4, 1));
+
+		Sum = _mm_cvtss_f32(Sum4);
+#elif SOUNDVIS_NEON
+		float32x4_t Sum4 = vdupq_n_f32(0.0f);
+
+		for (; WeightIndex + 4 <= NumWeights; WeightIndex += 4)
+		{
+			Sum4 = vmlaq_f32(Sum4, vld1q_f32(Input + WeightIndex), vld1q_f32(Weights + WeightIndex));
+		}
+
+		const float32x2_t Sum2 = vadd_f32(vget_low_f32(Sum4), vget_high_f32(Sum4));
+
+		Sum = vget_lane_f32(vpadd_f32(Sum2, Sum2), 0);
+#endif
+
+		for (; WeightIndex < NumWeights; ++WeightIndex)
+		{
+			Sum += Input[WeightIndex] * Weights[WeightIndex];
+		}
+
+		_Out[RowIndex] = Sum;
+	}
+}
+
+
+/// Spectrum Output ///
+
+namespace SoundVisKernels
+{
+	// log2 of the mantissa m = 1 + t in [1, 2) is about t + t (t - 1) (C0 + t (C1 + t C2)). Exact at both ends, at most 1.2e-4 off in between
+	const float Log2C0 = -0.43872531f;
+	const float Log2C1 = 0.23905655f;
+	const float Log2C2 = -0.08212932f;
+
+	// dB per log2 step of the magnitude, 20 log10(2)
+	const float DecibelsPerLog2 = 6.0205999f;
+
+	// Magnitudes below this are silence, -200 dB
+	const float MinDecibelMagnitude = 1e-10f;
+
+	// Output values from the channel average of magnitudes, or of squared magnitudes if _bSquared
+	FORCEINLINE float FinishOutput(float _Value, ESoundVisSpectrumOutput _Output, bool _bSquared)
+	{
+		if (_Output == ESoundVisSpectrumOutput::Power)
+		{
+			return _bSquared ? _Value : _Value * _Value;
+		}
+
+		if (_Output == ESoundVisSpectrumOutput::Decibels)
+		{
+			uint32 Bits;
+			const float Value = FMath::Max(_Value, _bSquared ? MinDecibelMagnitude * MinDecibelMagnitude : MinDecibelMagnitude);
+
+			FMemory::Memcpy(&Bits, &Value, sizeof(Bits));
+
+			const float Exponent = (float)((int32)(Bits >> 23) - 127);
+
+			const uint32 MantissaBits = (Bits & 0x007FFFFF) | 0x3F800000;
+			float Mantissa;
+
+			FMemory::Memcpy(&Mantissa, &MantissaBits, sizeof(Mantissa));
+
+			const float T = Mantissa - 1.0f;
+			const float Log2 = Exponent + T + T * (T - 1.0f) * (Log2C0 + T * (Log2C1 + T * Log2C2));
+
+			// Squared magnitudes are already power, half the dB per step
+			return Log2 * (_bSquared ? DecibelsPerLog2 * 0.5f : DecibelsPerLog2);
+		}
+
+		return _Value;
+	}
+
+#if SOUNDVIS_SSE
+	FORCEINLINE __m128 FinishOutput4(__m128 _Value, ESoundVisSpectrumOutput _Output, bool _bSquared)
+	{
+		if (_Output == ESoundVisSpectrumOutput::Power)
+		{
+			return _bSquared ? _Value : _mm_mul_ps(_Value, _Value);
+		}
+
+		if (_Output == ESoundVisSpectrumOutput::Decibels)
+		{
+			const __m128i Bits = _mm_castps_si128(_mm_max_ps(_Value, _mm_set1_ps(_bSquared ? MinDecibelMagnitude * MinDecibelMagnitude : MinDecibelMagnitude)));
+
+			const __m128 Exponent = _mm_cvtepi32_ps(_mm_sub_epi32(_mm_srli_epi32(Bits, 23), _mm_set1_epi32(127)));
+			const __m128 Mantissa = _mm_castsi128_ps(_mm_or_si128(_mm_and_si128(Bits, _mm_set1_epi32(0x007FFFFF)), _mm_set1_epi32(0x3F800000)));
+
+			const __m128 T = _mm_sub_ps(Mantissa, _mm_set1_ps(1.0f));
+
+			__m128 Poly = _mm_add_ps(_mm_set1_ps(Log2C1), _mm_mul_ps(T, _mm_set1_ps(Log2C2)));
+			Poly = _mm_add_ps(_mm_set1_ps(Log2C0), _mm_mul_ps(T, Poly));
+			Poly = _mm_mul_ps(_mm_mul_ps(T, _mm_sub_ps(T, _mm_set1_ps(1.0f))), Poly);
+
+			const __m128 Log2 = _mm_add_ps(Exponent, _mm_add_ps(T, Poly));
+
+			return _mm_mul_ps(Log2, _mm_set1_ps(_bSquared ? DecibelsPerLog2 * 0.5f : DecibelsPerLog2));
+		}
+
+		return _Value;
+	}
+#elif SOUNDVIS_NEON
+	// ARMv7 has no vector square root. x times the reciprocal estimate after two Newton steps, the max keeps 0 at 0
+	FORCEINLINE float32x4_t Sqrt4(float32x4_t _Value)
+	{
+		const float32x4_t Clamped = vmaxq_f32(_Value, vdupq_n_f32(1e-30f));
+
+		float32x4_t Estimate = vrsqrteq_f32(Clamped);
+		Estimate = vmulq_f32(Estimate, vrsqrtsq_f32(vmulq_f32(Clamped, Estimate), Estimate));
+		Estimate = vmulq_f32(Estimate, vrsqrtsq_f32(vmulq_f32(Clamped, Estimate), Estimate));
+
+		return vmulq_f32(_Value, Estimate);
+	}
+
+	FORCEINLINE float32x4_t FinishOutput4(float32x4_t _Value, ESoundVisSpectrumOutput _Output, bool _bSquared)
+	{
+		if (_Output == ESoundVisSpectrumOutput::Power)
+		{
+			return _bSquared ? _Value : vmulq_f32(_Value, _Value);
+		}
+
+		if (_Output == ESoundVisSpectrumOutput::Decibels)
+		{
+			const uint32x4_t Bits = vreinterpretq_u32_f32(vmaxq_f32(_Value, vdupq_n_f32(_bSquared ? MinDecibelMagnitude * MinDecibelMagnitude : MinDecibelMagnitude)));
+
+			const float32x4_t Exponent = vcvtq_f32_s32(vsubq_s32(vreinterpretq_s32_u32(vshrq_n_u32(Bits, 23)), vdupq_n_s32(127)));
+			const float32x4_t Mantissa = vreinterpretq_f32_u32(vorrq_u32(vandq_u32(Bits, vdupq_n_u32(0x007FFFFF)), vdupq_n_u32(0x3F800000)));
+
+			const float32x4_t T = vsubq_f32(Mantissa, vdupq_n_f32(1.0f));
+
+			float32x4_t Poly = vmlaq_f32(vdupq_n_f32(Log2C1), T, vdupq_n_f32(Log2C2));
+			Poly = vmlaq_f32(vdupq_n_f32(Log2C0), T, Poly);
+			Poly = vmulq_f32(vmulq_f32(T, vsubq_f32(T, vdupq_n_f32(1.0f))), Poly);
+
+			const float32x4_t Log2 = vaddq_f32(Exponent, vaddq_f32(T, Poly));
+
+			return vmulq_f32(Log2, vdupq_n_f32(_bSquared ? DecibelsPerLog2 * 0.5f : DecibelsPerLog2));
+		}
+
+		return _Value;
+	}
+#endif
+}
+
+void SoundVisKernels::CombineChannelBins(const kiss_fft_cpx* const* _ChannelBins, int32 _NumChannels, int32 _NumBins, ESoundVisSpectrumOutput _Output, float* _Out)
+{
+	const float ChannelScale = 1.0f / _NumChannels;
+
+	// With one channel, power and dB come straight from the squared magnitude and need no square root
+	const bool bSquared = _NumChannels == 1 && _Output != ESoundVisSpectrumOutput::Magnitude;
+
+	int32 BinIndex = 0;
+
+#if SOUNDVIS_SSE
+	// 4 bins per loop, the channels are summed in the register
+	for (; BinIndex + 4 <= _NumBins; BinIndex += 4)
+	{
+		__m128 Sum = _mm_setzero_ps();
+
+		for (int32 ChannelIndex = 0; ChannelIndex < _NumChannels; ++ChannelIndex)
+		{
+			const float* Bins = (const float*)(_ChannelBins[ChannelIndex] + BinIndex);
+
+			const __m128 Low = _mm_loadu_ps(Bins);
+			const __m128 High = _mm_loadu_ps(Bins + 4);
+			const __m128 LowSquares = _mm_mul_ps(Low, Low);
+			const __m128 HighSquares = _mm_mul_ps(High, High);
+
+			// Even lanes are the real parts, odd lanes the imaginary parts
+			const __m128 Squared = _mm_add_ps(_mm_shuffle_ps(LowSquares, HighSquares, _MM_SHUFFLE(2, 0, 2, 0)), _mm_shuffle_ps(LowSquares, HighSquares, _MM_SHUFFLE(3, 1, 3, 1)));
+
+			Sum = _mm_add_ps(Sum, bSquared ? Squared : _mm_sqrt_ps(Squared));
+		}
+
+		_mm_storeu_ps(_Out + BinIndex, FinishOutput4(_mm_mul_ps(Sum, _mm_set1_ps(ChannelScale)), _Output, bSquared));
+	}
+#elif SOUNDVIS_NEON
+	for (; BinIndex + 4 <= _NumBins; BinIndex += 4)
+	{
+		float32x4_t Sum = vdupq_n_f32(0.0f);
+
+		for (int32 ChannelIndex = 0; ChannelIndex < _NumChannels; ++ChannelIndex)
+		{
+			// vld2 splits real and imaginary parts while loading
+			const float32x4x2_t Bins = vld2q_f32((const float*)(_ChannelBins[ChannelIndex] + BinIndex));
+
+			const float32x4_t Squared = vmlaq_f32(vmulq_f32(Bins.val[0], Bins.val[0]), Bins.val[1], Bins.val[1]);
+
+			Sum = vaddq_f32(Sum, bSquared ? Squared : Sqrt4(Squared));
+		}
+
+		vst1q_f32(_Out + BinIndex, FinishOutput4(vmulq_f32(Sum, vdupq_n_f32(ChannelScale)), _Output, bSquared));
+	}
+#endif
+
+	// Scalar loop for the tail
+	for (; BinIndex < _NumBins; ++BinIndex)
+	{
+		float Sum = 0.0f;
+
+		for (int32 ChannelIndex = 0; ChannelIndex < _NumChannels; ++ChannelIndex)
+		{
+			const kiss_fft_cpx& Bin = _ChannelBins[ChannelIndex][BinIndex];
+			const float Squared = Bin.r * Bin.r + Bin.i * Bin.i;
+
+			Sum += bSquared ? Squared : FMath::Sqrt(Squared);
+		}
+
+		_Out[BinIndex] = FinishOutput(Sum * ChannelScale, _Output, bSquared);
+	}
+}
+
+void SoundVisKernels::ConvertMagnitudes(const float* _Magnitudes, int32 _Num, ESoundVisSpectrumOutput _Output, float* _Out)
+{
+	if (_Output == ESoundVisSpectrumOutput::Magnitude)
+	{
+		if (_Out != _Magnitudes)
+		{
+			FMemory::Memcpy(_Out, _Magnitudes, _Num * sizeof(float));
+		}
+
+		return;
+	}
+
+	int32 Index = 0;
+
+#if SOUNDVIS_SSE
+	for (; Index + 4 <= _Num; Index += 4)
+	{
+		_mm_storeu_ps(_Out + Index, FinishOutput4(_mm_loadu_ps(_Magnitudes + Index), _Output, false));
+	}
+#elif SOUNDVIS_NEON
+	for (; Index + 4 <= _Num; Index += 4)
+	{
+		vst1q_f32(_Out + Index, FinishOutput4(vld1q_f32(_Magnitudes + Index), _Output, false));
+	}
+#endif
+
+	for (; Index < _Num; ++Index)
+	{
+		_Out[Index] = FinishOutput(_Magnitudes[Index], _Output, false);
+	}
+}
@@ -0,0 +1,34 @@
+// Copyright 1998-2015 Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "SoundVisTypes.h"
+
+/**
+	Small vectorized loops used by the analysis functions.
+	SSE2 and NEON versions are picked at compile time, everything else uses the scalar loop.
+*/
+namespace SoundVisKernels
+{
+	// Fills the window function of the given type into _OutWindow (_Size values)
+	void BuildWindow(ESoundVisWindowType _Type, int32 _Size, float* _OutWindow);
+
+	// Splits interleaved int16 frames into one float plane per channel and multiplies them with _Window in one pass
+	void DeinterleaveAndWindow(const int16* _Interleaved, int32 _NumChannels, int32 _NumFrames, const float* _Window, float* const* _OutPlanes);
+
+	// Min, max and sum of squares of every channel of _NumFrames interleaved int16 frames. Writes _NumChannels values to each output
+	void MinMaxSquares(const int16* _Interleaved, int32 _NumChannels, int32 _NumFrames, int16* _OutMin, int16* _OutMax, float* _OutSumSquares);
+
+	// Goertzel filters over one plane of _NumSamples. _Coefficients holds 2 cos(w) of every target, _OutMagnitudes gets the magnitude of the DFT at each w
+	void GoertzelMagnitudes(const float* _Samples, int32 _NumSamples, const double* _Coefficients, int32 _NumTargets, float* _OutMagnitudes);
+
+	// Value of every bin from the bins of _NumChannels channels, in one pass: the magnitudes averaged over the channels, then squared or
+	// converted to dB for Power and Decibels. Writes _NumBins values. dB use a polynomial log2 and are at most 0.001 dB off
+	void CombineChannelBins(const kiss_fft_cpx* const* _ChannelBins, int32 _NumChannels, int32 _NumBins, ESoundVisSpectrumOutput _Output, float* _Out);
+
+	// Turns _Num magnitudes into the values CombineChannelBins writes for _Output. _Out may be _Magnitudes
+	void ConvertMagnitudes(const float* _Magnitudes, int32 _Num, ESoundVisSpectrumOutput _Output, float* _Out);
+
+	// Sparse matrix times vector. Row r is the dot product of _RowNum[r] weights at _Weights + _RowOffset[r] and the same number of inputs at _Input + _RowFirst[r]
+	void SparseMatVec(const float* _Input, const int32* _RowFirst, const int32* _RowNum, const int32* _RowOffset, const float* _Weights, int32 _NumRows, float* _Out);
+}
@@ -0,0 +1,536 @@
+// Copyright 1998-2015 Epic Games, Inc. All Rights Reserved.
+
+#include "eXiSoundVisPrivatePCH.h"
+#include "SoundVisLibraryIndex.h"
+#include "SoundVisAnalysisCache.h"
+#include "Runtime/Engine/Public/VorbisAudioInfo.h"
+
+// Everything of an entry that goes into the index file
+static void SerializeLibraryEntry(FArchive& _Ar, FSoundVisLibraryEntry& _Entry)
+{
+	_Ar << _Entry.FilePath;
+	_Ar << _Entry.Duration;
+	_Ar << _Entry.SampleRate;
+	_Ar << _Entry.NumChannels;
+	_Ar << _Entry.ModificationTime;
+	_Ar << _Entry.FileSize;
+	_Ar << _Entry.bIsReadable;
+}
+
+// <0 if _A comes before _B. Ties fall back to the path, so the order doesn't change between queries
+static int32 CompareLibraryEntries(const FSoundVisLibraryEntry& _A, const FSoundVisLibraryEntry& _B, ESoundVisLibrarySort _SortBy)
+{
+	int32 Result = 0;
+
+	switch (_SortBy)
+	{
+	case ESoundVisLibrarySort::Name:
+		Result = FPaths::GetCleanFilename(_A.FilePath).Compare(FPaths::GetCleanFilename(_B.FilePath), ESearchCase::IgnoreCase);
+		break;
+
+	case ESoundVisLibrarySort::Duration:
+		Result = _A.Duration < _B.Duration ? -1 : (_A.Duration > _B.Duration ? 1 : 0);
+		break;
+
+	case ESoundVisLibrarySort::SampleRate:
+		Result = _A.SampleRate - _B.SampleRate;
+		break;
+
+	case ESoundVisLibrarySort::NumChannels:
+		Result = _A.NumChannels - _B.NumChannels;
+		break;
+
+	case ESoundVisLibrarySort::Modified:
+		Result = _A.ModificationTime < _B.ModificationTime ? -1 : (_A.ModificationTime > _B.ModificationTime ? 1 : 0);
+		break;
+	}
+
+	return Result != 0 ? Result : _A.FilePath.Compare(_B.FilePath, ESearchCase::IgnoreCase);
+}
+
+
+/// Header Reader Thread ///
+
+class FSoundVisLibraryIndex::FHeaderReader : public FRunnable
+{
+
+public:
+
+	FHeaderReader(FSoundVisLibraryIndex* _Index, TArray<FSoundVisLibraryEntry>* _Entries, const TArray<int32>* _ToRead, FThreadSafeCounter* _NextItem, int32 _ThreadIndex)
+		: Index(_Index)
+		, Entries(_Entries)
+		, ToRead(_ToRead)
+		, NextItem(_NextItem)
+	{
+		Thread = FRunnableThread::Create(this, *FString::Printf(TEXT("SoundVisLibraryReader%d"), _ThreadIndex), 0, TPri_BelowNormal);
+	}
+
+	virtual ~FHeaderReader()
+	{
+		delete Thread;
+		Thread = NULL;
+	}
+
+	virtual uint32 Run() override
+	{
+		// Every thread takes the next file until all are read, so slow files don't hold up a fixed share of the work
+		while (Index->StopTaskCounter.GetValue() == 0)
+		{
+			const int32 ItemIndex = NextItem->Increment() - 1;
+
+			if (ItemIndex >= ToRead->Num())
+			{
+				break;
+			}
+
+			// Every thread writes other entries, the array itself doesn't change while reading
+			ReadHeader((*Entries)[(*ToRead)[ItemIndex]]);
+
+			Index->NumHeadersRead.Increment();
+		}
+
+		return 0;
+	}
+
+	void WaitForCompletion()
+	{
+		Thread->WaitForCompletion();
+	}
+
+private:
+
+	FSoundVisLibraryIndex* Index;
+	TArray<FSoundVisLibraryEntry>* Entries;
+	const TArray<int32>* ToRead;
+	FThreadSafeCounter* NextItem;
+
+	FRunnableThread* Thread;
+};
+
+
+/// De-/Constructurs ///
+
+FSoundVisLibraryIndex::FSoundVisLibraryIndex(const FString& _RootDirectory, const FString& _FileExtension)
+	: RootDirectory(NormalizeRootDirectory(_RootDirectory))
+	, FileExtension(NormalizeFileExtension(_FileExtension))
+	, Thread(NULL)
+	, bIsScanning(false)
+{
+	LoadIndexFile();
+}
+
+FSoundVisLibraryIndex::~FSoundVisLibraryIndex()
+{
+	if (Thread)
+	{
+		Stop();
+		Thread->WaitForCompletion();
+
+		delete Thread;
+		Thread = NULL;
+	}
+}
+
+FString FSoundVisLibraryIndex::NormalizeRootDirectory(const FString& _RootDirectory)
+{
+	FString Directory = FPaths::ConvertRelativePathToFull(_RootDirectory);
+
+	FPaths::NormalizeDirectoryName(Directory);
+
+	return Directory;
+}
+
+FString FSoundVisLibraryIndex::NormalizeFileExtension(const FString& _FileExtension)
+{
+	FString Extension = _FileExtension;
+
+	// ".ogg" and "ogg" mean the same
+	Extension.RemoveFromStart(TEXT("."));
+
+	return Extension;
+}
+
+bool FSoundVisLibraryIndex::IsIndexOf(const FString& _RootDirectory, const FString& _FileExtension) const
+{
+	return RootDirectory == NormalizeRootDirectory(_RootDirectory) && FileExtension == NormalizeFileExtension(_FileExtension);
+}
+
+FString FSoundVisLibraryIndex::GetIndexDirectory()
+{
+	return FPaths::GameSavedDir() / TEXT("SoundVisLibrary");
+}
+
+FString FSoundVisLibraryIndex::GetIndexFilePath(const FString& _RootDirectory, const FString& _FileExtension)
+{
+	const FString Key = (_RootDirectory + TEXT("|") + _FileExtension).ToLower();
+
+	return GetIndexDirectory() / FString::Printf(TEXT("%08X.svindex"), FCrc::StrCrc32(*Key));
+}
+
+
+/// Scanning ///
+
+void FSoundVisLibraryIndex::StartScan()
+{
+	if (bIsScanning)
+	{
+		return;
+	}
+
+	// The thread of the last scan is done, just not deleted yet
+	if (Thread)
+	{
+		Thread->WaitForCompletion();
+
+		delete Thread;
+		Thread = NULL;
+	}
+
+	StopTaskCounter.Reset();
+	NumFilesFound.Reset();
+	NumHeadersRead.Reset();
+	NumHeadersToRead.Reset();
+
+	bIsScanning = true;
+
+	Thread = FRunnableThread::Create(this, TEXT("FSoundVisLibraryIndex"), 0, TPri_BelowNormal);
+}
+
+void FSoundVisLibraryIndex::GetScanProgress(int32& _OutNumFiles, int32& _OutNumHeadersRead, int32& _OutNumHeadersToRead) const
+{
+	_OutNumFiles = NumFilesFound.GetValue();
+	_OutNumHeadersRead = NumHeadersRead.GetValue();
+	_OutNumHeadersToRead = NumHeadersToRead.GetValue();
+}
+
+uint32 FSoundVisLibraryIndex::Run()
+{
+	const double StartTime = FPlatformTime::Seconds();
+
+	TArray<FSoundVisLibraryEntry> FoundEntries;
+
+	if (!FindFiles(FoundEntries))
+	{
+		bIsScanning = false;
+
+		return 0;
+	}
+
+	// Files with the same size and modification time keep what the index already knows about them
+	TArray<int32> ToRead;
+	bool bChanged = false;
+
+	{
+		FScopeLock Lock(&EntriesLock);
+
+		TMap<FString, const FSoundVisLibraryEntry*> KnownEntries;
+		KnownEntries.Reserve(Entries.Num());
+
+		for (const FSoundVisLibraryEntry& Entry : Entries)
+		{
+			KnownEntries.Add(Entry.FilePath, &Entry);
+		}
+
+		for (int32 EntryIndex = 0; EntryIndex < FoundEntries.Num(); ++EntryIndex)
+		{
+			FSoundVisLibraryEntry& Entry = FoundEntries[EntryIndex];
+
+			const FSoundVisLibraryEntry* const* KnownEntry = KnownEntries.Find(Entry.FilePath);
+
+			if (KnownEntry && (*KnownEntry)->FileSize == Entry.FileSize && (*KnownEntry)->ModificationTime == Entry.ModificationTime)
+			{
+				Entry = **KnownEntry;
+			}
+			else
+			{
+				ToRead.Add(EntryIndex);
+			}
+		}
+
+		bChanged = ToRead.Num() > 0 || FoundEntries.Num() != Entries.Num();
+	}
+
+	if (!ReadHeaders(FoundEntries, ToRead))
+	{
+		bIsScanning = false;
+
+		return 0;
+	}
+
+	if (bChanged)
+	{
+		SaveIndexFile(FoundEntries);
+
+		FScopeLock Lock(&EntriesLock);
+
+		Exchange(Entries, FoundEntries);
+	}
+
+	UE_LOG(LogSoundVisualization, Log, TEXT("Library scan of %s: %d files, %d headers read in %.2f s"), *RootDirectory, NumFilesFound.GetValue(), ToRead.Num(), FPlatformTime::Seconds() - StartTime);
+
+	bIsScanning = false;
+
+	return 0;
+}
+
+void FSoundVisLibraryIndex::Stop()
+{
+	StopTaskCounter.Increment();
+}
+
+bool FSoundVisLibraryIndex::FindFiles(TArray<FSoundVisLibraryEntry>& _OutEntries)
+{
+	// Size and modification time come with the directory entry, no extra stat per file
+	class FVisitor : public IPlatformFile::FDirectoryStatVisitor
+	{
+
+	public:
+
+		FVisitor(FSoundVisLibraryIndex* _Index, TArray<FSoundVisLibraryEntry>& _Entries)
+			: Index(_Index)
+			, Entries(_Entries)
+		{
+		}
+
+		virtual bool Visit(const TCHAR* _FilenameOrDirectory, const FFileStatData& _StatData) override
+		{
+			if (!_StatData.bIsDirectory && (Index->FileExtension.IsEmpty() || FPaths::GetExtension(_FilenameOrDirectory).Equals(Index->FileExtension, ESearchCase::IgnoreCase)))
+			{
+				FSoundVisLibraryEntry Entry;
+				Entry.FilePath = _FilenameOrDirectory;
+				Entry.FileSize = _StatData.FileSize;
+				Entry.ModificationTime = _StatData.ModificationTime;
+
+				Entries.Add(Entry);
+
+				Index->NumFilesFound.Increment();
+			}
+
+			// Returning false ends the walk
+			return Index->StopTaskCounter.GetValue() == 0;
+		}
+
+	private:
+
+		FSoundVisLibraryIndex* Index;
+		TArray<FSoundVisLibraryEntry>& Entries;
+	};
+
+	FVisitor Visitor(this, _OutEntries);
+
+	FPlatformFileManager::Get().GetPlatformFile().IterateDirectoryStatRecursively(*RootDirectory, Visitor);
+
+	return StopTaskCounter.GetValue() == 0;
+}
+
+bool FSoundVisLibraryIndex::ReadHeaders(TArray<FSoundVisLibraryEntry>& _Entries, const TArray<int32>& _ToRead)
+{
+	NumHeadersToRead.Set(_ToRead.Num());
+
+	if (_ToRead.Num() == 0)
+	{
+		return true;
+	}
+
+	// Leave one core to the game thread. On slow disks the threads mostly wait for the disk, which is the point
+	const int32 NumThreads = FMath::Min(FMath::Clamp(FPlatformMisc::NumberOfCores() - 1, 1, MaxReaderThreads), _ToRead.Num());
+
+	FThreadSafeCounter NextItem;
+
+	TArray<FHeaderReader*> Readers;
+
+	for (int32 ThreadIndex = 0; ThreadIndex < NumThreads; ++ThreadIndex)
+	{
+		Readers.Add(new FHeaderReader(this, &_Entries, &_ToRead, &NextItem, ThreadIndex));
+	}
+
+	for (FHeaderReader* Reader : Readers)
+	{
+		Reader->WaitForCompletion();
+
+		delete Reader;
+	}
+
+	return StopTaskCounter.GetValue() == 0;
+}
+
+void FSoundVisLibraryIndex::ReadHeader(FSoundVisLibraryEntry& _Entry)
+{
+	_Entry.bIsReadable = false;
+	_Entry.Duration = 0.0f;
+	_Entry.SampleRate = 0;
+	_Entry.NumChannels = 0;
+
+	FSoundVisMappedFile File;
+
+	if (!File.Open(_Entry.FilePath) || File.GetSize() > MAX_uint32)
+	{
+		return;
+	}
+
+	FVorbisAudioInfo AudioInfo;
+	FSoundQualityInfo QualityInfo = { 0 };
+
+	// Reads the first pages for the stream info and the last one for the duration
+	if (AudioInfo.ReadCompressedInfo(File.GetData(), (uint32)File.GetSize(), &QualityInfo))
+	{
+		_Entry.Duration = QualityInfo.Duration;
+		_Entry.SampleRate = QualityInfo.SampleRate;
+		_Entry.NumChannels = QualityInfo.NumChannels;
+		_Entry.bIsReadable = true;
+	}
+}
+
+
+/// Queries ///
+
+int32 FSoundVisLibraryIndex::GetNumEntries() const
+{
+	FScopeLock Lock(&EntriesLock);
+
+	return Entries.Num();
+}
+
+void FSoundVisLibraryIndex::Query(const FString& _NameFilter, float _MinDuration, float _MaxDuration, ESoundVisLibrarySort _SortBy, bool _bDescending, TArray<FSoundVisLibraryEntry>& _OutEntries) const
+{
+	_OutEntries.Reset();
+
+	{
+		FScopeLock Lock(&EntriesLock);
+
+		for (const FSoundVisLibraryEntry& Entry : Entries)
+		{
+			if (!Entry.bIsReadable || Entry.Duration < _MinDuration || (_MaxDuration > 0.0f && Entry.Duration > _MaxDuration))
+			{
+				continue;
+			}
+
+			if (!_NameFilter.IsEmpty() && !FPaths::GetCleanFilename(Entry.FilePath).Contains(_NameFilter))
+			{
+				continue;
+			}
+
+			_OutEntries.Add(Entry);
+		}
+	}
+
+	_OutEntries.Sort([_SortBy, _bDescending](const FSoundVisLibraryEntry& _A, const FSoundVisLibraryEntry& _B)
+	{
+		const int32 Result = CompareLibraryEntries(_A, _B, _SortBy);
+
+		return _bDescending ? Result > 0 : Result < 0;
+	});
+}
+
+
+/// Index File ///
+
+bool FSoundVisLibraryIndex::LoadIndexFile()
+{
+	const FString FilePath = GetIndexFilePath(RootDirectory, FileExtension);
+
+	FArchive* Reader = IFileManager::Get().CreateFileReader(*FilePath, FILEREAD_Silent);
+
+	if (!Reader)
+	{
+		// Never scanned yet
+		return false;
+	}
+
+	uint32 Magic = 0;
+	uint32 Version = 0;
+	FString IndexRootDirectory;
+	FString IndexFileExtension;
+	int32 NumEntries = 0;
+
+	*Reader << Magic;
+	*Reader << Version;
+
+	TArray<FSoundVisLibraryEntry> LoadedEntries;
+
+	bool bValid = !Reader->IsError() && Magic == FileMagic && Version == FileVersion;
+
+	if (bValid)
+	{
+		*Reader << IndexRootDirectory;
+		*Reader << IndexFileExtension;
+		*Reader << NumEntries;
+
+		// An entry takes more than one byte, so a bigger count can only come from a broken file
+		bValid = !Reader->IsError() && IndexRootDirectory == RootDirectory && IndexFileExtension == FileExtension && NumEntries >= 0 && NumEntries <= Reader->TotalSize();
+	}
+
+	if (bValid)
+	{
+		LoadedEntries.SetNum(NumEntries);
+
+		for (FSoundVisLibraryEntry& Entry : LoadedEntries)
+		{
+			SerializeLibraryEntry(*Reader, Entry);
+		}
+
+		bValid = !Reader->IsError();
+	}
+
+	delete Reader;
+
+	if (!bValid)
+	{
+		// The next scan reads every header again and writes a new one
+		UE_LOG(LogSoundVisualization, Warning, TEXT("Ignoring library index %s (old version or broken)"), *FilePath);
+
+		return false;
+	}
+
+	FScopeLock Lock(&EntriesLock);
+
+	Exchange(Entries, LoadedEntries);
+
+	return true;
+}
+
+bool FSoundVisLibraryIndex::SaveIndexFile(const TArray<FSoundVisLibraryEntry>& _Entries) const
+{
+	const FString FilePath = GetIndexFilePath(RootDirectory, FileExtension);
+	const FString TempFilePath = FilePath + TEXT(".tmp");
+
+	FArchive* Writer = IFileManager::Get().CreateFileWriter(*TempFilePath);
+
+	if (!Writer)
+	{
+		return false;
+	}
+
+	uint32 Magic = FileMagic;
+	uint32 Version = FileVersion;
+	FString IndexRootDirectory = RootDirectory;
+	FString IndexFileExtension = FileExtension;
+	int32 NumEntries = _Entries.Num();
+
+	*Writer << Magic;
+	*Writer << Version;
+	*Writer << IndexRootDirectory;
+	*Writer << IndexFileExtension;
+	*Writer << NumEntries;
+
+	for (const FSoundVisLibraryEntry& Entry : _Entries)
+	{
+		SerializeLibraryEntry(*Writer, const_cast<FSoundVisLibraryEntry&>(Entry));
+	}
+
+	const bool bWriteFailed = Writer->IsError();
+
+	delete Writer;
+
+	// Goes through a temp file like the analysis cache, so an interrupted write never leaves half an index
+	if (bWriteFailed || !IFileManager::Get().Move(*FilePath, *TempFilePath, true, true))
+	{
+		IFileManager::Get().Delete(*TempFilePath, false, false, true);
+
+		UE_LOG(LogSoundVisualization, Warning, TEXT("Couldn't write library index %s"), *FilePath);
+
+		return false;
+	}
+
+	return true;
+}
@@ -0,0 +1,223 @@
+// Copyright 1998-2015 Epic Games, Inc. All Rights Reserved.
+
+#include "eXiSoundVisPrivatePCH.h"
+#include "SoundVisualization.h"
+#include "SoundVisLiveTap.h"
+
+DECLARE_CYCLE_STAT(TEXT("Live Spectrum"), STAT_SoundVisLiveSpectrum, STATGROUP_SoundVis);
+
+/// Ring ///
+
+FSoundVisLiveRing::FSoundVisLiveRing(int32 _NumChannels, int32 _SampleRate, int32 _MinFrames)
+	: NumChannels(_NumChannels)
+	, SampleRate(_SampleRate)
+	, CapacityFrames(0)
+	, Mask(0)
+	, WritePosition(0)
+	, LastWriteTime(0.0)
+{
+	check(NumChannels > 0 && SampleRate > 0);
+
+	// Only half of the ring is readable, see WritePosition
+	CapacityFrames = FMath::RoundUpToPowerOfTwo(FMath::Max(_MinFrames, 1024) * 2);
+	Mask = CapacityFrames - 1;
+
+	Samples.SetNumZeroed(CapacityFrames * NumChannels);
+}
+
+void FSoundVisLiveRing::Write(const int16* _Interleaved, int32 _NumFrames)
+{
+	// Never more than half of the ring at once, so a write in progress can't reach the readable frames
+	while (_NumFrames > 0)
+	{
+		const int32 NumFrames = FMath::Min(_NumFrames, CapacityFrames / 2);
+		const int64 Position = WritePosition;
+
+		CopyIn(Position, _Interleaved, NumFrames);
+
+		// Publishes the position with a full barrier, so the frames are in memory before the reader can see it
+		FPlatformAtomics::InterlockedExchange(&WritePosition, Position + NumFrames);
+
+		_Interleaved += NumFrames * NumChannels;
+		_NumFrames -= NumFrames;
+	}
+
+	LastWriteTime = FPlatformTime::Seconds();
+}
+
+int64 FSoundVisLiveRing::GetWritePosition() const
+{
+	// Atomic read, also on 32 bit platforms
+	return FPlatformAtomics::InterlockedCompareExchange(const_cast<volatile int64*>(&WritePosition), 0, 0);
+}
+
+double FSoundVisLiveRing::GetLastWriteTime() const
+{
+	return LastWriteTime;
+}
+
+bool FSoundVisLiveRing::Read(int64 _FirstFrame, int32 _NumFrames, int16* _OutInterleaved) const
+{
+	const int32 ReadableFrames = CapacityFrames / 2;
+
+	if (_FirstFrame < 0 || _NumFrames <= 0 || _NumFrames > ReadableFrames)
+	{
+		return false;
+	}
+
+	const int64 Position = GetWritePosition();
+
+	if (_FirstFrame + _NumFrames > Position || _FirstFrame < Position - ReadableFrames)
+	{
+		return false;
+	}
+
+	CopyOut(_FirstFrame, _OutInterleaved, _NumFrames);
+
+	// The writer might have moved on while we copied. Whatever it wrote is still half a ring away from what we read if this holds
+	return _FirstFrame >= GetWritePosition() - ReadableFrames;
+}
+
+void FSoundVisLiveRing::CopyIn(int64 _Position, const int16* _Interleaved, int32 _NumFrames)
+{
+	const int32 Slot = (int32)(_Position & Mask);
+	const int32 FramesToEnd = FMath::Min(_NumFrames, CapacityFrames - Slot);
+
+	FMemory::Memcpy(Samples.GetData() + Slot * NumChannels, _Interleaved, FramesToEnd * NumChannels * sizeof(int16));
+	FMemory::Memcpy(Samples.GetData(), _Interleaved + FramesToEnd * NumChannels, (_NumFrames - FramesToEnd) * NumChannels * sizeof(int16));
+}
+
+void FSoundVisLiveRing::CopyOut(int64 _Position, int16* _OutInterleaved, int32 _NumFrames) const
+{
+	const int32 Slot = (int32)(_Position & Mask);
+	const int32 FramesToEnd = FMath::Min(_NumFrames, CapacityFrames - Slot);
+
+	FMemory::Memcpy(_OutInterleaved, Samples.GetData() + Slot * NumChannels, FramesToEnd * NumChannels * sizeof(int16));
+	FMemory::Memcpy(_OutInterleaved + FramesToEnd * NumChannels, Samples.GetData(), (_NumFrames - FramesToEnd) * NumChannels * sizeof(int16));
+}
+
+
+/// Analyzer ///
+
+FSoundVisLiveAnalyzer::FSoundVisLiveAnalyzer(const TSharedRef<FSoundVisLiveRing, ESPMode::ThreadSafe>& _Ring, int32 _FFTSize, int32 _HopSize, ESoundVisWindowType _WindowType, float _StartTime, float _Latency, bool _bFixedPoint)
+	: Ring(_Ring)
+	, FFTSize(_FFTSize)
+	, HopSize(FMath::Max(1, _HopSize))
+	, WindowType(_WindowType)
+	, StartTime(_StartTime)
+	, LatencyFrames(FMath::Max(0, FMath::RoundToInt(_Latency * _Ring->GetSampleRate())))
+	, MagnitudesTime(0.0f)
+	, Thread(NULL)
+{
+	WindowSamples.SetNumUninitialized(FFTSize * Ring->GetNumChannels());
+	WorkMagnitudes.SetNumUninitialized(FFTSize / 2);
+
+	// Before the thread starts, it owns the context from then on
+	FFTContext.SetFixedPoint(_bFixedPoint);
+
+	Thread = FRunnableThread::Create(this, TEXT("FSoundVisLiveAnalyzer"), 0, TPri_BelowNormal);
+}
+
+FSoundVisLiveAnalyzer::~FSoundVisLiveAnalyzer()
+{
+	if (Thread)
+	{
+		Stop();
+		Thread->WaitForCompletion();
+
+		delete Thread;
+		Thread = NULL;
+	}
+}
+
+uint32 FSoundVisLiveAnalyzer::Run()
+{
+	const int32 SampleRate = Ring->GetSampleRate();
+	const int32 NumChannels = Ring->GetNumChannels();
+
+	int64 LastCenterFrame = INDEX_NONE;
+
+	while (StopTaskCounter.GetValue() == 0)
+	{
+		FPlatformProcess::Sleep((float)HopSize / SampleRate);
+
+		const int64 CenterFrame = GetPlaybackFrame();
+
+		// Paused or ended, the last spectrum stays
+		if (CenterFrame == LastCenterFrame)
+		{
+			continue;
+		}
+
+		// With a small latency the window can't be centered, it ends at the newest frame then
+		const int64 FirstFrame = FMath::Min<int64>(CenterFrame - FFTSize / 2, Ring->GetWritePosition() - FFTSize);
+
+		if (FirstFrame < 0 || !Ring->Read(FirstFrame, FFTSize, WindowSamples.GetData()))
+		{
+			continue;
+		}
+
+		{
+			SCOPE_CYCLE_COUNTER(STAT_SoundVisLiveSpectrum);
+
+			FFTContext.CalculateMagnitudes(WindowSamples.GetData(), NumChannels, FFTSize, WindowType, WorkMagnitudes.GetData());
+		}
+
+		{
+			FScopeLock Lock(&ResultLock);
+
+			Exchange(Magnitudes, WorkMagnitudes);
+
+			MagnitudesTime = StartTime + (float)(FirstFrame + FFTSize / 2) / SampleRate;
+		}
+
+		// Holds the previous result after the exchange, or nothing the first time
+		WorkMagnitudes.SetNumUninitialized(FFTSize / 2);
+
+		LastCenterFrame = CenterFrame;
+	}
+
+	return 0;
+}
+
+void FSoundVisLiveAnalyzer::Stop()
+{
+	StopTaskCounter.Increment();
+}
+
+int64 FSoundVisLiveAnalyzer::GetPlaybackFrame() const
+{
+	const int64 WritePosition = Ring->GetWritePosition();
+
+	if (WritePosition == 0)
+	{
+		return 0;
+	}
+
+	// The device renders in bursts and plays them afterwards, so the heard frame moves on with the clock in between
+	const double SinceLastWrite = FPlatformTime::Seconds() - Ring->GetLastWriteTime();
+
+	const int64 Frame = WritePosition - LatencyFrames + (int64)(SinceLastWrite * Ring->GetSampleRate());
+
+	return FMath::Clamp<int64>(Frame, 0, WritePosition);
+}
+
+float FSoundVisLiveAnalyzer::GetPlaybackTime() const
+{
+	return StartTime + (float)GetPlaybackFrame() / Ring->GetSampleRate();
+}
+
+bool FSoundVisLiveAnalyzer::GetSpectrum(TArray<float>& _OutMagnitudes, float& _OutTime) const
+{
+	FScopeLock Lock(&ResultLock);
+
+	if (Magnitudes.Num() == 0)
+	{
+		return false;
+	}
+
+	_OutMagnitudes = Magnitudes;
+	_OutTime = MagnitudesTime;
+
+	return true;
+}
@@ -0,0 +1,67 @@
+// Copyright 1998-2015 Epic Games, Inc. All Rights Reserved.
+
+#include "eXiSoundVisPrivatePCH.h"
+#include "SoundVisualization.h"
+#include "SoundVisLoadSoundFileAction.h"
+
+USoundVisLoadSoundFileAction* USoundVisLoadSoundFileAction::SV_LoadSoundFileFromHDAsync(USoundVisualization* _SoundVisualization, const FString _FilePath)
+{
+	USoundVisLoadSoundFileAction* Action = NewObject<USoundVisLoadSoundFileAction>();
+
+	Action->SoundVisualization = _SoundVisualization;
+	Action->FilePath = _FilePath;
+	Action->LastProgress = 0.0f;
+
+	return Action;
+}
+
+void USoundVisLoadSoundFileAction::Activate()
+{
+	if (!SoundVisualization)
+	{
+		OnFailed.Broadcast(0.0f);
+
+		return;
+	}
+
+	// Nothing else references the action while the decode runs
+	AddToRoot();
+
+	// The callbacks can come after the action is gone, e.g. when the game ends during a decode
+	TWeakObjectPtr<USoundVisLoadSoundFileAction> WeakThis(this);
+
+	FSoundVisDecodeCallbacks Callbacks;
+
+	Callbacks.OnProgress = [WeakThis](float _Progress)
+	{
+		if (WeakThis.IsValid())
+		{
+			WeakThis->LastProgress = _Progress;
+			WeakThis->OnProgress.Broadcast(_Progress);
+		}
+	};
+
+	Callbacks.OnFinished = [WeakThis](bool _bSuccess)
+	{
+		if (WeakThis.IsValid())
+		{
+			WeakThis->Finish(_bSuccess);
+		}
+	};
+
+	SoundVisualization->LoadSoundFileFromHD(FilePath, &Callbacks);
+}
+
+void USoundVisLoadSoundFileAction::Finish(bool _bSuccess)
+{
+	if (_bSuccess)
+	{
+		OnDecoded.Broadcast(1.0f);
+	}
+	else
+	{
+		OnFailed.Broadcast(LastProgress);
+	}
+
+	RemoveFromRoot();
+}
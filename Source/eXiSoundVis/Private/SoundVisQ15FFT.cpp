@@ -0,0 +1,524 @@
+// Copyright 1998-2015 Epic Games, Inc. All Rights Reserved.
+
+#include "eXiSoundVisPrivatePCH.h"
+#include "SoundVisQ15FFT.h"
+#include "SoundVisSimd.h"
+
+namespace SoundVisQ15
+{
+	// Largest value of a stage input that can't overflow without halving. Its complex magnitude stays below 16384,
+	// so a + w b stays below 32768 in both parts. This holds for the stages with trivial twiddles too: their parts
+	// would fit up to 16383, but the complex magnitudes they'd leave behind overflow the later, halved stages
+	static const int32 MaxUnscaledValue = 11583;
+
+	FORCEINLINE int16 Saturate(int32 _Value)
+	{
+		return (int16)FMath::Clamp(_Value, -32768, 32767);
+	}
+
+	// _Value rounded to Q15, 1.0 becomes 32767
+	FORCEINLINE int16 ToQ15(double _Value)
+	{
+		return Saturate(FMath::RoundToInt((float)(_Value * 32767.0)));
+	}
+
+#if SOUNDVIS_SSE
+	// Largest absolute value of the 8 lanes of _Max and _Min
+	FORCEINLINE int32 ReduceMaxValue(__m128i _Max, __m128i _Min)
+	{
+		int16 MaxValues[8], MinValues[8];
+		_mm_storeu_si128((__m128i*)MaxValues, _Max);
+		_mm_storeu_si128((__m128i*)MinValues, _Min);
+
+		int32 MaxValue = 0;
+
+		for (int32 Lane = 0; Lane < 8; ++Lane)
+		{
+			MaxValue = FMath::Max(MaxValue, FMath::Max((int32)MaxValues[Lane], -(int32)MinValues[Lane]));
+		}
+
+		return MaxValue;
+	}
+
+	// (x + y + 1) >> 1 without leaving 16 bits: the unsigned average of the sign flipped values
+	FORCEINLINE __m128i HalvedAdd(__m128i _X, __m128i _Y)
+	{
+		const __m128i SignFlip = _mm_set1_epi16((int16)0x8000);
+
+		return _mm_xor_si128(_mm_avg_epu16(_mm_xor_si128(_X, SignFlip), _mm_xor_si128(_Y, SignFlip)), SignFlip);
+	}
+#endif
+
+	// Largest absolute part of _Num interleaved complex values
+	int32 GetMaxValue(const int16* _Data, int32 _Num)
+	{
+		int32 MaxValue = 0;
+		int32 Index = 0;
+
+#if SOUNDVIS_SSE
+		__m128i Max = _mm_setzero_si128();
+		__m128i Min = _mm_setzero_si128();
+
+		for (; Index + 8 <= _Num * 2; Index += 8)
+		{
+			const __m128i Values = _mm_loadu_si128((const __m128i*)(_Data + Index));
+
+			Max = _mm_max_epi16(Max, Values);
+			Min = _mm_min_epi16(Min, Values);
+		}
+
+		MaxValue = ReduceMaxValue(Max, Min);
+#endif
+
+		for (; Index < _Num * 2; ++Index)
+		{
+			MaxValue = FMath::Max(MaxValue, FMath::Abs((int32)_Data[Index]));
+		}
+
+		return MaxValue;
+	}
+
+	/**
+		The stages of half size 1 and 2 over _Num complex values. Their twiddles are exactly 1 (and -i for the second value of size 2),
+		so they need no multiplies and no table, which the Q15 twiddles couldn't represent anyway. Halved if _bHalve, returns the largest
+		absolute part it wrote
+	*/
+	int32 TrivialStage(int16* _Data, int32 _Num, int32 _Half, bool _bHalve)
+	{
+		check(_Half == 1 || _Half == 2);
+
+		int32 ScalarStart = 0;
+		int32 MaxValue = 0;
+
+#if SOUNDVIS_SSE
+		// 4 complex values per register, one 32 bit lane each. The lanes of w b and -w b are picked with masks
+		{
+			const __m128i Zero = _mm_setzero_si128();
+
+			__m128i Max = Zero;
+			__m128i Min = Zero;
+
+			for (int32 Index = 0; Index + 4 <= _Num; Index += 4)
+			{
+				const __m128i Values = _mm_loadu_si128((const __m128i*)(_Data + Index * 2));
+
+				__m128i A, Product;
+
+				if (_Half == 1)
+				{
+					// a0 b0 a1 b1: a0 a0 a1 a1 and b0 -b0 b1 -b1
+					const __m128i B = _mm_shuffle_epi32(Values, _MM_SHUFFLE(3, 3, 1, 1));
+					const __m128i OddLanes = _mm_setr_epi32(0, -1, 0, -1);
+
+					A = _mm_shuffle_epi32(Values, _MM_SHUFFLE(2, 2, 0, 0));
+					Product = _mm_or_si128(_mm_andnot_si128(OddLanes, B), _mm_and_si128(OddLanes, _mm_subs_epi16(Zero, B)));
+				}
+				else
+				{
+					// a0 a1 b0 b1: a0 a1 a0 a1 and b0, -i b1, -b0, i b1. -i (r, i) is (i, -r)
+					const __m128i B = _mm_shuffle_epi32(Values, _MM_SHUFFLE(3, 2, 3, 2));
+					const __m128i Swapped = _mm_shufflehi_epi16(_mm_shufflelo_epi16(B, _MM_SHUFFLE(2, 3, 0, 1)), _MM_SHUFFLE(2, 3, 0, 1));
+
+					A = _mm_shuffle_epi32(Values, _MM_SHUFFLE(1, 0, 1, 0));
+					Product = _mm_or_si128(
+						_mm_or_si128(_mm_and_si128(_mm_setr_epi16(-1, -1, 0, 0, 0, 0, 0, 0), B), _mm_and_si128(_mm_setr_epi16(0, 0, 0, 0, -1, -1, 0, 0), _mm_subs_epi16(Zero, B))),
+						_mm_or_si128(_mm_and_si128(_mm_setr_epi16(0, 0, -1, 0, 0, 0, 0, -1), Swapped), _mm_and_si128(_mm_setr_epi16(0, 0, 0, -1, 0, 0, -1, 0), _mm_subs_epi16(Zero, Swapped))));
+				}
+
+				const __m128i Result = _bHalve ? HalvedAdd(A, Product) : _mm_adds_epi16(A, Product);
+
+				_mm_storeu_si128((__m128i*)(_Data + Index * 2), Result);
+
+				Max = _mm_max_epi16(Max, Result);
+				Min = _mm_min_epi16(Min, Result);
+			}
+
+			MaxValue = ReduceMaxValue(Max, Min);
+			ScalarStart = _Num & ~3;
+		}
+#endif
+
+		for (int32 Group = ScalarStart; Group < _Num; Group += _Half * 2)
+		{
+			int16* A = _Data + Group * 2;
+			int16* B = A + _Half * 2;
+
+			for (int32 Index = 0; Index < _Half; ++Index)
+			{
+				const int32 BR = B[Index * 2];
+				const int32 BI = B[Index * 2 + 1];
+
+				// w b for w = 1, or w = -i
+				const int32 Real = Index == 0 ? BR : BI;
+				const int32 Imag = Index == 0 ? BI : -BR;
+
+				const int32 AR = A[Index * 2];
+				const int32 AI = A[Index * 2 + 1];
+
+				int32 Values[4] = { AR + Real, AI + Imag, AR - Real, AI - Imag };
+
+				for (int32 ValueIndex = 0; ValueIndex < 4; ++ValueIndex)
+				{
+					Values[ValueIndex] = Saturate(_bHalve ? (Values[ValueIndex] + 1) >> 1 : Values[ValueIndex]);
+
+					MaxValue = FMath::Max(MaxValue, FMath::Abs(Values[ValueIndex]));
+				}
+
+				A[Index * 2] = (int16)Values[0];
+				A[Index * 2 + 1] = (int16)Values[1];
+				B[Index * 2] = (int16)Values[2];
+				B[Index * 2 + 1] = (int16)Values[3];
+			}
+		}
+
+		return MaxValue;
+	}
+
+	/**
+		One radix 2 stage of half size _Half over _Num complex values: a + w b and a - w b, halved if _bHalve.
+		_Twiddles holds the (wr, -wi) pairs of the stage followed by its (wi, wr) pairs. Returns the largest absolute part it wrote
+	*/
+	int32 Radix2Stage(int16* _Data, const int16* _Twiddles, int32 _Num, int32 _Half, bool _bHalve)
+	{
+		const int16* RealTwiddles = _Twiddles;
+		const int16* ImagTwiddles = _Twiddles + _Half * 2;
+
+		int32 ScalarStart = 0;
+		int32 MaxValue = 0;
+
+#if SOUNDVIS_SSE
+		// Four butterflies per iteration. One madd is the real part of four products w b, the second one the imaginary part
+		if (_Half >= 4)
+		{
+			const __m128i Round = _mm_set1_epi32(1 << 14);
+
+			__m128i Max = _mm_setzero_si128();
+			__m128i Min = _mm_setzero_si128();
+
+			for (int32 Group = 0; Group < _Num; Group += _Half * 2)
+			{
+				int16* A = _Data + Group * 2;
+				int16* B = A + _Half * 2;
+
+				for (int32 Index = 0; Index < _Half; Index += 4)
+				{
+					const __m128i ValueA = _mm_loadu_si128((const __m128i*)(A + Index * 2));
+					const __m128i ValueB = _mm_loadu_si128((const __m128i*)(B + Index * 2));
+
+					const __m128i Real = _mm_srai_epi32(_mm_add_epi32(_mm_madd_epi16(ValueB, _mm_loadu_si128((const __m128i*)(RealTwiddles + Index * 2))), Round), 15);
+					const __m128i Imag = _mm_srai_epi32(_mm_add_epi32(_mm_madd_epi16(ValueB, _mm_loadu_si128((const __m128i*)(ImagTwiddles + Index * 2))), Round), 15);
+
+					// Back to interleaved int16. Both parts of w b are at most |b|, the packing only saturates rounding overshoots
+					const __m128i Packed = _mm_packs_epi32(Real, Imag);
+					const __m128i Product = _mm_unpacklo_epi16(Packed, _mm_unpackhi_epi64(Packed, Packed));
+
+					__m128i Sum, Difference;
+
+					if (_bHalve)
+					{
+						Sum = HalvedAdd(ValueA, Product);
+						Difference = HalvedAdd(ValueA, _mm_subs_epi16(_mm_setzero_si128(), Product));
+					}
+					else
+					{
+						Sum = _mm_adds_epi16(ValueA, Product);
+						Difference = _mm_subs_epi16(ValueA, Product);
+					}
+
+					_mm_storeu_si128((__m128i*)(A + Index * 2), Sum);
+					_mm_storeu_si128((__m128i*)(B + Index * 2), Difference);
+
+					Max = _mm_max_epi16(Max, _mm_max_epi16(Sum, Difference));
+					Min = _mm_min_epi16(Min, _mm_min_epi16(Sum, Difference));
+				}
+			}
+
+			MaxValue = ReduceMaxValue(Max, Min);
+			ScalarStart = _Num;
+		}
+#endif
+
+		for (int32 Group = ScalarStart; Group < _Num; Group += _Half * 2)
+		{
+			int16* A = _Data + Group * 2;
+			int16* B = A + _Half * 2;
+
+			for (int32 Index = 0; Index < _Half; ++Index)
+			{
+				const int32 BR = B[Index * 2];
+				const int32 BI = B[Index * 2 + 1];
+
+				const int32 Real = (BR * RealTwiddles[Index * 2] + BI * RealTwiddles[Index * 2 + 1] + (1 << 14)) >> 15;
+				const int32 Imag = (BR * ImagTwiddles[Index * 2] + BI * ImagTwiddles[Index * 2 + 1] + (1 << 14)) >> 15;
+
+				const int32 AR = A[Index * 2];
+				const int32 AI = A[Index * 2 + 1];
+
+				int32 Values[4] = { AR + Real, AI + Imag, AR - Real, AI - Imag };
+
+				for (int32 ValueIndex = 0; ValueIndex < 4; ++ValueIndex)
+				{
+					// Same rounding as the SSE average
+					Values[ValueIndex] = Saturate(_bHalve ? (Values[ValueIndex] + 1) >> 1 : Values[ValueIndex]);
+
+					MaxValue = FMath::Max(MaxValue, FMath::Abs(Values[ValueIndex]));
+				}
+
+				A[Index * 2] = (int16)Values[0];
+				A[Index * 2 + 1] = (int16)Values[1];
+				B[Index * 2] = (int16)Values[2];
+				B[Index * 2 + 1] = (int16)Values[3];
+			}
+		}
+
+		return MaxValue;
+	}
+
+	// |2 X[k]| of the packed spectrum, see CalculateMagnitudes
+	FORCEINLINE float SplitMagnitude(const int16* _Values, int32 _Bin, int32 _Mirror, float _WR, float _WI)
+	{
+		const float ZR = _Values[_Bin * 2];
+		const float ZI = _Values[_Bin * 2 + 1];
+		const float MR = _Values[_Mirror * 2];
+		const float MI = _Values[_Mirror * 2 + 1];
+
+		const float OddR = ZI + MI;
+		const float OddI = MR - ZR;
+
+		const float Real = ZR + MR + _WR * OddR - _WI * OddI;
+		const float Imag = ZI - MI + _WR * OddI + _WI * OddR;
+
+		return FMath::Sqrt(Real * Real + Imag * Imag);
+	}
+
+#if SOUNDVIS_SSE
+	// Real and imaginary parts of 4 interleaved int16 complex values as floats
+	FORCEINLINE void LoadParts(__m128i _Values, __m128& _OutReal, __m128& _OutImag)
+	{
+		const __m128 Low = _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpacklo_epi16(_Values, _Values), 16));
+		const __m128 High = _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpackhi_epi16(_Values, _Values), 16));
+
+		_OutReal = _mm_shuffle_ps(Low, High, _MM_SHUFFLE(2, 0, 2, 0));
+		_OutImag = _mm_shuffle_ps(Low, High, _MM_SHUFFLE(3, 1, 3, 1));
+	}
+#endif
+}
+
+
+/// De-/Constructurs ///
+
+FSoundVisQ15FFT::FSoundVisQ15FFT()
+	: Size(0)
+{
+}
+
+
+/// Tables ///
+
+void FSoundVisQ15FFT::Build(int32 _Size)
+{
+	check(SupportsSize(_Size));
+
+	Size = _Size;
+
+	const int32 NumValues = _Size / 2;
+	const int32 NumBits = FMath::FloorLog2(NumValues);
+
+	BitReverse.SetNumUninitialized(NumValues);
+
+	for (int32 Index = 0; Index < NumValues; ++Index)
+	{
+		int32 Reversed = 0;
+
+		for (int32 Bit = 0; Bit < NumBits; ++Bit)
+		{
+			Reversed |= ((Index >> Bit) & 1) << (NumBits - 1 - Bit);
+		}
+
+		BitReverse[Index] = Reversed;
+	}
+
+	// 4 (H - 1) values before the stage of half size H, 4 H for the stage itself
+	StageTwiddles.SetNumUninitialized(FMath::Max(4 * (NumValues - 1), 4));
+
+	for (int32 Half = 1; Half < NumValues; Half *= 2)
+	{
+		int16* RealTwiddles = StageTwiddles.GetData() + 4 * (Half - 1);
+		int16* ImagTwiddles = RealTwiddles + Half * 2;
+
+		for (int32 Index = 0; Index < Half; ++Index)
+		{
+			// exp(-2 pi i Index / (2 Half)), in double like the float kernels
+			const double Phase = -PI * Index / Half;
+
+			const int16 WR = SoundVisQ15::ToQ15(cos(Phase));
+			const int16 WI = SoundVisQ15::ToQ15(sin(Phase));
+
+			RealTwiddles[Index * 2] = WR;
+			RealTwiddles[Index * 2 + 1] = -WI;
+			ImagTwiddles[Index * 2] = WI;
+			ImagTwiddles[Index * 2 + 1] = WR;
+		}
+	}
+
+	// The split runs in float, so its twiddles don't need to be Q15
+	SplitTwiddles.SetNumUninitialized(NumValues * 2);
+
+	for (int32 Index = 0; Index < NumValues; ++Index)
+	{
+		const double Phase = -2.0 * PI * Index / _Size;
+
+		SplitTwiddles[Index] = (float)cos(Phase);
+		SplitTwiddles[NumValues + Index] = (float)sin(Phase);
+	}
+}
+
+void FSoundVisQ15FFT::QuantizeWindow(const float* _Window, int32 _NumFrames, int16* _OutWindow)
+{
+	for (int32 FrameIndex = 0; FrameIndex < _NumFrames; ++FrameIndex)
+	{
+		_OutWindow[FrameIndex] = SoundVisQ15::ToQ15(_Window[FrameIndex]);
+	}
+}
+
+
+/// Transforms ///
+
+void FSoundVisQ15FFT::WindowChannel(const int16* _Interleaved, int32 _NumChannels, int32 _Channel, int32 _NumFrames, const int16* _Window, int16* _OutSamples) const
+{
+	check(_NumFrames <= Size);
+
+	// The bit reversal spreads the padding over the whole block, so it's cleared first
+	if (_NumFrames < Size)
+	{
+		FMemory::Memzero(_OutSamples, Size * sizeof(int16));
+	}
+
+	const int32* Reversed = BitReverse.GetData();
+
+	int32 FrameIndex = 0;
+
+#if SOUNDVIS_SSE
+	// 8 frames per loop for mono and stereo, surround takes the scalar loop
+	if (_NumChannels <= 2)
+	{
+		for (; FrameIndex + 8 <= _NumFrames; FrameIndex += 8)
+		{
+			__m128i Samples;
+
+			if (_NumChannels == 1)
+			{
+				Samples = _mm_loadu_si128((const __m128i*)(_Interleaved + FrameIndex));
+			}
+			else
+			{
+				// Each int32 lane holds one frame, left in the low half and right in the high half
+				const __m128i Low = _mm_loadu_si128((const __m128i*)(_Interleaved + FrameIndex * 2));
+				const __m128i High = _mm_loadu_si128((const __m128i*)(_Interleaved + FrameIndex * 2 + 8));
+
+				Samples = _Channel == 0
+					? _mm_packs_epi32(_mm_srai_epi32(_mm_slli_epi32(Low, 16), 16), _mm_srai_epi32(_mm_slli_epi32(High, 16), 16))
+					: _mm_packs_epi32(_mm_srai_epi32(Low, 16), _mm_srai_epi32(High, 16));
+			}
+
+			const __m128i Window = _mm_loadu_si128((const __m128i*)(_Window + FrameIndex));
+
+			// (s w + 2^15) >> 16 is the high half of the product plus the top bit of the low half
+			__m128i Windowed = _mm_add_epi16(_mm_mulhi_epi16(Samples, Window), _mm_srli_epi16(_mm_mullo_epi16(Samples, Window), 15));
+
+			// Four complex values, each to its bit reversed place
+			for (int32 PairIndex = FrameIndex / 2; PairIndex < FrameIndex / 2 + 4; ++PairIndex)
+			{
+				const int32 Pair = _mm_cvtsi128_si32(Windowed);
+
+				FMemory::Memcpy(_OutSamples + Reversed[PairIndex] * 2, &Pair, sizeof(Pair));
+
+				Windowed = _mm_srli_si128(Windowed, 4);
+			}
+		}
+	}
+#endif
+
+	// Q15 product, one bit further down for the halving
+	for (; FrameIndex < _NumFrames; ++FrameIndex)
+	{
+		const int32 Sample = _Interleaved[FrameIndex * _NumChannels + _Channel];
+
+		_OutSamples[Reversed[FrameIndex / 2] * 2 + (FrameIndex & 1)] = (int16)((Sample * _Window[FrameIndex] + (1 << 15)) >> 16);
+	}
+}
+
+int32 FSoundVisQ15FFT::ComplexForward(int16* _Data) const
+{
+	const int32 NumValues = Size / 2;
+
+	// Every stage returns the largest value it wrote, the next stage decides from that if it has to halve
+	int32 MaxValue = SoundVisQ15::GetMaxValue(_Data, NumValues);
+	int32 NumHalvings = 0;
+
+	for (int32 Half = 1; Half < NumValues; Half *= 2)
+	{
+		const bool bHalve = MaxValue > SoundVisQ15::MaxUnscaledValue;
+
+		NumHalvings += bHalve ? 1 : 0;
+
+		MaxValue = Half <= 2
+			? SoundVisQ15::TrivialStage(_Data, NumValues, Half, bHalve)
+			: SoundVisQ15::Radix2Stage(_Data, StageTwiddles.GetData() + 4 * (Half - 1), NumValues, Half, bHalve);
+	}
+
+	return NumHalvings;
+}
+
+void FSoundVisQ15FFT::CalculateMagnitudes(int16* _Samples, float* _OutMagnitudes) const
+{
+	const int32 NumValues = Size / 2;
+
+	// WindowChannel halved the samples once already
+	const int32 NumHalvings = ComplexForward(_Samples) + 1;
+
+	// The split below yields twice the bins
+	const float Scale = (float)(1 << NumHalvings) * 0.5f;
+
+	const float* Cosines = SplitTwiddles.GetData();
+	const float* Sines = Cosines + NumValues;
+
+	// Even samples went into the real parts, odd ones into the imaginary parts. With Z[k] and conj(Z[N - k]):
+	// 2 X[k] = (Z[k] + conj(Z[N - k])) - i W^k (Z[k] - conj(Z[N - k])), W = exp(-2 pi i / Size). The sums of two int16
+	// parts are exact in float, only the twiddle products round
+	int32 BinIndex = 0;
+
+#if SOUNDVIS_SSE
+	// Bin 0 is its own mirror and goes through the scalar loop. From bin 1 on, the mirrors of 4 bins are the 4 values below N - k, in reverse
+	_OutMagnitudes[0] = SoundVisQ15::SplitMagnitude(_Samples, 0, 0, Cosines[0], Sines[0]) * Scale;
+
+	for (BinIndex = 1; BinIndex + 4 <= NumValues; BinIndex += 4)
+	{
+		__m128 ZR, ZI, MR, MI;
+
+		SoundVisQ15::LoadParts(_mm_loadu_si128((const __m128i*)(_Samples + BinIndex * 2)), ZR, ZI);
+		SoundVisQ15::LoadParts(_mm_loadu_si128((const __m128i*)(_Samples + (NumValues - BinIndex - 3) * 2)), MR, MI);
+
+		MR = _mm_shuffle_ps(MR, MR, _MM_SHUFFLE(0, 1, 2, 3));
+		MI = _mm_shuffle_ps(MI, MI, _MM_SHUFFLE(0, 1, 2, 3));
+
+		const __m128 EvenR = _mm_add_ps(ZR, MR);
+		const __m128 EvenI = _mm_sub_ps(ZI, MI);
+		const __m128 OddR = _mm_add_ps(ZI, MI);
+		const __m128 OddI = _mm_sub_ps(MR, ZR);
+
+		const __m128 WR = _mm_loadu_ps(Cosines + BinIndex);
+		const __m128 WI = _mm_loadu_ps(Sines + BinIndex);
+
+		const __m128 Real = _mm_add_ps(EvenR, _mm_sub_ps(_mm_mul_ps(WR, OddR), _mm_mul_ps(WI, OddI)));
+		const __m128 Imag = _mm_add_ps(EvenI, _mm_add_ps(_mm_mul_ps(WR, OddI), _mm_mul_ps(WI, OddR)));
+
+		_mm_storeu_ps(_OutMagnitudes + BinIndex, _mm_mul_ps(_mm_sqrt_ps(_mm_add_ps(_mm_mul_ps(Real, Real), _mm_mul_ps(Imag, Imag))), _mm_set1_ps(Scale)));
+	}
+#endif
+
+	for (; BinIndex < NumValues; ++BinIndex)
+	{
+		_OutMagnitudes[BinIndex] = SoundVisQ15::SplitMagnitude(_Samples, BinIndex, (NumValues - BinIndex) & (NumValues - 1), Cosines[BinIndex], Sines[BinIndex]) * Scale;
+	}
+}
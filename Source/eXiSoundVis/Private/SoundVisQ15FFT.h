@@ -0,0 +1,69 @@
+// Copyright 1998-2015 Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+/**
+	Fixed point real FFT for the analyzers that run with bFixedPointAnalysis. The samples stay int16 from the song to the
+	butterflies, window and twiddles are Q15. Only the last pass, which splits the packed result into the real spectrum,
+	runs in float and writes the magnitudes in the units of the float FFT. A window of 4096 samples moves 8 KB through the
+	stages instead of the 16 KB of the float planes and complex bins.
+
+	Radix 2 stages with block floating point: a stage only halves its values if they could overflow, and the magnitudes
+	are scaled back by the halvings at the end. Loud songs lose about as much precision as with kiss_fft's FIXED_POINT
+	build (which halves every stage), quiet songs keep theirs.
+
+	Power of two sizes from MinSize to MaxSize. Built once per size and only read afterwards, so threads can share one.
+*/
+class FSoundVisQ15FFT : public FNoncopyable
+{
+
+public:
+
+	static const int32 MinSize = 16;
+
+	// The tables of the largest size take about 640 KB
+	static const int32 MaxSize = 65536;
+
+	static bool SupportsSize(int32 _Size)
+	{
+		return _Size >= MinSize && _Size <= MaxSize && FMath::IsPowerOfTwo(_Size);
+	}
+
+	FSoundVisQ15FFT();
+
+	// Creates the tables for real FFTs of _Size samples
+	void Build(int32 _Size);
+
+	int32 GetSize() const
+	{
+		return Size;
+	}
+
+	// Q15 copy of a float window, 1.0 becomes 32767
+	static void QuantizeWindow(const float* _Window, int32 _NumFrames, int16* _OutWindow);
+
+	// Windows channel _Channel of _NumFrames interleaved frames into _OutSamples and zero pads up to GetSize().
+	// The samples are halved, so a packed pair of them never leaves the int16 range. Every pair is written to
+	// its bit reversed place, the order the butterflies read them in
+	void WindowChannel(const int16* _Interleaved, int32 _NumChannels, int32 _Channel, int32 _NumFrames, const int16* _Window, int16* _OutSamples) const;
+
+	// Magnitudes of the lower GetSize() / 2 bins of the samples WindowChannel wrote. _Samples are transformed in place
+	void CalculateMagnitudes(int16* _Samples, float* _OutMagnitudes) const;
+
+private:
+
+	// In place complex FFT of GetSize() / 2 interleaved Q15 values in bit reversed order. Returns how often the stages halved the values
+	int32 ComplexForward(int16* _Data) const;
+
+	int32 Size;
+
+	// Bit reversed index of every complex value, where WindowChannel puts it
+	TArray<int32> BitReverse;
+
+	// Per stage of half size H, starting at 4 * (H - 1): H pairs (wr, -wi) for the real part, then H pairs (wi, wr) for the imaginary part.
+	// The stages of half size 1 and 2 only multiply by 1 and -i and don't read theirs
+	TArray<int16> StageTwiddles;
+
+	// cos and sin of -2 pi k / Size, all cosines first, for splitting the packed result into the real spectrum
+	TArray<float> SplitTwiddles;
+};
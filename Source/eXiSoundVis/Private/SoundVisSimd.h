@@ -0,0 +1,18 @@
+// Copyright 1998-2015 Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+// Instruction set of the vectorized loops, picked at compile time. SOUNDVIS_SSE means SSE2, SOUNDVIS_NEON means NEON,
+// with neither the scalar loops run. Include it after the PCH, it needs the PLATFORM_ defines
+#if PLATFORM_ENABLE_VECTORINTRINSICS_NEON
+	#include <arm_neon.h>
+	#define SOUNDVIS_NEON 1
+	#define SOUNDVIS_SSE 0
+#elif PLATFORM_ENABLE_VECTORINTRINSICS
+	#include <emmintrin.h>
+	#define SOUNDVIS_NEON 0
+	#define SOUNDVIS_SSE 1
+#else
+	#define SOUNDVIS_NEON 0
+	#define SOUNDVIS_SSE 0
+#endif
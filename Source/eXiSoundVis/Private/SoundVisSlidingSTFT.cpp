@@ -0,0 +1,141 @@
+// Copyright 1998-2015 Epic Games, Inc. All Rights Reserved.
+
+#include "eXiSoundVisPrivatePCH.h"
+#include "SoundVisualization.h"
+#include "SoundVisSlidingSTFT.h"
+
+DECLARE_CYCLE_STAT(TEXT("Sliding STFT Frame"), STAT_SoundVisSlidingFrame, STATGROUP_SoundVis);
+
+FThreadSafeCounter FSoundVisSlidingSTFT::NumComputedFrames;
+
+/// De-/Constructurs ///
+
+FSoundVisSlidingSTFT::FSoundVisSlidingSTFT()
+	: Song(NULL)
+	, NumChannels(0)
+	, SampleRate(0)
+	, WindowFrames(0)
+	, FFTSize(0)
+	, HopSize(0)
+	, NumFrames(0)
+	, WindowType(ESoundVisWindowType::Hann)
+	, bFixedPoint(false)
+{
+	Reset();
+}
+
+
+/// Configuration ///
+
+void FSoundVisSlidingSTFT::Configure(const UObject* _Song, int32 _NumChannels, int32 _SampleRate, int32 _NumSampleFrames, int32 _WindowFrames, int32 _FFTSize, int32 _HopSize, ESoundVisWindowType _WindowType, bool _bFixedPoint)
+{
+	const int32 NewWindowFrames = _WindowFrames > 0 ? FMath::Min(_WindowFrames, _FFTSize) : _FFTSize;
+	const int32 NewNumFrames = _NumSampleFrames >= NewWindowFrames ? (_NumSampleFrames - NewWindowFrames) / _HopSize + 1 : 0;
+
+	if (_Song == Song && _NumChannels == NumChannels && _SampleRate == SampleRate && NewWindowFrames == WindowFrames && _FFTSize == FFTSize && _HopSize == HopSize && NewNumFrames == NumFrames && _WindowType == WindowType && _bFixedPoint == bFixedPoint)
+	{
+		return;
+	}
+
+	Reset();
+
+	Song = _Song;
+	NumChannels = _NumChannels;
+	SampleRate = _SampleRate;
+	WindowFrames = NewWindowFrames;
+	FFTSize = _FFTSize;
+	HopSize = _HopSize;
+	NumFrames = NewNumFrames;
+	WindowType = _WindowType;
+	bFixedPoint = _bFixedPoint;
+
+	CachedMagnitudes.SetNumUninitialized(NumCachedFrames * GetNumBins());
+}
+
+void FSoundVisSlidingSTFT::Reset()
+{
+	Song = NULL;
+	NumFrames = 0;
+
+	for (int32 SlotIndex = 0; SlotIndex < NumCachedFrames; ++SlotIndex)
+	{
+		CachedFrameIndices[SlotIndex] = INDEX_NONE;
+	}
+}
+
+
+/// Queries ///
+
+bool FSoundVisSlidingSTFT::GetSpectrumAtTime(float _CenterTime, FSoundVisFFTContext& _Context, TFunctionRef<const int16*(int32 _FirstFrame, int32 _NumFrames)> _GetSamples, float* _OutMagnitudes)
+{
+	if (NumFrames <= 0)
+	{
+		return false;
+	}
+
+	// Same mapping as the spectrogram, so both give the same result for the same grid
+	const float FramePosition = FMath::Clamp((_CenterTime * SampleRate - WindowFrames * 0.5f) / HopSize, 0.0f, (float)(NumFrames - 1));
+
+	const int32 FrameIndex = FMath::FloorToInt(FramePosition);
+	const int32 NextFrameIndex = FMath::Min(FrameIndex + 1, NumFrames - 1);
+	const float Alpha = FramePosition - FrameIndex;
+
+	const float* Frame = GetFrame(FrameIndex, _Context, _GetSamples);
+	const float* NextFrame = NextFrameIndex != FrameIndex ? GetFrame(NextFrameIndex, _Context, _GetSamples) : Frame;
+
+	if (!Frame || !NextFrame)
+	{
+		return false;
+	}
+
+	const int32 NumBins = GetNumBins();
+
+	for (int32 BinIndex = 0; BinIndex < NumBins; ++BinIndex)
+	{
+		_OutMagnitudes[BinIndex] = FMath::Lerp(Frame[BinIndex], NextFrame[BinIndex], Alpha);
+	}
+
+	return true;
+}
+
+const float* FSoundVisSlidingSTFT::GetFrame(int32 _FrameIndex, FSoundVisFFTContext& _Context, TFunctionRef<const int16*(int32 _FirstFrame, int32 _NumFrames)> _GetSamples)
+{
+	const int32 SlotIndex = _FrameIndex % NumCachedFrames;
+
+	float* SlotMagnitudes = CachedMagnitudes.GetData() + SlotIndex * GetNumBins();
+
+	if (CachedFrameIndices[SlotIndex] == _FrameIndex)
+	{
+		return SlotMagnitudes;
+	}
+
+	const int16* Samples = _GetSamples(_FrameIndex * HopSize, WindowFrames);
+
+	if (!Samples)
+	{
+		return NULL;
+	}
+
+	SCOPE_CYCLE_COUNTER(STAT_SoundVisSlidingFrame);
+
+	_Context.CalculateMagnitudes(Samples, NumChannels, FFTSize, WindowType, SlotMagnitudes, WindowFrames);
+
+	CachedFrameIndices[SlotIndex] = _FrameIndex;
+
+	NumComputedFrames.Increment();
+
+	return SlotMagnitudes;
+}
+
+
+/// Counters ///
+
+int32 FSoundVisSlidingSTFT::GetNumComputedFrames()
+{
+	return NumComputedFrames.GetValue();
+}
+
+void FSoundVisSlidingSTFT::ResetComputedFrames()
+{
+	NumComputedFrames.Reset();
+}
@@ -0,0 +1,391 @@
+// Copyright 1998-2015 Epic Games, Inc. All Rights Reserved.
+
+#include "eXiSoundVisPrivatePCH.h"
+#include "SoundVisualization.h"
+#include "SoundVisSpectrogram.h"
+#include "SoundVisBeatGrid.h"
+#include "SoundVisEnvelope.h"
+#include "SoundVisKernels.h"
+#include "Async/ParallelFor.h"
+
+DECLARE_CYCLE_STAT(TEXT("Build Spectrogram"), STAT_SoundVisSpectrogramBuild, STATGROUP_SoundVis);
+DECLARE_CYCLE_STAT(TEXT("Spectrogram Lookup"), STAT_SoundVisSpectrogramLookup, STATGROUP_SoundVis);
+
+// Frames a worker computes in one go. Every block brings its own FFT context
+static const int32 SpectrogramFramesPerBlock = 64;
+
+const float FSoundVisSpectrogram::BandEdges[FSoundVisSpectrogram::NumBands + 1] = { 20.0f, 60.0f, 250.0f, 500.0f, 2000.0f, 4000.0f, 6000.0f, 20000.0f };
+
+const float FSoundVisSpectrogram::DecibelStep = 0.75f;
+
+float FSoundVisSpectrogram::DecodeTable[256];
+
+struct FSoundVisSpectrogramTableInitializer
+{
+	FSoundVisSpectrogramTableInitializer()
+	{
+		// 0 stands for everything below a magnitude of 1, which is less than one step of the int16 input
+		FSoundVisSpectrogram::DecodeTable[0] = 0.0f;
+
+		for (int32 Value = 1; Value < 256; ++Value)
+		{
+			FSoundVisSpectrogram::DecodeTable[Value] = FMath::Pow(10.0f, Value * FSoundVisSpectrogram::DecibelStep / 20.0f);
+		}
+	}
+};
+
+static FSoundVisSpectrogramTableInitializer SpectrogramTableInitializer;
+
+/// De-/Constructurs ///
+
+FSoundVisSpectrogram::FSoundVisSpectrogram()
+	: FrameData(NULL)
+	, FrameRMSData(NULL)
+	, BandEnergyData(NULL)
+	, FluxData(NULL)
+	, FFTSize(0)
+	, HopSize(0)
+	, SampleRate(0)
+	, NumFrames(0)
+{
+}
+
+
+/// Building ///
+
+void FSoundVisSpectrogram::EncodeFrame(const float* _Magnitudes, int32 _NumBins, float* _Decibels, uint8* _OutFrame)
+{
+	SoundVisKernels::ConvertMagnitudes(_Magnitudes, _NumBins, ESoundVisSpectrumOutput::Decibels, _Decibels);
+
+	for (int32 BinIndex = 0; BinIndex < _NumBins; ++BinIndex)
+	{
+		_OutFrame[BinIndex] = (uint8)FMath::Clamp(FMath::RoundToInt(_Decibels[BinIndex] / DecibelStep), 0, 255);
+	}
+}
+
+void FSoundVisSpectrogram::Build(const int16* _PCM, int32 _NumChannels, int32 _NumSampleFrames, int32 _SampleRate, int32 _FFTSize, int32 _HopSize, ESoundVisWindowType _WindowType, bool _bFixedPoint, bool _bKeepFrames)
+{
+	SCOPE_CYCLE_COUNTER(STAT_SoundVisSpectrogramBuild);
+
+	bIsReady = false;
+
+	if (!_PCM || _NumSampleFrames < _FFTSize || _FFTSize < 2 || _HopSize <= 0 || bCancelRequested)
+	{
+		return;
+	}
+
+	FFTSize = _FFTSize;
+	HopSize = _HopSize;
+	SampleRate = _SampleRate;
+	NumFrames = (_NumSampleFrames - _FFTSize) / _HopSize + 1;
+
+	const int32 NumBins = GetNumBins();
+
+	// TArray counts in int32. Very long songs get a coarser grid instead of an overflow
+	while (_bKeepFrames && (int64)NumFrames * NumBins > MAX_int32)
+	{
+		HopSize *= 2;
+		NumFrames = (_NumSampleFrames - _FFTSize) / HopSize + 1;
+	}
+
+	if (HopSize != _HopSize)
+	{
+		UE_LOG(LogSoundVisualization, Warning, TEXT("Spectrogram of %d frames doesn't fit, hop raised from %d to %d samples."), _NumSampleFrames, _HopSize, HopSize);
+	}
+
+	if (_bKeepFrames)
+	{
+		Frames.SetNumUninitialized(NumFrames * NumBins);
+	}
+
+	FrameRMS.SetNumUninitialized(NumFrames);
+	BandEnergies.SetNumUninitialized(NumFrames * NumBands);
+	Flux.SetNumUninitialized(NumFrames);
+
+	// Brings the magnitudes back to sample units before the log of the flux, so it doesn't depend on the FFT size
+	const float FluxGain = 1.0f / _FFTSize;
+
+	// First and last bin (exclusive) of every band
+	int32 BandBins[NumBands + 1];
+
+	for (int32 EdgeIndex = 0; EdgeIndex <= NumBands; ++EdgeIndex)
+	{
+		BandBins[EdgeIndex] = FMath::Clamp(FMath::RoundToInt(BandEdges[EdgeIndex] * _FFTSize / _SampleRate), 0, NumBins);
+	}
+
+	const int32 NumBlocks = FMath::DivideAndRoundUp(NumFrames, SpectrogramFramesPerBlock);
+
+	ParallelFor(NumBlocks, [&](int32 BlockIndex)
+	{
+		FSoundVisFFTContext Context;
+
+		// The blocks already keep all cores busy
+		Context.SetParallelChannels(false);
+		Context.SetFixedPoint(_bFixedPoint);
+
+		TArray<float> Magnitudes;
+		TArray<float> Decibels;
+		TArray<float> Previous;
+		TArray<float> Current;
+
+		Magnitudes.SetNumUninitialized(NumBins);
+		Decibels.SetNumUninitialized(NumBins);
+		Previous.SetNumZeroed(NumBins);
+		Current.SetNumUninitialized(NumBins);
+
+		const int32 FirstFrame = BlockIndex * SpectrogramFramesPerBlock;
+		const int32 LastFrame = FMath::Min(FirstFrame + SpectrogramFramesPerBlock, NumFrames);
+
+		// Every block computes the frame before it once more for the flux, so the blocks don't depend on each other
+		if (FirstFrame > 0)
+		{
+			Context.CalculateMagnitudes(_PCM + (int64)(FirstFrame - 1) * HopSize * _NumChannels, _NumChannels, _FFTSize, _WindowType, Magnitudes.GetData());
+
+			for (int32 BinIndex = 0; BinIndex < NumBins; ++BinIndex)
+			{
+				Previous[BinIndex] = FMath::Loge(1.0f + FluxGain * Magnitudes[BinIndex]);
+			}
+		}
+
+		for (int32 FrameIndex = FirstFrame; FrameIndex < LastFrame; ++FrameIndex)
+		{
+			if (bCancelRequested)
+			{
+				return;
+			}
+
+			const int16* FrameSamples = _PCM + (int64)FrameIndex * HopSize * _NumChannels;
+			const float* FrameMagnitudes = Magnitudes.GetData();
+
+			Context.CalculateMagnitudes(FrameSamples, _NumChannels, _FFTSize, _WindowType, Magnitudes.GetData());
+
+			if (_bKeepFrames)
+			{
+				EncodeFrame(FrameMagnitudes, NumBins, Decibels.GetData(), Frames.GetData() + (int64)FrameIndex * NumBins);
+			}
+
+			// Only rising energy counts, a note that ends is no onset
+			float FluxSum = 0.0f;
+
+			for (int32 BinIndex = 0; BinIndex < NumBins; ++BinIndex)
+			{
+				Current[BinIndex] = FMath::Loge(1.0f + FluxGain * FrameMagnitudes[BinIndex]);
+
+				FluxSum += FMath::Max(0.0f, Current[BinIndex] - Previous[BinIndex]);
+			}
+
+			Flux[FrameIndex] = FrameIndex > 0 ? FluxSum / NumBins : 0.0f;
+
+			Exchange(Previous, Current);
+
+			// RMS of the (unwindowed) samples, over all channels
+			double SquareSum = 0.0;
+
+			for (int32 SampleIndex = 0; SampleIndex < _FFTSize * _NumChannels; ++SampleIndex)
+			{
+				SquareSum += FrameSamples[SampleIndex] * FrameSamples[SampleIndex];
+			}
+
+			FrameRMS[FrameIndex] = FMath::Sqrt(SquareSum / (_FFTSize * _NumChannels));
+
+			// Average magnitude of every band
+			float* FrameBands = BandEnergies.GetData() + (int64)FrameIndex * NumBands;
+
+			for (int32 BandIndex = 0; BandIndex < NumBands; ++BandIndex)
+			{
+				float BandSum = 0.0f;
+
+				for (int32 BinIndex = BandBins[BandIndex]; BinIndex < BandBins[BandIndex + 1]; ++BinIndex)
+				{
+					BandSum += FrameMagnitudes[BinIndex];
+				}
+
+				const int32 NumBandBins = BandBins[BandIndex + 1] - BandBins[BandIndex];
+
+				FrameBands[BandIndex] = NumBandBins > 0 ? BandSum / NumBandBins : 0.0f;
+			}
+		}
+	});
+
+	FrameData = _bKeepFrames ? Frames.GetData() : NULL;
+	FrameRMSData = FrameRMS.GetData();
+	BandEnergyData = BandEnergies.GetData();
+	FluxData = Flux.GetData();
+
+	bIsReady = !bCancelRequested;
+}
+
+void FSoundVisSpectrogram::InitFromMemory(const uint8* _Frames, const float* _FrameRMS, const float* _BandEnergies, const float* _Flux, int32 _NumFrames, int32 _SampleRate, int32 _FFTSize, int32 _HopSize)
+{
+	Reset();
+
+	FrameData = _Frames;
+	FrameRMSData = _FrameRMS;
+	BandEnergyData = _BandEnergies;
+	FluxData = _Flux;
+
+	NumFrames = _NumFrames;
+	SampleRate = _SampleRate;
+	FFTSize = _FFTSize;
+	HopSize = _HopSize;
+
+	bIsReady = true;
+}
+
+void FSoundVisSpectrogram::Cancel()
+{
+	bCancelRequested = true;
+}
+
+void FSoundVisSpectrogram::Reset()
+{
+	bIsReady = false;
+	bCancelRequested = false;
+
+	Frames.Empty();
+	FrameRMS.Empty();
+	BandEnergies.Empty();
+	Flux.Empty();
+
+	FrameData = NULL;
+	FrameRMSData = NULL;
+	BandEnergyData = NULL;
+	FluxData = NULL;
+
+	NumFrames = 0;
+}
+
+
+/// Lookup ///
+
+void FSoundVisSpectrogram::GetFramesAtTime(float _CenterTime, int32& _OutFrameIndex, int32& _OutNextFrameIndex, float& _OutAlpha) const
+{
+	check(bIsReady);
+
+	// Frame N covers the samples N * HopSize to N * HopSize + FFTSize
+	const float FramePosition = FMath::Clamp((_CenterTime * SampleRate - FFTSize * 0.5f) / HopSize, 0.0f, (float)(NumFrames - 1));
+
+	_OutFrameIndex = FMath::FloorToInt(FramePosition);
+	_OutNextFrameIndex = FMath::Min(_OutFrameIndex + 1, NumFrames - 1);
+	_OutAlpha = FramePosition - _OutFrameIndex;
+}
+
+void FSoundVisSpectrogram::GetSpectrumAtTime(float _CenterTime, float* _OutMagnitudes) const
+{
+	SCOPE_CYCLE_COUNTER(STAT_SoundVisSpectrogramLookup);
+
+	check(FrameData);
+
+	int32 FrameIndex, NextFrameIndex;
+	float Alpha;
+
+	GetFramesAtTime(_CenterTime, FrameIndex, NextFrameIndex, Alpha);
+
+	const int32 NumBins = GetNumBins();
+
+	const uint8* Frame = FrameData + (int64)FrameIndex * NumBins;
+	const uint8* NextFrame = FrameData + (int64)NextFrameIndex * NumBins;
+
+	for (int32 BinIndex = 0; BinIndex < NumBins; ++BinIndex)
+	{
+		_OutMagnitudes[BinIndex] = FMath::Lerp(DecodeTable[Frame[BinIndex]], DecodeTable[NextFrame[BinIndex]], Alpha);
+	}
+}
+
+void FSoundVisSpectrogram::GetBandEnergiesAtTime(float _CenterTime, float* _OutBandEnergies, float& _OutRMS) const
+{
+	int32 FrameIndex, NextFrameIndex;
+	float Alpha;
+
+	GetFramesAtTime(_CenterTime, FrameIndex, NextFrameIndex, Alpha);
+
+	const float* Bands = BandEnergyData + (int64)FrameIndex * NumBands;
+	const float* NextBands = BandEnergyData + (int64)NextFrameIndex * NumBands;
+
+	for (int32 BandIndex = 0; BandIndex < NumBands; ++BandIndex)
+	{
+		_OutBandEnergies[BandIndex] = FMath::Lerp(Bands[BandIndex], NextBands[BandIndex], Alpha);
+	}
+
+	_OutRMS = FMath::Lerp(FrameRMSData[FrameIndex], FrameRMSData[NextFrameIndex], Alpha);
+}
+
+
+/// Background Task ///
+
+FSoundVisSpectrogramTask::FSoundVisSpectrogramTask(FSoundVisSpectrogram* _Spectrogram, FAudioDecompressWorker* _DecompressWorker, const int16* _PCM, int32 _NumChannels, int32 _NumSampleFrames, int32 _SampleRate, int32 _FFTSize, int32 _HopSize, ESoundVisWindowType _WindowType, bool _bFixedPoint, bool _bKeepFrames)
+	: Spectrogram(_Spectrogram)
+	, DecompressWorker(_DecompressWorker)
+	, PCM(_PCM)
+	, NumChannels(_NumChannels)
+	, NumSampleFrames(_NumSampleFrames)
+	, SampleRate(_SampleRate)
+	, FFTSize(_FFTSize)
+	, HopSize(_HopSize)
+	, WindowType(_WindowType)
+	, bFixedPoint(_bFixedPoint)
+	, bKeepFrames(_bKeepFrames)
+	, bWriteCache(false)
+	, BeatGrid(NULL)
+	, Envelope(NULL)
+{
+}
+
+void FSoundVisSpectrogramTask::SetCacheEntry(const FSoundVisCacheKey& _CacheKey, const FSoundVisCacheMetadata& _Metadata)
+{
+	bWriteCache = true;
+
+	CacheKey = _CacheKey;
+	CacheMetadata = _Metadata;
+}
+
+void FSoundVisSpectrogramTask::SetBeatGrid(FSoundVisBeatGrid* _BeatGrid)
+{
+	BeatGrid = _BeatGrid;
+}
+
+void FSoundVisSpectrogramTask::SetEnvelope(FSoundVisEnvelope* _Envelope)
+{
+	Envelope = _Envelope;
+}
+
+void FSoundVisSpectrogramTask::DoWork()
+{
+	// The PCM buffer is only complete once the worker is done with it. Sleeps on its event, the timeout is only there to see a cancel
+	while (DecompressWorker && !DecompressWorker->WaitForFinish(FAudioDecompressWorker::FinishWaitMs))
+	{
+		if (Spectrogram->IsCancelRequested())
+		{
+			return;
+		}
+	}
+
+	// The pooled buffer isn't cleared, past a failed decode it still holds an older song
+	if (DecompressWorker && !DecompressWorker->HasSucceeded())
+	{
+		UE_LOG(LogSoundVisualization, Warning, TEXT("Spectrogram skipped, the song couldn't be decoded"));
+
+		return;
+	}
+
+	const int32 NumDecodedFrames = DecompressWorker ? FMath::Min(NumSampleFrames, DecompressWorker->GetDecodedFrames()) : NumSampleFrames;
+
+	// Much quicker than the spectrogram, the waveform can be drawn while the spectrogram still runs
+	if (Envelope)
+	{
+		Envelope->Build(PCM, NumChannels, NumDecodedFrames, SampleRate);
+	}
+
+	Spectrogram->Build(PCM, NumChannels, NumDecodedFrames, SampleRate, FFTSize, HopSize, WindowType, bFixedPoint, bKeepFrames);
+
+	// Next session can skip decoding and analyzing this song. A cancelled envelope is left out, the entry gets rebuilt once it's needed
+	if (bWriteCache && Spectrogram->IsReady())
+	{
+		FSoundVisAnalysisCache::Write(CacheKey, CacheMetadata, *Spectrogram, Envelope && Envelope->IsReady() ? Envelope : NULL);
+	}
+
+	if (BeatGrid && Spectrogram->IsReady())
+	{
+		BeatGrid->Build(*Spectrogram);
+	}
+}
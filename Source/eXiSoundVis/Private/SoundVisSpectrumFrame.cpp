@@ -0,0 +1,63 @@
+// Copyright 1998-2015 Epic Games, Inc. All Rights Reserved.
+
+#include "eXiSoundVisPrivatePCH.h"
+#include "SoundVisTypes.h"
+
+DECLARE_CYCLE_STAT(TEXT("Build Spectrum Frame"), STAT_SoundVisSpectrumFrameBuild, STATGROUP_SoundVis);
+
+void FSoundVisSpectrumFrame::Build(const float* _Bins, int32 _NumBins, int32 _SampleRate)
+{
+	SCOPE_CYCLE_COUNTER(STAT_SoundVisSpectrumFrameBuild);
+
+	NumBins = _Bins ? FMath::Max(_NumBins, 0) : 0;
+	SampleRate = _SampleRate;
+
+	// One more than bins, so the sum of [First, Last] is always PrefixSums[Last + 1] - PrefixSums[First]
+	PrefixSums.SetNumUninitialized(NumBins + 1, false);
+
+	double* SumPtr = PrefixSums.GetData();
+	double Sum = 0.0;
+
+	SumPtr[0] = 0.0;
+
+	for (int32 BinIndex = 0; BinIndex < NumBins; ++BinIndex)
+	{
+		Sum += _Bins[BinIndex];
+
+		SumPtr[BinIndex + 1] = Sum;
+	}
+}
+
+int32 FSoundVisSpectrumFrame::GetBinIndex(float _Frequency) const
+{
+	// Same truncation as "Frequency * Frequencies.Num() * 2 / SampleRate" in the Frequency Value functions.
+	// Double, so high frequencies of long spectrums don't round up into the next bin
+	return (int32)((double)_Frequency * NumBins * 2 / SampleRate);
+}
+
+float FSoundVisSpectrumFrame::GetAverage(float _StartFrequency, float _EndFrequency) const
+{
+	if (!IsValid())
+	{
+		return 0.0f;
+	}
+
+	const int32 FirstBin = FMath::Max(GetBinIndex(FMath::Min(_StartFrequency, _EndFrequency)), 0);
+	const int32 LastBin = FMath::Min(GetBinIndex(FMath::Max(_StartFrequency, _EndFrequency)), NumBins - 1);
+
+	// A band above the Nyquist frequency of a low sample rate has no bins
+	if (FirstBin > LastBin)
+	{
+		return 0.0f;
+	}
+
+	return (float)((PrefixSums[LastBin + 1] - PrefixSums[FirstBin]) / (LastBin - FirstBin + 1));
+}
+
+void FSoundVisSpectrumFrame::GetBandAverages(const float* _BandEdges, int32 _NumEdges, float* _OutValues) const
+{
+	for (int32 BandIndex = 0; BandIndex < _NumEdges - 1; ++BandIndex)
+	{
+		_OutValues[BandIndex] = GetAverage(_BandEdges[BandIndex], _BandEdges[BandIndex + 1]);
+	}
+}
@@ -0,0 +1,340 @@
+// Copyright 1998-2015 Epic Games, Inc. All Rights Reserved.
+
+#include "eXiSoundVisPrivatePCH.h"
+#include "SoundVisualization.h"
+#include "SoundVisStreamingPCM.h"
+
+DECLARE_CYCLE_STAT(TEXT("Decode Streaming Block"), STAT_SoundVisDecodeBlock, STATGROUP_SoundVis);
+
+/// De-/Constructurs ///
+
+FSoundVisStreamingPCM::FSoundVisStreamingPCM(USoundWave* _Wave, int32 _MaxBlocks, int32 _PrefetchBlocks, const uint8* _SourceData, uint32 _SourceSize, ICompressedAudioInfo* _OpenedAudioInfo)
+	: Wave(_Wave)
+	, AudioInfo(_OpenedAudioInfo)
+	, SourceData(_SourceData ? _SourceData : _Wave->ResourceData)
+	, SourceSize(_SourceData ? _SourceSize : _Wave->ResourceSize)
+	, bHeaderRead(_OpenedAudioInfo != NULL)
+	, NumChannels(_Wave->NumChannels)
+	, SampleRate(_Wave->SampleRate)
+	, NumFrames(0)
+	, NumBlocks(0)
+	, PrefetchBlocks(FMath::Max(1, _PrefetchBlocks))
+	, WindowBlocks(PrefetchBlocks)
+	, PlayheadBlock(0)
+	, UseCounter(0)
+	, NextSequentialBlock(INDEX_NONE)
+	, WakeUpEvent(NULL)
+	, Thread(NULL)
+{
+	check(NumChannels > 0 && SampleRate > 0);
+
+	NumFrames = _Wave->RawPCMDataSize / (2 * NumChannels);
+	NumBlocks = FMath::DivideAndRoundUp(NumFrames, SampleRate);
+
+	// The window around the playhead (one behind, the current one and the prefetched ones) has to fit
+	GrowSlots(FMath::Max(_MaxBlocks, PrefetchBlocks + 3));
+
+	if (!AudioInfo && GEngine && GEngine->GetMainAudioDevice())
+	{
+		AudioInfo = GEngine->GetMainAudioDevice()->CreateCompressedAudioInfo(Wave);
+	}
+
+	WakeUpEvent = FPlatformProcess::GetSynchEventFromPool(false);
+
+	Thread = FRunnableThread::Create(this, TEXT("FSoundVisStreamingPCM"), 0, TPri_BelowNormal);
+}
+
+FSoundVisStreamingPCM::~FSoundVisStreamingPCM()
+{
+	if (Thread)
+	{
+		Stop();
+		Thread->WaitForCompletion();
+
+		delete Thread;
+		Thread = NULL;
+	}
+
+	FPlatformProcess::ReturnSynchEventToPool(WakeUpEvent);
+	WakeUpEvent = NULL;
+
+	for (FBlock& Block : Blocks)
+	{
+		FMemory::Free(Block.Samples);
+	}
+
+	delete AudioInfo;
+}
+
+
+/// Decode Thread ///
+
+uint32 FSoundVisStreamingPCM::Run()
+{
+	FSoundQualityInfo QualityInfo = { 0 };
+
+	if (!bHeaderRead)
+	{
+		bHeaderRead = AudioInfo && SourceData && AudioInfo->ReadCompressedInfo(SourceData, SourceSize, &QualityInfo);
+	}
+
+	if (!bHeaderRead)
+	{
+		UE_LOG(LogSoundVisualization, Warning, TEXT("Streaming decode of %s failed, the compressed data can't be read"), *Wave->GetName());
+
+		return 0;
+	}
+
+	NextSequentialBlock = 0;
+
+	while (StopTaskCounter.GetValue() == 0)
+	{
+		int32 BlockIndex = INDEX_NONE;
+		int16* Samples = NULL;
+
+		{
+			FScopeLock Lock(&BlockLock);
+
+			BlockIndex = FindBlockToDecode();
+
+			if (BlockIndex != INDEX_NONE)
+			{
+				Samples = Blocks[ClaimSlot(BlockIndex)].Samples;
+			}
+		}
+
+		// Nothing to do until the playhead moves
+		if (BlockIndex == INDEX_NONE)
+		{
+			WakeUpEvent->Wait();
+
+			continue;
+		}
+
+		// No lock needed, GetFrames doesn't read slots that aren't decoded and only this thread reuses slots
+		DecodeBlock(BlockIndex, Samples);
+
+		FScopeLock Lock(&BlockLock);
+
+		const int32 SlotIndex = FindSlot(BlockIndex);
+
+		if (SlotIndex != INDEX_NONE)
+		{
+			Blocks[SlotIndex].bDecoded = true;
+		}
+	}
+
+	return 0;
+}
+
+void FSoundVisStreamingPCM::Stop()
+{
+	StopTaskCounter.Increment();
+
+	WakeUpEvent->Trigger();
+}
+
+void FSoundVisStreamingPCM::DecodeBlock(int32 _BlockIndex, int16* _OutSamples)
+{
+	SCOPE_CYCLE_COUNTER(STAT_SoundVisDecodeBlock);
+
+	// Blocks are exactly one second long, so the seek time is a whole number and hits the first frame of the block
+	if (_BlockIndex != NextSequentialBlock)
+	{
+		AudioInfo->SeekToTime((float)_BlockIndex);
+	}
+
+	// The last block is shorter, the decoder fills the rest with silence
+	AudioInfo->ReadCompressedData((uint8*)_OutSamples, false, SampleRate * NumChannels * sizeof(int16));
+
+	NextSequentialBlock = _BlockIndex + 1;
+}
+
+
+/// Block Management ///
+
+int32 FSoundVisStreamingPCM::FindSlot(int32 _BlockIndex) const
+{
+	for (int32 SlotIndex = 0; SlotIndex < Blocks.Num(); ++SlotIndex)
+	{
+		if (Blocks[SlotIndex].BlockIndex == _BlockIndex)
+		{
+			return SlotIndex;
+		}
+	}
+
+	return INDEX_NONE;
+}
+
+int32 FSoundVisStreamingPCM::FindBlockToDecode() const
+{
+	// The block at the playhead first, then the ones after it in playback order, then the one behind it
+	const int32 LastBlock = FMath::Min(PlayheadBlock + WindowBlocks, NumBlocks - 1);
+
+	for (int32 BlockIndex = PlayheadBlock; BlockIndex <= LastBlock; ++BlockIndex)
+	{
+		if (FindSlot(BlockIndex) == INDEX_NONE)
+		{
+			return BlockIndex;
+		}
+	}
+
+	if (PlayheadBlock > 0 && FindSlot(PlayheadBlock - 1) == INDEX_NONE)
+	{
+		return PlayheadBlock - 1;
+	}
+
+	return INDEX_NONE;
+}
+
+int32 FSoundVisStreamingPCM::ClaimSlot(int32 _BlockIndex)
+{
+	int32 BestSlot = INDEX_NONE;
+
+	for (int32 SlotIndex = 0; SlotIndex < Blocks.Num(); ++SlotIndex)
+	{
+		const FBlock& Block = Blocks[SlotIndex];
+
+		if (Block.BlockIndex == INDEX_NONE)
+		{
+			BestSlot = SlotIndex;
+			break;
+		}
+
+		// Never evict what the playhead still needs
+		if (Block.BlockIndex >= PlayheadBlock - 1 && Block.BlockIndex <= PlayheadBlock + WindowBlocks)
+		{
+			continue;
+		}
+
+		if (BestSlot == INDEX_NONE || Block.LastUsed < Blocks[BestSlot].LastUsed)
+		{
+			BestSlot = SlotIndex;
+		}
+	}
+
+	// There are always slots for the whole window, so there is always a slot outside of it
+	check(BestSlot != INDEX_NONE);
+
+	FBlock& Block = Blocks[BestSlot];
+	Block.BlockIndex = _BlockIndex;
+	Block.LastUsed = UseCounter;
+	Block.bDecoded = false;
+
+	return BestSlot;
+}
+
+void FSoundVisStreamingPCM::GrowSlots(int32 _NumSlots)
+{
+	// The decode thread only keeps the Samples pointer of its slot, which doesn't move
+	for (int32 SlotIndex = Blocks.Num(); SlotIndex < FMath::Min(_NumSlots, NumBlocks); ++SlotIndex)
+	{
+		FBlock Block;
+		Block.BlockIndex = INDEX_NONE;
+		Block.Samples = (int16*)FMemory::Malloc(SampleRate * NumChannels * sizeof(int16));
+		Block.LastUsed = 0;
+		Block.bDecoded = false;
+
+		Blocks.Add(Block);
+	}
+}
+
+
+/// Sample Access ///
+
+const int16* FSoundVisStreamingPCM::GetFrames(int32 _FirstFrame, int32 _NumFrames, int16* _Scratch)
+{
+	if (_FirstFrame < 0 || _NumFrames <= 0 || _FirstFrame + _NumFrames > NumFrames)
+	{
+		return NULL;
+	}
+
+	const int32 FirstBlock = _FirstFrame / SampleRate;
+	const int32 LastBlock = (_FirstFrame + _NumFrames - 1) / SampleRate;
+
+	FScopeLock Lock(&BlockLock);
+
+	// Without more slots the end of this request would never be decoded. Grows once per longer request, the window stays that size
+	if (LastBlock - FirstBlock > WindowBlocks)
+	{
+		WindowBlocks = LastBlock - FirstBlock;
+
+		GrowSlots(WindowBlocks + 3);
+
+		UE_LOG(LogSoundVisualization, Log, TEXT("Streaming decode of %s now keeps %d blocks for requests of %d frames"), *Wave->GetName(), Blocks.Num(), _NumFrames);
+
+		WakeUpEvent->Trigger();
+	}
+
+	if (PlayheadBlock != FirstBlock)
+	{
+		PlayheadBlock = FirstBlock;
+
+		WakeUpEvent->Trigger();
+	}
+
+	const int16* Frames = CopyResidentFrames(_FirstFrame, _NumFrames, _Scratch);
+
+	if (!Frames)
+	{
+		WakeUpEvent->Trigger();
+	}
+
+	return Frames;
+}
+
+const int16* FSoundVisStreamingPCM::GetFramesIfResident(int32 _FirstFrame, int32 _NumFrames, int16* _Scratch)
+{
+	if (_FirstFrame < 0 || _NumFrames <= 0 || _FirstFrame + _NumFrames > NumFrames)
+	{
+		return NULL;
+	}
+
+	FScopeLock Lock(&BlockLock);
+
+	return CopyResidentFrames(_FirstFrame, _NumFrames, _Scratch);
+}
+
+const int16* FSoundVisStreamingPCM::CopyResidentFrames(int32 _FirstFrame, int32 _NumFrames, int16* _Scratch)
+{
+	const int32 FirstBlock = _FirstFrame / SampleRate;
+	const int32 LastBlock = (_FirstFrame + _NumFrames - 1) / SampleRate;
+
+	++UseCounter;
+
+	// Check all blocks first, so a miss doesn't leave half a window behind
+	for (int32 BlockIndex = FirstBlock; BlockIndex <= LastBlock; ++BlockIndex)
+	{
+		const int32 SlotIndex = FindSlot(BlockIndex);
+
+		if (SlotIndex == INDEX_NONE || !Blocks[SlotIndex].bDecoded)
+		{
+			return NULL;
+		}
+	}
+
+	// Copied under the lock, so the decode thread can't reuse a slot while we read it
+	int32 Frame = _FirstFrame;
+	int16* OutPtr = _Scratch;
+
+	for (int32 BlockIndex = FirstBlock; BlockIndex <= LastBlock; ++BlockIndex)
+	{
+		FBlock& Block = Blocks[FindSlot(BlockIndex)];
+		Block.LastUsed = UseCounter;
+
+		const int32 BlockEnd = FMath::Min((BlockIndex + 1) * SampleRate, _FirstFrame + _NumFrames);
+		const int32 FramesInBlock = BlockEnd - Frame;
+
+		FMemory::Memcpy(OutPtr, Block.Samples + (Frame - BlockIndex * SampleRate) * NumChannels, FramesInBlock * NumChannels * sizeof(int16));
+
+		OutPtr += FramesInBlock * NumChannels;
+		Frame = BlockEnd;
+	}
+
+	return _Scratch;
+}
+
+SIZE_T FSoundVisStreamingPCM::GetResidentBytes() const
+{
+	return (SIZE_T)Blocks.Num() * SampleRate * NumChannels * sizeof(int16);
+}
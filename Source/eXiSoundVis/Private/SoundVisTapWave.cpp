@@ -0,0 +1,91 @@
+// Copyright 1998-2015 Epic Games, Inc. All Rights Reserved.
+
+#include "eXiSoundVisPrivatePCH.h"
+#include "SoundVisualization.h"
+#include "SoundVisTapWave.h"
+
+DECLARE_CYCLE_STAT(TEXT("Tap Wave Decode"), STAT_SoundVisTapWaveDecode, STATGROUP_SoundVis);
+
+bool USoundVisTapWave::Init(USoundWave* _SourceWave, float _StartTime, const TSharedRef<FSoundVisLiveRing, ESPMode::ThreadSafe>& _Ring)
+{
+	FAudioDevice* AudioDevice = GEngine ? GEngine->GetMainAudioDevice() : NULL;
+
+	if (!_SourceWave || !AudioDevice || AudioInfo)
+	{
+		return false;
+	}
+
+	// The copy of the file the SoundWave gets to be playable
+	_SourceWave->InitAudioResource(AudioDevice->GetRuntimeFormat(_SourceWave));
+
+	if (!_SourceWave->ResourceData)
+	{
+		UE_LOG(LogSoundVisualization, Warning, TEXT("%s has no compressed data to play, load it with bMakeSoundWavePlayable"), *_SourceWave->GetName());
+
+		return false;
+	}
+
+	AudioInfo = AudioDevice->CreateCompressedAudioInfo(_SourceWave);
+
+	FSoundQualityInfo QualityInfo = { 0 };
+
+	if (!AudioInfo || !AudioInfo->ReadCompressedInfo(_SourceWave->ResourceData, _SourceWave->ResourceSize, &QualityInfo))
+	{
+		delete AudioInfo;
+		AudioInfo = NULL;
+
+		return false;
+	}
+
+	if (_StartTime > 0.0f)
+	{
+		AudioInfo->SeekToTime(_StartTime);
+	}
+
+	SourceWave = _SourceWave;
+	Ring = _Ring;
+
+	SoundGroup = ESoundGroup::SOUNDGROUP_Default;
+	NumChannels = QualityInfo.NumChannels;
+	SampleRate = QualityInfo.SampleRate;
+	Duration = FMath::Max(0.0f, QualityInfo.Duration - _StartTime);
+	bLooping = false;
+
+	return true;
+}
+
+int32 USoundVisTapWave::GeneratePCMData(uint8* _PCMData, const int32 _SamplesNeeded)
+{
+	SCOPE_CYCLE_COUNTER(STAT_SoundVisTapWaveDecode);
+
+	const int32 BytesNeeded = _SamplesNeeded * sizeof(int16);
+
+	if (!AudioInfo || bSourceFinished)
+	{
+		FMemory::Memzero(_PCMData, BytesNeeded);
+	}
+	else
+	{
+		// Fills the part after the end of the song with silence
+		bSourceFinished = AudioInfo->ReadCompressedData(_PCMData, false, BytesNeeded);
+	}
+
+	// Exactly what the device is going to play, including the silence at the end
+	if (Ring.IsValid())
+	{
+		Ring->Write((const int16*)_PCMData, _SamplesNeeded / NumChannels);
+	}
+
+	return BytesNeeded;
+}
+
+void USoundVisTapWave::BeginDestroy()
+{
+	// Stops the sounds that still play this wave
+	Super::BeginDestroy();
+
+	delete AudioInfo;
+	AudioInfo = NULL;
+
+	Ring.Reset();
+}
@@ -2,81 +2,293 @@
 
 #include "eXiSoundVisPrivatePCH.h"
 #include "SoundVisualization.h"
+#include "SoundVisKernels.h"
+#include "SoundVisDecoderPool.h"
+#include "SoundVisFilterbank.h"
+#include "Async/Async.h"
+#include "Async/ParallelFor.h"
+
+DECLARE_CYCLE_STAT(TEXT("Old Frequency Spectrum"), STAT_SoundVisOldSpectrum, STATGROUP_SoundVis);
+DECLARE_CYCLE_STAT(TEXT("New Frequency Spectrum"), STAT_SoundVisNewSpectrum, STATGROUP_SoundVis);
+DECLARE_CYCLE_STAT(TEXT("Band Energies"), STAT_SoundVisBandEnergies, STATGROUP_SoundVis);
+DECLARE_CYCLE_STAT(TEXT("Spectrum Batch"), STAT_SoundVisSpectrumBatch, STATGROUP_SoundVis);
+DECLARE_CYCLE_STAT(TEXT("Frequency Values"), STAT_SoundVisFrequencyValues, STATGROUP_SoundVis);
+
+FThreadSafeCounter64 USoundVisualization::NumLoadBytesCopied;
+FThreadSafeCounter64 USoundVisualization::NumLoadBytesMapped;
 
 /// De-/Constructurs ///
 
 // Destructor to make sure the Buffer is freed again
 USoundVisualization::~USoundVisualization()
 {
-	FMemory::Free(PCMSampleBuffer);
+	// The spectrogram task reads from the Buffer
+	StopSpectrogramPrecompute();
+
+	StopStreamingDecode();
+
+	StopLiveAnalysis();
+
+	// Cancels the decode job writing into the Buffer
+	ReleasePCMSampleBuffer();
+
+	// Nothing reads the file anymore
+	ReleaseSongFile();
+
+	// Stops a running scan
+	delete LibraryIndex;
+	LibraryIndex = NULL;
 }
 
 
 /// Functions to load Data from the HardDrive ///
 
+// Calls OnFinished right away, for loads that end without a decode job. Only called on the game thread
+static void NotifyLoadFinished(const FSoundVisDecodeCallbacks* _Callbacks, bool _bSuccess)
+{
+	if (_Callbacks && _Callbacks->OnFinished)
+	{
+		_Callbacks->OnFinished(_bSuccess);
+	}
+}
+
 // C++ Version of the LoadSoundFileFromHD function
-bool USoundVisualization::LoadSoundFileFromHD(const FString& _FilePath)
+bool USoundVisualization::LoadSoundFileFromHD(const FString& _FilePath, const FSoundVisDecodeCallbacks* _Callbacks)
 {
 	// Create new SoundWave Object
 	USoundWave* SW = NewObject<USoundWave>(USoundWave::StaticClass());
 
 	if (!SW)
 	{
+		NotifyLoadFinished(_Callbacks, false);
+
+		return false;
+	}
+
+	// Map the file instead of reading it into an array. The decoders read straight from the mapping
+	FSoundVisMappedFile* File = new FSoundVisMappedFile();
+
+	if (!File->Open(_FilePath) || File->GetSize() > MAX_int32)
+	{
+		delete File;
+
+		NotifyLoadFinished(_Callbacks, false);
+
 		return false;
 	}
 
-	//* If true the song was successfully loaded
-	bool bLoaded = false;
+	const uint8* FileData = File->GetData();
+	const int32 FileSize = (int32)File->GetSize();
+
+	if (File->IsMapped())
+	{
+		NumLoadBytesMapped.Add(FileSize);
+	}
+	else
+	{
+		NumLoadBytesCopied.Add(FileSize);
+	}
+
+	// Key of this file in the analysis cache
+	FSoundVisCacheKey CacheKey;
+
+	bool bCacheHit = false;
 
-	// Array for loaded song file (binary, encoded)
-	TArray<uint8> RawFile;
+	// Nothing gets analyzed up front for live analysis, hashing the file would be wasted
+	if (bUseAnalysisCache && !bLiveAnalysisOnly)
+	{
+		CacheKey = FSoundVisCacheKey::Make(FileData, FileSize, SpectrogramWindowDuration, SpectrogramHopDuration, WindowType, bFixedPointAnalysis);
+
+		bCacheHit = LoadAnalysisFromCache(SW, CacheKey);
+	}
 
-	// Load file into RawFileArray
-	bLoaded = FFileHelper::LoadFileToArray(RawFile, _FilePath.GetCharArray().GetData());
+	// Fill the Sound Data into the SoundWave object. A cache entry already brought it along.
+	// This is the only time the header gets parsed, the decoder of the song takes this AudioInfo over
+	ICompressedAudioInfo* AudioInfo = NULL;
 
-	if (bLoaded)
+	if (!bCacheHit)
 	{
-		// Fill the Sound Data into the SoundWave object
-		if (RawFile.Num() > 0)
-			bLoaded = FillSoundWaveInfo(SW, &RawFile) == 0 ? true : false;
-		else
-			bLoaded = false;
+		AudioInfo = new FVorbisAudioInfo();
 
+		if (!ReadSoundWaveInfo(SW, FileData, FileSize, AudioInfo))
+		{
+			delete AudioInfo;
+			delete File;
+
+			NotifyLoadFinished(_Callbacks, false);
+
+			return false;
+		}
+	}
+
+	// Only needed to play the SoundWave, the analysis doesn't use it. The tap wave of the live analysis decodes this copy
+	if (bMakeSoundWavePlayable || bLiveAnalysisOnly)
+	{
 		// Return Address to the OGG CompressedData part of this SW
 		FByteBulkData* bulkData = &SW->CompressedFormatData.GetFormat(TEXT("OGG"));
 
 		bulkData->Lock(LOCK_READ_WRITE);
 
-		// Copy the RawFile Data into the SW CompressedFormatData
-		FMemory::Memmove(bulkData->Realloc(RawFile.Num()), RawFile.GetData(), RawFile.Num());
+		// Copy the File Data into the SW CompressedFormatData
+		FMemory::Memcpy(bulkData->Realloc(FileSize), FileData, FileSize);
 
 		bulkData->Unlock();
+
+		NumLoadBytesCopied.Add(FileSize);
 	}
-	
-	if(!bLoaded)
+
+	// Everything that reads the previous song's file has to stop before it gets unmapped. A cache hit already stopped the spectrogram and the samples
+	if (!bCacheHit)
 	{
-		return false;
+		StopSpectrogramPrecompute();
 	}
 
-	// Get the PCMSampleBuffer filled
-	GetPCMDataFromFile(SW, 0.0f, SW->Duration, true);
+	ReleasePCMSampleBuffer();
+
+	// The blocks of the previous song don't belong to this one
+	StopStreamingDecode();
+
+	ReleaseSongFile();
+
+	SongFile = File;
+	SongAudioInfo = AudioInfo;
 
 	// Return the pointer to the loaded SoundWave
 	CurrentSoundWave = SW;
 
+	// Everything the analysis needs is in the cache, no need to decode
+	if (bCacheHit)
+	{
+		if (bDetectBeats)
+		{
+			StartBeatDetection(SW);
+		}
+
+		if (bBuildEnvelope && AnalysisCache->HasEnvelope())
+		{
+			AnalysisCache->InitEnvelope(Envelope);
+
+			EnvelopeWave = SW;
+		}
+
+		// Nothing decodes from the file, it doesn't stay mapped for the whole song
+		ReleaseSongFile();
+
+		NotifyLoadFinished(_Callbacks, true);
+
+		return true;
+	}
+
+	// The song gets decoded while it plays, once. The copy in the SoundWave is all the tap wave needs
+	if (bLiveAnalysisOnly)
+	{
+		ReleaseSongFile();
+
+		NotifyLoadFinished(_Callbacks, true);
+
+		return true;
+	}
+
+	// Only decode the part around the analyzed position. The song can be analyzed right away
+	if (bStreamingDecode)
+	{
+		const bool bStarted = StartStreamingDecode(SW);
+
+		NotifyLoadFinished(_Callbacks, bStarted);
+
+		return bStarted;
+	}
+
+	// Get the PCMSampleBuffer filled
+	GetPCMDataFromFile(SW, 0.0f, SW->Duration, true, _Callbacks);
+
+	if (bUseAnalysisCache)
+	{
+		FSoundVisCacheMetadata Metadata;
+		Metadata.NumChannels = SW->NumChannels;
+		Metadata.SampleRate = SW->SampleRate;
+		Metadata.Duration = SW->Duration;
+		Metadata.RawPCMDataSize = SW->RawPCMDataSize;
+
+		// The spectrogram task writes the cache entry once it's done
+		StartSpectrogramPrecompute(SW, &CacheKey, &Metadata);
+	}
+	else if (bPrecomputeSpectrogram || bDetectBeats)
+	{
+		// Beats alone don't need the frames
+		StartSpectrogramPrecompute(SW, NULL, NULL, bPrecomputeSpectrogram);
+	}
+
+	// With the analysis cache, the spectrogram task builds the envelope for the entry
+	if (bBuildEnvelope && !bUseAnalysisCache)
+	{
+		StartEnvelopeBuild(SW);
+	}
+
+	return true;
+}
+
+// Maps the cached analysis of a song and applies the stored song info to the SoundWave
+bool USoundVisualization::LoadAnalysisFromCache(USoundWave* _SW, const FSoundVisCacheKey& _CacheKey)
+{
+	FSoundVisAnalysisCache* Entry = new FSoundVisAnalysisCache();
+
+	// An entry without the envelope counts as a miss if the song needs one, rebuilding it writes one with the envelope.
+	// Streamed songs get no envelope anyway
+	if (!Entry->Open(_CacheKey) || (bBuildEnvelope && !bStreamingDecode && !Entry->HasEnvelope()))
+	{
+		delete Entry;
+
+		return false;
+	}
+
+	// The song is accepted. Only now the old spectrogram goes, it might still point into the old cache entry
+	StopSpectrogramPrecompute();
+
+	AnalysisCache = Entry;
+
+	const FSoundVisCacheMetadata& Metadata = AnalysisCache->GetMetadata();
+
+	_SW->SoundGroup = ESoundGroup::SOUNDGROUP_Default;
+	_SW->NumChannels = Metadata.NumChannels;
+	_SW->Duration = Metadata.Duration;
+	_SW->RawPCMDataSize = Metadata.RawPCMDataSize;
+	_SW->SampleRate = Metadata.SampleRate;
+
+	AnalysisCache->InitSpectrogram(Spectrogram);
+
+	SpectrogramWave = _SW;
+
+	// The samples of the previous song don't belong to this one
+	ReleasePCMSampleBuffer();
+
 	return true;
 }
 
 // Called to get the Wave Info into the SoundWave*
 int USoundVisualization::FillSoundWaveInfo(class USoundWave* _SW, TArray<uint8>* _RawFile)
 {
-	FSoundQualityInfo SQInfo;
 	FVorbisAudioInfo VorbisAudioInfo = FVorbisAudioInfo();
 
+	return ReadSoundWaveInfo(_SW, _RawFile->GetData(), _RawFile->Num(), &VorbisAudioInfo) ? 0 : 1;
+}
+
+// Parses the header of the compressed data with _AudioInfo, which can decode the data afterwards
+bool USoundVisualization::ReadSoundWaveInfo(USoundWave* _SW, const uint8* _Data, uint32 _DataSize, ICompressedAudioInfo* _AudioInfo)
+{
+	FSoundQualityInfo SQInfo;
+
 	// Save the CompressedData in SQInfo
-	if (!VorbisAudioInfo.ReadCompressedInfo(_RawFile->GetData(), _RawFile->Num(), &SQInfo))
+	if (!_AudioInfo->ReadCompressedInfo(_Data, _DataSize, &SQInfo))
+	{
+		return false;
+	}
+
+	if (SQInfo.NumChannels <= 0 || SQInfo.NumChannels > FSoundVisFFTContext::MaxChannels)
 	{
-		return 1;
+		UE_LOG(LogSoundVisualization, Warning, TEXT("Songs with %d channels are not supported (up to %d)"), SQInfo.NumChannels, FSoundVisFFTContext::MaxChannels);
+
+		return false;
 	}
 
 	_SW->SoundGroup = ESoundGroup::SOUNDGROUP_Default;
@@ -85,444 +297,1289 @@ int USoundVisualization::FillSoundWaveInfo(class USoundWave* _SW, TArray<uint8>*
 	_SW->RawPCMDataSize = SQInfo.SampleDataSize;
 	_SW->SampleRate = SQInfo.SampleRate;
 
-	return 0;
+	return true;
+}
+
+bool USoundVisualization::TakeSongSource(USoundWave* _SoundWave, const uint8*& _OutData, uint32& _OutDataSize, ICompressedAudioInfo*& _OutOpenedAudioInfo)
+{
+	if (_SoundWave != CurrentSoundWave || !SongFile)
+	{
+		return false;
+	}
+
+	_OutData = SongFile->GetData();
+	_OutDataSize = SongFile->GetSize();
+
+	// Only the first decoder gets the parsed header, it can't be shared
+	_OutOpenedAudioInfo = SongAudioInfo;
+	SongAudioInfo = NULL;
+
+	return true;
+}
+
+void USoundVisualization::ReleaseSongFile()
+{
+	delete SongAudioInfo;
+	SongAudioInfo = NULL;
+
+	delete SongFile;
+	SongFile = NULL;
 }
 
 
 /// Function to decompress the crompressed Data that comes with the .ogg file ///
 
-void USoundVisualization::GetPCMDataFromFile(USoundWave* _SoundWave, float _StartTime, float _Duration, bool _Synchronous)
+void USoundVisualization::GetPCMDataFromFile(USoundWave* _SoundWave, float _StartTime, float _Duration, bool _Synchronous, const FSoundVisDecodeCallbacks* _Callbacks)
 {
 	check(_SoundWave);
 
-	check(_SoundWave->NumChannels == 1 || _SoundWave->NumChannels == 2)
+	if (_SoundWave->NumChannels <= 0 || _SoundWave->NumChannels > FSoundVisFFTContext::MaxChannels)
+	{
+		UE_LOG(LogSoundVisualization, Warning, TEXT("%s has %d channels, only up to %d are supported"), *_SoundWave->GetName(), _SoundWave->NumChannels, FSoundVisFFTContext::MaxChannels);
+	}
+	else if (!_SoundWave->RawPCMData || _SoundWave->RawPCMDataSize <= 0)
+	{
+		// Get the main audio device
+		FAudioDevice* AudioDevice = GEngine->GetMainAudioDevice();
 
-		if (!_SoundWave->RawPCMData || _SoundWave->RawPCMDataSize <= 0)
+		if (AudioDevice)
 		{
-			// Get the main audio device
-			FAudioDevice* AudioDevice = GEngine->GetMainAudioDevice();
+			const uint8* SourceData = NULL;
+			uint32 SourceSize = 0;
+			ICompressedAudioInfo* OpenedAudioInfo = NULL;
 
-			if (AudioDevice)
+			// The current song decodes straight from its mapped file, every other SoundWave needs its resource data
+			if (!TakeSongSource(_SoundWave, SourceData, SourceSize, OpenedAudioInfo))
 			{
 				_SoundWave->InitAudioResource(AudioDevice->GetRuntimeFormat(_SoundWave));
+			}
 
-				float FBufferSize = _Duration * _SoundWave->SampleRate * _SoundWave->NumChannels;
+			float FBufferSize = _Duration * _SoundWave->SampleRate * _SoundWave->NumChannels;
 
-				const uint32 BufferSize = FMath::FloorToInt(FBufferSize); // Duration * SampleRate * NumChannels
+			const uint32 BufferSize = FMath::FloorToInt(FBufferSize); // Duration * SampleRate * NumChannels
 
-				if (DecompressWorker == NULL)
-				{
-					if (PCMSampleBuffer)
-					{
-						FMemory::Free(PCMSampleBuffer);
-					}
+			// The spectrogram task and our previous job still use the old Buffer. Jobs of other objects don't matter, they have their own.
+			// The previous job stops after its current chunk, so switching tracks doesn't wait for a decode nobody needs anymore
+			StopSpectrogramPrecompute();
+			ReleasePCMSampleBuffer();
 
-					PCMSampleBuffer = (uint8*)FMemory::Malloc(BufferSize * 2);
-					DecompressWorker = FAudioDecompressWorker::Initialize(_SoundWave, PCMSampleBuffer, _StartTime, _Duration);
-				}
-				else
-				{
-					if (DecompressWorker->IsFinished())
-					{
-						FMemory::Free(PCMSampleBuffer);
+			PCMSampleBuffer = FSoundVisDecoderPool::Get().AcquireBuffer(BufferSize * 2, PCMSampleBufferSize);
 
-						PCMSampleBuffer = (uint8*)FMemory::Malloc(BufferSize * 2);
+			DecompressWorker = new FAudioDecompressWorker(_SoundWave, PCMSampleBuffer, _StartTime, _Duration, DecodePriority);
 
-						DecompressWorker->Shutdown();
+			if (SourceData)
+			{
+				DecompressWorker->SetSource(SourceData, SourceSize, OpenedAudioInfo);
+			}
 
-						DecompressWorker = FAudioDecompressWorker::Initialize(_SoundWave, PCMSampleBuffer, _StartTime, _Duration);
-					}
-				}
+			if (_Callbacks)
+			{
+				DecompressWorker->Callbacks = *_Callbacks;
 			}
+
+			DecompressWorker->Start();
+
+			return;
 		}
+	}
+
+	// No decode job got started
+	NotifyLoadFinished(_Callbacks, false);
 }
 
 
-/// Blueprint Versions of the File Data Functions ///
+/// Functions to decode the _SoundWave block by block ///
 
-bool USoundVisualization::SV_LoadSoundFileFromHD(const FString _FilePath)
+bool USoundVisualization::StartStreamingDecode(USoundWave* _SoundWave)
 {
-	return LoadSoundFileFromHD(_FilePath);
-}
+	StopStreamingDecode();
 
-bool USoundVisualization::SV_LoadAllSoundFileNamesFromHD(const FString _DirectoryPath, const bool _bAbsolutePath, const bool _bFullPath, const FString _FileExtension, TArray<FString>& _SoundFileNames)
-{
-	FString FinalPath = _DirectoryPath;
+	if (!_SoundWave || _SoundWave->NumChannels <= 0 || _SoundWave->NumChannels > FSoundVisFFTContext::MaxChannels || _SoundWave->SampleRate <= 0)
+	{
+		return false;
+	}
 
-	if (!_bAbsolutePath)
+	FAudioDevice* AudioDevice = GEngine->GetMainAudioDevice();
+
+	if (!AudioDevice || !FPlatformProcess::SupportsMultithreading())
 	{
-		FinalPath = FPaths::ConvertRelativePathToFull(FPaths::GameDir()) + _DirectoryPath;
+		return false;
+	}
+
+	const uint8* SourceData = NULL;
+	uint32 SourceSize = 0;
+	ICompressedAudioInfo* OpenedAudioInfo = NULL;
+
+	// The decode thread reads the mapped file of the current song, or the compressed data from the resource
+	if (!TakeSongSource(_SoundWave, SourceData, SourceSize, OpenedAudioInfo))
+	{
+		_SoundWave->InitAudioResource(AudioDevice->GetRuntimeFormat(_SoundWave));
 	}
 
-	TArray<FString> DirectoriesToSkip;
+	// The whole song buffer of the previous song isn't used anymore, neither is its spectrogram
+	StopSpectrogramPrecompute();
+	ReleasePCMSampleBuffer();
+
+	StreamingPCM = new FSoundVisStreamingPCM(_SoundWave, StreamingCacheSeconds, StreamingPrefetchSeconds, SourceData, SourceSize, OpenedAudioInfo);
+
+	return true;
+}
+
+void USoundVisualization::StopStreamingDecode()
+{
+	// Waits for the decode thread
+	delete StreamingPCM;
+	StreamingPCM = NULL;
+
+	// The cached frames were computed from its blocks
+	SlidingSTFT.Reset();
+}
 
-	IPlatformFile &PlatformFile = FPlatformFileManager::Get().GetPlatformFile();
-	FLocalTimestampDirectoryVisitor Visitor(PlatformFile, DirectoriesToSkip, DirectoriesToSkip, false);
-	PlatformFile.IterateDirectory(*FinalPath, Visitor);
+const int16* USoundVisualization::GetSampleFrames(USoundWave* _SoundWave, int32 _FirstFrame, int32 _NumFrames)
+{
+	const int32 NumChannels = _SoundWave->NumChannels;
 
-	for (TMap<FString, FDateTime>::TIterator TimestampIt(Visitor.FileTimes); TimestampIt; ++TimestampIt)
+	if (StreamingPCM)
 	{
-		const FString FilePath = TimestampIt.Key();
-		const FString FileName = FPaths::GetCleanFilename(FilePath);
+		int16* Scratch = FFTContext.GetScratch<int16>(ESoundVisScratch::Samples, _NumFrames * NumChannels);
 
-		bool bShouldAddFile = true;
+		return StreamingPCM->GetFrames(_FirstFrame, _NumFrames, Scratch);
+	}
 
-		if (!_FileExtension.IsEmpty())
+	if (PCMSampleBuffer)
+	{
+		// While the worker is running, only the part below its watermark is decoded
+		if (DecompressWorker && _FirstFrame + _NumFrames > DecompressWorker->GetDecodedFrames())
 		{
-			if (!(FPaths::GetExtension(FileName, false).Equals(_FileExtension, ESearchCase::IgnoreCase)))
-			{
-				bShouldAddFile = false;
-			}
+			return NULL;
 		}
 
-		if (bShouldAddFile)
-		{
-			_SoundFileNames.Add(_bFullPath ? FilePath : FileName);
-		}
+		return reinterpret_cast<const int16*>(PCMSampleBuffer) + (int64)_FirstFrame * NumChannels;
 	}
 
-	return true;
+	return NULL;
 }
 
+void USoundVisualization::ReleasePCMSampleBuffer()
+{
+	// The envelope task reads from the Buffer
+	StopEnvelopeBuild();
+
+	// Stops the worker writing into them
+	delete DecompressWorker;
+	DecompressWorker = NULL;
+
+	FSoundVisDecoderPool::ReleaseBuffer(PCMSampleBuffer, PCMSampleBufferSize);
+
+	// The cached frames were computed from the Buffer
+	SlidingSTFT.Reset();
+
+	PCMSampleBuffer = NULL;
+	PCMSampleBufferSize = 0;
+}
 
-/// Helper Functions ///
 
-float USoundVisualization::GetFFTInValue(const int16 SampleValue, const int16 SampleIndex, const int16 SampleCount)
+/// Functions to analyze the playing Audio ///
+
+bool USoundVisualization::StartLiveAnalysis(UAudioComponent* _AudioComponent, USoundWave* _SoundWave, float _StartTime)
 {
-	float FFTValue = SampleValue;
+	StopLiveAnalysis();
 
-	// Apply the Hann window
-	FFTValue *= 0.5f * (1 - FMath::Cos(2 * PI * SampleIndex / (SampleCount - 1)));
+	// The FFT context handles up to 7.1
+	if (!_AudioComponent || !_SoundWave || _SoundWave->NumChannels <= 0 || _SoundWave->NumChannels > FSoundVisFFTContext::MaxChannels || _SoundWave->SampleRate <= 0 || !FPlatformProcess::SupportsMultithreading())
+	{
+		return false;
+	}
 
-	return FFTValue;
+	const int32 SampleRate = _SoundWave->SampleRate;
+
+	// Same power of two window the spectrum functions would use for this duration
+	const int32 FFTSize = FSoundVisFFTContext::GetPowerOfTwoSize(FMath::FloorToInt(SampleRate * LiveWindowDuration));
+	const int32 HopSize = FMath::Max(1, FMath::FloorToInt(SampleRate * LiveHopDuration));
+
+	// The ring has to hold the window behind the latency, plus what the device renders in one go
+	const int32 RingFrames = FFTSize + FMath::CeilToInt(LiveLatency * SampleRate) + SampleRate;
+
+	TSharedRef<FSoundVisLiveRing, ESPMode::ThreadSafe> Ring = MakeShareable(new FSoundVisLiveRing(_SoundWave->NumChannels, SampleRate, RingFrames));
+
+	USoundVisTapWave* TapWave = NewObject<USoundVisTapWave>(this);
+
+	if (!TapWave->Init(_SoundWave, _StartTime, Ring))
+	{
+		return false;
+	}
+
+	LiveWave = TapWave;
+	LiveAnalyzer = new FSoundVisLiveAnalyzer(Ring, FFTSize, HopSize, WindowType, _StartTime, LiveLatency, bFixedPointAnalysis);
+
+	_AudioComponent->SetSound(TapWave);
+	_AudioComponent->Play();
+
+	return true;
 }
 
+void USoundVisualization::StopLiveAnalysis()
+{
+	delete LiveAnalyzer;
+	LiveAnalyzer = NULL;
 
-/// SOUND VIZ ///
+	// The AudioComponent keeps it alive while it plays
+	LiveWave = NULL;
+}
 
-/// C++ Versions of the Analyze Functions ///
 
-void USoundVisualization::Old_CalculateFrequencySpectrum(USoundWave* SoundWave, const bool bSplitChannels, const float StartTime, const float TimeLength, const int32 SpectrumWidth, TArray< TArray<float> >& OutSpectrums)
+/// Functions to precompute the Spectrogram of the current _SoundWave ///
+
+bool USoundVisualization::StartSpectrogramPrecompute(USoundWave* _SoundWave, const FSoundVisCacheKey* _CacheKey, const FSoundVisCacheMetadata* _CacheMetadata, bool _bKeepFrames)
 {
-	OutSpectrums.Empty();
+	StopSpectrogramPrecompute();
 
-	const int32 NumChannels = SoundWave->NumChannels;
-	if (SpectrumWidth > 0 && NumChannels > 0)
+	if (!_SoundWave || !PCMSampleBuffer || _SoundWave->NumChannels <= 0 || _SoundWave->SampleRate <= 0)
 	{
-		// Setup the output data
-		OutSpectrums.AddZeroed((bSplitChannels ? NumChannels : 1));
+		return false;
+	}
 
-		for (int32 ChannelIndex = 0; ChannelIndex < OutSpectrums.Num(); ++ChannelIndex)
+	const int32 NumChannels = _SoundWave->NumChannels;
+
+	// Same power of two window the spectrum functions would use for this duration
+	const int32 FFTSize = FSoundVisFFTContext::GetPowerOfTwoSize(FMath::FloorToInt(_SoundWave->SampleRate * SpectrogramWindowDuration));
+	const int32 HopSize = FMath::Max(1, FMath::FloorToInt(_SoundWave->SampleRate * SpectrogramHopDuration));
+
+	// Don't read further than the Buffer GetPCMDataFromFile allocated
+	const int32 NumSampleFrames = FMath::Min(_SoundWave->RawPCMDataSize / (2 * NumChannels), FMath::FloorToInt(_SoundWave->Duration * _SoundWave->SampleRate));
+
+	SpectrogramWave = _SoundWave;
+
+	SpectrogramTask = new FAsyncTask<FSoundVisSpectrogramTask>(&Spectrogram, DecompressWorker, reinterpret_cast<const int16*>(PCMSampleBuffer), NumChannels, NumSampleFrames, _SoundWave->SampleRate, FFTSize, HopSize, WindowType, bFixedPointAnalysis, _bKeepFrames);
+
+	if (_CacheKey && _CacheMetadata)
+	{
+		SpectrogramTask->GetTask().SetCacheEntry(*_CacheKey, *_CacheMetadata);
+	}
+
+	// The beat grid follows right after the spectrogram in the same task
+	if (bDetectBeats)
+	{
+		SpectrogramTask->GetTask().SetBeatGrid(&BeatGrid);
+	}
+
+	// The envelope goes into the cache entry as well, so the same task builds it from the same samples
+	if (_CacheKey && bBuildEnvelope)
+	{
+		StopEnvelopeBuild();
+
+		EnvelopeWave = _SoundWave;
+		bSpectrogramBuildsEnvelope = true;
+
+		SpectrogramTask->GetTask().SetEnvelope(&Envelope);
+	}
+
+	SpectrogramTask->StartBackgroundTask();
+
+	return true;
+}
+
+void USoundVisualization::StopSpectrogramPrecompute()
+{
+	if (SpectrogramTask)
+	{
+		// The task might already be building the beat grid, or still the envelope
+		Spectrogram.Cancel();
+		BeatGrid.Cancel();
+
+		if (bSpectrogramBuildsEnvelope)
 		{
-			OutSpectrums[ChannelIndex].AddZeroed(SpectrumWidth);
+			Envelope.Cancel();
 		}
 
-		if (PCMSampleBuffer != NULL)
+		SpectrogramTask->EnsureCompletion();
+
+		delete SpectrogramTask;
+		SpectrogramTask = NULL;
+	}
+
+	// The beat grid is built from the spectrogram
+	StopBeatDetection();
+
+	// An envelope the task finished stays, a cancelled one is gone
+	if (bSpectrogramBuildsEnvelope)
+	{
+		bSpectrogramBuildsEnvelope = false;
+
+		if (!Envelope.IsReady())
 		{
-			float FBufferSize = TimeLength * SoundWave->SampleRate * SoundWave->NumChannels;
+			Envelope.Reset();
 
-			const uint32 BufferSize = FMath::FloorToInt(FBufferSize) * 2; // Duration * SampleRate * NumChannels * 2
+			EnvelopeWave = NULL;
+		}
+	}
 
-			int32 SampleCount = 0;
-			int32 SampleCounts[10] = { 0 };
+	Spectrogram.Reset();
+
+	// Only after the reset, the spectrogram might point into the mapped entry
+	delete AnalysisCache;
+	AnalysisCache = NULL;
+
+	SpectrogramWave = NULL;
+}
+
+
+/// Functions to detect the Beats of the current _SoundWave ///
+
+bool USoundVisualization::StartBeatDetection(USoundWave* _SoundWave)
+{
+	// A spectrogram task that is still running builds the beat grid itself, if bDetectBeats was set when it started
+	if (!_SoundWave || _SoundWave != SpectrogramWave || !Spectrogram.IsReady())
+	{
+		return false;
+	}
+
+	StopBeatDetection();
+
+	BeatGridTask = new FAsyncTask<FSoundVisBeatGridTask>(&BeatGrid, &Spectrogram);
+
+	BeatGridTask->StartBackgroundTask();
+
+	return true;
+}
+
+void USoundVisualization::StopBeatDetection()
+{
+	if (BeatGridTask)
+	{
+		BeatGrid.Cancel();
+
+		BeatGridTask->EnsureCompletion();
+
+		delete BeatGridTask;
+		BeatGridTask = NULL;
+	}
+
+	BeatGrid.Reset();
+}
+
+
+/// Functions to build the Envelope of the current _SoundWave ///
+
+bool USoundVisualization::StartEnvelopeBuild(USoundWave* _SoundWave)
+{
+	// Already on its way, together with the spectrogram
+	if (bSpectrogramBuildsEnvelope && _SoundWave == EnvelopeWave)
+	{
+		return true;
+	}
+
+	StopEnvelopeBuild();
+
+	if (!_SoundWave || !PCMSampleBuffer || _SoundWave->NumChannels <= 0 || _SoundWave->SampleRate <= 0)
+	{
+		return false;
+	}
+
+	const int32 NumChannels = _SoundWave->NumChannels;
+
+	// Don't read further than the Buffer GetPCMDataFromFile allocated
+	const int32 NumSampleFrames = FMath::Min(_SoundWave->RawPCMDataSize / (2 * NumChannels), FMath::FloorToInt(_SoundWave->Duration * _SoundWave->SampleRate));
+
+	EnvelopeWave = _SoundWave;
+
+	EnvelopeTask = new FAsyncTask<FSoundVisEnvelopeTask>(&Envelope, DecompressWorker, reinterpret_cast<const int16*>(PCMSampleBuffer), NumChannels, NumSampleFrames, _SoundWave->SampleRate);
+
+	EnvelopeTask->StartBackgroundTask();
+
+	return true;
+}
+
+void USoundVisualization::StopEnvelopeBuild()
+{
+	// The spectrogram task might be in the middle of it
+	if (bSpectrogramBuildsEnvelope)
+	{
+		StopSpectrogramPrecompute();
+	}
+
+	if (EnvelopeTask)
+	{
+		Envelope.Cancel();
+
+		EnvelopeTask->EnsureCompletion();
+
+		delete EnvelopeTask;
+		EnvelopeTask = NULL;
+	}
+
+	Envelope.Reset();
+
+	EnvelopeWave = NULL;
+}
+
+
+/// Blueprint Versions of the File Data Functions ///
+
+bool USoundVisualization::SV_LoadSoundFileFromHD(const FString _FilePath)
+{
+	return LoadSoundFileFromHD(_FilePath);
+}
+
+bool USoundVisualization::SV_LoadAllSoundFileNamesFromHD(const FString _DirectoryPath, const bool _bAbsolutePath, const bool _bFullPath, const FString _FileExtension, TArray<FString>& _SoundFileNames)
+{
+	FString FinalPath = _DirectoryPath;
+
+	if (!_bAbsolutePath)
+	{
+		FinalPath = FPaths::ConvertRelativePathToFull(FPaths::GameDir()) + _DirectoryPath;
+	}
+
+	// Only looks at the names, unlike a timestamp visitor that stats every file. The library index is the way to get more than names
+	class FVisitor : public IPlatformFile::FDirectoryVisitor
+	{
+
+	public:
+
+		FVisitor(const FString& _Extension, bool _bFullPath, TArray<FString>& _FileNames)
+			: Extension(_Extension)
+			, bFullPath(_bFullPath)
+			, FileNames(_FileNames)
+		{
+		}
+
+		virtual bool Visit(const TCHAR* _FilenameOrDirectory, bool _bIsDirectory) override
+		{
+			if (!_bIsDirectory && (Extension.IsEmpty() || FPaths::GetExtension(_FilenameOrDirectory).Equals(Extension, ESearchCase::IgnoreCase)))
+			{
+				if (bFullPath)
+				{
+					// Standardized like the timestamp visitor did it, so the paths stay the same as before
+					FString FilePath = _FilenameOrDirectory;
+					FPaths::MakeStandardFilename(FilePath);
+
+					FileNames.Add(FilePath);
+				}
+				else
+				{
+					FileNames.Add(FPaths::GetCleanFilename(_FilenameOrDirectory));
+				}
+			}
+
+			return true;
+		}
+
+	private:
+
+		const FString& Extension;
+		bool bFullPath;
+		TArray<FString>& FileNames;
+	};
+
+	FString Extension = _FileExtension;
+	Extension.RemoveFromStart(TEXT("."));
+
+	FVisitor Visitor(Extension, _bFullPath, _SoundFileNames);
+
+	FPlatformFileManager::Get().GetPlatformFile().IterateDirectoryRecursively(*FinalPath, Visitor);
+
+	return true;
+}
+
+
+/// Blueprint Versions of the Library Functions ///
+
+void USoundVisualization::SV_StartLibraryScan(const FString _DirectoryPath, const bool _bAbsolutePath, const FString _FileExtension)
+{
+	FString FinalPath = _DirectoryPath;
+
+	if (!_bAbsolutePath)
+	{
+		FinalPath = FPaths::ConvertRelativePathToFull(FPaths::GameDir()) + _DirectoryPath;
+	}
+
+	// Another directory gets its own index, the old one stops scanning
+	if (!LibraryIndex || !LibraryIndex->IsIndexOf(FinalPath, _FileExtension))
+	{
+		delete LibraryIndex;
+
+		LibraryIndex = new FSoundVisLibraryIndex(FinalPath, _FileExtension);
+	}
+
+	LibraryIndex->StartScan();
+}
+
+bool USoundVisualization::SV_GetLibraryScanProgress(int32& _NumFiles, int32& _NumHeadersRead, int32& _NumHeadersToRead)
+{
+	if (!LibraryIndex)
+	{
+		_NumFiles = 0;
+		_NumHeadersRead = 0;
+		_NumHeadersToRead = 0;
+
+		return false;
+	}
+
+	LibraryIndex->GetScanProgress(_NumFiles, _NumHeadersRead, _NumHeadersToRead);
+
+	return LibraryIndex->IsScanning();
+}
+
+void USoundVisualization::SV_QueryLibrary(const FString _NameFilter, const float _MinDuration, const float _MaxDuration, const ESoundVisLibrarySort _SortBy, const bool _bDescending, TArray<FSoundVisLibraryEntry>& _Entries)
+{
+	if (!LibraryIndex)
+	{
+		_Entries.Empty();
+
+		return;
+	}
+
+	LibraryIndex->Query(_NameFilter, _MinDuration, _MaxDuration, _SortBy, _bDescending, _Entries);
+}
+
+
+/// Helper Functions ///
+
+float USoundVisualization::GetFFTInValue(const int16 SampleValue, const int32 SampleIndex, const int32 SampleCount)
+{
+	float FFTValue = SampleValue;
+
+	// Apply the Hann window
+	FFTValue *= 0.5f * (1 - FMath::Cos(2 * PI * SampleIndex / (SampleCount - 1)));
+
+	return FFTValue;
+}
+
+
+/// SOUND VIZ ///
+
+/// C++ Versions of the Analyze Functions ///
+
+void USoundVisualization::Old_CalculateFrequencySpectrum(USoundWave* SoundWave, const bool bSplitChannels, const float StartTime, const float TimeLength, const int32 SpectrumWidth, TArray< TArray<float> >& OutSpectrums)
+{
+	SCOPE_CYCLE_COUNTER(STAT_SoundVisOldSpectrum);
+
+	OutSpectrums.Empty();
+
+	const int32 NumChannels = SoundWave->NumChannels;
+	if (SpectrumWidth > 0 && NumChannels > 0 && NumChannels <= FSoundVisFFTContext::MaxChannels)
+	{
+		// Setup the output data
+		OutSpectrums.AddZeroed((bSplitChannels ? NumChannels : 1));
+
+		for (int32 ChannelIndex = 0; ChannelIndex < OutSpectrums.Num(); ++ChannelIndex)
+		{
+			OutSpectrums[ChannelIndex].AddZeroed(SpectrumWidth);
+		}
+
+		if (PCMSampleBuffer != NULL || StreamingPCM != NULL)
+		{
+			float FBufferSize = TimeLength * SoundWave->SampleRate * SoundWave->NumChannels;
+
+			const uint32 BufferSize = FMath::FloorToInt(FBufferSize) * 2; // Duration * SampleRate * NumChannels * 2
+
+			int32 SampleCount = 0;
+			int32 SampleCounts[10] = { 0 };
+
+			int32 FirstSample = SoundWave->SampleRate * StartTime;
+			int32 LastSample = SoundWave->SampleRate * (StartTime + TimeLength);
+
+			SampleCount = SoundWave->RawPCMDataSize / (2 * NumChannels);
+
+			FirstSample = FMath::Min(SampleCount, FirstSample);
+			LastSample = FMath::Min(SampleCount, LastSample);
+
+			int32 SamplesToRead = LastSample - FirstSample;
+
+			if (SamplesToRead > 0)
+			{
+				// Shift the window enough so that we get a power of 2
+				int32 PoT = 2;
+				while (SamplesToRead > PoT) PoT *= 2;
+
+				FirstSample = FMath::Max(0, FirstSample - (PoT - SamplesToRead) / 2);
+
+				SamplesToRead = PoT;
+
+				// With this equation, LastSample is either Equal or greater than SamplesToRead 
+				LastSample = FirstSample + SamplesToRead;
+
+				// If we have more samples than the SampleCount (due to PoT), end the window at the end of the song. Songs shorter than the window end up negative
+				if (LastSample > SampleCount)
+				{
+					FirstSample = SampleCount - SamplesToRead;
+				}
+				// This makes 0 sense! We can't get a negative FirstSample
+				if (FirstSample < 0)
+				{
+					// If we get to this point we can't create a reasonable window so just give up
+					return;
+				}
+
+				// One pointer per channel, up to 7.1
+				float* buf[FSoundVisFFTContext::MaxChannels] = { 0 };
+				kiss_fft_cpx* out[FSoundVisFFTContext::MaxChannels] = { 0 };
+
+				// Save the Samples Data wie have to the SamplePtr
+				const int16* SamplePtr = GetSampleFrames(SoundWave, FirstSample, SamplesToRead);
+
+				// Streamed block isn't decoded yet
+				if (SamplePtr == NULL)
+				{
+					return;
+				}
+
+				// One scratch block for all channels, reused between calls. The planes stay 16 byte aligned
+				const int32 PlaneStride = FSoundVisFFTContext::GetPlaneStride(SamplesToRead);
+
+				float* InBuffer = FFTContext.GetScratch<float>(ESoundVisScratch::Input, PlaneStride * NumChannels);
+				kiss_fft_cpx* OutBuffer = FFTContext.GetScratch<kiss_fft_cpx>(ESoundVisScratch::Output, SamplesToRead * NumChannels);
+
+				for (int32 ChannelIndex = 0; ChannelIndex < NumChannels; ++ChannelIndex)
+				{
+					// For each Channel, point to room for SamplesToRead numbers
+					buf[ChannelIndex] = InBuffer + ChannelIndex * PlaneStride;
+					out[ChannelIndex] = OutBuffer + ChannelIndex * SamplesToRead;
+				}
+
+				// Use Window function to get a better result for the Data. Splits the channels in the same pass
+				SoundVisKernels::DeinterleaveAndWindow(SamplePtr, NumChannels, SamplesToRead, FFTContext.GetWindow(WindowType, SamplesToRead), buf);
+
+				// The samples are real, so a real FFT gives us the lower half of the spectrum. Two channels share one complex FFT
+				FFTContext.TransformChannels(buf, out, NumChannels, SamplesToRead);
+
+				// Wide spectrums read past the middle bin, so mirror the upper half like the complex FFT would return it
+				for (int32 ChannelIndex = 0; ChannelIndex < NumChannels; ++ChannelIndex)
+				{
+					for (int32 BinIndex = SamplesToRead / 2 + 1; BinIndex < SamplesToRead; ++BinIndex)
+					{
+						out[ChannelIndex][BinIndex].r = out[ChannelIndex][SamplesToRead - BinIndex].r;
+						out[ChannelIndex][BinIndex].i = -out[ChannelIndex][SamplesToRead - BinIndex].i;
+					}
+				}
+
+				// Level of every bin, 10 log10 of the scaled power. That is the dB of the magnitude plus the dB of the scale, from the vectorized kernel
+				float* Decibels[FSoundVisFFTContext::MaxChannels] = { 0 };
+
+				if (bSplitChannels)
+				{
+					float* DecibelBuffer = FFTContext.GetScratch<float>(ESoundVisScratch::Magnitudes, SamplesToRead * NumChannels);
+
+					const float ScaleDecibels = 20.0f * FMath::LogX(10.0f, 2.0f / SamplesToRead);
+
+					for (int32 ChannelIndex = 0; ChannelIndex < NumChannels; ++ChannelIndex)
+					{
+						Decibels[ChannelIndex] = DecibelBuffer + ChannelIndex * SamplesToRead;
+
+						SoundVisKernels::CombineChannelBins(&out[ChannelIndex], 1, SamplesToRead, ESoundVisSpectrumOutput::Decibels, Decibels[ChannelIndex]);
+
+						for (int32 BinIndex = 0; BinIndex < SamplesToRead; ++BinIndex)
+						{
+							Decibels[ChannelIndex][BinIndex] += ScaleDecibels;
+						}
+					}
+				}
+
+				int32 SamplesPerSpectrum = SamplesToRead / (2 * SpectrumWidth);
+				int32 ExcessSamples = SamplesToRead % (2 * SpectrumWidth);
+
+				int32 FirstSampleForSpectrum = 1;
+
+				for (int32 SpectrumIndex = 0; SpectrumIndex < SpectrumWidth; ++SpectrumIndex)
+				{
+					int32 SamplesRead = 0;
+					double SampleSum = 0;
+					int32 SamplesForSpectrum = SamplesPerSpectrum + (ExcessSamples-- > 0 ? 1 : 0);
+
+					float Test = 0.0;
+
+					for (int32 ChannelIndex = 0; ChannelIndex < NumChannels; ++ChannelIndex)
+					{
+						if (out[ChannelIndex])
+						{
+							if (bSplitChannels)
+							{
+								SampleSum = 0;
+							}
+
+							for (int32 SampleIndex = 0; SampleIndex < SamplesForSpectrum; ++SampleIndex)
+							{
+								Test += FMath::Sqrt(FMath::Square(out[ChannelIndex][SampleIndex].r) + FMath::Square(out[ChannelIndex][SampleIndex].i));
+
+								if (bSplitChannels)
+								{
+									SampleSum += Decibels[ChannelIndex][FirstSampleForSpectrum + SampleIndex];
+								}
+							}
+
+							if (bSplitChannels)
+							{
+								OutSpectrums[ChannelIndex][SpectrumIndex] = (float)(SampleSum / SamplesForSpectrum);
+
+							}
+							SamplesRead += SamplesForSpectrum;
+						}
+					}
+
+					if (!bSplitChannels)
+					{
+						//OutSpectrums[0][SpectrumIndex] = (float)(SampleSum / SamplesRead);
+						OutSpectrums[0][SpectrumIndex] = Test;
+					}
+
+					FirstSampleForSpectrum += SamplesForSpectrum;
+				}
+
+			}
+		}
+	}
+}
+
+void USoundVisualization::New_CalculateFrequencySpectrum(USoundWave* _SoundWave, const float _StartTime, const float _Duration, TArray<float>& _OutFrequencies)
+{
+	SCOPE_CYCLE_COUNTER(STAT_SoundVisNewSpectrum);
+
+	// Keep the allocation of the passed array, we refill it anyway
+	_OutFrequencies.Reset();
+
+	const int32 NumChannels = _SoundWave->NumChannels;
+
+	if (NumChannels > 0)
+	{
+		// For 0.1 seconds and 44100 samples per second, this would be 4410 samples, half of them will be returned by FFT, so 2205 array size
+		/*
+		int32 NumFreq = 0;
+
+		int32 Temp = ((int32)(_SoundWave->SampleRate * _Duration)) % 2;
+
+		if (Temp > 0)
+		{
+		NumFreq = 1;
+		}
+
+		NumFreq += (int32)((_SoundWave->SampleRate * _Duration) / 2);
+
+		_OutFrequencies.AddZeroed(NumFreq);*/
+
+		// Songs loaded from the analysis cache only have the spectrogram, no samples
+		const bool bHasSpectrogram = _SoundWave == SpectrogramWave && Spectrogram.HasFrames();
+
+		if (PCMSampleBuffer != NULL || StreamingPCM != NULL || bHasSpectrogram)
+		{
+			int32 FirstSample = 0;
+			int32 SamplesToRead = 0;
+			int32 FFTSize = 0;
+			float CenterTime = 0.0f;
+
+			if (GetSpectrumWindow(_SoundWave, _StartTime, _Duration, FirstSample, SamplesToRead, FFTSize, CenterTime))
+			{
+				// Served from the precomputed spectrogram if it was built for this song and window size. Its frames aren't padded
+				if (bHasSpectrogram && Spectrogram.GetFFTSize() == FFTSize && SamplesToRead == FFTSize)
+				{
+					_OutFrequencies.AddUninitialized(Spectrogram.GetNumBins());
+
+					Spectrogram.GetSpectrumAtTime(CenterTime, _OutFrequencies.GetData());
+
+					SoundVisKernels::ConvertMagnitudes(_OutFrequencies.GetData(), _OutFrequencies.Num(), SpectrumOutput, _OutFrequencies.GetData());
+
+					return;
+				}
+
+				// This makes 0 sense! We can't get a negative FirstSample
+				if (FirstSample < 0)
+				{
+					// If we get to this point we can't create a reasonable window so just give up
+					return;
+				}
+
+				// Reuses the frames of the previous queries on the hop grid
+				if (bSlidingSpectrum)
+				{
+					_OutFrequencies.AddUninitialized(FFTSize / 2);
+
+					if (!GetSlidingSpectrum(_SoundWave, SamplesToRead, FFTSize, CenterTime, _OutFrequencies.GetData()))
+					{
+						_OutFrequencies.Reset();
+					}
+
+					SoundVisKernels::ConvertMagnitudes(_OutFrequencies.GetData(), _OutFrequencies.Num(), SpectrumOutput, _OutFrequencies.GetData());
+
+					return;
+				}
+
+				// Save the Samples Data wie have to the SamplePtr. NULL without samples or if the streamed block isn't decoded yet
+				const int16* SamplePtr = GetSampleFrames(_SoundWave, FirstSample, SamplesToRead);
+
+				if (SamplePtr == NULL)
+				{
+					return;
+				}
+
+				_OutFrequencies.AddUninitialized(FFTSize / 2);
+
+				// Window, real FFT and magnitudes averaged over the channels, in the requested output
+				FFTContext.SetFixedPoint(bFixedPointAnalysis);
+				FFTContext.CalculateSpectrum(SamplePtr, NumChannels, FFTSize, WindowType, SpectrumOutput, _OutFrequencies.GetData(), SamplesToRead);
+			}
+		}
+	}
+}
+
+int32 USoundVisualization::New_CalculateFrequencySpectrumBatch(USoundWave* _SoundWave, const TArray<float>& _StartTimes, const float _Duration, const ESoundVisBatchOutput _Output, const ESoundVisBandLayout _Layout, const ESoundVisFilterShape _Shape, const int32 _NumMelBands, TArray<float>& _OutValues)
+{
+	SCOPE_CYCLE_COUNTER(STAT_SoundVisSpectrumBatch);
+
+	_OutValues.Reset();
+
+	const int32 NumChannels = _SoundWave->NumChannels;
+	const int32 SampleRate = _SoundWave->SampleRate;
+	const int32 NumRows = _StartTimes.Num();
+
+	const bool bHasSpectrogram = _SoundWave == SpectrogramWave && Spectrogram.HasFrames();
+
+	if (NumRows <= 0 || NumChannels <= 0 || NumChannels > FSoundVisFFTContext::MaxChannels || SampleRate <= 0 || (PCMSampleBuffer == NULL && StreamingPCM == NULL && !bHasSpectrogram))
+	{
+		return 0;
+	}
+
+	// Every row uses the same window, also the ones at the end of the song. Power of two windows grow around the requested part,
+	// the others read exactly it and get zero padded
+	const int32 SampleCount = _SoundWave->RawPCMDataSize / (2 * NumChannels);
+	const int32 WindowSamples = FMath::Max(1, FMath::FloorToInt(SampleRate * _Duration));
+	const int32 FFTSize = FSoundVisFFTContext::GetFFTSize(FFTSizePolicy, WindowSamples);
+	const int32 NumFrames = FFTSizePolicy == ESoundVisFFTSizePolicy::PowerOfTwo ? FFTSize : WindowSamples;
+
+	if (NumFrames > SampleCount)
+	{
+		return 0;
+	}
+
+	const bool bBands = _Output == ESoundVisBatchOutput::Bands;
+
+	// Only the band count is read here. A cached filterbank is freed by the next one its context adds, so every chunk uses the one of its own context
+	const int32 RowLength = bBands ? FFTContext.GetFilterbank(FFTSize, SampleRate, _Layout, _Shape, _NumMelBands).GetNumBands() : FFTSize / 2;
+	const bool bUseSpectrogram = bHasSpectrogram && Spectrogram.GetFFTSize() == FFTSize && NumFrames == FFTSize;
+
+	_OutValues.SetNumZeroed(NumRows * RowLength);
+
+	// First frame and center time of every row, the same way GetSpectrumWindow picks them
+	TArray<int32> RowFirstFrames;
+	TArray<float> RowCenterTimes;
+	RowFirstFrames.SetNumUninitialized(NumRows);
+	RowCenterTimes.SetNumUninitialized(NumRows);
+
+	for (int32 RowIndex = 0; RowIndex < NumRows; ++RowIndex)
+	{
+		const int32 FirstSample = FMath::Clamp(FMath::FloorToInt(SampleRate * _StartTimes[RowIndex]), 0, SampleCount);
+
+		RowCenterTimes[RowIndex] = (FirstSample + FMath::Min(WindowSamples, SampleCount - FirstSample) * 0.5f) / SampleRate;
+		RowFirstFrames[RowIndex] = FMath::Clamp(FirstSample - (NumFrames - WindowSamples) / 2, 0, SampleCount - NumFrames);
+	}
+
+	// The streamed blocks can only be read from this thread, so their windows are copied out before the FFTs start.
+	// Only blocks that are already there, the rows jump around the song and must not pull the decoding away from the playhead
+	TArray<const int16*> RowSamples;
+	RowSamples.SetNumZeroed(NumRows);
+
+	if (!bUseSpectrogram)
+	{
+		if (StreamingPCM)
+		{
+			BatchSamples.SetNumUninitialized(NumRows * NumFrames * NumChannels);
+
+			for (int32 RowIndex = 0; RowIndex < NumRows; ++RowIndex)
+			{
+				RowSamples[RowIndex] = StreamingPCM->GetFramesIfResident(RowFirstFrames[RowIndex], NumFrames, BatchSamples.GetData() + (int64)RowIndex * NumFrames * NumChannels);
+			}
+		}
+		else
+		{
+			for (int32 RowIndex = 0; RowIndex < NumRows; ++RowIndex)
+			{
+				RowSamples[RowIndex] = GetSampleFrames(_SoundWave, RowFirstFrames[RowIndex], NumFrames);
+			}
+		}
+	}
+
+	// One chunk of neighbouring rows per core, every chunk with its own context. All rows cost the same, so they are split evenly
+	const int32 NumChunks = FMath::Min(NumRows, FTaskGraphInterface::Get().GetNumWorkerThreads() + 1);
+
+	while (BatchContexts.Num() < NumChunks)
+	{
+		FSoundVisFFTContext* Context = new FSoundVisFFTContext();
+
+		// The chunks already keep all cores busy
+		Context->SetParallelChannels(false);
+
+		BatchContexts.Add(Context);
+	}
+
+	ParallelFor(NumChunks, [&](int32 ChunkIndex)
+	{
+		FSoundVisFFTContext& Context = BatchContexts[ChunkIndex];
+
+		Context.SetFixedPoint(bFixedPointAnalysis);
+
+		// Stays valid for the whole chunk, nothing else adds a filterbank to this context until the batch is done
+		const FSoundVisFilterbank* Filterbank = bBands ? &Context.GetFilterbank(FFTSize, SampleRate, _Layout, _Shape, _NumMelBands) : NULL;
+
+		const int32 FirstRow = (int64)NumRows * ChunkIndex / NumChunks;
+		const int32 LastRow = (int64)NumRows * (ChunkIndex + 1) / NumChunks;
+
+		for (int32 RowIndex = FirstRow; RowIndex < LastRow; ++RowIndex)
+		{
+			float* Row = _OutValues.GetData() + (int64)RowIndex * RowLength;
+
+			if (bUseSpectrogram)
+			{
+				float* Magnitudes = bBands ? Context.GetScratch<float>(ESoundVisScratch::Magnitudes, FFTSize / 2) : Row;
+
+				Spectrogram.GetSpectrumAtTime(RowCenterTimes[RowIndex], Magnitudes);
+
+				if (bBands)
+				{
+					Filterbank->Apply(Magnitudes, Row);
+				}
+				else
+				{
+					SoundVisKernels::ConvertMagnitudes(Row, RowLength, SpectrumOutput, Row);
+				}
+			}
+			else if (RowSamples[RowIndex])
+			{
+				if (bBands)
+				{
+					Context.CalculateBandEnergies(RowSamples[RowIndex], NumChannels, FFTSize, WindowType, *Filterbank, Row, NumFrames);
+				}
+				else
+				{
+					Context.CalculateSpectrum(RowSamples[RowIndex], NumChannels, FFTSize, WindowType, SpectrumOutput, Row, NumFrames);
+				}
+			}
+		}
+	});
+
+	return RowLength;
+}
+
+bool USoundVisualization::New_CalculateFrequencyValues(USoundWave* _SoundWave, const float _StartTime, const float _Duration, const int32* _Frequencies, const int32 _NumFrequencies, float* _OutValues)
+{
+	SCOPE_CYCLE_COUNTER(STAT_SoundVisFrequencyValues);
+
+	const int32 NumChannels = _SoundWave->NumChannels;
+
+	const bool bHasSpectrogram = _SoundWave == SpectrogramWave && Spectrogram.HasFrames();
+
+	if (_NumFrequencies <= 0 || NumChannels <= 0 || _SoundWave->SampleRate <= 0 || (PCMSampleBuffer == NULL && StreamingPCM == NULL && !bHasSpectrogram))
+	{
+		return false;
+	}
+
+	int32 FirstSample = 0;
+	int32 SamplesToRead = 0;
+	int32 FFTSize = 0;
+	float CenterTime = 0.0f;
+
+	if (!GetSpectrumWindow(_SoundWave, _StartTime, _Duration, FirstSample, SamplesToRead, FFTSize, CenterTime))
+	{
+		return false;
+	}
+
+	const int32 NumBins = FFTSize / 2;
+
+	// Same as "Frequency * Frequencies.Num() * 2 / SampleRate" in the Frequency Value functions
+	TArray<int32, TInlineAllocator<16> > Bins;
+	Bins.SetNumUninitialized(_NumFrequencies);
+
+	for (int32 FrequencyIndex = 0; FrequencyIndex < _NumFrequencies; ++FrequencyIndex)
+	{
+		Bins[FrequencyIndex] = FMath::Clamp((int32)((int64)_Frequencies[FrequencyIndex] * NumBins * 2 / _SoundWave->SampleRate), 0, NumBins - 1);
+	}
+
+	// The precomputed and the sliding spectrum already have all bins, they only need to be picked
+	float* Magnitudes = NULL;
+
+	if (bHasSpectrogram && Spectrogram.GetFFTSize() == FFTSize && SamplesToRead == FFTSize)
+	{
+		Magnitudes = FFTContext.GetScratch<float>(ESoundVisScratch::Magnitudes, NumBins);
+
+		Spectrogram.GetSpectrumAtTime(CenterTime, Magnitudes);
+	}
+	else if (FirstSample < 0)
+	{
+		return false;
+	}
+	else if (bSlidingSpectrum)
+	{
+		Magnitudes = FFTContext.GetScratch<float>(ESoundVisScratch::Magnitudes, NumBins);
+
+		if (!GetSlidingSpectrum(_SoundWave, SamplesToRead, FFTSize, CenterTime, Magnitudes))
+		{
+			return false;
+		}
+	}
+
+	if (Magnitudes)
+	{
+		for (int32 FrequencyIndex = 0; FrequencyIndex < _NumFrequencies; ++FrequencyIndex)
+		{
+			_OutValues[FrequencyIndex] = Magnitudes[Bins[FrequencyIndex]];
+		}
+
+		SoundVisKernels::ConvertMagnitudes(_OutValues, _NumFrequencies, SpectrumOutput, _OutValues);
+
+		return true;
+	}
+
+	const int16* SamplePtr = GetSampleFrames(_SoundWave, FirstSample, SamplesToRead);
+
+	if (SamplePtr == NULL)
+	{
+		return false;
+	}
+
+	// Goertzel filters for a few bins, the FFT for many
+	FFTContext.SetFixedPoint(bFixedPointAnalysis);
+	FFTContext.CalculateBinMagnitudes(SamplePtr, NumChannels, FFTSize, WindowType, Bins.GetData(), _NumFrequencies, _OutValues, SamplesToRead);
+
+	SoundVisKernels::ConvertMagnitudes(_OutValues, _NumFrequencies, SpectrumOutput, _OutValues);
+
+	return true;
+}
 
-			int32 FirstSample = SoundWave->SampleRate * StartTime;
-			int32 LastSample = SoundWave->SampleRate * (StartTime + TimeLength);
+void USoundVisualization::New_CalculateChannelSpectrum(USoundWave* _SoundWave, int32 _ChannelIndex, const float _StartTime, const float _Duration, TArray<float>& _OutFrequencies)
+{
+	SCOPE_CYCLE_COUNTER(STAT_SoundVisNewSpectrum);
 
-			if (NumChannels <= 2)
-			{
-				SampleCount = SoundWave->RawPCMDataSize / (2 * NumChannels);
-			}
+	_OutFrequencies.Reset();
 
-			FirstSample = FMath::Min(SampleCount, FirstSample);
-			LastSample = FMath::Min(SampleCount, LastSample);
+	const int32 NumChannels = _SoundWave->NumChannels;
 
-			int32 SamplesToRead = LastSample - FirstSample;
+	// The spectrogram only holds the combined channels, so this always needs the samples
+	if (NumChannels <= 0 || NumChannels > FSoundVisFFTContext::MaxChannels || _ChannelIndex < 0 || _ChannelIndex >= NumChannels || (PCMSampleBuffer == NULL && StreamingPCM == NULL))
+	{
+		return;
+	}
 
-			if (SamplesToRead > 0)
-			{
-				// Shift the window enough so that we get a power of 2
-				int32 PoT = 2;
-				while (SamplesToRead > PoT) PoT *= 2;
+	int32 FirstSample = 0;
+	int32 SamplesToRead = 0;
+	int32 FFTSize = 0;
+	float CenterTime = 0.0f;
 
-				FirstSample = FMath::Max(0, FirstSample - (PoT - SamplesToRead) / 2);
+	if (!GetSpectrumWindow(_SoundWave, _StartTime, _Duration, FirstSample, SamplesToRead, FFTSize, CenterTime) || FirstSample < 0)
+	{
+		return;
+	}
 
-				SamplesToRead = PoT;
+	const int16* SamplePtr = GetSampleFrames(_SoundWave, FirstSample, SamplesToRead);
 
-				// With this equation, LastSample is either Equal or greater than SamplesToRead 
-				LastSample = FirstSample + SamplesToRead;
+	if (SamplePtr == NULL)
+	{
+		return;
+	}
 
-				// If we have more samples than the SampleCount (due to PoT)
-				if (LastSample > SampleCount)
-				{
-					// Regarding above comments, this will either 0 or >0, so FirstSample can't be negative
-					FirstSample = LastSample - SamplesToRead;
-				}
-				// This makes 0 sense! We can't get a negative FirstSample
-				if (FirstSample < 0)
-				{
-					// If we get to this point we can't create a reasonable window so just give up
-					return;
-				}
+	_OutFrequencies.SetNumUninitialized(FFTSize / 2);
 
-				// Create 2 complex number pointer arrays of size 10 and set their value to 0
-				kiss_fft_cpx* buf[10] = { 0 };
-				kiss_fft_cpx* out[10] = { 0 };
+	// Same window and FFT as the combined spectrum, but only the requested channel gets transformed
+	FFTContext.SetFixedPoint(bFixedPointAnalysis);
+	FFTContext.CalculateChannelSpectrum(SamplePtr, NumChannels, _ChannelIndex, FFTSize, WindowType, SpectrumOutput, _OutFrequencies.GetData(), SamplesToRead);
+}
 
-				// Create a one dimensional int Array with the SamplesToRead in it
-				int32 Dims[1] = { SamplesToRead };
+void USoundVisualization::New_CalculateBandEnergies(USoundWave* _SoundWave, const float _StartTime, const float _Duration, const ESoundVisBandLayout _Layout, const ESoundVisFilterShape _Shape, const int32 _NumMelBands, TArray<float>& _OutBandEnergies)
+{
+	SCOPE_CYCLE_COUNTER(STAT_SoundVisBandEnergies);
 
-				// Struct of data kiss_fftnd_state
-				kiss_fftnd_cfg stf = kiss_fftnd_alloc(Dims, 1, 0, NULL, NULL);
+	_OutBandEnergies.Reset();
 
-				// Save the Samples Data wie have to the SamplePtr
-				int16* SamplePtr = reinterpret_cast<int16*>(PCMSampleBuffer);
+	const int32 NumChannels = _SoundWave->NumChannels;
 
-				// STEREO/MONO
-				if (NumChannels <= 2)
-				{
-					for (int32 ChannelIndex = 0; ChannelIndex < NumChannels; ++ChannelIndex)
-					{
-						// For each Channel, create room for SamplesToRead complex numbers
-						buf[ChannelIndex] = (kiss_fft_cpx *)KISS_FFT_MALLOC(sizeof(kiss_fft_cpx) * SamplesToRead);
-						out[ChannelIndex] = (kiss_fft_cpx *)KISS_FFT_MALLOC(sizeof(kiss_fft_cpx) * SamplesToRead);
-					}
+	const bool bHasSpectrogram = _SoundWave == SpectrogramWave && Spectrogram.HasFrames();
 
-					SamplePtr += (FirstSample * NumChannels);
+	if (NumChannels <= 0 || (PCMSampleBuffer == NULL && StreamingPCM == NULL && !bHasSpectrogram))
+	{
+		return;
+	}
 
-					for (int32 SampleIndex = 0; SampleIndex < SamplesToRead; ++SampleIndex)
-					{
-						for (int32 ChannelIndex = 0; ChannelIndex < NumChannels; ++ChannelIndex)
-						{
-							// Use Window function to get a better result for the Data (Hann Window)
-							buf[ChannelIndex][SampleIndex].r = GetFFTInValue(*SamplePtr, SampleIndex, SamplesToRead);
-							buf[ChannelIndex][SampleIndex].i = 0.f;
+	int32 FirstSample = 0;
+	int32 SamplesToRead = 0;
+	int32 FFTSize = 0;
+	float CenterTime = 0.0f;
 
-							SamplePtr++;
-						}
-					}
-				}
-				// Lost the thin line to what this does
-				for (int32 ChannelIndex = 0; ChannelIndex < NumChannels; ++ChannelIndex)
-				{
-					if (buf[ChannelIndex])
-					{
-						kiss_fftnd(stf, buf[ChannelIndex], out[ChannelIndex]);
-					}
-				}
+	if (!GetSpectrumWindow(_SoundWave, _StartTime, _Duration, FirstSample, SamplesToRead, FFTSize, CenterTime))
+	{
+		return;
+	}
 
+	const FSoundVisFilterbank& Filterbank = FFTContext.GetFilterbank(FFTSize, _SoundWave->SampleRate, _Layout, _Shape, _NumMelBands);
 
-				int32 SamplesPerSpectrum = SamplesToRead / (2 * SpectrumWidth);
-				int32 ExcessSamples = SamplesToRead % (2 * SpectrumWidth);
+	if (bHasSpectrogram && Spectrogram.GetFFTSize() == FFTSize && SamplesToRead == FFTSize)
+	{
+		// The spectrogram only has the linear bins, so they go through a scratch block first
+		float* Magnitudes = FFTContext.GetScratch<float>(ESoundVisScratch::Magnitudes, Spectrogram.GetNumBins());
 
-				int32 FirstSampleForSpectrum = 1;
+		Spectrogram.GetSpectrumAtTime(CenterTime, Magnitudes);
 
-				for (int32 SpectrumIndex = 0; SpectrumIndex < SpectrumWidth; ++SpectrumIndex)
-				{
-					int32 SamplesRead = 0;
-					double SampleSum = 0;
-					int32 SamplesForSpectrum = SamplesPerSpectrum + (ExcessSamples-- > 0 ? 1 : 0);
+		_OutBandEnergies.AddUninitialized(Filterbank.GetNumBands());
 
-					float Test = 0.0;
+		Filterbank.Apply(Magnitudes, _OutBandEnergies.GetData());
 
-					for (int32 ChannelIndex = 0; ChannelIndex < NumChannels; ++ChannelIndex)
-					{
-						if (out[ChannelIndex])
-						{
-							if (bSplitChannels)
-							{
-								SampleSum = 0;
-							}
+		return;
+	}
 
-							for (int32 SampleIndex = 0; SampleIndex < SamplesForSpectrum; ++SampleIndex)
-							{
-								float PostScaledR = out[ChannelIndex][FirstSampleForSpectrum + SampleIndex].r * 2.f / SamplesToRead;
-								float PostScaledI = out[ChannelIndex][FirstSampleForSpectrum + SampleIndex].i * 2.f / SamplesToRead;
+	if (FirstSample < 0)
+	{
+		return;
+	}
 
-								float Val = 10.f * FMath::LogX(10.f, FMath::Square(PostScaledR) + FMath::Square(PostScaledI));
-								Test += FMath::Sqrt(FMath::Square(out[ChannelIndex][SampleIndex].r) + FMath::Square(out[ChannelIndex][SampleIndex].i));
-								SampleSum += Val;
-							}
+	if (bSlidingSpectrum)
+	{
+		float* Magnitudes = FFTContext.GetScratch<float>(ESoundVisScratch::Magnitudes, FFTSize / 2);
 
-							if (bSplitChannels)
-							{
-								OutSpectrums[ChannelIndex][SpectrumIndex] = (float)(SampleSum / SamplesForSpectrum);
+		if (GetSlidingSpectrum(_SoundWave, SamplesToRead, FFTSize, CenterTime, Magnitudes))
+		{
+			_OutBandEnergies.AddUninitialized(Filterbank.GetNumBands());
 
-							}
-							SamplesRead += SamplesForSpectrum;
-						}
-					}
+			Filterbank.Apply(Magnitudes, _OutBandEnergies.GetData());
+		}
 
-					if (!bSplitChannels)
-					{
-						//OutSpectrums[0][SpectrumIndex] = (float)(SampleSum / SamplesRead);
-						OutSpectrums[0][SpectrumIndex] = Test;
-					}
+		return;
+	}
 
-					FirstSampleForSpectrum += SamplesForSpectrum;
-				}
+	const int16* SamplePtr = GetSampleFrames(_SoundWave, FirstSample, SamplesToRead);
 
-				KISS_FFT_FREE(stf);
-				for (int32 ChannelIndex = 0; ChannelIndex < NumChannels; ++ChannelIndex)
-				{
-					if (buf[ChannelIndex])
-					{
-						KISS_FFT_FREE(buf[ChannelIndex]);
-						KISS_FFT_FREE(out[ChannelIndex]);
-					}
-				}
-			}
-		}
+	if (SamplePtr == NULL)
+	{
+		return;
 	}
+
+	_OutBandEnergies.AddUninitialized(Filterbank.GetNumBands());
+
+	FFTContext.SetFixedPoint(bFixedPointAnalysis);
+	FFTContext.CalculateBandEnergies(SamplePtr, NumChannels, FFTSize, WindowType, Filterbank, _OutBandEnergies.GetData(), SamplesToRead);
 }
 
-void USoundVisualization::New_CalculateFrequencySpectrum(USoundWave* _SoundWave, const float _StartTime, const float _Duration, TArray<float>& _OutFrequencies)
+bool USoundVisualization::GetSlidingSpectrum(USoundWave* _SoundWave, const int32 _NumFrames, const int32 _FFTSize, const float _CenterTime, float* _OutMagnitudes)
 {
-	_OutFrequencies.Empty();
-
 	const int32 NumChannels = _SoundWave->NumChannels;
+	const int32 HopSize = FMath::Max(1, FMath::FloorToInt(_SoundWave->SampleRate * SlidingHopDuration));
 
-	if (NumChannels > 0)
-	{
-		// For 0.1 seconds and 44100 samples per second, this would be 4410 samples, half of them will be returned by FFT, so 2205 array size
-		/*
-		int32 NumFreq = 0;
-
-		int32 Temp = ((int32)(_SoundWave->SampleRate * _Duration)) % 2;
+	SlidingSTFT.Configure(_SoundWave, NumChannels, _SoundWave->SampleRate, _SoundWave->RawPCMDataSize / (2 * NumChannels), _NumFrames, _FFTSize, HopSize, WindowType, bFixedPointAnalysis);
 
-		if (Temp > 0)
-		{
-		NumFreq = 1;
-		}
+	FFTContext.SetFixedPoint(bFixedPointAnalysis);
 
-		NumFreq += (int32)((_SoundWave->SampleRate * _Duration) / 2);
+	return SlidingSTFT.GetSpectrumAtTime(_CenterTime, FFTContext, [&](int32 _FirstFrame, int32 _NumFrames)
+	{
+		return GetSampleFrames(_SoundWave, _FirstFrame, _NumFrames);
+	}, _OutMagnitudes);
+}
 
-		_OutFrequencies.AddZeroed(NumFreq);*/
+bool USoundVisualization::GetSpectrumWindow(USoundWave* _SoundWave, const float _StartTime, const float _Duration, int32& _OutFirstSample, int32& _OutNumFrames, int32& _OutFFTSize, float& _OutCenterTime) const
+{
+	const int32 NumChannels = _SoundWave->NumChannels;
 
-		if (PCMSampleBuffer != NULL)
-		{
-			float FBufferSize = _Duration * _SoundWave->SampleRate * _SoundWave->NumChannels;
+	// Get first and last sample
+	int32 FirstSample = _SoundWave->SampleRate * _StartTime;
+	int32 LastSample = _SoundWave->SampleRate * (_StartTime + _Duration);
 
-			const uint32 BufferSize = FMath::FloorToInt(FBufferSize) * 2; // Duration * SampleRate * NumChannels * 2
+	// Get Maximum amount of samples in this song
+	int32 SampleCount = _SoundWave->RawPCMDataSize / (2 * NumChannels);
 
-																		  // Get first and last sample
-			int32 FirstSample = _SoundWave->SampleRate * _StartTime;
-			int32 LastSample = _SoundWave->SampleRate * (_StartTime + _Duration);
+	FirstSample = FMath::Min(SampleCount, FirstSample);
+	LastSample = FMath::Min(SampleCount, LastSample);
 
-			// Get Maximum amount of samples in this song
-			int32 SampleCount = _SoundWave->RawPCMDataSize / (2 * NumChannels);
+	// Actual samples we gonna read
+	int32 SamplesToRead = LastSample - FirstSample;
 
-			FirstSample = FMath::Min(SampleCount, FirstSample);
-			LastSample = FMath::Min(SampleCount, LastSample);
+	if (SamplesToRead <= 0)
+	{
+		return false;
+	}
 
-			// Actual samples we gonna read
-			int32 SamplesToRead = LastSample - FirstSample;
+	// The spectrogram looks up the middle of the requested part, not of the shifted window
+	_OutCenterTime = (FirstSample + SamplesToRead * 0.5f) / _SoundWave->SampleRate;
 
-			if (SamplesToRead > 0)
-			{
-				// Shift the window enough so that we get a power of 2
-				int32 PoT = 2;
-				while (SamplesToRead > PoT) PoT *= 2;
+	_OutFFTSize = FSoundVisFFTContext::GetFFTSize(FFTSizePolicy, SamplesToRead);
 
-				FirstSample = FMath::Max(0, FirstSample - (PoT - SamplesToRead) / 2);
+	// Exactly the requested part. The FFT pads it with zeros behind the window, so its center doesn't move
+	if (FFTSizePolicy != ESoundVisFFTSizePolicy::PowerOfTwo)
+	{
+		_OutFirstSample = FirstSample;
+		_OutNumFrames = SamplesToRead;
 
-				SamplesToRead = PoT;
+		return true;
+	}
 
-				// With this equation, LastSample is either Equal or greater than SamplesToRead 
-				LastSample = FirstSample + SamplesToRead;
+	// Shift the window enough so that we get a power of 2
+	int32 PoT = _OutFFTSize;
 
-				// If we have more samples than the SampleCount (due to PoT)
-				if (LastSample > SampleCount)
-				{
-					// Regarding above comments, this will either 0 or >0, so FirstSample can't be negative
-					FirstSample = LastSample - SamplesToRead;
-				}
-				// This makes 0 sense! We can't get a negative FirstSample
-				if (FirstSample < 0)
-				{
-					// If we get to this point we can't create a reasonable window so just give up
-					return;
-				}
+	FirstSample = FMath::Max(0, FirstSample - (PoT - SamplesToRead) / 2);
 
-				kiss_fft_cpx* buf[2] = { 0 };
-				kiss_fft_cpx* out[2] = { 0 };
+	SamplesToRead = PoT;
 
-				// Create a one dimensional int Array with the SamplesToRead in it
-				int32 Dims[1] = { SamplesToRead };
+	// With this equation, LastSample is either Equal or greater than SamplesToRead 
+	LastSample = FirstSample + SamplesToRead;
 
-				// Struct of data kiss_fftnd_state
-				kiss_fftnd_cfg stf = kiss_fftnd_alloc(Dims, 1, 0, NULL, NULL);
+	// If we have more samples than the SampleCount (due to PoT), end the window at the end of the song. Songs shorter than the window end up negative
+	if (LastSample > SampleCount)
+	{
+		FirstSample = SampleCount - SamplesToRead;
+	}
 
-				// Save the Samples Data wie have to the SamplePtr
-				int16* SamplePtr = reinterpret_cast<int16*>(PCMSampleBuffer);
+	_OutFirstSample = FirstSample;
+	_OutNumFrames = SamplesToRead;
 
-				for (int32 ChannelIndex = 0; ChannelIndex < NumChannels; ChannelIndex++)
-				{
-					buf[ChannelIndex] = (kiss_fft_cpx *)KISS_FFT_MALLOC(sizeof(kiss_fft_cpx) * SamplesToRead);
-					out[ChannelIndex] = (kiss_fft_cpx *)KISS_FFT_MALLOC(sizeof(kiss_fft_cpx) * SamplesToRead);
-				}
+	return true;
+}
 
-				SamplePtr += (FirstSample * NumChannels);
+// Average absolute sample value of _AmplitudeBuckets equally long parts of the interleaved samples. Combined, it's the average over all channels
+static void FillAmplitudeBuckets(const int16* SamplePtr, const int32 NumChannels, const uint32 NumFrames, const bool bSplitChannels, const int32 AmplitudeBuckets, TArray< TArray<float> >& OutAmplitudes)
+{
+	uint32 SamplesPerAmplitude = NumFrames / AmplitudeBuckets;
+	uint32 ExcessSamples = NumFrames % AmplitudeBuckets;
 
-				for (int32 SampleIndex = 0; SampleIndex < SamplesToRead; ++SampleIndex)
-				{
-					//if (SampleIndex + FirstSample <= SampleCount)
-					//{
-					for (int32 ChannelIndex = 0; ChannelIndex < NumChannels; ChannelIndex++)
-					{
-						// Use Window function to get a better result for the Data (Hann Window)
-						buf[ChannelIndex][SampleIndex].r = GetFFTInValue(*SamplePtr, SampleIndex, SamplesToRead);
-						buf[ChannelIndex][SampleIndex].i = 0.f;
+	// WAV files aren't limited to 7.1, so the sums only live on the stack up to there
+	TArray<int64, TInlineAllocator<FSoundVisFFTContext::MaxChannels> > SampleSum;
+	SampleSum.SetNumUninitialized(NumChannels);
 
-						SamplePtr++;
-					}
-					//	}
-					/*else
-					{
-					for (int32 ChannelIndex = 0; ChannelIndex < NumChannels; ChannelIndex++)
-					{
-					// Fill with zeros
-					buf[ChannelIndex][SampleIndex].r = 0.f;
-					buf[ChannelIndex][SampleIndex].i = 0.f;
-					}
-					}*/
-				}
+	for (int32 AmplitudeIndex = 0; AmplitudeIndex < AmplitudeBuckets; ++AmplitudeIndex)
+	{
+		uint32 SamplesToRead = SamplesPerAmplitude;
 
-				for (int32 ChannelIndex = 0; ChannelIndex < NumChannels; ChannelIndex++)
-				{
-					if (buf[ChannelIndex])
-					{
-						kiss_fftnd(stf, buf[ChannelIndex], out[ChannelIndex]);
-					}
-				}
+		// Spread the rest over the first buckets. ExcessSamples is unsigned, so don't let it wrap around
+		if (ExcessSamples > 0)
+		{
+			++SamplesToRead;
+			--ExcessSamples;
+		}
 
-				_OutFrequencies.AddZeroed(SamplesToRead / 2);
+		if (SamplesToRead == 0)
+		{
+			continue;
+		}
 
-				for (int32 SampleIndex = 0; SampleIndex < SamplesToRead / 2; ++SampleIndex)
-				{
-					float ChannelSum = 0.0f;
+		FMemory::Memzero(SampleSum.GetData(), NumChannels * sizeof(int64));
 
-					for (int32 ChannelIndex = 0; ChannelIndex < NumChannels; ++ChannelIndex)
-					{
-						if (out[ChannelIndex])
-						{
-							ChannelSum += FMath::Sqrt(FMath::Square(out[ChannelIndex][SampleIndex].r) + FMath::Square(out[ChannelIndex][SampleIndex].i));
-						}
-					}
+		for (uint32 SampleIndex = 0; SampleIndex < SamplesToRead; ++SampleIndex)
+		{
+			for (int32 ChannelIndex = 0; ChannelIndex < NumChannels; ++ChannelIndex)
+			{
+				SampleSum[ChannelIndex] += FMath::Abs(*SamplePtr);
+				SamplePtr++;
+			}
+		}
 
-					_OutFrequencies[SampleIndex] = ChannelSum / NumChannels;
-				}
+		if (bSplitChannels)
+		{
+			for (int32 ChannelIndex = 0; ChannelIndex < NumChannels; ++ChannelIndex)
+			{
+				OutAmplitudes[ChannelIndex][AmplitudeIndex] = SampleSum[ChannelIndex] / (float)SamplesToRead;
+			}
+		}
+		else
+		{
+			int64 ChannelSum = 0;
 
-				KISS_FFT_FREE(stf);
-				for (int32 ChannelIndex = 0; ChannelIndex < NumChannels; ++ChannelIndex)
-				{
-					if (buf[ChannelIndex])
-					{
-						KISS_FFT_FREE(buf[ChannelIndex]);
-						KISS_FFT_FREE(out[ChannelIndex]);
-					}
-				}
+			for (int32 ChannelIndex = 0; ChannelIndex < NumChannels; ++ChannelIndex)
+			{
+				ChannelSum += SampleSum[ChannelIndex];
 			}
+
+			OutAmplitudes[0][AmplitudeIndex] = ChannelSum / (float)(SamplesToRead * NumChannels);
 		}
 	}
 }
@@ -561,47 +1618,35 @@ void USoundVisualization::Old_GetAmplitude(USoundWave* SoundWave, const bool bSp
 				uint32 FirstSample = *WaveInfo.pSamplesPerSec * StartTime;
 				uint32 LastSample = *WaveInfo.pSamplesPerSec * (StartTime + TimeLength);
 
-				if (NumChannels <= 2)
-				{
-					SampleCount = WaveInfo.SampleDataSize / (2 * NumChannels);
-				}
+				SampleCount = WaveInfo.SampleDataSize / (2 * NumChannels);
 
 				FirstSample = FMath::Min(SampleCount, FirstSample);
 				LastSample = FMath::Min(SampleCount, LastSample);
 
+				// FirstSample counts frames, the samples are interleaved
 				int16* SamplePtr = reinterpret_cast<int16*>(WaveInfo.SampleDataStart);
-				if (NumChannels <= 2)
-				{
-					SamplePtr += FirstSample;
-				}
+				SamplePtr += FirstSample * NumChannels;
 
-				uint32 SamplesPerAmplitude = (LastSample - FirstSample) / AmplitudeBuckets;
-				uint32 ExcessSamples = (LastSample - FirstSample) % AmplitudeBuckets;
-
-				for (int32 AmplitudeIndex = 0; AmplitudeIndex < AmplitudeBuckets; ++AmplitudeIndex)
-				{
-					if (NumChannels <= 2)
-					{
-						int64 SampleSum[2] = { 0 };
-						uint32 SamplesToRead = SamplesPerAmplitude + (ExcessSamples-- > 0 ? 1 : 0);
-						for (uint32 SampleIndex = 0; SampleIndex < SamplesToRead; ++SampleIndex)
-						{
-							for (int32 ChannelIndex = 0; ChannelIndex < NumChannels; ++ChannelIndex)
-							{
-								SampleSum[ChannelIndex] += FMath::Abs(*SamplePtr);
-								SamplePtr++;
-							}
-						}
-						for (int32 ChannelIndex = 0; ChannelIndex < NumChannels; ++ChannelIndex)
-						{
-							OutAmplitudes[(bSplitChannels ? ChannelIndex : 0)][AmplitudeIndex] = SampleSum[ChannelIndex] / (float)SamplesToRead;
-						}
-					}
-				}
+				FillAmplitudeBuckets(SamplePtr, NumChannels, LastSample - FirstSample, bSplitChannels, AmplitudeBuckets, OutAmplitudes);
 			}
 
 			SoundWave->RawData.Unlock();
 		}
+		// Compressed songs have no raw data, use the decoded samples. Works as soon as the worker decoded past the window
+		else if (PCMSampleBuffer != NULL || StreamingPCM != NULL)
+		{
+			const int32 SampleCount = SoundWave->RawPCMDataSize / (2 * NumChannels);
+
+			const int32 FirstSample = FMath::Min(SampleCount, FMath::FloorToInt(SoundWave->SampleRate * StartTime));
+			const int32 LastSample = FMath::Min(SampleCount, FMath::FloorToInt(SoundWave->SampleRate * (StartTime + TimeLength)));
+
+			const int16* SamplePtr = LastSample > FirstSample ? GetSampleFrames(SoundWave, FirstSample, LastSample - FirstSample) : NULL;
+
+			if (SamplePtr != NULL)
+			{
+				FillAmplitudeBuckets(SamplePtr, NumChannels, LastSample - FirstSample, bSplitChannels, AmplitudeBuckets, OutAmplitudes);
+			}
+		}
 	}
 }
 
@@ -644,15 +1689,63 @@ void USoundVisualization::SV_Old_CalculateFrequencySpectrum(USoundWave* SoundWav
 	}
 }
 
-void USoundVisualization::SV_New_CalculateFrequencySpectrum(USoundWave* _SoundWave, const float _StartTime, const float _Duration, TArray<float>& _OutFrequencies)
+void USoundVisualization::SV_New_CalculateFrequencySpectrum(USoundWave* _SoundWave, const float _StartTime, const float _Duration, TArray<float>& _OutFrequencies)
+{
+	_OutFrequencies.Reset();
+
+	if (_SoundWave)
+	{
+		New_CalculateFrequencySpectrum(_SoundWave, _StartTime, _Duration, _OutFrequencies);
+	}
+
+}
+
+void USoundVisualization::SV_CalculateFrequencySpectrumBatch(USoundWave* _SoundWave, const TArray<float>& _StartTimes, const float _Duration, const ESoundVisBatchOutput _Output, const ESoundVisBandLayout _Layout, const ESoundVisFilterShape _Shape, const int32 _NumMelBands, TArray<float>& _OutValues, int32& _RowLength)
+{
+	_OutValues.Reset();
+	_RowLength = 0;
+
+	if (_SoundWave)
+	{
+		_RowLength = New_CalculateFrequencySpectrumBatch(_SoundWave, _StartTimes, _Duration, _Output, _Layout, _Shape, _NumMelBands, _OutValues);
+	}
+}
+
+void USoundVisualization::SV_New_CalculateChannelFrequencySpectrum(USoundWave* _SoundWave, int32 _Channel, const float _StartTime, const float _Duration, TArray<float>& _OutFrequencies)
+{
+	_OutFrequencies.Reset();
+
+	if (_SoundWave)
+	{
+		if (_Channel == 0)
+		{
+			New_CalculateFrequencySpectrum(_SoundWave, _StartTime, _Duration, _OutFrequencies);
+		}
+		else if (_Channel > 0 && _Channel <= _SoundWave->NumChannels)
+		{
+			New_CalculateChannelSpectrum(_SoundWave, _Channel - 1, _StartTime, _Duration, _OutFrequencies);
+		}
+	}
+}
+
+void USoundVisualization::SV_CalculateBandEnergies(USoundWave* _SoundWave, const float _StartTime, const float _Duration, const ESoundVisBandLayout _Layout, const ESoundVisFilterShape _Shape, const int32 _NumMelBands, TArray<float>& _OutBandEnergies)
 {
-	_OutFrequencies.Empty();
+	_OutBandEnergies.Reset();
 
 	if (_SoundWave)
 	{
-		New_CalculateFrequencySpectrum(_SoundWave, _StartTime, _Duration, _OutFrequencies);
+		New_CalculateBandEnergies(_SoundWave, _StartTime, _Duration, _Layout, _Shape, _NumMelBands, _OutBandEnergies);
 	}
+}
+
+void USoundVisualization::SV_GetBandCenterFrequencies(USoundWave* _SoundWave, const ESoundVisBandLayout _Layout, const int32 _NumMelBands, TArray<float>& _OutCenterFrequencies)
+{
+	_OutCenterFrequencies.Reset();
 
+	if (_SoundWave)
+	{
+		FSoundVisFilterbank::GetCenterFrequencies(_SoundWave->SampleRate, _Layout, _NumMelBands, _OutCenterFrequencies);
+	}
 }
 
 void USoundVisualization::SV_Old_GetAmplitude(USoundWave* SoundWave, int32 Channel, float StartTime, float TimeLength, int32 AmplitudeBuckets, TArray<float>& OutAmplitudes)
@@ -680,275 +1773,407 @@ void USoundVisualization::SV_Old_GetAmplitude(USoundWave* SoundWave, int32 Chann
 }
 
 
-/// NOT WORKING! DON'T TOUCH!  ///
+/// Multithreading Functions (Check Ramas Wiki Entry if you don't understand that stuff :X) ///
 
-float Energie(int16* _Data, int32 _Offset, int32 _Window, int32 _SongLength)
-{
-	float Energy = 0.f;
+const int32 FAudioDecompressWorker::DecodeChunkFrames;
+
+const uint32 FAudioDecompressWorker::FinishWaitMs;
+
+const float FAudioDecompressWorker::ProgressStep = 0.05f;
 
-	for (int32 i = _Offset; (i < _Offset + _Window) && (i < _SongLength); i++)
+FAudioDecompressWorker::FAudioDecompressWorker(USoundWave* _InWave, uint8* _PCMBuffer, float _StartTime, float _Duration, ESoundVisDecodePriority _Priority)
+	: PCMOutBuffer(_PCMBuffer)
+	, bIsFinished(false)
+	, bCancelRequested(false)
+	, CurrentTime(_StartTime)
+	, DecompressDuration(_Duration)
+	, Wave(_InWave)
+	, AudioInfo(NULL)
+	, SourceData(NULL)
+	, SourceSize(0)
+	, bHeaderRead(false)
+	, Priority(_Priority)
+	, DoneEvent(FPlatformProcess::GetSynchEventFromPool(true))
+	, bStarted(false)
+	, bSucceeded(false)
+{
+	if (GEngine && GEngine->GetMainAudioDevice())
 	{
-		Energy = Energy + _Data[i] * _Data[i] / _Window;
+		AudioInfo = GEngine->GetMainAudioDevice()->CreateCompressedAudioInfo(Wave);
 	}
-
-	return Energy;
 }
-/*
-void USoundVisualization::GetBPMOfSong(USoundWave* _SoundWave, int32 &BMPOfSong)
+
+FAudioDecompressWorker::~FAudioDecompressWorker()
 {
-	// Start: Setup Values
-	int32 SongLength = _SoundWave->RawPCMDataSize / (2 * _SoundWave->NumChannels);;
+	Cancel();
+	EnsureCompletion();
 
-	float* Energy1024 = new float[SongLength / 1024];
-	float* Energy44100 = new float[SongLength / 1024];
-	float* Conv = new float[SongLength / 1024];
-	float* Beat = new float[SongLength / 1024];
-	float* Energie_Peak = new float[SongLength / 1024 + 21];
-	for (int32 i = 0; i < SongLength / 1024 + 21; i++)
-		Energie_Peak[i] = 0;
+	FPlatformProcess::ReturnSynchEventToPool(DoneEvent);
+	DoneEvent = NULL;
 
-	if (PCMSampleBuffer == NULL)
-		return;
+	delete AudioInfo;
+	AudioInfo = NULL;
+}
+
+void FAudioDecompressWorker::SetSource(const uint8* _Data, uint32 _DataSize, ICompressedAudioInfo* _OpenedAudioInfo)
+{
+	check(!bStarted);
 
-	int16* SamplePtr = reinterpret_cast<int16*>(PCMSampleBuffer);
-	// End: Setup Values
+	SourceData = _Data;
+	SourceSize = _DataSize;
 
-	for (int32 i = 0; i < SongLength / 1024; i++)
+	if (_OpenedAudioInfo)
 	{
-		Energy1024[i] = Energie(SamplePtr, i * 1024, 4096, SongLength);
-	}
+		delete AudioInfo;
 
-	////
+		AudioInfo = _OpenedAudioInfo;
+		bHeaderRead = true;
+	}
+}
 
-	Energy44100[0] = 0;
+void FAudioDecompressWorker::Start()
+{
+	check(!bStarted);
 
-	float Sum = 0.f;
+	bStarted = true;
 
-	for (int32 i = 0; i < 43; i++)
+	if (FPlatformProcess::SupportsMultithreading())
 	{
-		Sum += Energy1024[i];
+		FSoundVisDecoderPool::Get().AddJob(this);
 	}
-
-	Energy44100[0] = Sum / 43;
-
-	for (int32 i = 1; i < SongLength / 1024; i++)
+	else
 	{
-		Sum = Sum - Energy1024[i - 1] + Energy1024[i + 42];
-		Energy44100[i] = Sum / 43;
+		DoWork();
 	}
+}
 
-	////
+void FAudioDecompressWorker::DoWork()
+{
+	DecodedFrames.Set(0);
 
-	for (int32 i = 21; i < SongLength / 1024; i++)
+	if (!SourceData && Wave)
 	{
-		if (Energy1024[i] > 1.3 * Energy44100[i - 21])
-		{
-			Energie_Peak[i] = 1;
-		}
+		SourceData = Wave->ResourceData;
+		SourceSize = Wave->ResourceSize;
 	}
 
-	///
+	if (!Wave || !AudioInfo || !SourceData)
+	{
+		MarkFinished();
 
-	TArray<int32> T;
-	int32 I_Prec = 0;
+		return;
+	}
 
-	for (int32 i = 1; i < SongLength / 1024; i++)
+	// Parse the audio header for the relevant information, unless the loader already did
+	if (!bHeaderRead)
 	{
-		if ((Energie_Peak[i] == 1) && (Energie_Peak[i - 1] == 0))
+		FSoundQualityInfo QualityInfo = { 0 };
+
+		if (AudioInfo->ReadCompressedInfo(SourceData, SourceSize, &QualityInfo))
 		{
-			int32 Di = i - I_Prec;
-			if (Di > 5)
+			// Extract the data
+			Wave->SampleRate = QualityInfo.SampleRate;
+			Wave->NumChannels = QualityInfo.NumChannels;
+
+			if (QualityInfo.Duration > 0.0f)
 			{
-				T.Add(Di);
-				I_Prec = i;
+				Wave->Duration = QualityInfo.Duration;
 			}
+
+			bHeaderRead = true;
+		}
+		else if (Wave->DecompressionType == DTYPE_RealTime || Wave->DecompressionType == DTYPE_Native)
+		{
+			Wave->RemoveAudioResource();
 		}
 	}
 
-	int32 T_Occ_Max = 0;
-	float T_Occ_Moy = 0.f;
+	if (bHeaderRead)
+	{
+		FScopeCycleCounterUObject WaveObject(Wave);
+
+		const int32 NumFrames = DecompressDuration * Wave->SampleRate;
+		const int32 FrameBytes = Wave->NumChannels * 2;
 
-	int32 Occurences_T[86];
+		AudioInfo->SeekToTime(CurrentTime);
 
-	for (int32 i = 0; i < 86; i++)
-		Occurences_T[i] = 0;
+		float ReportedProgress = 0.0f;
 
-	for (int32 i = 1; i < T.Num(); i++)
-	{
-		if (T[i] <= 86)
+		int32 Frame = 0;
+
+		// Decode in chunks and publish every finished one, so the analysis can start on the first chunk
+		while (Frame < NumFrames && !bCancelRequested)
 		{
-			Occurences_T[T[i]]++;
+			const int32 ChunkFrames = FMath::Min(DecodeChunkFrames, NumFrames - Frame);
+
+			const bool bReachedEnd = AudioInfo->ReadCompressedData(PCMOutBuffer + Frame * FrameBytes, false, ChunkFrames * FrameBytes);
+
+			Frame += ChunkFrames;
+
+			// The decoder only filled this chunk with silence, do the same for the rest
+			if (bReachedEnd)
+			{
+				FMemory::Memzero(PCMOutBuffer + Frame * FrameBytes, (NumFrames - Frame) * FrameBytes);
+
+				Frame = NumFrames;
+			}
+
+			// Set is a full barrier, so the samples are visible before the new watermark
+			DecodedFrames.Set(Frame);
+
+			const float Progress = (float)Frame / NumFrames;
+
+			if (Callbacks.OnProgress && (Progress - ReportedProgress >= ProgressStep || Frame == NumFrames))
+			{
+				ReportedProgress = Progress;
+
+				// The job might be deleted before the game thread gets to it, so the task gets its own copy of the callback
+				TFunction<void(float)> OnProgress = Callbacks.OnProgress;
+
+				AsyncTask(ENamedThreads::GameThread, [OnProgress, Progress]()
+				{
+					OnProgress(Progress);
+				});
+			}
 		}
+
+		// What got decoded decides, a cancel that comes in after the last chunk doesn't make the job fail
+		bSucceeded = NumFrames > 0 && Frame == NumFrames;
 	}
 
-	int Occ_Max = 0;
+	MarkFinished();
+}
 
-	for (int32 i = 1; i < 86; i++)
+void FAudioDecompressWorker::MarkFinished()
+{
+	// Before the event, the owner may delete the job as soon as it's triggered
+	if (Callbacks.OnFinished)
 	{
-		if (Occurences_T[i] > Occ_Max)
+		TFunction<void(bool)> OnFinished = Callbacks.OnFinished;
+		const bool bSuccess = bSucceeded;
+
+		AsyncTask(ENamedThreads::GameThread, [OnFinished, bSuccess]()
 		{
-			T_Occ_Max = i;
-			Occ_Max = Occurences_T[i];
-		}
+			OnFinished(bSuccess);
+		});
 	}
 
-	int Voisin = T_Occ_Max - 1;
-	if (Occurences_T[T_Occ_Max + 1] > Occurences_T[Voisin])
-		Voisin = T_Occ_Max + 1;
+	// Polling readers may go on as soon as this is set, but only the owner frees the job, after waiting for the event
+	bIsFinished = true;
 
-	float Div = Occurences_T[T_Occ_Max] + Occurences_T[Voisin];
+	// Last thing the worker touches
+	DoneEvent->Trigger();
+}
 
-	if (Div == 0)
-		T_Occ_Moy = 0;
-	else
-		T_Occ_Moy = (float)(T_Occ_Max * Occurences_T[T_Occ_Max] + (Voisin)* Occurences_T[Voisin]) / Div;
+void FAudioDecompressWorker::Cancel()
+{
+	bCancelRequested = true;
+}
 
-	int32 Tempo = (int32) 60.f / (T_Occ_Moy* (1024.f / 44100.f));
+void FAudioDecompressWorker::EnsureCompletion()
+{
+	// No shortcut on bIsFinished: it is set before the event gets triggered, and the caller may free the event right after this
+	if (!bStarted)
+	{
+		return;
+	}
 
-	GEngine->AddOnScreenDebugMessage(-1, 100.f, FColor::Red, FString::FromInt(Tempo));
+	// Nobody started it yet, so nobody has to be waited for
+	if (FSoundVisDecoderPool::Get().RetractJob(this))
+	{
+		MarkFinished();
+	}
 
-	BMPOfSong = Tempo;
+	DoneEvent->Wait();
 }
-*/
 
 
-/// Multithreading Functions (Check Ramas Wiki Entry if you don't understand that stuff :X) ///
+/// Blueprint Versions of the Envelope Functions ///
 
-FAudioDecompressWorker* FAudioDecompressWorker::Runnable = NULL;
+bool USoundVisualization::SV_StartEnvelopeBuild(USoundWave* _SoundWave)
+{
+	return StartEnvelopeBuild(_SoundWave);
+}
 
-FAudioDecompressWorker::FAudioDecompressWorker(USoundWave* _InWave, uint8* _PCMBuffer, float _StartTime, float _Duration)
-	: Wave(_InWave)
-	, CurrentTime(_StartTime)
-	, DecompressDuration(_Duration)
-	, PCMOutBuffer(_PCMBuffer)
-	, AudioInfo(NULL)
+bool USoundVisualization::SV_IsEnvelopeReady() const
 {
-	if (GEngine && GEngine->GetMainAudioDevice())
+	return Envelope.IsReady();
+}
+
+void USoundVisualization::SV_GetEnvelope(USoundWave* _SoundWave, int32 _Channel, float _StartTime, float _TimeLength, int32 _Buckets, TArray<float>& _OutMin, TArray<float>& _OutMax, TArray<float>& _OutRMS)
+{
+	_OutMin.Reset();
+	_OutMax.Reset();
+	_OutRMS.Reset();
+
+	if (!_SoundWave || _SoundWave != EnvelopeWave || !Envelope.IsReady() || _Buckets <= 0 || _Channel < 0 || _Channel > Envelope.GetNumChannels())
 	{
-		AudioInfo = GEngine->GetMainAudioDevice()->CreateCompressedAudioInfo(Wave);
+		return;
 	}
 
-	Thread = FRunnableThread::Create(this, TEXT("FAudioDecompressWorker"), 0, TPri_BelowNormal); //windows default = 8mb for thread, could specify more
+	const int32 SampleRate = Envelope.GetSampleRate();
+
+	const int32 FirstFrame = FMath::FloorToInt(_StartTime * SampleRate);
+	const int32 NumFrames = FMath::Max(1, FMath::FloorToInt(_TimeLength * SampleRate));
+
+	_OutMin.AddUninitialized(_Buckets);
+	_OutMax.AddUninitialized(_Buckets);
+	_OutRMS.AddUninitialized(_Buckets);
+
+	// Channel 0 combines them, the envelope counts from 0
+	Envelope.GetBuckets(FirstFrame, NumFrames, _Buckets, _Channel == 0 ? INDEX_NONE : _Channel - 1, _OutMin.GetData(), _OutMax.GetData(), _OutRMS.GetData());
 }
 
-FAudioDecompressWorker::~FAudioDecompressWorker()
+
+/// Blueprint Versions of the Beat Functions ///
+
+bool USoundVisualization::SV_StartBeatDetection(USoundWave* _SoundWave)
 {
-	delete Thread;
-	Thread = NULL;
+	return StartBeatDetection(_SoundWave);
 }
 
-bool FAudioDecompressWorker::Init()
+bool USoundVisualization::SV_IsBeatGridReady() const
 {
-	return true;
+	return BeatGrid.IsReady();
 }
 
-uint32 FAudioDecompressWorker::Run()
+void USoundVisualization::SV_GetTempo(USoundWave* _SoundWave, float& _BPM, float& _Confidence)
 {
-	FPlatformProcess::Sleep(0.03);
+	_BPM = 0.0f;
+	_Confidence = 0.0f;
 
-	bIsFinished = false;
-
-	if (!Wave)
+	if (_SoundWave && _SoundWave == SpectrogramWave && BeatGrid.IsReady())
 	{
-		bIsFinished = true;
+		_BPM = BeatGrid.GetTempo();
+		_Confidence = BeatGrid.GetTempoConfidence();
+	}
+}
 
-		return 0;
+bool USoundVisualization::SV_GetNextBeat(USoundWave* _SoundWave, float _Time, float& _BeatTime, float& _Confidence, int32& _BeatIndex)
+{
+	_BeatTime = 0.0f;
+	_Confidence = 0.0f;
+	_BeatIndex = INDEX_NONE;
+
+	if (!_SoundWave || _SoundWave != SpectrogramWave || !BeatGrid.IsReady())
+	{
+		return false;
 	}
 
-	if (AudioInfo != NULL)
+	_BeatIndex = BeatGrid.FindNextBeat(_Time);
+
+	if (_BeatIndex == INDEX_NONE)
 	{
-		FSoundQualityInfo QualityInfo = { 0 };
+		return false;
+	}
 
-		// Parse the audio header for the relevant information
-		if (!(Wave->ResourceData))
-		{
-			bIsFinished = true;
+	_BeatTime = BeatGrid.GetBeatTimes()[_BeatIndex];
+	_Confidence = BeatGrid.GetBeatConfidences()[_BeatIndex];
 
-			return 0;
-		}
+	return true;
+}
 
-		if (AudioInfo->ReadCompressedInfo(Wave->ResourceData, Wave->ResourceSize, &QualityInfo))
-		{
-			FScopeCycleCounterUObject WaveObject(Wave);
+void USoundVisualization::SV_GetBeatGrid(USoundWave* _SoundWave, TArray<float>& _BeatTimes, TArray<float>& _Confidences)
+{
+	_BeatTimes.Reset();
+	_Confidences.Reset();
 
-			// Extract the data
-			Wave->SampleRate = QualityInfo.SampleRate;
-			Wave->NumChannels = QualityInfo.NumChannels;
+	if (_SoundWave && _SoundWave == SpectrogramWave && BeatGrid.IsReady())
+	{
+		_BeatTimes = BeatGrid.GetBeatTimes();
+		_Confidences = BeatGrid.GetBeatConfidences();
+	}
+}
 
-			if (QualityInfo.Duration > 0.0f)
-			{
-				Wave->Duration = QualityInfo.Duration;
-			}
+void USoundVisualization::SV_GetOnsetsInRange(USoundWave* _SoundWave, float _StartTime, float _EndTime, TArray<float>& _OnsetTimes)
+{
+	_OnsetTimes.Reset();
 
-			const uint32 PCMBufferSize = DecompressDuration * Wave->SampleRate * Wave->NumChannels;
+	if (!_SoundWave || _SoundWave != SpectrogramWave || !BeatGrid.IsReady())
+	{
+		return;
+	}
 
-			AudioInfo->SeekToTime(CurrentTime);
-			AudioInfo->ReadCompressedData(PCMOutBuffer, false, PCMBufferSize * 2);
-		}
-		else if (Wave->DecompressionType == DTYPE_RealTime || Wave->DecompressionType == DTYPE_Native)
-		{
-			Wave->RemoveAudioResource();
-		}
+	const TArray<float>& OnsetTimes = BeatGrid.GetOnsetTimes();
 
-		delete AudioInfo;
+	const int32 FirstOnset = BeatGrid.FindNextOnset(_StartTime);
+
+	if (FirstOnset == INDEX_NONE)
+	{
+		return;
 	}
 
-	bIsFinished = true;
+	for (int32 OnsetIndex = FirstOnset; OnsetIndex < OnsetTimes.Num() && OnsetTimes[OnsetIndex] <= _EndTime; ++OnsetIndex)
+	{
+		_OnsetTimes.Add(OnsetTimes[OnsetIndex]);
+	}
+}
+
 
-	return 0;
+/// Blueprint Versions of the Live Functions ///
+
+bool USoundVisualization::SV_PlayWithLiveAnalysis(UAudioComponent* _AudioComponent, USoundWave* _SoundWave, float _StartTime)
+{
+	return StartLiveAnalysis(_AudioComponent, _SoundWave, _StartTime);
 }
 
-void FAudioDecompressWorker::Stop()
+void USoundVisualization::SV_StopLiveAnalysis()
 {
-	StopTaskCounter.Increment();
+	StopLiveAnalysis();
 }
 
-FAudioDecompressWorker* FAudioDecompressWorker::Initialize(USoundWave* _InWave, uint8* _PCMBuffer, float _StartTime, float _Duration)
+bool USoundVisualization::SV_GetLiveFrequencySpectrum(TArray<float>& _OutFrequencies, float& _Time)
 {
-	if (!Runnable && FPlatformProcess::SupportsMultithreading())
+	_OutFrequencies.Reset();
+	_Time = 0.0f;
+
+	if (!LiveAnalyzer || !LiveAnalyzer->GetSpectrum(_OutFrequencies, _Time))
 	{
-		Runnable = new FAudioDecompressWorker(_InWave, _PCMBuffer, _StartTime, _Duration);
+		return false;
 	}
 
-	return Runnable;
+	// The analysis thread only keeps magnitudes
+	SoundVisKernels::ConvertMagnitudes(_OutFrequencies.GetData(), _OutFrequencies.Num(), SpectrumOutput, _OutFrequencies.GetData());
+
+	return true;
 }
 
-void FAudioDecompressWorker::EnsureCompletion()
+float USoundVisualization::SV_GetLivePlaybackTime() const
 {
-	Stop();
-	Thread->WaitForCompletion();
+	return LiveAnalyzer ? LiveAnalyzer->GetPlaybackTime() : 0.0f;
 }
 
-void FAudioDecompressWorker::Shutdown()
+
+/// Blueprint Versions of the Spectrogram Functions ///
+
+bool USoundVisualization::SV_StartSpectrogramPrecompute(USoundWave* _SoundWave)
 {
-	if (Runnable)
-	{
-		Runnable->EnsureCompletion();
-		delete Runnable;
-		Runnable = NULL;
-	}
+	return StartSpectrogramPrecompute(_SoundWave);
 }
 
-bool FAudioDecompressWorker::IsThreadFinished()
+bool USoundVisualization::SV_IsSpectrogramReady() const
 {
-	if (Runnable)
-	{
-		return Runnable->IsFinished();
-	}
-
-	return true;
+	return Spectrogram.IsReady();
 }
 
-void FAudioDecompressWorker::Exit()
+void USoundVisualization::SV_GetPrecomputedBandEnergies(USoundWave* _SoundWave, float _Time, TArray<float>& _OutBandEnergies, float& _RMS)
 {
-	Thread->Kill();
+	_OutBandEnergies.Reset();
+	_RMS = 0.0f;
+
+	if (_SoundWave && _SoundWave == SpectrogramWave && Spectrogram.IsReady())
+	{
+		_OutBandEnergies.AddUninitialized(FSoundVisSpectrogram::NumBands);
+
+		Spectrogram.GetBandEnergiesAtTime(_Time, _OutBandEnergies.GetData(), _RMS);
+	}
 }
 
 
 /// Frequency Data Functions ///
 
 // Function to return the most commen frequencies
-void USoundVisualization::SV_GetFrequencyValues(USoundWave* _SoundWave, TArray<float> _Frequencies, float& F16, float& F32, float& F64, float& F128, float& F256, float& F512, float& F1000, float& F2000, float& F4000, float& F8000, float& F16000)
+void USoundVisualization::SV_GetFrequencyValues(USoundWave* _SoundWave, const TArray<float>& _Frequencies, float& F16, float& F32, float& F64, float& F128, float& F256, float& F512, float& F1000, float& F2000, float& F4000, float& F8000, float& F16000)
 {
 	if (_SoundWave && _Frequencies.Num() > 0)
 	{
@@ -980,8 +2205,47 @@ void USoundVisualization::SV_GetFrequencyValues(USoundWave* _SoundWave, TArray<f
 	}
 }
 
+void USoundVisualization::SV_CalculateFrequencyValues(USoundWave* _SoundWave, const float _StartTime, const float _Duration, float& F16, float& F32, float& F64, float& F128, float& F256, float& F512, float& F1000, float& F2000, float& F4000, float& F8000, float& F16000)
+{
+	static const int32 Frequencies[11] = { 16, 32, 64, 128, 256, 512, 1000, 2000, 4000, 8000, 16000 };
+
+	float Values[11] = { 0.0f };
+
+	if (_SoundWave && !New_CalculateFrequencyValues(_SoundWave, _StartTime, _Duration, Frequencies, 11, Values))
+	{
+		FMemory::Memzero(Values, sizeof(Values));
+	}
+
+	F16 = Values[0];
+	F32 = Values[1];
+	F64 = Values[2];
+	F128 = Values[3];
+	F256 = Values[4];
+	F512 = Values[5];
+	F1000 = Values[6];
+	F2000 = Values[7];
+	F4000 = Values[8];
+	F8000 = Values[9];
+	F16000 = Values[10];
+}
+
+void USoundVisualization::SV_CalculateSpecificFrequencyValues(USoundWave* _SoundWave, const float _StartTime, const float _Duration, const TArray<int32>& _WantedFrequencies, TArray<float>& _OutValues)
+{
+	_OutValues.Reset();
+
+	if (_SoundWave && _WantedFrequencies.Num() > 0)
+	{
+		_OutValues.AddUninitialized(_WantedFrequencies.Num());
+
+		if (!New_CalculateFrequencyValues(_SoundWave, _StartTime, _Duration, _WantedFrequencies.GetData(), _WantedFrequencies.Num(), _OutValues.GetData()))
+		{
+			_OutValues.Reset();
+		}
+	}
+}
+
 // Function to get the nearly exact value of a given frequency
-void USoundVisualization::SV_GetSpecificFrequencyValue(USoundWave* _SoundWave, TArray<float> _Frequencies, int32 _WantedFrequency, float& _FrequencyValue)
+void USoundVisualization::SV_GetSpecificFrequencyValue(USoundWave* _SoundWave, const TArray<float>& _Frequencies, int32 _WantedFrequency, float& _FrequencyValue)
 {
 	if (_SoundWave && _Frequencies.Num() > 0)
 	{
@@ -990,25 +2254,54 @@ void USoundVisualization::SV_GetSpecificFrequencyValue(USoundWave* _SoundWave, T
 }
 
 // Function to get the average value of the subbass frequencies
-void USoundVisualization::SV_GetAverageSubBassValue(USoundWave* _SoundWave, TArray<float> _Frequencies, float& _AverageSubBass)
+void USoundVisualization::SV_GetAverageSubBassValue(USoundWave* _SoundWave, const TArray<float>& _Frequencies, float& _AverageSubBass)
 {
-	SV_GetAverageFrequencyValueInRange(_SoundWave, _Frequencies, 20, 60, _AverageSubBass);
+	if (!_SoundWave)
+	{
+		_AverageSubBass = 0.0f;
+
+		return;
+	}
+
+	// Running sums instead of a loop over the bins, like SV_GetAverageFrequencyValuesInBands
+	BandQueryFrame.Build(_Frequencies.GetData(), _Frequencies.Num(), _SoundWave->SampleRate);
+
+	_AverageSubBass = BandQueryFrame.GetAverage(20, 60);
 }
 
 // Function to get the average value of the bass frequencies
-void USoundVisualization::SV_GetAverageBassValue(USoundWave* _SoundWave, TArray<float> _Frequencies, float& _AverageBass)
+void USoundVisualization::SV_GetAverageBassValue(USoundWave* _SoundWave, const TArray<float>& _Frequencies, float& _AverageBass)
 {
-	SV_GetAverageFrequencyValueInRange(_SoundWave, _Frequencies, 60, 250, _AverageBass);
+	if (!_SoundWave)
+	{
+		_AverageBass = 0.0f;
+
+		return;
+	}
+
+	// Running sums instead of a loop over the bins, like SV_GetAverageFrequencyValuesInBands
+	BandQueryFrame.Build(_Frequencies.GetData(), _Frequencies.Num(), _SoundWave->SampleRate);
+
+	_AverageBass = BandQueryFrame.GetAverage(60, 250);
 }
 
 // Function to calculate the average frequency value of a given interval
-void USoundVisualization::SV_GetAverageFrequencyValueInRange(USoundWave* _SoundWave, TArray<float> _Frequencies, int32 _StartFrequence, int32 _EndFrequence, float& _AverageFrequency)
+void USoundVisualization::SV_GetAverageFrequencyValueInRange(USoundWave* _SoundWave, const TArray<float>& _Frequencies, int32 _StartFrequence, int32 _EndFrequence, float& _AverageFrequency)
 {
 	if (_StartFrequence >= _EndFrequence || _StartFrequence < 20 || _EndFrequence > 22000)
 		return;
 
-	int32 FStart = (int32)(_StartFrequence  * _Frequencies.Num() * 2 / _SoundWave->SampleRate);
-	int32 FEnd = (int32)(_EndFrequence * _Frequencies.Num() * 2 / _SoundWave->SampleRate);
+	_AverageFrequency = 0.0f;
+
+	if (!_SoundWave || _SoundWave->SampleRate <= 0 || _Frequencies.Num() == 0)
+		return;
+
+	int32 FStart = FMath::Max((int32)(_StartFrequence  * _Frequencies.Num() * 2 / _SoundWave->SampleRate), 0);
+	int32 FEnd = FMath::Min((int32)(_EndFrequence * _Frequencies.Num() * 2 / _SoundWave->SampleRate), _Frequencies.Num() - 1);
+
+	// A range above a low sample rate's Nyquist frequency has no bins
+	if (FStart > FEnd)
+		return;
 
 	int32 NumberOfFrequencies = 0;
 
@@ -1023,3 +2316,80 @@ void USoundVisualization::SV_GetAverageFrequencyValueInRange(USoundWave* _SoundW
 
 	_AverageFrequency = ValueSum / NumberOfFrequencies;
 }
+
+// Function to calculate the average values of many frequency bands at once
+void USoundVisualization::SV_GetAverageFrequencyValuesInBands(USoundWave* _SoundWave, const TArray<float>& _Frequencies, const TArray<float>& _BandEdges, TArray<float>& _OutBandValues)
+{
+	_OutBandValues.Reset();
+
+	if (!_SoundWave || _Frequencies.Num() == 0 || _BandEdges.Num() < 2)
+		return;
+
+	// One pass over the spectrum, afterwards every band is two lookups
+	BandQueryFrame.Build(_Frequencies.GetData(), _Frequencies.Num(), _SoundWave->SampleRate);
+
+	_OutBandValues.AddUninitialized(_BandEdges.Num() - 1);
+
+	BandQueryFrame.GetBandAverages(_BandEdges.GetData(), _BandEdges.Num(), _OutBandValues.GetData());
+}
+
+// Function to prepare a spectrum for band queries
+void USoundVisualization::SV_MakeSpectrumFrame(USoundWave* _SoundWave, const TArray<float>& _Frequencies, FSoundVisSpectrumFrame& _OutFrame)
+{
+	_OutFrame.Build(_Frequencies.GetData(), _Frequencies.Num(), _SoundWave ? _SoundWave->SampleRate : 0);
+}
+
+// Function to get the average value of a frequency interval of a prepared spectrum
+void USoundVisualization::SV_GetSpectrumFrameAverage(const FSoundVisSpectrumFrame& _Frame, float _StartFrequency, float _EndFrequency, float& _AverageFrequency)
+{
+	_AverageFrequency = _Frame.GetAverage(_StartFrequency, _EndFrequency);
+}
+
+// Function to get the average values of many frequency bands of a prepared spectrum
+void USoundVisualization::SV_GetSpectrumFrameBandValues(const FSoundVisSpectrumFrame& _Frame, const TArray<float>& _BandEdges, TArray<float>& _OutBandValues)
+{
+	_OutBandValues.Reset();
+
+	if (_BandEdges.Num() < 2)
+		return;
+
+	_OutBandValues.AddUninitialized(_BandEdges.Num() - 1);
+
+	_Frame.GetBandAverages(_BandEdges.GetData(), _BandEdges.Num(), _OutBandValues.GetData());
+}
+
+
+/// Debug Functions ///
+
+void USoundVisualization::SV_GetLoadCopyCounts(float& _CopiedMB, float& _MappedMB, const bool _bResetCounters)
+{
+	_CopiedMB = NumLoadBytesCopied.GetValue() / (1024.0f * 1024.0f);
+	_MappedMB = NumLoadBytesMapped.GetValue() / (1024.0f * 1024.0f);
+
+	if (_bResetCounters)
+	{
+		NumLoadBytesCopied.Reset();
+		NumLoadBytesMapped.Reset();
+	}
+}
+
+void USoundVisualization::SV_GetFFTAllocationCounts(int32& _PlanAllocations, int32& _BufferAllocations, const bool _bResetCounters)
+{
+	_PlanAllocations = FSoundVisFFTContext::GetNumPlanAllocations();
+	_BufferAllocations = FSoundVisFFTContext::GetNumScratchAllocations();
+
+	if (_bResetCounters)
+	{
+		FSoundVisFFTContext::ResetAllocationCounters();
+	}
+}
+
+void USoundVisualization::SV_GetSlidingSpectrumCounts(int32& _ComputedFrames, const bool _bResetCounters)
+{
+	_ComputedFrames = FSoundVisSlidingSTFT::GetNumComputedFrames();
+
+	if (_bResetCounters)
+	{
+		FSoundVisSlidingSTFT::ResetComputedFrames();
+	}
+}
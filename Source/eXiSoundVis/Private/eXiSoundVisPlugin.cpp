@@ -1,5 +1,8 @@
 #include "eXiSoundVisPrivatePCH.h"
 #include "eXiSoundVisPlugin.h"
+#include "SoundVisDecoderPool.h"
+
+DEFINE_LOG_CATEGORY(LogSoundVisualization);
 
 void IeXiSoundVisPlugin::StartupModule()
 {
@@ -7,7 +10,8 @@ void IeXiSoundVisPlugin::StartupModule()
 }
 void IeXiSoundVisPlugin::ShutdownModule()
 {
-
+	// Stops the decoder threads
+	FSoundVisDecoderPool::Shutdown();
 }
 
 IMPLEMENT_MODULE(IeXiSoundVisPlugin, eXiSoundVis)
\ No newline at end of file
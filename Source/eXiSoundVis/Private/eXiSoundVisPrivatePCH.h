@@ -2,4 +2,9 @@
 #include "CoreUObject.h"
 #include "eXiSoundVisPlugin.h"
 #include "ThirdParty/Kiss_FFT/kiss_fft129/kiss_fft.h"
-#include "ThirdParty/Kiss_FFT/kiss_fft129/tools/kiss_fftnd.h"
\ No newline at end of file
+#include "ThirdParty/Kiss_FFT/kiss_fft129/tools/kiss_fftr.h"
+
+DECLARE_LOG_CATEGORY_EXTERN(LogSoundVisualization, Log, All);
+
+// "stat SoundVis" shows the timings of the analysis functions
+DECLARE_STATS_GROUP(TEXT("SoundVis"), STATGROUP_SoundVis, STATCAT_Advanced);
\ No newline at end of file
@@ -0,0 +1,204 @@
+// Copyright 1998-2015 Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "Runtime/Core/Public/Async/AsyncWork.h"
+
+#include "SoundVisTypes.h"
+
+class FSoundVisSpectrogram;
+class FSoundVisEnvelope;
+class FSoundVisCacheVerifyTask;
+
+// Identifies one analysis result: the raw file content plus the analysis settings
+struct FSoundVisCacheKey
+{
+	// SHA1 of the raw (compressed) file bytes
+	uint8 ContentHash[20];
+
+	// CRC of the analysis settings and the analysis version
+	uint32 ParamsHash;
+
+	FSoundVisCacheKey();
+
+	// Hashes the file content and the settings the spectrogram gets built with
+	static FSoundVisCacheKey Make(const uint8* _FileData, int64 _FileSize, float _WindowDuration, float _HopDuration, ESoundVisWindowType _WindowType, bool _bFixedPoint);
+
+	// Used as file name of the cache entry
+	FString ToString() const;
+};
+
+// The SoundWave info FillSoundWaveInfo would read from the Vorbis header
+struct FSoundVisCacheMetadata
+{
+	int32 NumChannels;
+	int32 SampleRate;
+	float Duration;
+	int32 RawPCMDataSize;
+
+	FSoundVisCacheMetadata();
+};
+
+/**
+	Read-only view of a whole file. Memory mapped on Windows and POSIX platforms,
+	everywhere else the file is read into memory once.
+*/
+class FSoundVisMappedFile : public FNoncopyable
+{
+
+public:
+
+	FSoundVisMappedFile();
+	~FSoundVisMappedFile();
+
+	bool Open(const FString& _FilePath);
+	void Close();
+
+	const uint8* GetData() const
+	{
+		return Data;
+	}
+
+	int64 GetSize() const
+	{
+		return Size;
+	}
+
+	// False if the platform couldn't map it and the file was read into memory instead
+	bool IsMapped() const
+	{
+		return MappingHandle != NULL;
+	}
+
+private:
+
+	const uint8* Data;
+	int64 Size;
+
+	// Platform handles of the mapping
+	void* FileHandle;
+	void* MappingHandle;
+
+	// Only used if the platform can't map files
+	TArray<uint8> FallbackData;
+};
+
+/**
+	Persistent per-song analysis results in <Saved>/SoundVisCache, one file per FSoundVisCacheKey.
+	The file is a small header followed by the spectrogram frames, the RMS envelope, the
+	band energies and the flux, each block 16 byte aligned, so a mapped file can be used without copying.
+	Entries written with bBuildEnvelope also hold level 0 of the waveform envelope, the levels above are merged again on load.
+	Entries from another version, with other settings, or with a wrong size or checksum are
+	treated as missing and get rebuilt.
+	Every block has its own checksum. Open() only checks the small float blocks and the envelope, the frames
+	get checked by a background task: any byte is a valid level, so until then a damaged
+	entry only shows wrong levels. A damaged entry gets deleted when it is closed.
+*/
+class FSoundVisAnalysisCache : public FNoncopyable
+{
+
+public:
+
+	// "SVAC" and the version of the file layout. Bump the version whenever the layout or the analysis changes
+	static const uint32 FileMagic = 0x43415653;
+	static const uint32 FileVersion = 4;
+
+	FSoundVisAnalysisCache();
+	~FSoundVisAnalysisCache();
+
+	static FString GetCacheDirectory();
+	static FString GetCacheFilePath(const FSoundVisCacheKey& _Key);
+
+	// Maps the entry of _Key and validates it. Missing, stale or corrupt entries return false, broken files get deleted.
+	// Starts checking the frames in the background
+	bool Open(const FSoundVisCacheKey& _Key);
+
+	// Waits for the frame check, deletes the file if it failed
+	void Close();
+
+	bool IsOpen() const
+	{
+		return bIsOpen;
+	}
+
+	const FSoundVisCacheMetadata& GetMetadata() const
+	{
+		return Metadata;
+	}
+
+	// Points the spectrogram at the mapped data. Only valid until Close()
+	void InitSpectrogram(FSoundVisSpectrogram& _Spectrogram) const;
+
+	// False if the entry was written without an envelope
+	bool HasEnvelope() const
+	{
+		return EnvelopeFrames > 0;
+	}
+
+	// Copies the stored envelope into _Envelope, which stays valid after Close()
+	void InitEnvelope(FSoundVisEnvelope& _Envelope) const;
+
+	// Writes a finished spectrogram with frames, and the envelope if one is given, as the entry of _Key. Goes through a temp file,
+	// so readers never see half a file. The blocks are written straight from the spectrogram and the envelope, nothing gets copied
+	static bool Write(const FSoundVisCacheKey& _Key, const FSoundVisCacheMetadata& _Metadata, const FSoundVisSpectrogram& _Spectrogram, const FSoundVisEnvelope* _Envelope = NULL);
+
+private:
+
+	friend class FSoundVisCacheVerifyTask;
+
+	// Compares the CRC of the frames with the header in pieces, so Close() doesn't have to wait long. Runs on the verify task
+	void VerifyFrames();
+
+	FSoundVisMappedFile File;
+
+	FString FilePath;
+
+	bool bIsOpen;
+
+	FAsyncTask<FSoundVisCacheVerifyTask>* VerifyTask;
+
+	FThreadSafeBool bCancelVerify;
+	FThreadSafeBool bFramesDamaged;
+
+	FSoundVisCacheMetadata Metadata;
+
+	// Layout of the opened entry
+	int32 FFTSize;
+	int32 HopSize;
+	int32 NumFrames;
+	const uint8* Frames;
+	const float* FrameRMS;
+	const float* BandEnergies;
+	const float* Flux;
+	uint64 NumFrameBytes;
+	uint32 FramesCrc;
+
+	// Level 0 of the envelope, no envelope if EnvelopeFrames is 0
+	int32 EnvelopeFrames;
+	const int16* EnvelopeMin;
+	const int16* EnvelopeMax;
+	const float* EnvelopeSumSquares;
+};
+
+/**
+	Background task of FSoundVisAnalysisCache that checks the frames of the opened entry.
+*/
+class FSoundVisCacheVerifyTask : public FNonAbandonableTask
+{
+	friend class FAsyncTask<FSoundVisCacheVerifyTask>;
+
+public:
+
+	FSoundVisCacheVerifyTask(FSoundVisAnalysisCache* _Cache);
+
+	void DoWork();
+
+	FORCEINLINE TStatId GetStatId() const
+	{
+		RETURN_QUICK_DECLARE_CYCLE_STAT(FSoundVisCacheVerifyTask, STATGROUP_ThreadPoolAsyncTasks);
+	}
+
+private:
+
+	FSoundVisAnalysisCache* Cache;
+};
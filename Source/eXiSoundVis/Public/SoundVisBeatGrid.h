@@ -0,0 +1,133 @@
+// Copyright 1998-2015 Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "Runtime/Core/Public/Async/AsyncWork.h"
+
+class FSoundVisSpectrogram;
+
+/**
+	Onsets, tempo and beat grid of a whole song, derived from the frames of its spectrogram.
+	The onset strength is the log spectral flux with the local mean removed. The tempo is the strongest
+	autocorrelation lag of the onset strength, weighted towards 120 BPM. The beats are the path through
+	the onsets that best keeps that tempo (dynamic programming), so they stay on the grid through quiet parts.
+	Times are sorted, so all queries are binary searches.
+*/
+class FSoundVisBeatGrid : public FNoncopyable
+{
+
+public:
+
+	// Tempo range the autocorrelation searches
+	static const float MinTempo;
+	static const float MaxTempo;
+
+	FSoundVisBeatGrid();
+
+	// Computes onsets, tempo and beats of a ready spectrogram. Call IsReady() before reading
+	void Build(const FSoundVisSpectrogram& _Spectrogram);
+
+	// Makes a running or upcoming Build() return early. The beat grid stays not ready
+	void Cancel();
+
+	bool IsCancelRequested() const
+	{
+		return bCancelRequested;
+	}
+
+	// Frees the beats and clears a pending Cancel()
+	void Reset();
+
+	bool IsReady() const
+	{
+		return bIsReady;
+	}
+
+	// Beats per minute, and how periodic the onsets are at that tempo (0 to 1)
+	float GetTempo() const
+	{
+		return Tempo;
+	}
+
+	float GetTempoConfidence() const
+	{
+		return TempoConfidence;
+	}
+
+	int32 GetNumBeats() const
+	{
+		return BeatTimes.Num();
+	}
+
+	// Beat times in seconds, sorted, and how strong the onset on every beat is (0 to 1)
+	const TArray<float>& GetBeatTimes() const
+	{
+		return BeatTimes;
+	}
+
+	const TArray<float>& GetBeatConfidences() const
+	{
+		return BeatConfidences;
+	}
+
+	// Onset times in seconds, sorted
+	const TArray<float>& GetOnsetTimes() const
+	{
+		return OnsetTimes;
+	}
+
+	// Index of the first beat after _Time, INDEX_NONE if there is none
+	int32 FindNextBeat(float _Time) const;
+
+	// Index of the first onset after _Time, INDEX_NONE if there is none
+	int32 FindNextOnset(float _Time) const;
+
+private:
+
+	// Index of the first value in the sorted _Values that is greater than _Value
+	static int32 UpperBound(const TArray<float>& _Values, float _Value);
+
+	// Log spectral flux of every frame, with the local mean removed and scaled to a standard deviation of 1. False if cancelled
+	bool CalculateOnsetStrength(const FSoundVisSpectrogram& _Spectrogram, TArray<float>& _OutStrength);
+
+	// Beat period in frames (not rounded) from the autocorrelation of the onset strength
+	float EstimatePeriod(const TArray<float>& _Strength, float _SecondsPerFrame, float& _OutConfidence) const;
+
+	// Frames of the beats that best fit _Period. False if cancelled
+	bool TrackBeats(const TArray<float>& _Strength, float _Period, TArray<int32>& _OutBeatFrames) const;
+
+	float Tempo;
+	float TempoConfidence;
+
+	TArray<float> BeatTimes;
+	TArray<float> BeatConfidences;
+	TArray<float> OnsetTimes;
+
+	FThreadSafeBool bIsReady;
+	FThreadSafeBool bCancelRequested;
+};
+
+/**
+	Background task that builds the beat grid of a spectrogram that is already ready, e.g. one loaded from the analysis cache.
+	A spectrogram that still gets computed builds the beat grid in its own task right after (FSoundVisSpectrogramTask::SetBeatGrid).
+*/
+class FSoundVisBeatGridTask : public FNonAbandonableTask
+{
+	friend class FAsyncTask<FSoundVisBeatGridTask>;
+
+public:
+
+	FSoundVisBeatGridTask(FSoundVisBeatGrid* _BeatGrid, const FSoundVisSpectrogram* _Spectrogram);
+
+	void DoWork();
+
+	FORCEINLINE TStatId GetStatId() const
+	{
+		RETURN_QUICK_DECLARE_CYCLE_STAT(FSoundVisBeatGridTask, STATGROUP_ThreadPoolAsyncTasks);
+	}
+
+private:
+
+	FSoundVisBeatGrid* BeatGrid;
+	const FSoundVisSpectrogram* Spectrogram;
+};
@@ -0,0 +1,91 @@
+// Copyright 1998-2015 Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+class FAudioDecompressWorker;
+
+/**
+	Bounded set of threads that run the decode jobs of all SoundVisualization objects, so
+	several songs (e.g. a preview deck and the main deck) can be decoded at the same time.
+	Waiting jobs are picked by priority first and in the order they were added second.
+	The pool also keeps freed PCM buffers up to a byte limit, so switching tracks doesn't allocate a new song buffer every time.
+	Buffers that nobody picked up for a while are freed on the next track switch.
+*/
+class FSoundVisDecoderPool : public FNoncopyable
+{
+
+public:
+
+	// Upper limit of decoder threads, no matter how many cores there are
+	static const int32 MaxThreads = 4;
+
+	// Bytes of freed PCM buffers kept for reuse (about two 10 minute stereo songs at 44.1 kHz). If more come back, the oldest ones are freed
+	static const SIZE_T MaxPooledBytes = 256 * 1024 * 1024;
+
+	// Seconds a freed buffer may wait for reuse before AcquireBuffer frees it
+	static const double PooledBufferIdleSeconds;
+
+	// Creates the pool and its threads on first use
+	static FSoundVisDecoderPool& Get();
+
+	// Stops the threads. Jobs that are still waiting get finished without decoding. Called when the module shuts down
+	static void Shutdown();
+
+	// Queues a job. It has to stay alive until it is finished or retracted
+	void AddJob(FAudioDecompressWorker* _Job);
+
+	// Takes a job out of the queue if no thread picked it up yet
+	bool RetractJob(FAudioDecompressWorker* _Job);
+
+	int32 GetNumThreads() const
+	{
+		return Threads.Num();
+	}
+
+	// Returns the smallest pooled buffer of at least _MinBytes (and at most twice that), or a new one. _OutBytes is its real size
+	uint8* AcquireBuffer(SIZE_T _MinBytes, SIZE_T& _OutBytes);
+
+	// Gives a buffer from AcquireBuffer back. _Bytes is the size AcquireBuffer returned. Frees it if the pool is already shut down
+	static void ReleaseBuffer(uint8* _Buffer, SIZE_T _Bytes);
+
+	// Frees the pooled buffers that were released more than _MaxIdleSeconds ago, all of them with 0
+	static void TrimBuffers(double _MaxIdleSeconds);
+
+private:
+
+	class FDecoderThread;
+
+	FSoundVisDecoderPool();
+	~FSoundVisDecoderPool();
+
+	// Removes and returns the waiting job with the highest priority, NULL if there is none
+	FAudioDecompressWorker* PopJob();
+
+	FCriticalSection QueueLock;
+	TArray<FAudioDecompressWorker*> PendingJobs;
+
+	TArray<FDecoderThread*> Threads;
+
+	struct FPooledBuffer
+	{
+		uint8* Data;
+		SIZE_T Size;
+
+		// FPlatformTime::Seconds() of the release
+		double ReleaseTime;
+	};
+
+	// Frees buffers until they fit into MaxPooledBytes, the oldest first. BufferLock has to be held
+	void EnforceByteLimit();
+
+	FCriticalSection BufferLock;
+	TArray<FPooledBuffer> FreeBuffers;
+	SIZE_T PooledBytes;
+
+	// Wakes one idle thread. Whoever wakes up passes it on if there is more to do
+	FEvent* WakeUpEvent;
+
+	FThreadSafeBool bIsShuttingDown;
+
+	static FSoundVisDecoderPool* Instance;
+};
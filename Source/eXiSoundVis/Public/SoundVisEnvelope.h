@@ -0,0 +1,150 @@
+// Copyright 1998-2015 Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "Runtime/Core/Public/Async/AsyncWork.h"
+
+class FAudioDecompressWorker;
+
+/**
+	Min, max and RMS of a whole song at power of two block sizes, like the mip levels of a texture.
+	Level 0 has one entry per BaseBlockFrames frames and channel, every level above merges two blocks of the one below.
+	A waveform query picks the coarsest level whose blocks still fit into one bucket, so it reads
+	a few blocks per bucket no matter how far it is zoomed out.
+*/
+class FSoundVisEnvelope : public FNoncopyable
+{
+
+public:
+
+	// Frames per block of level 0. Level L has blocks of BaseBlockFrames << L frames
+	static const int32 BaseBlockShift = 6;
+	static const int32 BaseBlockFrames = 1 << BaseBlockShift;
+
+	FSoundVisEnvelope();
+
+	// Computes all levels of the interleaved int16 PCM. Level 0 is spread over the worker threads. Call IsReady() before reading
+	void Build(const int16* _PCM, int32 _NumChannels, int32 _NumFrames, int32 _SampleRate);
+
+	// Copies level 0, e.g. from an analysis cache entry, and computes the levels above. Ready right away
+	void InitFromBaseLevel(const int16* _Min, const int16* _Max, const float* _SumSquares, int32 _NumChannels, int32 _NumFrames, int32 _SampleRate);
+
+	// Makes a running or upcoming Build() return early. The envelope stays not ready
+	void Cancel();
+
+	bool IsCancelRequested() const
+	{
+		return bCancelRequested;
+	}
+
+	// Frees the levels and clears a pending Cancel()
+	void Reset();
+
+	bool IsReady() const
+	{
+		return bIsReady;
+	}
+
+	int32 GetNumChannels() const
+	{
+		return NumChannels;
+	}
+
+	int32 GetNumFrames() const
+	{
+		return NumFrames;
+	}
+
+	int32 GetSampleRate() const
+	{
+		return SampleRate;
+	}
+
+	int32 GetNumLevels() const
+	{
+		return Levels.Num();
+	}
+
+	// Level 0 as InitFromBaseLevel takes it, GetNumBaseBlocks() values per channel, one channel after the other. Only when ready
+	int32 GetNumBaseBlocks() const
+	{
+		return Levels[0].NumBlocks;
+	}
+
+	const int16* GetBaseMin() const
+	{
+		return Levels[0].Min.GetData();
+	}
+
+	const int16* GetBaseMax() const
+	{
+		return Levels[0].Max.GetData();
+	}
+
+	const float* GetBaseSumSquares() const
+	{
+		return Levels[0].SumSquares.GetData();
+	}
+
+	/**
+		Writes min, max and RMS (-1 to 1) of _NumBuckets equally long parts of the frames [_FirstFrame, _FirstFrame + _NumFrames).
+		_Channel INDEX_NONE combines all channels. Buckets are widened to whole blocks, buckets outside of the song are 0
+	*/
+	void GetBuckets(int32 _FirstFrame, int32 _NumFrames, int32 _NumBuckets, int32 _Channel, float* _OutMin, float* _OutMax, float* _OutRMS) const;
+
+private:
+
+	// Merges the last level into the ones above it until one block is left
+	void BuildUpperLevels();
+
+	// All values are stored channel-major: [Channel * NumBlocks + Block]
+	struct FLevel
+	{
+		int32 NumBlocks;
+
+		TArray<int16> Min;
+		TArray<int16> Max;
+
+		// Sum of the squared samples, so merged blocks and buckets can get their RMS without knowing the blocks' lengths
+		TArray<float> SumSquares;
+	};
+
+	TArray<FLevel> Levels;
+
+	int32 NumChannels;
+	int32 NumFrames;
+	int32 SampleRate;
+
+	FThreadSafeBool bIsReady;
+	FThreadSafeBool bCancelRequested;
+};
+
+/**
+	Background task that waits for the decompress worker and then builds the envelope.
+	Used with FAsyncTask, so the owner can wait for it before freeing the PCM buffer.
+*/
+class FSoundVisEnvelopeTask : public FNonAbandonableTask
+{
+	friend class FAsyncTask<FSoundVisEnvelopeTask>;
+
+public:
+
+	FSoundVisEnvelopeTask(FSoundVisEnvelope* _Envelope, FAudioDecompressWorker* _DecompressWorker, const int16* _PCM, int32 _NumChannels, int32 _NumFrames, int32 _SampleRate);
+
+	void DoWork();
+
+	FORCEINLINE TStatId GetStatId() const
+	{
+		RETURN_QUICK_DECLARE_CYCLE_STAT(FSoundVisEnvelopeTask, STATGROUP_ThreadPoolAsyncTasks);
+	}
+
+private:
+
+	FSoundVisEnvelope* Envelope;
+	FAudioDecompressWorker* DecompressWorker;
+
+	const int16* PCM;
+	int32 NumChannels;
+	int32 NumFrames;
+	int32 SampleRate;
+};
@@ -0,0 +1,332 @@
+// Copyright 1998-2015 Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "ThirdParty/Kiss_FFT/kiss_fft129/kiss_fft.h"
+#include "ThirdParty/Kiss_FFT/kiss_fft129/tools/kiss_fftr.h"
+
+#include "SoundVisTypes.h"
+
+class FSoundVisFilterbank;
+class FSoundVisQ15FFT;
+
+// Roles of the scratch buffers a context hands out. Each role is one contiguous block
+namespace ESoundVisScratch
+{
+	enum Type
+	{
+		Input,
+		Output,
+		Temp,		// Packed channel pairs of StereoForward and TransformChannels
+		Samples,	// int16 frames copied out of the streamed blocks
+		Magnitudes,	// Linear magnitudes the filterbank reads from
+		Goertzel,	// Filter coefficients of CalculateBinMagnitudes
+		FixedSamples,		// Q15 samples of the fixed point path, transformed in place
+		FixedMagnitudes,	// Magnitudes of every channel of the fixed point path
+
+		Num
+	};
+}
+
+/**
+	Heap objects of one kind (plans, window tables, filterbanks), keyed by size and parameters.
+	Holds at most MaxEntries of them. When a new one doesn't fit, the least recently used one
+	is freed, so a value must not be kept past the next Add.
+*/
+template<typename KeyType, typename ValueType>
+class TSoundVisCache : public FNoncopyable
+{
+
+public:
+
+	// Queries with durations that change every tick (ZeroPadded, MixedRadix) would otherwise add a new table each time
+	static const int32 MaxEntries = 8;
+
+	typedef void (*FFreeFunction)(ValueType);
+
+	explicit TSoundVisCache(FFreeFunction _FreeFunction)
+		: FreeFunction(_FreeFunction)
+		, UseCounter(0)
+	{
+	}
+
+	~TSoundVisCache()
+	{
+		Empty();
+	}
+
+	// Cached value of _Key, or NULL. Marks it as used
+	ValueType Find(const KeyType& _Key)
+	{
+		FEntry* Entry = Entries.Find(_Key);
+
+		if (!Entry)
+		{
+			return NULL;
+		}
+
+		Entry->LastUse = ++UseCounter;
+
+		return Entry->Value;
+	}
+
+	// Adds a value Find didn't have. Frees the least recently used one first if the cache is full
+	void Add(const KeyType& _Key, ValueType _Value)
+	{
+		if (Entries.Num() >= MaxEntries)
+		{
+			RemoveLeastRecentlyUsed();
+		}
+
+		FEntry& Entry = Entries.Add(_Key);
+
+		Entry.Value = _Value;
+		Entry.LastUse = ++UseCounter;
+	}
+
+	// Frees all values
+	void Empty()
+	{
+		for (typename TMap<KeyType, FEntry>::TIterator EntryIt(Entries); EntryIt; ++EntryIt)
+		{
+			FreeFunction(EntryIt.Value().Value);
+		}
+
+		Entries.Empty();
+	}
+
+	int32 Num() const
+	{
+		return Entries.Num();
+	}
+
+private:
+
+	struct FEntry
+	{
+		ValueType Value;
+		uint64 LastUse;
+	};
+
+	void RemoveLeastRecentlyUsed()
+	{
+		KeyType OldestKey = KeyType();
+		uint64 OldestUse = MAX_uint64;
+
+		// At most MaxEntries entries, a linear search is fine
+		for (typename TMap<KeyType, FEntry>::TIterator EntryIt(Entries); EntryIt; ++EntryIt)
+		{
+			if (EntryIt.Value().LastUse < OldestUse)
+			{
+				OldestUse = EntryIt.Value().LastUse;
+				OldestKey = EntryIt.Key();
+			}
+		}
+
+		FEntry Oldest;
+
+		if (Entries.RemoveAndCopyValue(OldestKey, Oldest))
+		{
+			FreeFunction(Oldest.Value);
+		}
+	}
+
+	TMap<KeyType, FEntry> Entries;
+
+	FFreeFunction FreeFunction;
+
+	uint64 UseCounter;
+};
+
+/**
+	Keeps the kiss_fft plans and the scratch buffers of one analyzer alive between
+	spectrum queries. After the first query of a given size, further queries of that
+	size don't touch the heap anymore. Each kind of table keeps the last
+	TSoundVisCache::MaxEntries sizes, older ones are freed.
+
+	kiss_fftr plans carry their own temp buffer, so a context must only be used by
+	one thread at a time. Threads that run FFTs in parallel need their own context.
+
+	Power of two sizes from 512 to 4096 run on the fixed size kernels of SoundVisFixedFFT,
+	everything else on kiss_fft.
+
+	Any channel count up to MaxChannels works. The channels are split into 16 byte
+	aligned float planes, and go through the complex FFT in pairs. With more than
+	one pair (surround), the pairs run in parallel unless SetParallelChannels(false).
+
+	With SetFixedPoint(true), the spectrum and band functions run the int16 FFT of
+	FSoundVisQ15FFT for the sizes it supports instead, one channel after the other.
+	Only the last pass that turns the packed result into magnitudes runs in float. Goertzel bins stay float.
+*/
+class FSoundVisFFTContext : public FNoncopyable
+{
+
+public:
+
+	// 7.1
+	static const int32 MaxChannels = 8;
+
+	FSoundVisFFTContext();
+	~FSoundVisFFTContext();
+
+	/// Spectrum ///
+
+	// Windowed real FFT of _Size interleaved int16 frames. Writes the magnitudes of the lower _Size / 2 bins, averaged over the channels.
+	// With _NumFrames (below _Size), only that many frames are read and windowed, and the rest is zero padded
+	void CalculateMagnitudes(const int16* _Interleaved, int32 _NumChannels, int32 _Size, ESoundVisWindowType _WindowType, float* _OutMagnitudes, int32 _NumFrames = 0);
+
+	// Like CalculateMagnitudes, but writes _Output values. Magnitudes, power and dB come out of the same pass over the bins
+	void CalculateSpectrum(const int16* _Interleaved, int32 _NumChannels, int32 _Size, ESoundVisWindowType _WindowType, ESoundVisSpectrumOutput _Output, float* _OutValues, int32 _NumFrames = 0);
+
+	// Like CalculateSpectrum, but of channel _Channel only. The other channels are neither windowed nor transformed. Writes _Size / 2 values
+	void CalculateChannelSpectrum(const int16* _Interleaved, int32 _NumChannels, int32 _Channel, int32 _Size, ESoundVisWindowType _WindowType, ESoundVisSpectrumOutput _Output, float* _OutValues, int32 _NumFrames = 0);
+
+	// Magnitudes of only the _NumBins given bins (each below _Size / 2), the same values CalculateMagnitudes writes for them.
+	// Runs one Goertzel filter per bin instead of the FFT if PrefersGoertzel says that's cheaper
+	void CalculateBinMagnitudes(const int16* _Interleaved, int32 _NumChannels, int32 _Size, ESoundVisWindowType _WindowType, const int32* _Bins, int32 _NumBins, float* _OutMagnitudes, int32 _NumFrames = 0);
+
+	// True if _NumBins Goertzel filters over _Size samples are cheaper than the FFT and the magnitudes of all bins
+	static bool PrefersGoertzel(int32 _NumBins, int32 _Size);
+
+	// Like CalculateMagnitudes, but applies _Filterbank and writes its band values. Magnitudes above the last band are skipped
+	void CalculateBandEnergies(const int16* _Interleaved, int32 _NumChannels, int32 _Size, ESoundVisWindowType _WindowType, const FSoundVisFilterbank& _Filterbank, float* _OutBands, int32 _NumFrames = 0);
+
+	/// FFT Sizes ///
+
+	// Smallest power of two that holds _NumSamples (at least 2)
+	static int32 GetPowerOfTwoSize(int32 _NumSamples);
+
+	// Even size of only the factors 2, 3, 5 and 7 that holds _NumSamples and has the lowest estimated kiss_fft cost. Never costs more than GetPowerOfTwoSize
+	static int32 GetMixedRadixSize(int32 _NumSamples);
+
+	// FFT size _Policy picks for a window of _NumSamples
+	static int32 GetFFTSize(ESoundVisFFTSizePolicy _Policy, int32 _NumSamples);
+
+	/// Transforms ///
+
+	// Real to complex FFT of _Size (even) samples. Writes _Size / 2 + 1 bins to _OutBins
+	void RealForward(const float* _InSamples, kiss_fft_cpx* _OutBins, int32 _Size);
+
+	// Two real channels packed into one complex FFT. Writes _Size / 2 + 1 bins per channel
+	void StereoForward(const float* _InLeft, const float* _InRight, kiss_fft_cpx* _OutLeft, kiss_fft_cpx* _OutRight, int32 _Size);
+
+	// Real FFT of _NumChannels planes of _Size samples. Two channels share a complex FFT, an odd last one uses the real FFT
+	void TransformChannels(const float* const* _InPlanes, kiss_fft_cpx* const* _OutChannelBins, int32 _NumChannels, int32 _Size);
+
+	// Floats from the start of one channel plane to the next, so every plane stays 16 byte aligned
+	static int32 GetPlaneStride(int32 _Size)
+	{
+		return Align(_Size, 4);
+	}
+
+	// Runs the channel pairs of surround songs in parallel. Turn it off for contexts that already run on a ParallelFor worker
+	void SetParallelChannels(bool _bParallel)
+	{
+		bParallelChannels = _bParallel;
+	}
+
+	// Runs the spectrum and band functions on the fixed point FFT where it supports the size. Less memory traffic, about 60 to 70 dB of dynamic range
+	void SetFixedPoint(bool _bFixedPoint)
+	{
+		bFixedPoint = _bFixedPoint;
+	}
+
+	bool IsFixedPoint() const
+	{
+		return bFixedPoint;
+	}
+
+	// True if the fixed point FFT has _Size, power of two sizes from 16 to 65536
+	static bool SupportsFixedPoint(int32 _Size);
+
+	/// Plans and Scratch Memory ///
+
+	// The Get functions below return cached tables, creating them on first use. A table stays valid until the next Get of another key of the same kind
+
+	// Returns the cached real plan for _Size samples, creating it on first use. _Size has to be even
+	kiss_fftr_cfg GetRealPlan(int32 _Size);
+
+	// Returns the cached complex plan for _Size samples, creating it on first use
+	kiss_fft_cfg GetComplexPlan(int32 _Size);
+
+	// Returns the cached window table of _Type for _Size samples (16 byte aligned), creating it on first use
+	const float* GetWindow(ESoundVisWindowType _Type, int32 _Size);
+
+	// Returns the cached fixed point FFT for _Size samples, creating it on first use
+	const FSoundVisQ15FFT& GetQ15FFT(int32 _Size);
+
+	// Returns the cached Q15 copy of the window table of _Type for _Size samples, creating it on first use
+	const int16* GetFixedWindow(ESoundVisWindowType _Type, int32 _Size);
+
+	// Returns the cached filterbank for the bins of a _Size FFT, creating it on first use
+	const FSoundVisFilterbank& GetFilterbank(int32 _Size, int32 _SampleRate, ESoundVisBandLayout _Layout, ESoundVisFilterShape _Shape, int32 _NumMelBands);
+
+	// Returns a 16 byte aligned block of at least _NumBytes. The block only moves if it has to grow
+	void* GetScratchMemory(ESoundVisScratch::Type _Slot, SIZE_T _NumBytes);
+
+	template<typename T>
+	T* GetScratch(ESoundVisScratch::Type _Slot, int32 _NumElements)
+	{
+		return (T*)GetScratchMemory(_Slot, _NumElements * sizeof(T));
+	}
+
+	// Frees all plans and scratch buffers of this context
+	void Reset();
+
+	/// Allocation Counters (summed over all contexts) ///
+
+	// Plans and window tables
+	static int32 GetNumPlanAllocations();
+	static int32 GetNumScratchAllocations();
+	static void ResetAllocationCounters();
+
+private:
+
+	// True if the spectrum of _Size runs on the fixed point FFT
+	bool UsesFixedPoint(int32 _Size) const
+	{
+		return bFixedPoint && SupportsFixedPoint(_Size);
+	}
+
+	// Window and fixed point FFT of every channel. Returns _Size / 2 magnitudes per channel, one channel after the other, valid until the next transform
+	const float* ForwardFixedChannels(const int16* _Interleaved, int32 _NumChannels, int32 _NumFrames, int32 _Size, ESoundVisWindowType _WindowType);
+
+	// Window and real FFT of every channel. _OutChannelBins get the _Size / 2 + 1 bins of each channel, valid until the next transform
+	void ForwardChannels(const int16* _Interleaved, int32 _NumChannels, int32 _NumFrames, int32 _Size, ESoundVisWindowType _WindowType, kiss_fft_cpx** _OutChannelBins);
+
+	// Splits and windows _NumFrames frames into 16 byte aligned planes of _Size, zero padded after the frames. Fills _OutPlanes
+	void WindowChannels(const int16* _Interleaved, int32 _NumChannels, int32 _NumFrames, int32 _Size, ESoundVisWindowType _WindowType, float** _OutPlanes);
+
+	// Rough cost of a kiss_fft real FFT of _Size, from the butterflies its factors need
+	static float EstimateFFTCost(int32 _Size);
+
+	// Complex plan for a channel pair of _Size, NULL if the fixed size kernel runs it
+	kiss_fft_cfg GetPairPlan(int32 _Size);
+
+	// StereoForward with a given plan (NULL for the fixed size kernel) and _Size * 2 values of packing memory, so several pairs can run at once
+	static void PackedStereoForward(kiss_fft_cfg _Plan, const float* _InLeft, const float* _InRight, kiss_fft_cpx* _Packed, kiss_fft_cpx* _OutLeft, kiss_fft_cpx* _OutRight, int32 _Size);
+
+	// Plans, keyed by FFT size
+	TSoundVisCache<int32, kiss_fftr_cfg> RealPlans;
+	TSoundVisCache<int32, kiss_fft_cfg> ComplexPlans;
+
+	// Window tables, keyed by size and window type
+	TSoundVisCache<uint64, float*> Windows;
+	TSoundVisCache<uint64, int16*> FixedWindows;
+
+	// Fixed point FFTs, keyed by FFT size. Only powers of two from 16 to 65536, so this one needs no limit
+	TMap<int32, FSoundVisQ15FFT*> Q15FFTs;
+
+	// Filterbanks, keyed by FSoundVisFilterbank::MakeKey
+	TSoundVisCache<uint64, FSoundVisFilterbank*> Filterbanks;
+
+	// Scratch blocks and their current size in bytes
+	void* Scratch[ESoundVisScratch::Num];
+	SIZE_T ScratchSize[ESoundVisScratch::Num];
+
+	bool bParallelChannels;
+	bool bFixedPoint;
+
+	static FThreadSafeCounter NumPlanAllocations;
+	static FThreadSafeCounter NumScratchAllocations;
+};
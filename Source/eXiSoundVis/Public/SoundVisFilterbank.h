@@ -0,0 +1,61 @@
+// Copyright 1998-2015 Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "SoundVisTypes.h"
+
+/**
+	Sparse weights that turn the linear bins of one FFT size into log-frequency bands.
+	Every band only stores the weights of the bins it covers, in one contiguous block,
+	so applying it is a short dot product per band instead of a pass over all bins.
+	Build it once per (FFT size, sample rate, layout), FSoundVisFFTContext keeps them cached.
+*/
+class FSoundVisFilterbank : public FNoncopyable
+{
+
+public:
+
+	// Upper limit of Mel bands
+	static const int32 MaxMelBands = 256;
+
+	// Lowest and highest frequency any layout covers
+	static const float MinFrequency;
+	static const float MaxFrequency;
+
+	FSoundVisFilterbank();
+
+	// Computes the weights for the _FFTSize / 2 bins of a real FFT. _NumMelBands is only used by the Mel layout
+	void Build(int32 _FFTSize, int32 _SampleRate, ESoundVisBandLayout _Layout, ESoundVisFilterShape _Shape, int32 _NumMelBands);
+
+	// Writes GetNumBands() weighted band values of _Magnitudes into _OutBands. _Magnitudes needs at least GetNumBinsUsed() values
+	void Apply(const float* _Magnitudes, float* _OutBands) const;
+
+	int32 GetNumBands() const
+	{
+		return RowFirstBin.Num();
+	}
+
+	// All bins at and above this one have no weight, so the magnitudes don't have to be computed
+	int32 GetNumBinsUsed() const
+	{
+		return NumBinsUsed;
+	}
+
+	// Band centers in Hz. Only depends on the layout and the sample rate, not on the FFT size
+	static void GetCenterFrequencies(int32 _SampleRate, ESoundVisBandLayout _Layout, int32 _NumMelBands, TArray<float>& _OutCenters);
+
+	// Key of a filterbank in the cache of FSoundVisFFTContext
+	static uint64 MakeKey(int32 _FFTSize, int32 _SampleRate, ESoundVisBandLayout _Layout, ESoundVisFilterShape _Shape, int32 _NumMelBands);
+
+private:
+
+	// First bin, number of weights and offset into Weights of every band
+	TArray<int32> RowFirstBin;
+	TArray<int32> RowNumWeights;
+	TArray<int32> RowWeightOffset;
+
+	// Weights of all bands, each band's weights sum up to 1
+	TArray<float> Weights;
+
+	int32 NumBinsUsed;
+};
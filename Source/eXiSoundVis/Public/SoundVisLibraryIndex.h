@@ -0,0 +1,94 @@
+// Copyright 1998-2015 Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "SoundVisTypes.h"
+
+/**
+	Index of all sound files below a directory, with duration, sample rate and channels read from their headers.
+	The index is kept in <Saved>/SoundVisLibrary, so a rescan only reads the headers of files that are new or
+	whose size or modification time changed. The scan runs on its own thread, the headers are read by a few
+	more threads. Queries are answered from memory and see the previous index until a scan is done.
+*/
+class FSoundVisLibraryIndex : public FRunnable
+{
+
+public:
+
+	// "SVLI" and the version of the file layout
+	static const uint32 FileMagic = 0x494C5653;
+	static const uint32 FileVersion = 1;
+
+	// Upper limit of threads reading headers, no matter how many cores there are
+	static const int32 MaxReaderThreads = 4;
+
+	// Loads the index file of the directory, if there is one. _FileExtension can be with or without the dot, empty means every file
+	FSoundVisLibraryIndex(const FString& _RootDirectory, const FString& _FileExtension);
+	virtual ~FSoundVisLibraryIndex();
+
+	static FString GetIndexDirectory();
+	static FString GetIndexFilePath(const FString& _RootDirectory, const FString& _FileExtension);
+
+	// True if this is the index of _RootDirectory and _FileExtension, however they are written
+	bool IsIndexOf(const FString& _RootDirectory, const FString& _FileExtension) const;
+
+	// Starts a rescan in the background. Does nothing if one is already running
+	void StartScan();
+
+	bool IsScanning() const
+	{
+		return bIsScanning;
+	}
+
+	// Files found so far, and how many of their headers had to be read and are read already
+	void GetScanProgress(int32& _OutNumFiles, int32& _OutNumHeadersRead, int32& _OutNumHeadersToRead) const;
+
+	int32 GetNumEntries() const;
+
+	/**
+		Copies the readable entries whose file name contains _NameFilter (case insensitive, empty matches all)
+		and whose duration is in [_MinDuration, _MaxDuration] (a max <= 0 means no limit)
+	*/
+	void Query(const FString& _NameFilter, float _MinDuration, float _MaxDuration, ESoundVisLibrarySort _SortBy, bool _bDescending, TArray<FSoundVisLibraryEntry>& _OutEntries) const;
+
+	// FRunnable interface
+	virtual uint32 Run() override;
+	virtual void Stop() override;
+
+private:
+
+	class FHeaderReader;
+
+	// Full path without a trailing slash, and the extension without the dot
+	static FString NormalizeRootDirectory(const FString& _RootDirectory);
+	static FString NormalizeFileExtension(const FString& _FileExtension);
+
+	// Walks the directory and collects path, size and modification time of every matching file. False if stopped
+	bool FindFiles(TArray<FSoundVisLibraryEntry>& _OutEntries);
+
+	// Reads the headers of the entries in _ToRead with the reader threads. False if stopped
+	bool ReadHeaders(TArray<FSoundVisLibraryEntry>& _Entries, const TArray<int32>& _ToRead);
+
+	// Maps the file and lets the Vorbis decoder parse the header. Only the touched pages get read from disk
+	static void ReadHeader(FSoundVisLibraryEntry& _Entry);
+
+	bool LoadIndexFile();
+	bool SaveIndexFile(const TArray<FSoundVisLibraryEntry>& _Entries) const;
+
+	FString RootDirectory;
+	FString FileExtension;
+
+	// Result of the last scan (or the index file), guarded by EntriesLock
+	mutable FCriticalSection EntriesLock;
+	TArray<FSoundVisLibraryEntry> Entries;
+
+	FRunnableThread* Thread;
+
+	FThreadSafeBool bIsScanning;
+	FThreadSafeCounter StopTaskCounter;
+
+	// Progress of the running scan
+	FThreadSafeCounter NumFilesFound;
+	FThreadSafeCounter NumHeadersRead;
+	FThreadSafeCounter NumHeadersToRead;
+};
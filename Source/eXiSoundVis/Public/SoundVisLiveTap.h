@@ -0,0 +1,121 @@
+// Copyright 1998-2015 Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "SoundVisTypes.h"
+#include "SoundVisFFT.h"
+
+/**
+	Lock-free ring of interleaved int16 frames with one writer and one reader.
+	The writer is the thread the audio device renders a USoundVisTapWave on, it never waits and overwrites the oldest frames.
+	The reader copies frames out by their position and checks afterwards that they weren't overwritten meanwhile.
+	Positions count all frames ever written, so they don't wrap.
+*/
+class FSoundVisLiveRing : public FNoncopyable
+{
+
+public:
+
+	// Holds at least _MinFrames readable frames
+	FSoundVisLiveRing(int32 _NumChannels, int32 _SampleRate, int32 _MinFrames);
+
+	/// Writer ///
+
+	// Appends _NumFrames frames and publishes them. Only called by the one writer thread
+	void Write(const int16* _Interleaved, int32 _NumFrames);
+
+	/// Reader ///
+
+	// Frames written so far, and the time (FPlatformTime::Seconds) the last ones were written
+	int64 GetWritePosition() const;
+	double GetLastWriteTime() const;
+
+	// Copies the frames [_FirstFrame, _FirstFrame + _NumFrames). False if they aren't written yet or are already overwritten
+	bool Read(int64 _FirstFrame, int32 _NumFrames, int16* _OutInterleaved) const;
+
+	int32 GetNumChannels() const
+	{
+		return NumChannels;
+	}
+
+	int32 GetSampleRate() const
+	{
+		return SampleRate;
+	}
+
+private:
+
+	// Copies between the ring and linear memory, split at the end of the ring
+	void CopyIn(int64 _Position, const int16* _Interleaved, int32 _NumFrames);
+	void CopyOut(int64 _Position, int16* _OutInterleaved, int32 _NumFrames) const;
+
+	TArray<int16> Samples;
+
+	int32 NumChannels;
+	int32 SampleRate;
+
+	// Power of two, so positions map to slots with a mask
+	int32 CapacityFrames;
+	int32 Mask;
+
+	// Only the writer changes these. Readable frames are the newest CapacityFrames / 2, the half
+	// before them might be overwritten by a write that isn't published yet
+	volatile int64 WritePosition;
+	volatile double LastWriteTime;
+};
+
+/**
+	Analysis thread of a live tap. Every hop it runs one FFT on the frames around the position that is heard right now
+	and publishes the magnitudes. The heard position is the newest frame minus the output latency of the device,
+	moved on with the clock between two writes, because the device renders in bursts.
+*/
+class FSoundVisLiveAnalyzer : public FRunnable
+{
+
+public:
+
+	// _StartTime is the song time of the first frame written to _Ring. _Latency is in seconds. _bFixedPoint runs the FFTs on the fixed point path
+	FSoundVisLiveAnalyzer(const TSharedRef<FSoundVisLiveRing, ESPMode::ThreadSafe>& _Ring, int32 _FFTSize, int32 _HopSize, ESoundVisWindowType _WindowType, float _StartTime, float _Latency, bool _bFixedPoint = false);
+	virtual ~FSoundVisLiveAnalyzer();
+
+	// Song time of the heard frame
+	float GetPlaybackTime() const;
+
+	// Copies the newest spectrum (_FFTSize / 2 magnitudes) and the song time at its center. False if there is none yet
+	bool GetSpectrum(TArray<float>& _OutMagnitudes, float& _OutTime) const;
+
+	int32 GetFFTSize() const
+	{
+		return FFTSize;
+	}
+
+	// FRunnable interface
+	virtual uint32 Run() override;
+	virtual void Stop() override;
+
+private:
+
+	// Frame of the ring that is heard right now
+	int64 GetPlaybackFrame() const;
+
+	TSharedRef<FSoundVisLiveRing, ESPMode::ThreadSafe> Ring;
+
+	int32 FFTSize;
+	int32 HopSize;
+	ESoundVisWindowType WindowType;
+	float StartTime;
+	int32 LatencyFrames;
+
+	// Only used by the analysis thread
+	FSoundVisFFTContext FFTContext;
+	TArray<int16> WindowSamples;
+	TArray<float> WorkMagnitudes;
+
+	// Newest result, guarded by ResultLock. The writer of the ring never takes it
+	mutable FCriticalSection ResultLock;
+	TArray<float> Magnitudes;
+	float MagnitudesTime;
+
+	FRunnableThread* Thread;
+	FThreadSafeCounter StopTaskCounter;
+};
@@ -0,0 +1,68 @@
+// Copyright 1998-2015 Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "SoundVisTypes.h"
+#include "SoundVisFFT.h"
+
+/**
+	Spectrum queries on a fixed hop grid with the last few frames cached, for one visualizer that asks every tick.
+	Frame N covers the samples N * HopSize to N * HopSize + WindowFrames, like in the spectrogram, zero padded up to FFTSize. A query blends the
+	two frames around its center and only runs FFTs for frames that aren't cached yet. While the song plays that is
+	one frame per hop that passed since the last query, no matter how long the window is.
+*/
+class FSoundVisSlidingSTFT : public FNoncopyable
+{
+
+public:
+
+	// Frames kept, indexed by FrameIndex % NumCachedFrames
+	static const int32 NumCachedFrames = 8;
+
+	FSoundVisSlidingSTFT();
+
+	// Sets song and grid of the following queries. _WindowFrames (at most _FFTSize, 0 for all of it) are read per frame. The cached frames are dropped if anything changed.
+	// _bFixedPoint tells which FFT the context of the queries runs, so frames of the other one aren't blended in
+	void Configure(const UObject* _Song, int32 _NumChannels, int32 _SampleRate, int32 _NumSampleFrames, int32 _WindowFrames, int32 _FFTSize, int32 _HopSize, ESoundVisWindowType _WindowType, bool _bFixedPoint = false);
+
+	// Drops the cached frames and the configuration
+	void Reset();
+
+	int32 GetNumBins() const
+	{
+		return FFTSize / 2;
+	}
+
+	/**
+		Writes GetNumBins() magnitudes for a window centered at _CenterTime, blended from the two closest frames.
+		Frames that aren't cached are computed from the interleaved frames _GetSamples returns (NULL if they aren't there).
+		False if a frame couldn't be computed
+	*/
+	bool GetSpectrumAtTime(float _CenterTime, FSoundVisFFTContext& _Context, TFunctionRef<const int16*(int32 _FirstFrame, int32 _NumFrames)> _GetSamples, float* _OutMagnitudes);
+
+	// FFTs run by all sliding STFTs, to see how many queries were served from the cache
+	static int32 GetNumComputedFrames();
+	static void ResetComputedFrames();
+
+private:
+
+	// Magnitudes of the frame, from the cache or computed into it. NULL if the samples aren't there
+	const float* GetFrame(int32 _FrameIndex, FSoundVisFFTContext& _Context, TFunctionRef<const int16*(int32 _FirstFrame, int32 _NumFrames)> _GetSamples);
+
+	const UObject* Song;
+
+	int32 NumChannels;
+	int32 SampleRate;
+	int32 WindowFrames;
+	int32 FFTSize;
+	int32 HopSize;
+	int32 NumFrames;
+	ESoundVisWindowType WindowType;
+	bool bFixedPoint;
+
+	// NumCachedFrames x NumBins magnitudes, and the frame every slot holds (INDEX_NONE if empty)
+	TArray<float> CachedMagnitudes;
+	int32 CachedFrameIndices[NumCachedFrames];
+
+	static FThreadSafeCounter NumComputedFrames;
+};
@@ -0,0 +1,220 @@
+// Copyright 1998-2015 Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "Runtime/Core/Public/Async/AsyncWork.h"
+
+#include "SoundVisTypes.h"
+#include "SoundVisAnalysisCache.h"
+
+class FAudioDecompressWorker;
+class FSoundVisBeatGrid;
+class FSoundVisEnvelope;
+
+/**
+	Magnitude spectrum of a whole song, computed once on a fixed hop grid.
+	Frames are stored frame-major in one contiguous array (NumFrames x NumBins), so a
+	spectrum query at any time is a lookup plus a blend of the two closest frames.
+	Every bin is one byte, its level in steps of DecibelStep dB, so a frame takes a quarter
+	of the memory of the float magnitudes. Lookups decode them through a table.
+	Next to the spectrum every frame also gets its RMS, the energies of a few fixed bands
+	and the log spectral flux the beat grid needs. Those are kept in float, and can be built
+	without the frames for songs that only need beats.
+
+	The data either lives in the spectrogram itself (Build) or in memory owned by someone
+	else, e.g. a mapped analysis cache file (InitFromMemory).
+*/
+class FSoundVisSpectrogram : public FNoncopyable
+{
+
+public:
+
+	// SubBass, Bass, LowMids, Mids, HighMids, Presence, Brilliance
+	static const int32 NumBands = 7;
+
+	// NumBands + 1 band edges in Hz
+	static const float BandEdges[NumBands + 1];
+
+	// Level step of the stored bins. 255 steps reach 191 dB, above the largest magnitude an int16 FFT up to 65536 can return
+	static const float DecibelStep;
+
+	// Magnitude of a stored bin. 0 is silence
+	static float DecodeMagnitude(uint8 _Value)
+	{
+		return DecodeTable[_Value];
+	}
+
+	// Stored bins of _NumBins magnitudes. _Decibels is scratch memory of _NumBins floats
+	static void EncodeFrame(const float* _Magnitudes, int32 _NumBins, float* _Decibels, uint8* _OutFrame);
+
+	FSoundVisSpectrogram();
+
+	// Computes all frames of the interleaved int16 PCM, spread over the worker threads. Call IsReady() before reading.
+	// _bFixedPoint runs the FFTs on the fixed point path of the FFT context. Without _bKeepFrames only RMS, bands and flux are stored.
+	// The hop grows if the frames wouldn't fit into one array, see GetHopSize()
+	void Build(const int16* _PCM, int32 _NumChannels, int32 _NumSampleFrames, int32 _SampleRate, int32 _FFTSize, int32 _HopSize, ESoundVisWindowType _WindowType, bool _bFixedPoint = false, bool _bKeepFrames = true);
+
+	// Uses already computed data without copying it. The memory has to stay valid until the next Reset()
+	void InitFromMemory(const uint8* _Frames, const float* _FrameRMS, const float* _BandEnergies, const float* _Flux, int32 _NumFrames, int32 _SampleRate, int32 _FFTSize, int32 _HopSize);
+
+	// Makes a running or upcoming Build() return early. The spectrogram stays not ready
+	void Cancel();
+
+	bool IsCancelRequested() const
+	{
+		return bCancelRequested;
+	}
+
+	// Frees the frames and clears a pending Cancel()
+	void Reset();
+
+	bool IsReady() const
+	{
+		return bIsReady;
+	}
+
+	// False if only RMS, bands and flux were built. The spectrum lookups need the frames
+	bool HasFrames() const
+	{
+		return bIsReady && FrameData != NULL;
+	}
+
+	int32 GetFFTSize() const
+	{
+		return FFTSize;
+	}
+
+	int32 GetHopSize() const
+	{
+		return HopSize;
+	}
+
+	int32 GetSampleRate() const
+	{
+		return SampleRate;
+	}
+
+	int32 GetNumBins() const
+	{
+		return FFTSize / 2;
+	}
+
+	int32 GetNumFrames() const
+	{
+		return NumFrames;
+	}
+
+	// Raw data: NumFrames x NumBins stored bins, NumFrames RMS values, NumFrames x NumBands band energies and NumFrames flux values
+	const uint8* GetFrameData() const
+	{
+		return FrameData;
+	}
+
+	const float* GetFrameRMSData() const
+	{
+		return FrameRMSData;
+	}
+
+	const float* GetBandEnergyData() const
+	{
+		return BandEnergyData;
+	}
+
+	// Mean rise of log(1 + magnitude / FFTSize) over all bins from the frame before, 0 for the first frame
+	const float* GetFluxData() const
+	{
+		return FluxData;
+	}
+
+	// Writes GetNumBins() magnitudes for a window centered at _CenterTime, interpolated between the two closest frames
+	void GetSpectrumAtTime(float _CenterTime, float* _OutMagnitudes) const;
+
+	// Writes NumBands band energies and the RMS for a window centered at _CenterTime, interpolated like the spectrum
+	void GetBandEnergiesAtTime(float _CenterTime, float* _OutBandEnergies, float& _OutRMS) const;
+
+private:
+
+	// Maps a time to the closest frame before it, the one after it and the blend between them
+	void GetFramesAtTime(float _CenterTime, int32& _OutFrameIndex, int32& _OutNextFrameIndex, float& _OutAlpha) const;
+
+	// Magnitudes of the 256 stored values
+	static float DecodeTable[256];
+
+	friend struct FSoundVisSpectrogramTableInitializer;
+
+	// Owned data after Build(), empty after InitFromMemory()
+	TArray<uint8> Frames;
+	TArray<float> FrameRMS;
+	TArray<float> BandEnergies;
+	TArray<float> Flux;
+
+	// What the lookups read from, either the arrays above or external memory
+	const uint8* FrameData;
+	const float* FrameRMSData;
+	const float* BandEnergyData;
+	const float* FluxData;
+
+	int32 FFTSize;
+	int32 HopSize;
+	int32 SampleRate;
+	int32 NumFrames;
+
+	FThreadSafeBool bIsReady;
+	FThreadSafeBool bCancelRequested;
+};
+
+/**
+	Background task that waits for the decompress worker and then builds the spectrogram.
+	Used with FAsyncTask, so the owner can wait for it before freeing the PCM buffer.
+	If a cache entry is set, the finished spectrogram is also written to the analysis cache.
+	If a beat grid is set, it gets built from the finished spectrogram in the same task.
+	If an envelope is set, it gets built from the same samples first and goes into the cache entry too.
+*/
+class FSoundVisSpectrogramTask : public FNonAbandonableTask
+{
+	friend class FAsyncTask<FSoundVisSpectrogramTask>;
+
+public:
+
+	FSoundVisSpectrogramTask(FSoundVisSpectrogram* _Spectrogram, FAudioDecompressWorker* _DecompressWorker, const int16* _PCM, int32 _NumChannels, int32 _NumSampleFrames, int32 _SampleRate, int32 _FFTSize, int32 _HopSize, ESoundVisWindowType _WindowType, bool _bFixedPoint, bool _bKeepFrames = true);
+
+	// Write the result to the analysis cache once it is built
+	void SetCacheEntry(const FSoundVisCacheKey& _CacheKey, const FSoundVisCacheMetadata& _Metadata);
+
+	// Build the beat grid once the spectrogram is built. Cancel it together with the spectrogram
+	void SetBeatGrid(FSoundVisBeatGrid* _BeatGrid);
+
+	// Build the envelope before the spectrogram, and write it with the cache entry. Cancel it together with the spectrogram
+	void SetEnvelope(FSoundVisEnvelope* _Envelope);
+
+	void DoWork();
+
+	FORCEINLINE TStatId GetStatId() const
+	{
+		RETURN_QUICK_DECLARE_CYCLE_STAT(FSoundVisSpectrogramTask, STATGROUP_ThreadPoolAsyncTasks);
+	}
+
+private:
+
+	FSoundVisSpectrogram* Spectrogram;
+	FAudioDecompressWorker* DecompressWorker;
+
+	const int16* PCM;
+	int32 NumChannels;
+	int32 NumSampleFrames;
+	int32 SampleRate;
+	int32 FFTSize;
+	int32 HopSize;
+	ESoundVisWindowType WindowType;
+	bool bFixedPoint;
+	bool bKeepFrames;
+
+	// Only written to the cache if bWriteCache is set
+	bool bWriteCache;
+	FSoundVisCacheKey CacheKey;
+	FSoundVisCacheMetadata CacheMetadata;
+
+	// Only built if set
+	FSoundVisBeatGrid* BeatGrid;
+	FSoundVisEnvelope* Envelope;
+};
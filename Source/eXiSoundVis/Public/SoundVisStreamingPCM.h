@@ -0,0 +1,122 @@
+// Copyright 1998-2015 Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+/**
+	Decodes a song in blocks of one second instead of all at once. Only a fixed number of
+	blocks around the playhead stay in memory, so long songs don't need more memory than short ones.
+	The playhead follows the sample requests, and a decode thread keeps the blocks after it ready.
+	A request longer than the blocks around the playhead grows the cache once, so it can become resident.
+
+	GetFrames must only be called from one thread (usually the game thread).
+*/
+class FSoundVisStreamingPCM : public FRunnable
+{
+
+public:
+
+	// Decodes _SourceData, or the resource data of _Wave if it's NULL. An _OpenedAudioInfo that already read the header is taken over
+	FSoundVisStreamingPCM(USoundWave* _Wave, int32 _MaxBlocks, int32 _PrefetchBlocks, const uint8* _SourceData = NULL, uint32 _SourceSize = 0, ICompressedAudioInfo* _OpenedAudioInfo = NULL);
+	virtual ~FSoundVisStreamingPCM();
+
+	// FRunnable interface
+	virtual uint32 Run() override;
+	virtual void Stop() override;
+
+	int32 GetNumChannels() const
+	{
+		return NumChannels;
+	}
+
+	int32 GetNumFrames() const
+	{
+		return NumFrames;
+	}
+
+	// Frames per block (one second)
+	int32 GetBlockFrames() const
+	{
+		return SampleRate;
+	}
+
+	/**
+	* Copies _NumFrames interleaved frames starting at _FirstFrame into _Scratch (_NumFrames * NumChannels values)
+	* and returns it. Returns NULL if one of the blocks isn't decoded yet. Also moves the playhead to _FirstFrame,
+	* so the decode thread starts on the missing blocks and on the ones after them.
+	*/
+	const int16* GetFrames(int32 _FirstFrame, int32 _NumFrames, int16* _Scratch);
+
+	// Like GetFrames, but leaves the playhead and the decode thread alone. For batches that jump around the song and
+	// shouldn't drag the decoding away from the playing position
+	const int16* GetFramesIfResident(int32 _FirstFrame, int32 _NumFrames, int16* _Scratch);
+
+	// Bytes held by the block slots
+	SIZE_T GetResidentBytes() const;
+
+private:
+
+	struct FBlock
+	{
+		// Block of the song this slot holds, INDEX_NONE if empty
+		int32 BlockIndex;
+
+		// BlockFrames * NumChannels samples
+		int16* Samples;
+
+		// Value of UseCounter when the block was last read
+		uint64 LastUsed;
+
+		// False while the decode thread is still writing into it
+		bool bDecoded;
+	};
+
+	// Slot holding _BlockIndex, INDEX_NONE if it's not resident. BlockLock has to be held
+	int32 FindSlot(int32 _BlockIndex) const;
+
+	// Next block the decode thread should work on, INDEX_NONE if everything around the playhead is there. BlockLock has to be held
+	int32 FindBlockToDecode() const;
+
+	// Free slot, or the least recently used one outside of the playhead window. BlockLock has to be held
+	int32 ClaimSlot(int32 _BlockIndex);
+
+	// Adds slots until there are _NumSlots (at most NumBlocks). BlockLock has to be held
+	void GrowSlots(int32 _NumSlots);
+
+	// Copies the frames into _Scratch if all their blocks are decoded, NULL otherwise. BlockLock has to be held
+	const int16* CopyResidentFrames(int32 _FirstFrame, int32 _NumFrames, int16* _Scratch);
+
+	// Decodes one block into _OutSamples. Only called on the decode thread
+	void DecodeBlock(int32 _BlockIndex, int16* _OutSamples);
+
+	USoundWave* Wave;
+	ICompressedAudioInfo* AudioInfo;
+
+	const uint8* SourceData;
+	uint32 SourceSize;
+
+	// True if AudioInfo already parsed the header of SourceData
+	bool bHeaderRead;
+
+	int32 NumChannels;
+	int32 SampleRate;
+	int32 NumFrames;
+	int32 NumBlocks;
+
+	// Blocks decoded behind and after the playhead
+	int32 PrefetchBlocks;
+
+	// Blocks after the playhead that stay resident. PrefetchBlocks, or more if a request was longer
+	int32 WindowBlocks;
+
+	mutable FCriticalSection BlockLock;
+	TArray<FBlock> Blocks;
+	int32 PlayheadBlock;
+	uint64 UseCounter;
+
+	// Block the decoder is positioned at, so consecutive blocks don't need a seek
+	int32 NextSequentialBlock;
+
+	FEvent* WakeUpEvent;
+	FRunnableThread* Thread;
+	FThreadSafeCounter StopTaskCounter;
+};